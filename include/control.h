@@ -45,6 +45,7 @@ struct CommandLineArguments {
 	std::string working_dir;
 	std::string lang;
 	std::string machine;
+	std::string replay_voodoo;
 	std::vector<std::string> conf;
 	std::vector<std::string> set;
 	std::optional<std::vector<std::string>> editconf;
@@ -7,7 +7,9 @@
 
 #include "dosbox.h"
 
+#include <chrono>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "bit_view.h"
@@ -116,6 +118,12 @@ public:
 	virtual bool	Write(uint8_t * data,uint16_t * size)=0;
 	virtual bool	Seek(uint32_t * pos,uint32_t type)=0;
 	virtual void	Close()=0;
+	// Writes out anything the file holds back, for DOS commit file. Also
+	// reports a failure to write out held back data earlier.
+	virtual bool	Flush() { return true; }
+	// Writes out anything the file holds back, leaving a failure for the
+	// handle's next write, commit or close to report
+	virtual void	FlushHeldBackWrites() {}
 	virtual uint16_t	GetInformation(void)=0;
 	virtual bool IsOnReadOnlyMedium() const = 0;
 
@@ -213,6 +221,30 @@ public:
 	void SetLabel(const char *name, bool cdrom, bool allowupdate);
 	const char *GetLabel() const { return label; }
 
+	// Watch the cached host directories for changes, so files added,
+	// removed, or modified outside of DOS are picked up without a RESCAN.
+	// Only supported on Linux; returns false elsewhere.
+	bool EnableHostWatching();
+	bool IsWatchingHost() const { return watch_fd >= 0; }
+
+	// The details of a host file as reported by FindFirst/FindNext
+	struct FileDetails {
+		uint32_t size                = 0;
+		uint16_t date                = 0;
+		uint16_t time                = 0;
+		FatAttributeFlags attributes = {};
+		bool is_hidden_by_host       = false;
+	};
+
+	// The details are only cached while the host is being watched, as
+	// otherwise there's no telling when they change. Returns false if the
+	// file's details aren't cached.
+	bool GetFileDetails(const char* path, FileDetails& details);
+	void SetFileDetails(const char* path, const FileDetails& details);
+
+	// Drops the cached details of all files, e.g. after writing to one
+	void ForgetFileDetails() { ++details_generation; }
+
 	class CFileInfo {
 	public:
 		CFileInfo(void)
@@ -246,6 +278,22 @@ public:
 		// contents
 		std::vector<CFileInfo*> fileList;
 		std::vector<CFileInfo*> longNameList;
+
+		// Hashed lookups into the lists above: by short name, by the
+		// (case-normalised on Windows) name of the entries that have a
+		// generated short name, and by Wine-style short name. The last
+		// one is only built when first needed.
+		std::unordered_map<std::string, CFileInfo*> short_names = {};
+		std::unordered_map<std::string, CFileInfo*> long_names  = {};
+		std::unordered_map<std::string, CFileInfo*> wine_names  = {};
+		bool has_wine_names = false;
+
+		// Only valid if the generation matches the cache's
+		FileDetails details         = {};
+		uint32_t details_generation = 0;
+
+		// The host watch of a cached-in directory, or -1
+		int watch_id = -1;
 	};
 
 private:
@@ -253,7 +301,7 @@ private:
 	void DeleteFileInfo(CFileInfo *dir);
 
 	bool		RemoveTrailingDot	(char* shortname);
-	Bits		GetLongName		(CFileInfo* info, char* shortname, const size_t shortname_len);
+	CFileInfo*	FindEntry		(CFileInfo* info, char* shortname, const size_t shortname_len);
 	void		CreateShortName		(CFileInfo* dir, CFileInfo* info);
 	unsigned        CreateShortNameID       (CFileInfo* dir, const char* name);
 	int		CompareShortname	(const char* compareName, const char* shortName);
@@ -262,18 +310,30 @@ private:
 	CFileInfo*	FindDirInfo		(const char* path, char* expandedPath);
 	bool		RemoveSpaces		(char* str);
 	bool		OpenDir			(CFileInfo* dir, const char* path, uint16_t& id);
-	void		CreateEntry		(CFileInfo* dir, const char* name, bool is_directory);
+	size_t		CreateEntry		(CFileInfo* dir, const char* name, bool is_directory, bool keepSorted = true);
 	void		CopyEntry		(CFileInfo* dir, CFileInfo* from);
 	uint16_t		GetFreeID		(CFileInfo* dir);
 	void		Clear			(void);
+	void		CacheOutDir		(CFileInfo* dir);
+	void		ForgetResolvedPaths	(void);
+	CFileInfo*	FindFileInfo		(const char* path);
+
+	void WatchDir(CFileInfo* dir, const char* path);
+	void UnwatchDir(CFileInfo* dir);
+	void PollHostChanges(const bool force = false);
 
 	CFileInfo*	dirBase;
 	char		dirPath				[CROSS_LEN];
 	char		basePath			[CROSS_LEN];
 	TDirSort	sortDirType;
-	CFileInfo*	save_dir;
-	char		save_path			[CROSS_LEN];
-	char		save_expanded		[CROSS_LEN];
+
+	// The most recent results of FindDirInfo, most recently used first
+	struct ResolvedPath {
+		std::string path     = {};
+		std::string expanded = {};
+		CFileInfo* dir       = nullptr;
+	};
+	std::vector<ResolvedPath> resolved_paths = {};
 
 	uint16_t		srchNr;
 	CFileInfo*	dirSearch			[MAX_OPENDIRS];
@@ -282,6 +342,13 @@ private:
 
 	char		label				[CROSS_LEN];
 	bool		updatelabel;
+
+	// Generation 0 marks details that were never cached
+	uint32_t details_generation = 1;
+
+	int watch_fd = -1;
+	std::unordered_map<int, CFileInfo*> watched_dirs = {};
+	std::chrono::steady_clock::time_point last_poll  = {};
 };
 
 enum class DosDriveType : uint16_t {
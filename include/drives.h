@@ -6,6 +6,8 @@
 
 #include "dosbox.h"
 
+#include <array>
+#include <list>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -354,7 +356,7 @@ struct isoDirEntry {
 #define IS_ASSOC(fileFlags)	(!!(fileFlags & ISO_ASSOCIATED))
 #define IS_DIR(fileFlags)	(!!(fileFlags & ISO_DIRECTORY))
 #define IS_HIDDEN(fileFlags)	(!!(fileFlags & ISO_HIDDEN))
-#define ISO_MAX_HASH_TABLE_SIZE 	100
+#define ISO_DEFAULT_SECTOR_CACHE	1024
 
 // Must be constructed with a shared_ptr or it will throw an exception on internal call to shared_from_this()
 class isoDrive final : public DOS_Drive, public std::enable_shared_from_this<isoDrive> {
@@ -401,22 +403,35 @@ private:
 	bool GetNextDirEntry(const int dirIterator, isoDirEntry* de);
 	void FreeDirIterator(const int dirIterator);
 	bool ReadCachedSector(uint8_t** buffer, const uint32_t sector);
-	
+
+	// The parsed records of a directory, and the upper case names of
+	// its (non-associated) entries for path lookups
+	struct DirIndex {
+		std::vector<isoDirEntry> entries = {};
+		std::unordered_map<std::string, size_t> by_name = {};
+	};
+	std::shared_ptr<const DirIndex> GetDirIndex(const isoDirEntry& dir);
+
 	struct DirIterator {
-		bool valid;
-		bool root;
-		uint32_t currentSector;
-		uint32_t endSector;
-		uint32_t pos;
+		bool valid = false;
+		bool root  = false;
+		std::shared_ptr<const DirIndex> index = {};
+		size_t pos = 0;
 	} dirIterators[MAX_OPENDIRS];
 	
 	int nextFreeDirIterator;
-	
-	struct SectorHashEntry {
-		bool valid;
-		uint32_t sector;
-		uint8_t data[ISO_FRAMESIZE];
-	} sectorHashEntries[ISO_MAX_HASH_TABLE_SIZE];
+
+	// Directories indexed so far, by the sector they start at
+	std::unordered_map<uint32_t, std::shared_ptr<const DirIndex>> dir_indexes = {};
+
+	// Recently read sectors, the most recently used one first
+	struct CachedSector {
+		uint32_t sector = 0;
+		std::array<uint8_t, ISO_FRAMESIZE> data = {};
+	};
+	std::list<CachedSector> sector_cache = {};
+	std::unordered_map<uint32_t, std::list<CachedSector>::iterator> sector_cache_index = {};
+	size_t max_cached_sectors = ISO_DEFAULT_SECTOR_CACHE;
 
 	bool iso;
 	bool dataCD;
@@ -509,9 +524,11 @@ private:
 	void add_DOSdir_to_cache(const char* name);
 	void remove_DOSdir_from_cache(const char* name);
 	void update_cache(bool read_directory_contents = false);
+	void restore_cache_entries(const std::string& dos_dir);
+	void refresh_cache_of(const char* dos_name);
 
-	std::vector<std::string> deleted_files_in_base; //Set is probably better, or some other solution (involving the disk).
-	std::vector<std::string> deleted_paths_in_base; //Currently only used to hide the overlay folder.
+	std::unordered_set<std::string> deleted_files_in_base;
+	std::unordered_set<std::string> deleted_paths_in_base; //Currently only used to hide the overlay folder.
 	std::string overlap_folder;
 	void add_deleted_file(const char* name, bool create_on_disk);
 	void remove_deleted_file(const char* name, bool create_on_disk);
@@ -529,8 +546,9 @@ private:
 	std::string create_filename_of_special_operation(const char* dosname, const char* operation);
 	void convert_overlay_to_DOSname_in_base(char* dirname );
 	//For caching the update_cache routine.
-	std::vector<std::string> DOSnames_cache; //Also set is probably better.
+	std::unordered_set<std::string> DOSnames_cache;
 	std::vector<std::string> DOSdirs_cache; //Can not blindly change its type. it is important that subdirs come after the parent directory.
+	std::unordered_set<std::string> DOSdirs_index; //Same names as DOSdirs_cache, for lookups
 	const std::string special_prefix;
 };
 
@@ -6,11 +6,19 @@
 
 #include "dosbox.h"
 
-#include <functional>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 #include "config.h"
 
+/** A received Ethernet frame, as handed out by EthernetConnection::PeekPackets
+ */
+struct EthernetPacket {
+	const uint8_t *data = nullptr; /*!< The bytes of the Ethernet frame */
+	int size = 0;                  /*!< The size (in bytes) of the frame */
+};
+
 /** A virtual Ethernet connection
  * While emulated Ethernet adapters provide the ability for the guest OS to
  * send and receive Ethernet packets, the emulator itself needs to pass these
@@ -49,17 +57,26 @@ public:
 	 */
 	virtual void SendPacket(const uint8_t *packet, int size) = 0;
 
-	/** Gets all pending packets from the connection.
-	 * This function passes each pending packet to the callback function.
-	 * The callback provides a pointer to the bytes of an Ethernet frame,
-	 * and the size (in bytes) of the Ethernet frame.
-	 * Using a lambda for std::function allows easy looping over GetPackets
-	 * instead of jumping around between functions and sharing global state.
-	 * This function does not define the state of the packet data outside
-	 * the callback. Copy the packet data if you need to use it later.
-	 * @param callback The function called for each pending packet
+	/** Gets a batch of pending packets from the connection.
+	 * This function fills 'packets' with up to 'max_packets' of the
+	 * oldest pending packets, in the order they arrived. The packets
+	 * aren't copied: their data stays valid and unchanged until they're
+	 * released, so receivers can copy each frame straight to where it's
+	 * needed.
+	 * @param packets Where to store the pending packets
+	 * @param max_packets The maximum number of packets to return
+	 * @return The number of packets stored in 'packets'
+	 */
+	virtual size_t PeekPackets(EthernetPacket *packets, size_t max_packets) = 0;
+
+	/** Removes the oldest pending packets from the connection.
+	 * Call this after PeekPackets with the number of packets consumed.
+	 * Packets that aren't released are returned again by the next call
+	 * to PeekPackets, which lets a receiver that's out of room hold
+	 * them back until it can take them.
+	 * @param num_packets The number of peeked packets to remove
 	 */
-	virtual void GetPackets(std::function<int(const uint8_t *, int)> callback) = 0;
+	virtual void ReleasePackets(size_t num_packets) = 0;
 };
 
 /** Opens a virtual Ethernet connection to a backend.
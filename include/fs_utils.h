@@ -207,6 +207,12 @@ void close_native_file(const NativeFileHandle handle);
 // Sets the file size to be equal to the current file position
 bool truncate_native_file(const NativeFileHandle handle);
 
+// Copies the whole contents of 'src' to 'dst', which should be empty. Uses
+// the host's copy offloading (such as reflinks) where available, so large
+// files can be copied without reading them. The file positions are left at
+// the end of the copied data.
+bool copy_native_file(const NativeFileHandle src, const NativeFileHandle dst);
+
 DosDateTime get_dos_file_time(const NativeFileHandle handle);
 void set_dos_file_time(const NativeFileHandle handle, const uint16_t date, const uint16_t time);
 
@@ -121,7 +121,7 @@ public:
 	uint16_t getFragCount(void);
 
 	bool writeData();
-	void writeDataBuffer(uint8_t* buffer, uint16_t length);
+	void writeDataBuffer(const uint8_t* buffer, uint16_t length);
 
 	void getFragDesc(uint16_t descNum, fragmentDescriptor *fragDesc);
 	RealPt getESRAddr(void);
@@ -17,7 +17,7 @@ struct packetBuffer {
 	bool waitsize;
 };
 
-#define SOCKETTABLESIZE 16
+#define SOCKETTABLESIZE 64
 #define CONVIP(hostvar) hostvar & 0xff, (hostvar >> 8) & 0xff, (hostvar >> 16) & 0xff, (hostvar >> 24) & 0xff
 #define CONVIPX(hostvar) hostvar[0], hostvar[1], hostvar[2], hostvar[3], hostvar[4], hostvar[5]
 
@@ -28,6 +28,11 @@ bool IPX_isConnectedToServer(Bits tableNum, IPaddress ** ptrAddr);
 
 uint8_t packetCRC(uint8_t *buffer, uint16_t bufSize);
 
+// Registers the client that sent the given registration packet, and returns
+// the slot of a registered client, or -1 if there's none
+void registerClient(const UDPpacket &inPacket);
+int findConnection(uint32_t host, uint16_t port);
+
 #endif
 
 #endif
@@ -464,6 +464,10 @@ void MIXER_EnableFastForwardMode();
 void MIXER_DisableFastForwardMode();
 bool MIXER_FastForwardModeEnabled();
 
+// True when the main thread mixes the audio in emulated time for offline
+// rendering; channel callbacks must never block waiting on the main thread.
+bool MIXER_OfflineModeEnabled();
+
 const AudioFrame MIXER_GetMasterVolume();
 void MIXER_SetMasterVolume(const AudioFrame gain);
 
@@ -530,8 +534,20 @@ inline void MIXER_PullFromQueueCallback(const int frames_requested, DeviceType*
 	}
 	static std::vector<AudioType> to_mix = {};
 
-	const auto frames_received = check_cast<int>(
-	        device->output_queue.BulkDequeue(to_mix, frames_requested));
+	// In offline mode we're called on the main thread, which is also the
+	// producer, so only take what's already there
+	auto frames_to_dequeue = frames_requested;
+	if (MIXER_OfflineModeEnabled()) {
+		frames_to_dequeue = std::min(frames_requested,
+		                             check_cast<int>(
+		                                     device->output_queue.Size()));
+	}
+
+	const auto frames_received =
+	        frames_to_dequeue > 0
+	                ? check_cast<int>(device->output_queue.BulkDequeue(
+	                          to_mix, frames_to_dequeue))
+	                : 0;
 
 	if (frames_received > 0) {
 		if constexpr (std::is_same_v<AudioType, AudioFrame>) {
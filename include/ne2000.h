@@ -179,6 +179,13 @@ struct bx_ne2k_t {
 	int tx_timer_active = 0;
 };
 
+// What became of a frame offered to bx_ne2k_c::rx_frame()
+enum class Ne2kRxResult {
+	Received, // copied into the receive ring
+	Dropped,  // filtered out or not accepted in the current state
+	NoSpace,  // the receive ring is full, offer it again later
+};
+
 class bx_ne2k_c  {
 public:
   bx_ne2k_c(void);
@@ -215,7 +222,7 @@ public:
 
   //static void rx_handler(void *arg, const void *buf, unsigned len);
   BX_NE2K_SMF unsigned mcast_index(const void *dst);
-  BX_NE2K_SMF int rx_frame(const void *buf, unsigned bytes);
+  BX_NE2K_SMF Ne2kRxResult rx_frame(const void *buf, unsigned bytes);
 
   static uint32_t read_handler(void *this_ptr, io_port_t address, io_width_t io_len);
   static void   write_handler(void *this_ptr, io_port_t address, io_val_t value, io_width_t io_len);
@@ -73,4 +73,5 @@ void PIC_RemoveEvents(PIC_EventHandler handler);
 void PIC_RemoveSpecificEvents(PIC_EventHandler handler, uint32_t val);
 
 void PIC_SetIRQMask(uint32_t irq, bool masked);
+bool PIC_IsIRQMasked(uint32_t irq);
 #endif
@@ -88,7 +88,10 @@ struct RenderPal_t {
 
 struct Render {
 	ImageInfo src = {};
-	uint32_t src_start   = 0;
+
+	// Size of a source line and its pixels in bytes
+	uint32_t src_line_bytes  = 0;
+	uint32_t src_pixel_bytes = 0;
 
 	// Frames per second
 	double fps = 0;
@@ -113,6 +116,10 @@ struct Render {
 		uint32_t inHeight   = 0;
 		uint32_t inLine     = 0;
 		uint32_t outLine    = 0;
+
+		// Number of pixels at the start of the next line that are
+		// known to be unchanged, so the scaler can skip them
+		uint32_t skipPixels = 0;
 	} scale = {};
 
 	RenderPal_t pal = {};
@@ -10,6 +10,7 @@
 #include <optional>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #if C_OPENGL
 #include <SDL_opengl.h>
@@ -299,8 +300,19 @@ struct SDL_Block {
 		SDL_PixelFormat* pixelFormat = nullptr;
 
 		InterpolationMode interpolation_mode = InterpolationMode::Bilinear;
+
+		// Set when changed lines have been uploaded to the texture, or
+		// the texture or viewport has changed, since the last present
+		bool has_new_frame = false;
 	} texture = {};
 
+	struct {
+		// The rendered frame in 32-bit XRGB format; it's never shown
+		// but the rendered image captures are taken from it
+		std::vector<uint32_t> framebuf = {};
+		int pitch                      = 0;
+	} headless = {};
+
 	struct {
 		present_frame_f* present      = present_frame_noop;
 		update_frame_buffer_f* update = update_frame_noop;
@@ -0,0 +1,201 @@
+// SPDX-FileCopyrightText:  2025-2025 The DOSBox Staging Team
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef DOSBOX_SPSC_QUEUE_H
+#define DOSBOX_SPSC_QUEUE_H
+
+/*  SPSC (Single-Producer/Single-Consumer) Queue
+ *  --------------------------------------------
+ *  A fixed-size, lock-free, wait-free queue for handing items from exactly
+ *  one producer thread to exactly one consumer thread. Neither side ever
+ *  blocks: pushing into a full queue or popping from an empty queue simply
+ *  fails and the caller decides what to do.
+ *
+ *  Unlike the RWQueue, the SPSC queue never takes a mutex, so it's safe to use
+ *  on hot paths such as IO port write handlers where the emulation thread
+ *  must not contend with the mixer thread.
+ *
+ *  The capacity must be a power of two. The read and write indices are kept
+ *  on separate cache lines to avoid false sharing between the two threads.
+ */
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <optional>
+
+template <typename T, size_t Capacity>
+class SpscQueue {
+	static_assert(std::has_single_bit(Capacity),
+	              "SpscQueue capacity must be power of two");
+
+	static constexpr size_t IndexMask     = Capacity - 1;
+	static constexpr size_t CacheLineSize = 64;
+
+public:
+	SpscQueue()                            = default;
+	SpscQueue(const SpscQueue&)            = delete;
+	SpscQueue& operator=(const SpscQueue&) = delete;
+
+	// Producer side. Returns false (and doesn't queue the item) if the
+	// queue is full.
+	bool Push(const T& item)
+	{
+		const auto write = write_index.load(std::memory_order_relaxed);
+		const auto read  = read_index.load(std::memory_order_acquire);
+
+		if (write - read == Capacity) {
+			return false;
+		}
+		items[write & IndexMask] = item;
+		write_index.store(write + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer side. Returns a pointer to the oldest item without removing
+	// it, or nullptr if the queue is empty. The pointer stays valid until
+	// the next Pop().
+	const T* Front() const
+	{
+		const auto read  = read_index.load(std::memory_order_relaxed);
+		const auto write = write_index.load(std::memory_order_acquire);
+
+		if (read == write) {
+			return nullptr;
+		}
+		return &items[read & IndexMask];
+	}
+
+	// Consumer side. Returns a pointer to the item 'offset' places after the
+	// oldest one without removing anything, or nullptr if the queue doesn't
+	// hold that many items. Lets the consumer work through a batch of items
+	// in place before releasing them with Pop(num_items).
+	const T* Peek(const size_t offset) const
+	{
+		const auto read  = read_index.load(std::memory_order_relaxed);
+		const auto write = write_index.load(std::memory_order_acquire);
+
+		if (write - read <= offset) {
+			return nullptr;
+		}
+		return &items[(read + offset) & IndexMask];
+	}
+
+	// Consumer side. Removes the oldest item; the queue must not be empty.
+	void Pop()
+	{
+		Pop(1);
+	}
+
+	// Consumer side. Removes the 'num_items' oldest items; the queue must
+	// hold at least that many.
+	void Pop(const size_t num_items)
+	{
+		const auto read = read_index.load(std::memory_order_relaxed);
+		read_index.store(read + num_items, std::memory_order_release);
+	}
+
+	// Consumer side. Removes and returns the oldest item, if any.
+	std::optional<T> TryPop()
+	{
+		const auto item = Front();
+		if (!item) {
+			return {};
+		}
+		std::optional<T> result = *item;
+		Pop();
+		return result;
+	}
+
+	// Safe to call from either side, but the result is only a snapshot.
+	size_t Size() const
+	{
+		const auto write = write_index.load(std::memory_order_acquire);
+		const auto read  = read_index.load(std::memory_order_acquire);
+		return write - read;
+	}
+
+	bool IsEmpty() const
+	{
+		return Size() == 0;
+	}
+
+	static constexpr size_t MaxCapacity()
+	{
+		return Capacity;
+	}
+
+private:
+	std::array<T, Capacity> items = {};
+
+	alignas(CacheLineSize) std::atomic<size_t> write_index = 0;
+	alignas(CacheLineSize) std::atomic<size_t> read_index  = 0;
+};
+
+/*  Timed Write Queue
+ *  -----------------
+ *  Sound devices that render on the mixer thread use this to receive the
+ *  register writes made by the emulation thread. Each write is tagged with
+ *  the emulated time it happened at (PIC_FullIndex), and the renderer applies
+ *  the writes in between generating frames, so they take effect on the
+ *  sample matching their emulated time.
+ *
+ *  The Write type must provide a `double timestamp_ms` member.
+ */
+template <typename Write, size_t Capacity>
+class TimedWriteQueue {
+public:
+	// Emulation thread. Returns false if the write had to be dropped
+	// because the mixer thread hasn't kept up.
+	bool Push(const Write& write)
+	{
+		if (queue.Push(write)) {
+			return true;
+		}
+		++num_dropped;
+		return false;
+	}
+
+	// Mixer thread. Applies all writes that happened at or before the
+	// given emulated time, in order.
+	template <typename ApplyFunc>
+	void ApplyUpTo(const double timestamp_ms, ApplyFunc&& apply)
+	{
+		while (const auto write = queue.Front()) {
+			if (write->timestamp_ms > timestamp_ms) {
+				break;
+			}
+			apply(*write);
+			queue.Pop();
+		}
+	}
+
+	// Mixer thread. Applies all queued writes regardless of their time.
+	template <typename ApplyFunc>
+	void ApplyAll(ApplyFunc&& apply)
+	{
+		while (const auto write = queue.Front()) {
+			apply(*write);
+			queue.Pop();
+		}
+	}
+
+	size_t Size() const
+	{
+		return queue.Size();
+	}
+
+	// Emulation thread
+	int GetNumDropped() const
+	{
+		return num_dropped;
+	}
+
+private:
+	SpscQueue<Write, Capacity> queue = {};
+
+	int num_dropped = 0;
+};
+
+#endif // DOSBOX_SPSC_QUEUE_H
@@ -259,8 +259,16 @@ struct VgaDraw {
 	uint32_t parts_left     = 0;
 	Bitu byte_panning_shift = 0;
 
+	// If true, the parts of a frame are all drawn in one go at the end of
+	// the active display period, instead of one PIC event per part. The
+	// first register write that changes the picture mid-frame falls back
+	// to drawing the rest of that frame part by part.
+	bool render_whole_frames = false;
+	bool is_frame_deferred   = false;
+
 	struct {
 		double framestart = 0;
+		double drawstart  = 0; // When the first part would be drawn
 		double vrstart = 0, vrend = 0;     // V-retrace
 		double hrstart = 0, hrend = 0;     // H-retrace
 		double hblkstart = 0, hblkend = 0; // H-blanking
@@ -1158,6 +1166,26 @@ void VGA_SetCGA4Table(uint8_t val0, uint8_t val1, uint8_t val2, uint8_t val3);
 PixelFormat VGA_ActivateHardwareCursor();
 void VGA_KillDrawing(void);
 
+// Call before a register write that changes the picture. If the current
+// frame is being drawn in one go at its end, this draws the lines the beam
+// has already passed, and draws the rest of the frame part by part.
+void VGA_CatchUpDrawing();
+
+// Whether writing 'val' to the attribute controller, or to the selected
+// CRTC, graphics controller or sequencer register, changes the picture, so
+// the frame needs catching up first
+bool attr_write_changes_picture(const uint8_t val);
+bool crtc_write_changes_picture(const uint8_t val);
+bool gfx_write_changes_picture(const uint8_t val);
+bool seq_write_changes_picture(const uint8_t val);
+
+void vga_write_p3d5(io_port_t port, io_val_t value, io_width_t width);
+uint8_t vga_read_p3d5(io_port_t port, io_width_t width);
+
+void write_p3c5(io_port_t port, io_val_t value, io_width_t width);
+uint8_t read_p3c5(io_port_t port, io_width_t width);
+void write_p3cf(io_port_t port, io_val_t value, io_width_t width);
+
 void VGA_SetOverride(const bool vga_override, const double override_refresh_hz = 0);
 void VGA_LogInitialization(const char* adapter_name, const char* ram_type,
                            const size_t num_modes);
@@ -54,7 +54,10 @@
 
 enum class RenderingBackend {
 	Texture,
-	OpenGl
+	OpenGl,
+
+	// Renders into memory only, for running without a display
+	Headless
 };
 
 typedef enum {
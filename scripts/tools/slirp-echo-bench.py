@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+
+# SPDX-FileCopyrightText:  2025-2025 The DOSBox Staging Team
+# SPDX-License-Identifier: MIT
+
+"""
+Measure TCP round-trip latency and throughput through the slirp backend.
+
+Run a TCP echo server in the guest (any DOS packet driver program that
+sends back what it receives), forward a host port to it, then point this
+script at the forwarded port. For example, with the guest echoing on
+port 7:
+
+    [ethernet]
+    ne2000            = on
+    tcp_port_forwards = 7777:7
+
+    $ ./scripts/tools/slirp-echo-bench.py --port 7777
+
+Run it against builds before and after a change to compare them.
+"""
+
+# pylint: disable=invalid-name
+# pylint: disable=missing-docstring
+
+import argparse
+import socket
+import statistics
+import sys
+import threading
+import time
+
+
+def recv_exactly(sock, num_bytes):
+    data = bytearray()
+    while len(data) < num_bytes:
+        chunk = sock.recv(num_bytes - len(data))
+        if not chunk:
+            raise ConnectionError("connection closed by the guest")
+        data += chunk
+    return bytes(data)
+
+
+def measure_latency(sock, num_pings, size):
+    payload = bytes(i & 0xff for i in range(size))
+    rtts_ms = []
+
+    for _ in range(num_pings):
+        start = time.perf_counter()
+        sock.sendall(payload)
+        if recv_exactly(sock, size) != payload:
+            raise ValueError("echoed data doesn't match")
+        rtts_ms.append((time.perf_counter() - start) * 1000)
+
+    rtts_ms.sort()
+    p95 = rtts_ms[min(len(rtts_ms) - 1, int(len(rtts_ms) * 0.95))]
+
+    print(f"latency: {num_pings} x {size} bytes, "
+          f"min {rtts_ms[0]:.2f} ms, median {statistics.median(rtts_ms):.2f} ms, "
+          f"p95 {p95:.2f} ms, max {rtts_ms[-1]:.2f} ms")
+
+
+def measure_throughput(sock, total_bytes, chunk_size):
+    chunk = bytes(i & 0xff for i in range(chunk_size))
+    received = 0
+
+    def receive():
+        nonlocal received
+        while received < total_bytes:
+            data = sock.recv(65536)
+            if not data:
+                return
+            received += len(data)
+
+    receiver = threading.Thread(target=receive)
+    start = time.perf_counter()
+    receiver.start()
+
+    sent = 0
+    while sent < total_bytes:
+        num_bytes = min(chunk_size, total_bytes - sent)
+        sock.sendall(chunk[:num_bytes])
+        sent += num_bytes
+
+    receiver.join()
+    elapsed = time.perf_counter() - start
+
+    if received < total_bytes:
+        raise ConnectionError(f"only {received} of {total_bytes} bytes echoed")
+
+    print(f"throughput: {total_bytes // 1024} KB echoed in {elapsed:.2f} s, "
+          f"{total_bytes / 1024 / elapsed:.1f} KB/s each way")
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+
+    parser.add_argument("--host", default="127.0.0.1",
+                        help="host the guest's echo port is forwarded to (default: %(default)s)")
+    parser.add_argument("--port", type=int, required=True,
+                        help="forwarded host port of the guest's echo server")
+    parser.add_argument("--pings", type=int, default=200,
+                        help="number of round trips to time (default: %(default)s)")
+    parser.add_argument("--ping-size", type=int, default=32,
+                        help="bytes per round trip (default: %(default)s)")
+    parser.add_argument("--kbytes", type=int, default=1024,
+                        help="kilobytes to echo for the throughput test (default: %(default)s)")
+
+    return parser.parse_args()
+
+
+def main():
+    args = parse_args()
+
+    with socket.create_connection((args.host, args.port), timeout=30) as sock:
+        sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+
+        measure_latency(sock, args.pings, args.ping_size)
+        measure_throughput(sock, args.kbytes * 1024, 1460)
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -36,15 +36,19 @@ static struct {
 	} state = {};
 
 	struct {
-		int32_t audio              = 1;
-		int32_t midi               = 1;
-		int32_t raw_opl_stream     = 1;
-		int32_t rad_opl_instrument = 1;
-		int32_t video              = 1;
-		int32_t image              = 1;
-		int32_t serial_log         = 1;
+		int32_t audio                  = 1;
+		int32_t midi                   = 1;
+		int32_t raw_opl_stream         = 1;
+		int32_t rad_opl_instrument     = 1;
+		int32_t video                  = 1;
+		int32_t image                  = 1;
+		int32_t serial_log             = 1;
+		int32_t voodoo_register_stream = 1;
 	} next_index = {};
 
+	// Set once at startup; survives capture section restarts
+	OfflineRender offline_render = OfflineRender::Off;
+
 	void reset()
 	{
 		path.clear();
@@ -89,6 +93,11 @@ bool CAPTURE_IsCapturingVideo()
 	return capture.state.video != CaptureState::Off;
 }
 
+bool CAPTURE_IsOfflineRendering()
+{
+	return capture.offline_render != OfflineRender::Off;
+}
+
 static const char* capture_type_to_string(const CaptureType type)
 {
 	switch (type) {
@@ -105,6 +114,8 @@ static const char* capture_type_to_string(const CaptureType type)
 
 	case CaptureType::SerialLog: return "serial log";
 
+	case CaptureType::VoodooRegisterStream: return "Voodoo register stream";
+
 	default: assertm(false, "Unknown CaptureType"); return "";
 	}
 }
@@ -125,6 +136,8 @@ static const char* capture_type_to_basename(const CaptureType type)
 
 	case CaptureType::SerialLog: return "serial";
 
+	case CaptureType::VoodooRegisterStream: return "voodoo";
+
 	default: assertm(false, "Unknown CaptureType"); return "";
 	}
 }
@@ -145,6 +158,8 @@ static const char* capture_type_to_extension(const CaptureType type)
 
 	case CaptureType::SerialLog: return ".serlog";
 
+	case CaptureType::VoodooRegisterStream: return ".vrs";
+
 	default: assertm(false, "Unknown CaptureType"); return "";
 	}
 }
@@ -239,6 +254,10 @@ static void set_next_capture_index(const CaptureType type, int32_t index)
 		capture.next_index.serial_log = index;
 		break;
 
+	case CaptureType::VoodooRegisterStream:
+		capture.next_index.voodoo_register_stream = index;
+		break;
+
 	default: assertm(false, "Unknown CaptureType");
 	}
 }
@@ -263,7 +282,8 @@ static bool maybe_create_capture_dir_and_init_capture_indices()
 	                                             CaptureType::RawImage,
 	                                             CaptureType::UpscaledImage,
 	                                             CaptureType::RenderedImage,
-	                                             CaptureType::SerialLog};
+	                                             CaptureType::SerialLog,
+	                                             CaptureType::VoodooRegisterStream};
 
 	for (auto type : all_capture_types) {
 		const auto index = find_highest_capture_index(type);
@@ -303,6 +323,9 @@ int32_t get_next_capture_index(const CaptureType type)
 
 	case CaptureType::SerialLog: return capture.next_index.serial_log++;
 
+	case CaptureType::VoodooRegisterStream:
+		return capture.next_index.voodoo_register_stream++;
+
 	default: assertm(false, "Unknown CaptureType"); return 0;
 	}
 }
@@ -597,6 +620,31 @@ static void capture_init(Section* sec)
 
 	image_capturer = std::make_unique<ImageCapturer>(prefs);
 
+	capture_video_set_compression(secprop->GetString("video_compression"));
+
+	// Offline rendering can only be enabled at startup, and it kicks off
+	// the requested capture right away so batch jobs need no interaction
+	static bool offline_render_initialised = false;
+	if (!offline_render_initialised) {
+		offline_render_initialised = true;
+
+		const auto offline_pref = secprop->GetString("offline_render");
+		if (offline_pref == "audio") {
+			capture.offline_render = OfflineRender::Audio;
+			handle_capture_audio_event(true);
+
+		} else if (offline_pref == "video") {
+			capture.offline_render = OfflineRender::Video;
+			CAPTURE_StartVideoCapture();
+		}
+
+		if (capture.offline_render != OfflineRender::Off) {
+			LOG_MSG("CAPTURE: Offline rendering enabled; capturing %s output "
+			        "in emulated time",
+			        offline_pref.c_str());
+		}
+	}
+
 	constexpr auto changeable_at_runtime = true;
 	sec->AddDestroyFunction(&capture_destroy, changeable_at_runtime);
 }
@@ -682,6 +730,35 @@ static void init_capture_dosbox_settings(SectionProp& secprop)
 	        "Keybindings for taking single screenshots in specific formats are also\n"
 	        "available.");
 	assert(str_prop);
+
+	str_prop = secprop.AddString("video_compression", when_idle, "balanced");
+	str_prop->SetValues({"fast", "balanced", "best"});
+	str_prop->SetHelp(
+	        "Set the compression of the lossless ZMBV video captures ('balanced' by\n"
+	        "default):\n"
+	        "  fast:      Fastest encoding at the cost of larger files. Use this for long\n"
+	        "             captures on slower hosts.\n"
+	        "  balanced:  Good compression at a moderate encoding speed.\n"
+	        "  best:      Smallest files, but encoding takes about 3 times as long.\n"
+	        "All settings produce standard ZMBV files; the image quality is identical.");
+	assert(str_prop);
+
+	str_prop = secprop.AddString("offline_render",
+	                             Property::Changeable::OnlyAtStart,
+	                             "off");
+	str_prop->SetValues({"off", "audio", "video"});
+	str_prop->SetHelp(
+	        "Render the audio or video output to a file faster than real time ('off' by\n"
+	        "default). Meant for unattended batch captures:\n"
+	        "  off:    Normal real-time operation.\n"
+	        "  audio:  Start capturing the audio output to a WAV file at startup.\n"
+	        "  video:  Start capturing the video and audio output to an AVI file at\n"
+	        "          startup.\n"
+	        "In offline mode the emulation runs unthrottled, no sound is played on the\n"
+	        "host, and audio is mixed in emulated time on the emulation thread, so the\n"
+	        "captured output does not depend on the speed of the host. Use a fixed\n"
+	        "'cycles' setting to get identical captures across runs.");
+	assert(str_prop);
 }
 
 void CAPTURE_AddConfigSection(const ConfigPtr& conf)
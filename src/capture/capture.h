@@ -21,11 +21,14 @@ enum class CaptureType {
 	RawImage,
 	UpscaledImage,
 	RenderedImage,
-	SerialLog
+	SerialLog,
+	VoodooRegisterStream
 };
 
 enum class CaptureState { Off, Pending, InProgress };
 
+enum class OfflineRender { Off, Audio, Video };
+
 void CAPTURE_AddConfigSection(const ConfigPtr& conf);
 
 // TODO move raw OPL and serial log capture into the capture module too
@@ -58,6 +61,11 @@ bool CAPTURE_IsCapturingPostRenderImage();
 bool CAPTURE_IsCapturingMidi();
 bool CAPTURE_IsCapturingVideo();
 
+// In offline rendering mode the emulation runs unthrottled and the mixer is
+// driven by emulated time instead of the host audio device, so captures are
+// identical regardless of host speed.
+bool CAPTURE_IsOfflineRendering();
+
 // Only used internally in the capture module
 int32_t get_next_capture_index(const CaptureType type);
 
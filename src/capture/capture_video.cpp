@@ -3,13 +3,16 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 
 #include "capture.h"
+#include "capture_video.h"
 
 #include <cassert>
 #include <cmath>
+#include <thread>
 
 #include "math_utils.h"
 #include "mem.h"
 #include "render.h"
+#include "rwqueue.h"
 #include "support.h"
 
 #include "zmbv/zmbv.h"
@@ -21,6 +24,13 @@ static constexpr auto NumAudioChannels = 2;
 
 static constexpr auto AviHeaderSize = 500;
 
+// Number of frames the emulation can get ahead of the encoder before it has
+// to wait. Only a slow host that can't keep up with encoding in the long
+// run will ever fill this up.
+static constexpr auto MaxQueuedFrames = 8;
+
+// The AVI file, the codec and everything else below, except the audio
+// buffer, are owned by the encoder thread while a capture is in progress.
 static struct {
 	FILE* handle = nullptr;
 
@@ -44,6 +54,16 @@ static struct {
 		uint32_t buf_frames_used = 0;
 		uint32_t bytes_written   = 0;
 	} audio = {};
+
+	// Set from the config; applied when the next capture file is created
+	ZMBV_COMPRESSION compression = ZMBV_COMPRESSION::BALANCED;
+
+	std::thread encoder = {};
+
+	RWQueue<VideoFrameTask> frame_queue{MaxQueuedFrames};
+
+	// Recycled tasks with their buffers already allocated
+	RWQueue<VideoFrameTask> free_frames{MaxQueuedFrames + 1};
 } video = {};
 
 static ZMBV_FORMAT to_zmbv_format(const PixelFormat format)
@@ -119,11 +139,24 @@ static void add_avi_chunk(const char* tag, const uint32_t size,
 	host_writed(index + 12, size);
 }
 
+static void stop_encoder()
+{
+	// Let the encoder finish the pending frames
+	video.frame_queue.Stop();
+
+	if (video.encoder.joinable()) {
+		video.encoder.join();
+	}
+	video.frame_queue.Start();
+}
+
 void capture_video_finalise()
 {
 	if (!video.handle) {
 		return;
 	}
+	stop_encoder();
+
 	if (video.codec) {
 		video.codec->FinishVideo();
 	}
@@ -304,6 +337,19 @@ void capture_video_add_audio_data(const uint32_t sample_rate,
 	video.audio.sample_rate = sample_rate;
 }
 
+void capture_video_set_compression(const std::string& compression_pref)
+{
+	if (compression_pref == "fast") {
+		video.compression = ZMBV_COMPRESSION::FAST;
+	} else if (compression_pref == "best") {
+		video.compression = ZMBV_COMPRESSION::BEST;
+	} else {
+		video.compression = ZMBV_COMPRESSION::BALANCED;
+	}
+}
+
+static void encode_queued_frames();
+
 static void create_avi_file(const uint16_t width, const uint16_t height,
                             const PixelFormat pixel_format,
                             const float frames_per_second, ZMBV_FORMAT format)
@@ -313,7 +359,13 @@ static void create_avi_file(const uint16_t width, const uint16_t height,
 		return;
 	}
 	video.codec = new VideoCodec();
-	if (!video.codec->SetupCompress(width, height)) {
+	if (!video.codec->SetupCompress(width, height, video.compression)) {
+		// Without an encoder thread the frame queue would never drain
+		fclose(video.handle);
+		video.handle = nullptr;
+
+		delete video.codec;
+		video.codec = nullptr;
 		return;
 	}
 
@@ -336,13 +388,16 @@ static void create_avi_file(const uint16_t width, const uint16_t height,
 	video.written               = 0;
 	video.audio.buf_frames_used = 0;
 	video.audio.bytes_written   = 0;
+
+	video.encoder = std::thread(encode_queued_frames);
+	set_thread_name(video.encoder, "dosbox:vidcap");
 }
 
 // Performs some transforms on the passed down rendered image to make sure
-// we're capturing the raw output, then passes the result in the same
-// byte-order to the encoder. Endianness varies per pixel format (see
-// PixelFormat in video.h for details); the ZMBV encoder handles all that
-// detail.
+// we're capturing the raw output, then copies the result in the same
+// byte-order into the task's frame buffer for the encoder. Endianness varies
+// per pixel format (see PixelFormat in video.h for details); the ZMBV encoder
+// handles all that detail.
 //
 // We always write non-double-scanned and non-pixel-doubled frames in raw
 // video capture mode :
@@ -362,7 +417,7 @@ static void create_avi_file(const uint16_t width, const uint16_t height,
 // artifacts (so 320x200 is rendered as 640x200, and 640x200 as 1280x200).
 // These are written as-is, otherwise we'd be losing information.
 //
-static void compress_raw_frame(const RenderedImage& image)
+static void copy_raw_frame(const RenderedImage& image, VideoFrameTask& task)
 {
 	const auto& src = image.params;
 	auto src_row    = image.image_data;
@@ -378,47 +433,97 @@ static void compress_raw_frame(const RenderedImage& image)
 
 	const auto pixel_skip_count = (src.rendered_pixel_doubling ? 1 : 0);
 
-	auto compress_row = [&](const uint8_t* row_buffer) {
-		video.codec->CompressLines(1, &row_buffer);
-	};
-
 	const auto src_bpp = to_bytes_per_pixel(src.pixel_format);
 	const auto dest_bpp = to_bytes_per_pixel(to_zmbv_format(src.pixel_format));
 
-	// Maybe compress the source rows straight away without copying. Note
-	// that this is a shortcut scenario; hard-code it to false to exercise
-	// the rote version below.
+	task.pixel_format = src.pixel_format;
+	task.row_bytes    = raw_width * dest_bpp;
+
+	// Only grows; the buffer is reused across frames
+	const auto frame_bytes = check_cast<size_t>(task.row_bytes * raw_height);
+	if (task.pixels.size() < frame_bytes) {
+		task.pixels.resize(frame_bytes);
+	}
+	auto dest_row = task.pixels.data();
+
+	// Maybe copy the source rows straight away. Note that this is a
+	// shortcut scenario; hard-code it to false to exercise the rote
+	// version below.
 
 	const auto can_use_src_directly = (src_bpp == dest_bpp &&
 	                                   pixel_skip_count == 0);
 	if (can_use_src_directly) {
 		for (auto i = 0; i < raw_height; ++i, src_row += src_pitch) {
-			compress_row(src_row);
+			std::memcpy(dest_row, src_row, task.row_bytes);
+			dest_row += task.row_bytes;
 		}
 		return;
 	}
 
-	// Otherwise we need to arrange the source bytes before compressing
+	// Otherwise we need to arrange the source bytes
 	assert(!can_use_src_directly);
 
-	// Grow the target row buffer if needed
-	const auto dest_row_bytes = check_cast<uint16_t>(src.width * dest_bpp);
-	static std::vector<uint8_t> dest_row = {};
-	if (dest_row.size() < dest_row_bytes) {
-		dest_row.resize(dest_row_bytes, 0);
-	}
-
 	const auto src_advance = src_bpp * (pixel_skip_count + 1);
 
 	for (auto i = 0; i < raw_height; ++i, src_row += src_pitch) {
 		auto src_pixel  = src_row;
-		auto dest_pixel = dest_row.data();
+		auto dest_pixel = dest_row;
 
 		for (auto j = 0; j < raw_width; ++j, src_pixel += src_advance) {
 			std::memcpy(dest_pixel, src_pixel, src_bpp);
 			dest_pixel += dest_bpp;
 		}
-		compress_row(dest_row.data());
+		dest_row += task.row_bytes;
+	}
+}
+
+// Runs on the encoder thread
+static void encode_frame(const VideoFrameTask& task)
+{
+	const auto codec_flags = (video.frames % 300 == 0) ? 1 : 0;
+
+	if (!video.codec->PrepareCompressFrame(codec_flags,
+	                                       to_zmbv_format(task.pixel_format),
+	                                       task.has_palette ? task.palette.data()
+	                                                        : nullptr,
+	                                       video.buf.data(),
+	                                       video.buf_size)) {
+		return;
+	}
+
+	auto row = task.pixels.data();
+	for (auto i = 0; i < video.height; ++i, row += task.row_bytes) {
+		const uint8_t* row_buffer = row;
+		video.codec->CompressLines(1, &row_buffer);
+	}
+
+	const auto written = video.codec->FinishCompressFrame();
+	if (written < 0) {
+		return;
+	}
+
+	add_avi_chunk("00dc", written, video.buf.data(), codec_flags & 1 ? 0x10 : 0x0);
+	video.frames++;
+
+	//		LOG_MSG("CAPTURE: Frame %d video %d audio
+	//%d",video.frames, written, video.audio_buf_frames_used *4 );
+	if (!task.audio.empty()) {
+		const auto audio_bytes = check_cast<uint32_t>(
+		        task.audio.size() * sizeof(int16_t));
+
+		add_avi_chunk("01wb", audio_bytes, task.audio.data(), 0);
+
+		video.audio.bytes_written = audio_bytes;
+	}
+}
+
+static void encode_queued_frames()
+{
+	while (auto task = video.frame_queue.Dequeue()) {
+		encode_frame(*task);
+
+		// Hand the buffers back for reuse; drop them if the pool is full
+		video.free_frames.NonblockingEnqueue(std::move(*task));
 	}
 }
 
@@ -457,36 +562,24 @@ void capture_video_add_frame(const RenderedImage& image, const float frames_per_
 		return;
 	}
 
-	const auto codec_flags = (video.frames % 300 == 0) ? 1 : 0;
-
-	if (!video.codec->PrepareCompressFrame(codec_flags,
-	                                       zmbv_format,
-	                                       image.palette_data,
-	                                       video.buf.data(),
-	                                       video.buf_size)) {
-		return;
+	// Only the emulation thread takes tasks from the pool, so it can't
+	// become empty between the check and the dequeue
+	VideoFrameTask task = {};
+	if (!video.free_frames.IsEmpty()) {
+		task = std::move(*video.free_frames.Dequeue());
 	}
 
-	compress_raw_frame(image);
+	copy_raw_frame(image, task);
 
-	const auto written = video.codec->FinishCompressFrame();
-	if (written < 0) {
-		return;
+	task.has_palette = (image.palette_data != nullptr);
+	if (task.has_palette) {
+		std::memcpy(task.palette.data(), image.palette_data, task.palette.size());
 	}
 
-	add_avi_chunk("00dc", written, video.buf.data(), codec_flags & 1 ? 0x10 : 0x0);
-	video.frames++;
+	const auto num_samples = video.audio.buf_frames_used * NumAudioChannels;
+	task.audio.assign(&video.audio.buf[0][0], &video.audio.buf[0][0] + num_samples);
+	video.audio.buf_frames_used = 0;
 
-	//		LOG_MSG("CAPTURE: Frame %d video %d audio
-	//%d",video.frames, written, video.audio_buf_frames_used *4 );
-	if (video.audio.buf_frames_used) {
-		add_avi_chunk("01wb",
-		              video.audio.buf_frames_used * SampleFrameSize,
-		              video.audio.buf,
-		              0);
-
-		video.audio.bytes_written = video.audio.buf_frames_used *
-		                            SampleFrameSize;
-		video.audio.buf_frames_used = 0;
-	}
+	// Blocks only if the encoder is too far behind
+	video.frame_queue.Enqueue(std::move(task));
 }
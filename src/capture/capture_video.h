@@ -5,8 +5,31 @@
 #ifndef DOSBOX_CAPTURE_VIDEO_H
 #define DOSBOX_CAPTURE_VIDEO_H
 
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
 #include "render.h"
 
+// A raw video frame and the audio captured since the previous frame, copied
+// out of the render buffers so the encoder thread can compress them while
+// the emulation carries on. Tasks are recycled to avoid reallocating the
+// buffers on every frame.
+struct VideoFrameTask {
+	PixelFormat pixel_format = {};
+
+	// Tightly packed rows of the raw (non-doubled) image
+	std::vector<uint8_t> pixels = {};
+	int row_bytes               = 0;
+
+	std::array<uint8_t, 256 * 4> palette = {};
+	bool has_palette                     = false;
+
+	// Interleaved 16-bit stereo samples
+	std::vector<int16_t> audio = {};
+};
+
 void capture_video_add_frame(const RenderedImage& image,
                              const float frames_per_second);
 
@@ -16,4 +39,7 @@ void capture_video_add_audio_data(const uint32_t sample_rate,
 
 void capture_video_finalise();
 
+// Takes effect from the next video capture file
+void capture_video_set_compression(const std::string& compression_pref);
+
 #endif
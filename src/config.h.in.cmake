@@ -143,6 +143,9 @@
 // Defined if function mmap is available
 #cmakedefine HAVE_MMAP
 
+// Defined if function copy_file_range is available
+#cmakedefine HAVE_COPY_FILE_RANGE
+
 // Defined if mmap flag MAPJIT is available
 #cmakedefine HAVE_MAP_JIT
 
@@ -178,6 +181,7 @@
 #cmakedefine HAVE_SYS_SOCKET_H
 #cmakedefine HAVE_SYS_TYPES_H
 #cmakedefine HAVE_SYS_XATTR_H
+#cmakedefine HAVE_SYS_INOTIFY_H
 
 
 // Hardware-related defines
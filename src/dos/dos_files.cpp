@@ -171,6 +171,17 @@ static bool file_is_locked(const char *file_name, const uint8_t drive, const uin
 	return false;
 }
 
+// Other handles may still hold back data written to a file, which has to
+// reach the host file before it's opened, created, renamed or deleted
+static void flush_handles_to(const char* file_name, const uint8_t drive)
+{
+	for (const auto& file : Files) {
+		if (file && file->GetDrive() == drive && file->IsName(file_name)) {
+			file->FlushHeldBackWrites();
+		}
+	}
+}
+
 static bool regions_overlap(const uint32_t pos1, const uint32_t len1, const uint32_t pos2, const uint32_t len2)
 {
 	return !((pos1 >= pos2 + len2) || (pos1 + len1 <= pos2));
@@ -558,6 +569,9 @@ bool DOS_Rename(const char* const oldname, const char* const newname)
 		return false;
 	}
 
+	flush_handles_to(fullold, driveold);
+	flush_handles_to(fullnew, drivenew);
+
 	if (new_ptr->Rename(fullold, fullnew)) {
 		return true;
 	}
@@ -732,6 +746,8 @@ bool DOS_CloseFile(uint16_t entry, bool fcb, uint8_t * refcnt) {
 		DOS_SetError(DOSERR_INVALID_HANDLE);
 		return false;
 	};
+	// Data written earlier may have failed to reach the disk
+	const bool is_flushed = Files[handle]->Flush();
 	Files[handle]->Close();
 
 	if (!fcb) {
@@ -745,6 +761,10 @@ bool DOS_CloseFile(uint16_t entry, bool fcb, uint8_t * refcnt) {
 		refs=0;
 	}
 	if (refcnt!=nullptr) *refcnt=static_cast<uint8_t>(refs+1);
+	if (!is_flushed) {
+		DOS_SetError(DOSERR_ACCESS_DENIED);
+		return false;
+	}
 	return true;
 }
 
@@ -759,6 +779,10 @@ bool DOS_FlushFile(uint16_t entry) {
 		return false;
 	};
 	LOG(LOG_DOSMISC,LOG_NORMAL)("FFlush used.");
+	if (!Files[handle]->Flush()) {
+		DOS_SetError(DOSERR_ACCESS_DENIED);
+		return false;
+	}
 	return true;
 }
 
@@ -808,6 +832,8 @@ bool DOS_CreateFile(const char* name, FatAttributeFlags attributes,
 		DOS_SetError(DOSERR_ACCESS_DENIED);
 		return false;
 	}
+	flush_handles_to(fullname, drive);
+
 	Files[handle] = Drives.at(drive)->FileCreate(fullname, attributes);
 	if (Files[handle]) {
 		Files[handle]->SetDrive(drive);
@@ -873,6 +899,8 @@ bool DOS_OpenFile(const char* name, uint8_t flags, uint16_t* entry, bool fcb)
 			DOS_SetError(DOSERR_ACCESS_DENIED);
 			return false;
 		}
+		flush_handles_to(fullname, drive);
+
 		const auto old_errorcode = dos.errorcode;
 		dos.errorcode = 0;
 		Files[handle] = Drives.at(drive)->FileOpen(fullname, flags);
@@ -976,6 +1004,8 @@ bool DOS_UnlinkFile(const char* const name)
 		return false;
 	}
 
+	flush_handles_to(fullname, drive);
+
 	return Drives.at(drive)->FileUnlink(fullname);
 }
 
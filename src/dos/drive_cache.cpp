@@ -5,9 +5,16 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <cstring>
 #include <iterator>
 #include <vector>
 
+#if defined(HAVE_SYS_INOTIFY_H)
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
 #include "cross.h"
 #include "dos_inc.h"
 #include "drives.h"
@@ -22,36 +29,11 @@ bool SortByName(DOS_Drive_Cache::CFileInfo* const a,
 	return strcmp(a->shortname, b->shortname) < 0;
 }
 
-bool SortByNameRev(DOS_Drive_Cache::CFileInfo* const a,
-                   DOS_Drive_Cache::CFileInfo* const b)
-{
-	return strcmp(a->shortname, b->shortname) > 0;
-}
-
-bool SortByDirName(DOS_Drive_Cache::CFileInfo* const a,
-                   DOS_Drive_Cache::CFileInfo* const b)
-{
-	// Directories first...
-	if (a->isDir!=b->isDir) return (a->isDir>b->isDir);	
-	return strcmp(a->shortname,b->shortname)<0;
-}
-
-bool SortByDirNameRev(DOS_Drive_Cache::CFileInfo* const a,
-                      DOS_Drive_Cache::CFileInfo* const b)
-{
-	// Directories first...
-	if (a->isDir!=b->isDir) return (a->isDir>b->isDir);	
-	return strcmp(a->shortname,b->shortname)>0;
-}
-
 DOS_Drive_Cache::DOS_Drive_Cache(void)
 	: dirBase(new CFileInfo),
 	  dirPath{0},
 	  basePath{0},
 	  sortDirType(DIRALPHABETICAL),
-	  save_dir(nullptr),
-	  save_path{0},
-	  save_expanded{0},
 	  srchNr(0),
 	  dirSearch{nullptr},
 	  dirFindFirst{nullptr},
@@ -66,9 +48,6 @@ DOS_Drive_Cache::DOS_Drive_Cache(const char* path)
 	  dirPath{0},
 	  basePath{0},
 	  sortDirType(DIRALPHABETICAL),
-	  save_dir(nullptr),
-	  save_path{0},
-	  save_expanded{0},
 	  srchNr(0),
 	  dirSearch{nullptr},
 	  dirFindFirst{nullptr},
@@ -85,6 +64,11 @@ DOS_Drive_Cache::~DOS_Drive_Cache(void) {
 		DeleteFileInfo(dirFindFirst[i]);
 		dirFindFirst[i] = nullptr;
 	}
+#if defined(HAVE_SYS_INOTIFY_H)
+	if (watch_fd >= 0) {
+		close(watch_fd);
+	}
+#endif
 }
 
 void DOS_Drive_Cache::Clear(void) {
@@ -99,7 +83,7 @@ void DOS_Drive_Cache::EmptyCache(void) {
 	// Empty Cache and reinit
 	Clear();
 	dirBase		= new CFileInfo;
-	save_dir	= nullptr;
+	ForgetResolvedPaths();
 	srchNr		= 0;
 	if (basePath[0] != 0) SetBaseDir(basePath);
 }
@@ -180,7 +164,7 @@ char* DOS_Drive_Cache::GetExpandNameAndNormaliseCase(const char* path)
 	if (pos) {
 		// Last Entry = File
 		safe_strcpy(dir, pos+1);
-		(void) GetLongName(dirInfo, dir, sizeof(dir)); // ignore the return code
+		(void) FindEntry(dirInfo, dir, sizeof(dir)); // ignore the return code
 		safe_strcat(work, dir);
 	}
 
@@ -209,23 +193,17 @@ void DOS_Drive_Cache::AddEntry(const char* path, bool checkExists) {
 		safe_strcpy(file, pos+1);
 		// Check if file already exists, then don't add new entry...
 		if (checkExists) {
-			if (GetLongName(dir, file, sizeof(file))>=0) return;
+			if (FindEntry(dir, file, sizeof(file))) return;
 		}
 
-		CreateEntry(dir,file,false);
+		const auto index = CreateEntry(dir,file,false);
 
-		if (const auto rcode = GetLongName(dir, file, sizeof(file));
-		    rcode >= 0) {
-			// if the function succeeded, the return value is the index
-			const auto index = static_cast<size_t>(rcode);
-
-			uint32_t i;
-			// Check if there are any open search dir that are affected by this...
-			for (i=0; i<MAX_OPENDIRS; i++) {
-				if ((dirSearch[i] == dir) &&
-				    (index <= dirSearch[i]->nextEntry)) {
-					dirSearch[i]->nextEntry++;
-				}
+		uint32_t i;
+		// Check if there are any open search dir that are affected by this...
+		for (i=0; i<MAX_OPENDIRS; i++) {
+			if ((dirSearch[i] == dir) &&
+			    (index <= dirSearch[i]->nextEntry)) {
+				dirSearch[i]->nextEntry++;
 			}
 		}
 		//		LOG_DEBUG("DIR: Added Entry %s",path);
@@ -262,10 +240,9 @@ void DOS_Drive_Cache::AddEntryDirOverlay(const char* path, bool checkExists) {
 		safe_strcpy(file, pos + 1);
 		// Check if directory already exists, then don't add new entry...
 		if (checkExists) {
-			Bits index = GetLongName(dir, file, sizeof(file));
-			if (index >= 0) {
+			if (CFileInfo* existing = FindEntry(dir, file, sizeof(file))) {
 				//directory already exists, but most likely empty. 
-				dir = dir->fileList[index];
+				dir = existing;
 				if (dir->isOverlayDir && dir->fileList.empty()) {
 					//maybe care about searches ? but this function should only run on cache inits/refreshes.
 					//add dot entries
@@ -276,27 +253,21 @@ void DOS_Drive_Cache::AddEntryDirOverlay(const char* path, bool checkExists) {
 			}
 		}
 
-		CreateEntry(dir,file,true);
+		const auto index = CreateEntry(dir,file,true);
 
-		if (const auto rcode = GetLongName(dir, file, sizeof(file));
-		    rcode >= 0) {
-			// if the function succeeded, the return value is the index
-			const auto index = static_cast<size_t>(rcode);
-
-			uint32_t i;
-			// Check if there are any open search dir that are affected by this...
-			for (i=0; i<MAX_OPENDIRS; i++) {
-				if ((dirSearch[i] == dir) &&
-				    (index <= dirSearch[i]->nextEntry)) {
-					dirSearch[i]->nextEntry++;
-				}
+		uint32_t i;
+		// Check if there are any open search dir that are affected by this...
+		for (i=0; i<MAX_OPENDIRS; i++) {
+			if ((dirSearch[i] == dir) &&
+			    (index <= dirSearch[i]->nextEntry)) {
+				dirSearch[i]->nextEntry++;
 			}
-
-			dir = dir->fileList[index];
-			dir->isOverlayDir = true;
-			CreateEntry(dir,".",true);
-			CreateEntry(dir,"..",true);
 		}
+
+		dir = dir->fileList[index];
+		dir->isOverlayDir = true;
+		CreateEntry(dir,".",true);
+		CreateEntry(dir,"..",true);
 		//		LOG_DEBUG("DIR: Added Entry %s",path);
 	} else {
 		//		LOG_DEBUG("DIR: Error: Failed to add %s",path);	
@@ -340,6 +311,11 @@ void DOS_Drive_Cache::CacheOut(const char* path, bool ignoreLastDir) {
 	}
 
 //	LOG_DEBUG("DIR: Caching out %s : dir %s",expand,dir->orgname);
+	CacheOutDir(dir);
+}
+
+void DOS_Drive_Cache::CacheOutDir(CFileInfo* dir)
+{
 	// delete file objects...
 	//Maybe check if it is a file and then only delete the file and possibly the long name. instead of all objects in the dir.
 	for(uint32_t i=0; i<dir->fileList.size(); i++) {
@@ -351,7 +327,16 @@ void DOS_Drive_Cache::CacheOut(const char* path, bool ignoreLastDir) {
 	// clear lists
 	dir->fileList.clear();
 	dir->longNameList.clear();
-	save_dir = nullptr;
+	dir->short_names.clear();
+	dir->long_names.clear();
+	dir->wine_names.clear();
+	dir->has_wine_names = false;
+	ForgetResolvedPaths();
+}
+
+void DOS_Drive_Cache::ForgetResolvedPaths(void)
+{
+	resolved_paths.clear();
 }
 
 bool DOS_Drive_Cache::IsCachedIn(CFileInfo* curDir)
@@ -360,6 +345,16 @@ bool DOS_Drive_Cache::IsCachedIn(CFileInfo* curDir)
 }
 
 
+// Host names are matched case-insensitively on Windows only
+static std::string normalise_long_name(const char* name)
+{
+	std::string normalised = name;
+#if defined(WIN32)
+	lowcase(normalised);
+#endif
+	return normalised;
+}
+
 bool DOS_Drive_Cache::GetShortName(const char* fullname, char* shortname) {
 	// Get Dir Info
 	char expand[CROSS_LEN] = {0};
@@ -371,23 +366,12 @@ bool DOS_Drive_Cache::GetShortName(const char* fullname, char* shortname) {
 	else
 		return false;
 
-	std::vector<CFileInfo*>::size_type filelist_size = curDir->longNameList.size();
-	if (filelist_size <= 0) {
+	const auto it = curDir->long_names.find(normalise_long_name(pos));
+	if (it == curDir->long_names.end()) {
 		return false;
 	}
-
-	// The orgname part of the list is not sorted (shortname is)! So we can only walk through it.
-	for(Bitu i = 0; i < filelist_size; i++) {
-#if defined (WIN32)
-		if (strcasecmp(pos,curDir->longNameList[i]->orgname) == 0) {
-#else
-		if (strcmp(pos,curDir->longNameList[i]->orgname) == 0) {
-#endif
-			safe_strncpy(shortname, curDir->longNameList[i]->shortname, DOS_NAMELENGTH_ASCII);
-			return true;
-		}
-	}
-	return false;
+	safe_strncpy(shortname, it->second->shortname, DOS_NAMELENGTH_ASCII);
+	return true;
 }
 
 int DOS_Drive_Cache::CompareShortname(const char* compareName, const char* shortName) {
@@ -467,7 +451,7 @@ bool DOS_Drive_Cache::RemoveTrailingDot(char* shortname) {
 #if WINE_DRIVE_SUPPORT
 //Changes to interact with WINE by supporting their namemangling.
 //The code is rather slow, because orglist is unordered, so it needs to be avoided if possible.
-//Hence the tests in GetLongFileName
+//Hence the tests in FindEntry, which also hashes a directory only once
 
 
 // From the Wine project
@@ -543,45 +527,47 @@ static Bits wine_hash_short_file_name( char* name, char* buffer )
 }
 #endif
 
-Bits DOS_Drive_Cache::GetLongName(CFileInfo* curDir, char* shortName, const size_t shortName_len) {
-	std::vector<CFileInfo*>::size_type filelist_size = curDir->fileList.size();
-	if (filelist_size <= 0) {
-		return -1;
+DOS_Drive_Cache::CFileInfo* DOS_Drive_Cache::FindEntry(CFileInfo* curDir,
+                                                       char* shortName,
+                                                       const size_t shortName_len)
+{
+	if (curDir->fileList.empty()) {
+		return nullptr;
 	}
 
 	// Remove dot, if no extension...
 	RemoveTrailingDot(shortName);
-	// Search long name and return array number of element
-	Bits low	= 0;
-	Bits high	= (Bits)(filelist_size-1);
-	Bits mid,res;
-	while (low<=high) {
-		mid = (low+high)/2;
-		res = strcmp(shortName,curDir->fileList[mid]->shortname);
-		if (res>0)	low  = mid+1; else
-		if (res<0)	high = mid-1; else
-		{	// Found
-			safe_strncpy(shortName, curDir->fileList[mid]->orgname, shortName_len);
-			return mid;
-		};
+
+	CFileInfo* info = nullptr;
+	if (const auto it = curDir->short_names.find(shortName);
+	    it != curDir->short_names.end()) {
+		info = it->second;
 	}
 #ifdef WINE_DRIVE_SUPPORT
-	if (strlen(shortName) < 8 || shortName[4] != '~' || shortName[5] == '.' || shortName[6] == '.' || shortName[7] == '.') return -1; // not available
-	// else it's most likely a Wine style short name ABCD~###, # = not dot  (length at least 8) 
-	// The above test is rather strict as the following loop can be really slow if filelist_size is large.
-	char buff[CROSS_LEN];
-	for (Bitu i = 0; i < filelist_size; i++) {
-		res = wine_hash_short_file_name(curDir->fileList[i]->orgname,buff);
-		buff[res] = 0;
-		if (!strcmp(shortName,buff)) {	
-			// Found
-			safe_strncpy(shortName, curDir->fileList[i]->orgname, shortName_len);
-			return (Bits)i;
+	else if (strlen(shortName) >= 8 && shortName[4] == '~' && shortName[5] != '.' &&
+	         shortName[6] != '.' && shortName[7] != '.') {
+		// Most likely a Wine style short name ABCD~###, # = not dot
+		// (length at least 8). Hashing every name in the directory is
+		// slow, so only do it once.
+		if (!curDir->has_wine_names) {
+			char buff[CROSS_LEN];
+			for (const auto entry : curDir->fileList) {
+				const auto len = wine_hash_short_file_name(entry->orgname, buff);
+				buff[len] = 0;
+				curDir->wine_names.emplace(buff, entry);
+			}
+			curDir->has_wine_names = true;
+		}
+		if (const auto it = curDir->wine_names.find(shortName);
+		    it != curDir->wine_names.end()) {
+			info = it->second;
 		}
 	}
 #endif
-	// not available
-	return -1;
+	if (info) {
+		safe_strncpy(shortName, info->orgname, shortName_len);
+	}
+	return info;
 }
 
 bool DOS_Drive_Cache::RemoveSpaces(char* str) {
@@ -628,7 +614,7 @@ void DOS_Drive_Cache::CreateShortName(CFileInfo* curDir, CFileInfo* info) {
 	if (!createShort) {
 		char buffer[CROSS_LEN];
 		safe_strcpy(buffer, tmpName);
-		createShort = (GetLongName(curDir, buffer, sizeof(buffer)) >= 0);
+		createShort = (FindEntry(curDir, buffer, sizeof(buffer)) != nullptr);
 	}
 
 	if (createShort) {
@@ -674,28 +660,10 @@ void DOS_Drive_Cache::CreateShortName(CFileInfo* curDir, CFileInfo* info) {
 		}
 
 		// keep list sorted for CreateShortNameID to work correctly
-		if (!curDir->longNameList.empty()) {
-			if (!(strcmp(info->shortname,curDir->longNameList.back()->shortname)<0)) {
-				// append at end of list
-				curDir->longNameList.push_back(info);
-			} else {
-				// look for position where to insert this element
-				bool found=false;
-				std::vector<CFileInfo*>::iterator it;
-				for (it=curDir->longNameList.begin(); it!=curDir->longNameList.end(); ++it) {
-					if (strcmp(info->shortname,(*it)->shortname)<0) {
-						found = true;
-						break;
-					}
-				}
-				// Put it in longname list...
-				if (found) curDir->longNameList.insert(it,info);
-				else curDir->longNameList.push_back(info);
-			}
-		} else {
-			// empty file list, append
-			curDir->longNameList.push_back(info);
-		}
+		auto& names = curDir->longNameList;
+		names.insert(std::upper_bound(names.begin(), names.end(), info, SortByName),
+		             info);
+		curDir->long_names.emplace(normalise_long_name(info->orgname), info);
 	} else {
 		safe_strcpy(info->shortname, tmpName);
 	}
@@ -713,10 +681,16 @@ DOS_Drive_Cache::CFileInfo* DOS_Drive_Cache::FindDirInfo(const char* path, char*
 	CFileInfo*	curDir = dirBase;
 	uint16_t		id;
 
-	if (save_dir && (strcmp(path,save_path)==0)) {
-		safe_strncpy(expandedPath, save_expanded, CROSS_LEN);
-		return save_dir;
-	};
+	// Changes on the host can invalidate the saved result
+	PollHostChanges();
+
+	for (auto it = resolved_paths.begin(); it != resolved_paths.end(); ++it) {
+		if (it->path == path) {
+			safe_strncpy(expandedPath, it->expanded.c_str(), CROSS_LEN);
+			std::rotate(resolved_paths.begin(), it, it + 1);
+			return resolved_paths.front().dir;
+		}
+	}
 
 //	LOG_DEBUG("DIR: Find %s",path);
 
@@ -751,7 +725,7 @@ DOS_Drive_Cache::CFileInfo* DOS_Drive_Cache::FindDirInfo(const char* path, char*
 		};
  
 		// Path found
-		Bits nextDir = GetLongName(curDir, dir, sizeof(dir));
+		CFileInfo* nextDir = FindEntry(curDir, dir, sizeof(dir));
 		strncat(expandedPath, dir, CROSS_LEN - strlen(expandedPath) - 1);
 
 		// Error check
@@ -760,8 +734,8 @@ DOS_Drive_Cache::CFileInfo* DOS_Drive_Cache::FindDirInfo(const char* path, char*
 		};
 */
 		// Follow Directory
-		if ((nextDir>=0) && curDir->fileList[nextDir]->isDir) {
-			curDir = curDir->fileList[nextDir];
+		if (nextDir && nextDir->isDir) {
+			curDir = nextDir;
 			safe_strcpy(curDir->orgname, dir);
 			if (!IsCachedIn(curDir)) {
 				if (OpenDir(curDir,expandedPath,id)) {
@@ -783,10 +757,13 @@ DOS_Drive_Cache::CFileInfo* DOS_Drive_Cache::FindDirInfo(const char* path, char*
 		}
 	} while (pos);
 
-	// Save last result for faster access next time
-	safe_strcpy(save_path, path);
-	safe_strcpy(save_expanded, expandedPath);
-	save_dir = curDir;
+	// Save the result for faster access next time. Games tend to work on
+	// a handful of directories at a time, so only keep the latest ones.
+	constexpr size_t MaxResolvedPaths = 16;
+	if (resolved_paths.size() >= MaxResolvedPaths) {
+		resolved_paths.pop_back();
+	}
+	resolved_paths.insert(resolved_paths.begin(), {path, expandedPath, curDir});
 
 	return curDir;
 }
@@ -830,7 +807,8 @@ bool DOS_Drive_Cache::OpenDir(CFileInfo* dir, const char* expand, uint16_t& id)
 	return false;
 }
 
-void DOS_Drive_Cache::CreateEntry(CFileInfo* dir, const char* name, bool is_directory) {
+size_t DOS_Drive_Cache::CreateEntry(CFileInfo* dir, const char* name,
+                                    bool is_directory, bool keepSorted) {
 	CFileInfo* info = new CFileInfo;
 	safe_strcpy(info->orgname, name);
 	info->shortNr = 0;
@@ -839,30 +817,26 @@ void DOS_Drive_Cache::CreateEntry(CFileInfo* dir, const char* name, bool is_dire
 	// Check for long filenames...
 	CreateShortName(dir, info);		
 
-	bool found = false;
-
-	// keep list sorted (so GetLongName works correctly, used by CreateShortName in this routine)
-	if (!dir->fileList.empty()) {
-		if (!(strcmp(info->shortname,dir->fileList.back()->shortname)<0)) {
-			// append at end of list
-			dir->fileList.push_back(info);
-		} else {
-			// look for position where to insert this element
-			std::vector<CFileInfo*>::iterator it;
-			for (it=dir->fileList.begin(); it!=dir->fileList.end(); ++it) {
-				if (strcmp(info->shortname,(*it)->shortname)<0) {
-					found = true;
-					break;
-				}
-			}
-			// Put file in lists
-			if (found) dir->fileList.insert(it,info);
-			else dir->fileList.push_back(info);
-		}
-	} else {
-		// empty file list, append
-		dir->fileList.push_back(info);
+	dir->short_names.emplace(info->shortname, info);
+#ifdef WINE_DRIVE_SUPPORT
+	if (dir->has_wine_names) {
+		char buff[CROSS_LEN];
+		buff[wine_hash_short_file_name(info->orgname, buff)] = 0;
+		dir->wine_names.emplace(buff, info);
+	}
+#endif
+
+	// When reading a whole directory, the list gets sorted once at the end
+	auto& files = dir->fileList;
+	if (!keepSorted) {
+		files.push_back(info);
+		return files.size() - 1;
 	}
+
+	// keep list sorted, for FindFirst and the searches in progress
+	const auto it = files.insert(std::upper_bound(files.begin(), files.end(), info, SortByName),
+	                             info);
+	return static_cast<size_t>(std::distance(files.begin(), it));
 }
 
 void DOS_Drive_Cache::CopyEntry(CFileInfo* dir, CFileInfo* from) {
@@ -894,16 +868,20 @@ bool DOS_Drive_Cache::ReadDir(uint16_t id, char* &result) {
 		// Read complete directory
 		char dir_name[CROSS_LEN];
 		bool is_directory;
+		auto& files = dirSearch[id]->fileList;
 		if (read_directory_first(dirp, dir_name, is_directory)) {
-			CreateEntry(dirSearch[id], dir_name, is_directory);
+			CreateEntry(dirSearch[id], dir_name, is_directory, false);
 			while (read_directory_next(dirp, dir_name, is_directory)) {
-				CreateEntry(dirSearch[id], dir_name, is_directory);
+				CreateEntry(dirSearch[id], dir_name, is_directory, false);
 			}
 		}
+		std::stable_sort(files.begin(), files.end(), SortByName);
 
 		// close dir
 		close_directory(dirp);
 
+		WatchDir(dirSearch[id], dirPath);
+
 		// Info
 /*		if (!dirp) {
 			LOG_DEBUG("DIR: Error Caching in %s",dirPath);			
@@ -940,6 +918,10 @@ bool DOS_Drive_Cache::SetResult(CFileInfo* dir, char* &result, Bitu entryNr)
 // FindFirst / FindNext
 bool DOS_Drive_Cache::FindFirst(char* path, uint16_t& id) {
 	uint16_t	dirID;
+
+	// A new search should always reflect the host's current state
+	PollHostChanges(true);
+
 	// Cache directory in 
 	if (!OpenDir(path,dirID)) return false;
 
@@ -973,16 +955,22 @@ bool DOS_Drive_Cache::FindFirst(char* path, uint16_t& id) {
 	dirFindFirst[dirFindFirstID]->nextEntry = 0;
 
 	// Copy entries to use with FindNext
+	auto& found = dirFindFirst[dirFindFirstID]->fileList;
+	found.reserve(dirSearch[dirID]->fileList.size());
 	for (Bitu i=0; i<dirSearch[dirID]->fileList.size(); i++) {
 		CopyEntry(dirFindFirst[dirFindFirstID],dirSearch[dirID]->fileList[i]);
 	}
-	// Now re-sort the fileList accordingly to output
+	// Now re-sort the fileList accordingly to output. It's already sorted
+	// by name, so there's no need for a full sort.
+	const auto is_dir = [](const CFileInfo* info) { return info->isDir; };
 	switch (sortDirType) {
 		case ALPHABETICAL		: break;
-//		case ALPHABETICAL		: std::sort(dirFindFirst[dirFindFirstID]->fileList.begin(), dirFindFirst[dirFindFirstID]->fileList.end(), SortByName);		break;
-		case DIRALPHABETICAL	: std::sort(dirFindFirst[dirFindFirstID]->fileList.begin(), dirFindFirst[dirFindFirstID]->fileList.end(), SortByDirName);		break;
-		case ALPHABETICALREV	: std::sort(dirFindFirst[dirFindFirstID]->fileList.begin(), dirFindFirst[dirFindFirstID]->fileList.end(), SortByNameRev);		break;
-		case DIRALPHABETICALREV	: std::sort(dirFindFirst[dirFindFirstID]->fileList.begin(), dirFindFirst[dirFindFirstID]->fileList.end(), SortByDirNameRev);	break;
+		case DIRALPHABETICAL	: std::stable_partition(found.begin(), found.end(), is_dir);	break;
+		case ALPHABETICALREV	: std::reverse(found.begin(), found.end());	break;
+		case DIRALPHABETICALREV	:
+			std::reverse(found.begin(), found.end());
+			std::stable_partition(found.begin(), found.end(), is_dir);
+			break;
 		case NOSORT				: break;
 	}
 
@@ -1015,6 +1003,7 @@ void DOS_Drive_Cache::ClearFileInfo(CFileInfo *dir) {
 		dirSearch[dir->id] = nullptr;
 		dir->id = MAX_OPENDIRS;
 	}
+	UnwatchDir(dir);
 }
 
 void DOS_Drive_Cache::DeleteFileInfo(CFileInfo *dir) {
@@ -1023,3 +1012,182 @@ void DOS_Drive_Cache::DeleteFileInfo(CFileInfo *dir) {
 		delete dir;
 	}
 }
+
+DOS_Drive_Cache::CFileInfo* DOS_Drive_Cache::FindFileInfo(const char* path)
+{
+	const char* pos = strrchr(path, CROSS_FILESPLIT);
+	if (!pos) {
+		return nullptr;
+	}
+
+	// Only look up the directory part, so a directory entry isn't cached in
+	char dir[CROSS_LEN];
+	safe_strcpy(dir, path);
+	dir[pos - path + 1] = 0;
+
+	char expand[CROSS_LEN];
+	CFileInfo* dir_info = FindDirInfo(dir, expand);
+
+	char name[CROSS_LEN];
+	safe_strcpy(name, pos + 1);
+
+	return FindEntry(dir_info, name, sizeof(name));
+}
+
+bool DOS_Drive_Cache::GetFileDetails(const char* path, FileDetails& details)
+{
+	if (!IsWatchingHost()) {
+		return false;
+	}
+	const auto info = FindFileInfo(path);
+	if (!info || info->details_generation != details_generation) {
+		return false;
+	}
+	details = info->details;
+	return true;
+}
+
+void DOS_Drive_Cache::SetFileDetails(const char* path, const FileDetails& details)
+{
+	if (!IsWatchingHost()) {
+		return;
+	}
+	if (const auto info = FindFileInfo(path); info) {
+		info->details            = details;
+		info->details_generation = details_generation;
+	}
+}
+
+#if defined(HAVE_SYS_INOTIFY_H)
+
+// Changes to a directory's listing
+constexpr uint32_t ListingChangeMask = IN_CREATE | IN_DELETE | IN_MOVED_FROM |
+                                       IN_MOVED_TO;
+
+// Changes to the details of a directory's entries
+constexpr uint32_t DetailsChangeMask = IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE;
+
+bool DOS_Drive_Cache::EnableHostWatching()
+{
+	if (watch_fd >= 0) {
+		return true;
+	}
+	watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (watch_fd < 0) {
+		LOG_WARNING("DIRCACHE: Can't watch '%s' for changes: %s",
+		            basePath,
+		            strerror(errno));
+		return false;
+	}
+
+	// Start over, so the directories cached in so far get watched too
+	EmptyCache();
+	return true;
+}
+
+void DOS_Drive_Cache::WatchDir(CFileInfo* dir, const char* path)
+{
+	if (watch_fd < 0 || !dir) {
+		return;
+	}
+	const auto watch_id = inotify_add_watch(watch_fd,
+	                                        path,
+	                                        ListingChangeMask | DetailsChangeMask);
+	if (watch_id < 0) {
+		LOG(LOG_DOSMISC, LOG_WARN)("DIRCACHE: Can't watch '%s' for changes: %s",
+		                          path,
+		                          strerror(errno));
+		return;
+	}
+
+	// Watching the same directory again returns the same ID
+	if (dir->watch_id >= 0 && dir->watch_id != watch_id) {
+		UnwatchDir(dir);
+	}
+	dir->watch_id          = watch_id;
+	watched_dirs[watch_id] = dir;
+}
+
+void DOS_Drive_Cache::UnwatchDir(CFileInfo* dir)
+{
+	if (dir->watch_id < 0) {
+		return;
+	}
+	const auto it = watched_dirs.find(dir->watch_id);
+	if (it != watched_dirs.end() && it->second == dir) {
+		inotify_rm_watch(watch_fd, dir->watch_id);
+		watched_dirs.erase(it);
+	}
+	dir->watch_id = -1;
+}
+
+void DOS_Drive_Cache::PollHostChanges(const bool force)
+{
+	if (watch_fd < 0) {
+		return;
+	}
+
+	// Reading the events is a system call, so don't do it for every
+	// path lookup; a search in progress sees the state from its start
+	constexpr auto PollInterval = std::chrono::milliseconds(100);
+
+	const auto now = std::chrono::steady_clock::now();
+	if (!force && now - last_poll < PollInterval) {
+		return;
+	}
+	last_poll = now;
+
+	alignas(inotify_event) char buffer[4096];
+
+	ssize_t num_bytes = 0;
+	while ((num_bytes = read(watch_fd, buffer, sizeof(buffer))) > 0) {
+		for (auto pos = buffer; pos < buffer + num_bytes;) {
+			const auto event = reinterpret_cast<const inotify_event*>(pos);
+			pos += sizeof(inotify_event) + event->len;
+
+			if (event->mask & IN_Q_OVERFLOW) {
+				// Changes were lost, so nothing cached can be trusted
+				LOG(LOG_DOSMISC, LOG_NORMAL)("DIRCACHE: Too many host changes, emptying cache of '%s'",
+				                             basePath);
+				EmptyCache();
+				continue;
+			}
+
+			// The directory may have been cached out by an earlier event
+			const auto it = watched_dirs.find(event->wd);
+			if (it == watched_dirs.end()) {
+				continue;
+			}
+			CFileInfo* dir = it->second;
+
+			if (event->mask & IN_IGNORED) {
+				// The directory was removed or unmounted
+				dir->watch_id = -1;
+				watched_dirs.erase(it);
+			} else if (event->mask & ListingChangeMask) {
+				CacheOutDir(dir);
+			} else if ((event->mask & DetailsChangeMask) && event->len) {
+				for (const auto info : dir->fileList) {
+					if (strcmp(info->orgname, event->name) == 0) {
+						info->details_generation = 0;
+					}
+				}
+			}
+		}
+	}
+}
+
+#else
+
+bool DOS_Drive_Cache::EnableHostWatching()
+{
+	return false;
+}
+
+void DOS_Drive_Cache::WatchDir(CFileInfo*, const char*) {}
+
+void DOS_Drive_Cache::UnwatchDir(CFileInfo*) {}
+
+void DOS_Drive_Cache::PollHostChanges(const bool) {}
+
+#endif
@@ -5,8 +5,10 @@
 
 #include <cctype>
 #include <cstring>
+#include <iterator>
 
 #include "cdrom.h"
+#include "control.h"
 #include "dos_mscdex.h"
 #include "dos_system.h"
 #include "string_utils.h"
@@ -142,10 +144,14 @@ isoDrive::isoDrive(char driveLetter, const char *fileName, uint8_t mediaid, int
 {
 	this->fileName[0]  = '\0';
 	this->discLabel[0] = '\0';
-	memset(dirIterators, 0, sizeof(dirIterators));
-	memset(sectorHashEntries, 0, sizeof(sectorHashEntries));
 	memset(&rootEntry, 0, sizeof(isoDirEntry));
 
+	const auto section = static_cast<SectionProp*>(control->GetSection("dos"));
+	if (section) {
+		max_cached_sectors = static_cast<size_t>(
+		        section->GetInt("cdrom_sector_cache"));
+	}
+
 	safe_strcpy(this->fileName, fileName);
 	type  = DosDriveType::Iso;
 	error = UpdateMscdex(driveLetter, fileName, subUnit);
@@ -389,12 +395,9 @@ Bits isoDrive::UnMount()
 int isoDrive::GetDirIterator(const isoDirEntry* de) {
 	int dirIterator = nextFreeDirIterator;
 
-	// get start and end sector of the directory entry (pad end sector if necessary)
-	dirIterators[dirIterator].currentSector = EXTENT_LOCATION(*de);
-	dirIterators[dirIterator].endSector =
-		EXTENT_LOCATION(*de) + DATA_LENGTH(*de) / ISO_FRAMESIZE - 1;
-	if (DATA_LENGTH(*de) % ISO_FRAMESIZE != 0)
-		dirIterators[dirIterator].endSector++;
+	// The iterator keeps the index alive, even if it's dropped from
+	// dir_indexes in the meantime
+	dirIterators[dirIterator].index = GetDirIndex(*de);
 
 	// reset position and mark as valid
 	dirIterators[dirIterator].pos = 0;
@@ -407,41 +410,18 @@ int isoDrive::GetDirIterator(const isoDirEntry* de) {
 }
 
 bool isoDrive::GetNextDirEntry(const int dirIteratorHandle, isoDirEntry* de) {
-	bool result = false;
-	uint8_t* buffer = nullptr;
 	DirIterator& dirIterator = dirIterators[dirIteratorHandle];
 
-	// check if the directory entry is valid
-	if (dirIterator.valid && ReadCachedSector(&buffer, dirIterator.currentSector)) {
-		// check if the next sector has to be read
-		if ((dirIterator.pos >= ISO_FRAMESIZE)
-		 || (buffer[dirIterator.pos] == 0)
-		 || (dirIterator.pos + buffer[dirIterator.pos] > ISO_FRAMESIZE)) {
-
-			// check if there is another sector available
-		 	if (dirIterator.currentSector < dirIterator.endSector) {
-			 	dirIterator.pos = 0;
-			 	dirIterator.currentSector++;
-			 	if (!ReadCachedSector(&buffer, dirIterator.currentSector)) {
-			 		return false;
-			 	}
-		 	} else {
-		 		return false;
-		 	}
-		 }
-		 // read sector and advance sector pointer
-		 const int length = readDirEntry(de, &buffer[dirIterator.pos]);
-		 result = length >= 0;
-		 if (length >= 0)
-			 dirIterator.pos += static_cast<unsigned>(length);
-		 else // read failed, so step back to our prior iterator
-			 dirIterator.pos--;
+	if (!dirIterator.valid || dirIterator.pos >= dirIterator.index->entries.size()) {
+		return false;
 	}
-	return result;
+	*de = dirIterator.index->entries[dirIterator.pos++];
+	return true;
 }
 
 void isoDrive::FreeDirIterator(const int dirIterator) {
 	dirIterators[dirIterator].valid = false;
+	dirIterators[dirIterator].index.reset();
 
 	// if this was the last aquired iterator decrement nextFreeIterator
 	if ((dirIterator + 1) % MAX_OPENDIRS == nextFreeDirIterator) {
@@ -453,21 +433,97 @@ void isoDrive::FreeDirIterator(const int dirIterator) {
 	}
 }
 
-bool isoDrive::ReadCachedSector(uint8_t** buffer, const uint32_t sector) {
-	// get hash table entry
-	int pos = sector % ISO_MAX_HASH_TABLE_SIZE;
-	SectorHashEntry& he = sectorHashEntries[pos];
+std::shared_ptr<const isoDrive::DirIndex> isoDrive::GetDirIndex(const isoDirEntry& dir)
+{
+	const auto first_sector = EXTENT_LOCATION(dir);
 
-	// check if the entry is valid and contains the correct sector
-	if (!he.valid || he.sector != sector) {
-		if (!CDROM::cdroms[subUnit]->ReadSector(he.data, false, sector)) {
-			return false;
+	if (const auto it = dir_indexes.find(first_sector); it != dir_indexes.end()) {
+		return it->second;
+	}
+
+	// get start and end sector of the directory entry (pad end sector if necessary)
+	auto last_sector = first_sector + DATA_LENGTH(dir) / ISO_FRAMESIZE - 1;
+	if (DATA_LENGTH(dir) % ISO_FRAMESIZE != 0)
+		last_sector++;
+
+	auto index = std::make_shared<DirIndex>();
+
+	uint32_t sector = first_sector;
+	uint32_t pos    = 0;
+	uint8_t* buffer = nullptr;
+
+	bool has_entry = ReadCachedSector(&buffer, sector);
+	while (has_entry) {
+		// check if the next sector has to be read
+		if ((pos >= ISO_FRAMESIZE) || (buffer[pos] == 0) ||
+		    (pos + buffer[pos] > ISO_FRAMESIZE)) {
+			// check if there is another sector available
+			if (sector >= last_sector) {
+				break;
+			}
+			pos = 0;
+			sector++;
+			if (!ReadCachedSector(&buffer, sector)) {
+				break;
+			}
+		}
+
+		// Directory listings stop at the first record that can't be
+		// read, as they always have
+		isoDirEntry de = {};
+		const int length = readDirEntry(&de, &buffer[pos]);
+		if (length <= 0) {
+			break;
+		}
+		pos += static_cast<unsigned>(length);
+
+		if (!IS_ASSOC(FLAGS1)) {
+			std::string name(reinterpret_cast<char*>(de.ident));
+			upcase(name);
+			// Earlier records win, as with the sequential search
+			index->by_name.emplace(std::move(name), index->entries.size());
 		}
-		he.valid = true;
-		he.sector = sector;
+		index->entries.push_back(de);
 	}
 
-	*buffer = he.data;
+	// Bound the memory used on CDs with many directories; the indexes
+	// are quick to rebuild from the cached sectors
+	constexpr size_t MaxIndexedDirs = 256;
+	if (dir_indexes.size() >= MaxIndexedDirs) {
+		dir_indexes.clear();
+	}
+	dir_indexes.emplace(first_sector, index);
+
+	return index;
+}
+
+bool isoDrive::ReadCachedSector(uint8_t** buffer, const uint32_t sector) {
+	if (const auto it = sector_cache_index.find(sector);
+	    it != sector_cache_index.end()) {
+		sector_cache.splice(sector_cache.begin(), sector_cache, it->second);
+		*buffer = it->second->data.data();
+		return true;
+	}
+
+	// Reuse the least recently used entry once the cache is full
+	if (!sector_cache.empty() && sector_cache.size() >= max_cached_sectors) {
+		sector_cache_index.erase(sector_cache.back().sector);
+		sector_cache.splice(sector_cache.begin(),
+		                    sector_cache,
+		                    std::prev(sector_cache.end()));
+	} else {
+		sector_cache.emplace_front();
+	}
+
+	auto& entry = sector_cache.front();
+	if (!CDROM::cdroms[subUnit]->ReadSector(entry.data.data(), false, sector)) {
+		sector_cache.pop_front();
+		return false;
+	}
+	entry.sector = sector;
+	sector_cache_index[sector] = sector_cache.begin();
+
+	*buffer = entry.data.data();
 	return true;
 }
 
@@ -544,29 +600,29 @@ bool isoDrive :: lookup(isoDirEntry *de, const char *path) {
 	safe_strcpy(isoPath, path);
 	strreplace(isoPath, '\\', '/');
 
-	// iterate over all path elements (name), and search each of them in the current de
+	// iterate over all path elements (name), and look each of them up in the current de
 	for(char* name = strtok(isoPath, "/"); nullptr != name; name = strtok(nullptr, "/")) {
 
-		bool found = false;
 		// current entry must be a directory, abort otherwise
-		if (IS_DIR(FLAGS2)) {
+		if (!IS_DIR(FLAGS2)) {
+			return false;
+		}
 
-			// remove the trailing dot if present
-			size_t nameLength = strlen(name);
-			if (nameLength > 0) {
-				if (name[nameLength - 1] == '.') name[nameLength - 1] = 0;
-			}
+		// remove the trailing dot if present
+		size_t nameLength = strlen(name);
+		if (nameLength > 0) {
+			if (name[nameLength - 1] == '.') name[nameLength - 1] = 0;
+		}
 
-			// look for the current path element
-			int dirIterator = GetDirIterator(de);
-			while (!found && GetNextDirEntry(dirIterator, de)) {
-				if (!IS_ASSOC(FLAGS2) && (0 == strncasecmp((char*) de->ident, name, ISO_MAX_FILENAME_LENGTH))) {
-					found = true;
-				}
-			}
-			FreeDirIterator(dirIterator);
+		std::string key(name, strnlen(name, ISO_MAX_FILENAME_LENGTH));
+		upcase(key);
+
+		const auto index = GetDirIndex(*de);
+		const auto it    = index->by_name.find(key);
+		if (it == index->by_name.end()) {
+			return false;
 		}
-		if (!found) return false;
+		*de = index->entries[it->second];
 	}
 	return true;
 }
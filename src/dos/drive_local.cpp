@@ -8,6 +8,7 @@
 #include "drives.h"
 #include "drive_local.h"
 
+#include <algorithm>
 #include <cerrno>
 #include <climits>
 #include <cstdio>
@@ -16,6 +17,7 @@
 #include <ctime>
 #include <limits>
 #include <sys/types.h>
+#include <vector>
 
 #include "../hardware/disk_noise.h"
 #include "cross.h"
@@ -23,7 +25,9 @@
 #include "dos_mscdex.h"
 #include "fs_utils.h"
 #include "inout.h"
+#include "pic.h"
 #include "string_utils.h"
+#include "timer.h"
 
 bool localDrive::FileIsReadOnly(const char* name)
 {
@@ -315,10 +319,40 @@ bool localDrive::FindFirst(const char* _dir, DOS_DTA& dta, bool fcb_findfirst)
 	return FindNext(dta);
 }
 
+// Reads the details of a host file as shown by FindFirst/FindNext. Returns
+// false if the file can't be shown at all.
+static bool read_file_details(const char* host_name,
+                              DOS_Drive_Cache::FileDetails& details)
+{
+	struct stat stat_block;
+	if (stat(host_name, &stat_block) != 0) {
+		return false; // No symlinks and such
+	}
+
+	details.is_hidden_by_host = is_hidden_by_host(host_name);
+	if (details.is_hidden_by_host) {
+		return true;
+	}
+
+	if (DOSERR_NONE != local_drive_get_attributes(host_name, details.attributes)) {
+		return false;
+	}
+
+	details.size = (uint32_t)stat_block.st_size;
+	struct tm datetime;
+	if (cross::localtime_r(&stat_block.st_mtime, &datetime)) {
+		details.date = DOS_PackDate(datetime);
+		details.time = DOS_PackTime(datetime);
+	} else {
+		details.time = 6;
+		details.date = 4;
+	}
+	return true;
+}
+
 bool localDrive::FindNext(DOS_DTA& dta)
 {
 	char* dir_ent;
-	struct stat stat_block;
 	char full_name[CROSS_LEN];
 	char dir_entcopy[CROSS_LEN];
 
@@ -344,21 +378,24 @@ bool localDrive::FindNext(DOS_DTA& dta)
 		// dir_ent (by caching in a new directory and due to its design
 		// dir_ent might be lost.) Copying dir_ent first
 		safe_strcpy(dir_entcopy, dir_ent);
-		const char* temp_name = dirCache.GetExpandNameAndNormaliseCase(
-		        full_name);
-		if (stat(temp_name, &stat_block) != 0) {
-			continue; // No symlinks and such
-		}
 
-		if (is_hidden_by_host(temp_name)) {
-			continue; // No host-only hidden files
+		// The details are cached while the host directory is watched
+		// for changes, so listing a directory needs no system calls
+		DOS_Drive_Cache::FileDetails details = {};
+		if (!dirCache.GetFileDetails(full_name, details)) {
+			const char* temp_name = dirCache.GetExpandNameAndNormaliseCase(
+			        full_name);
+			if (!read_file_details(temp_name, details)) {
+				continue;
+			}
+			dirCache.SetFileDetails(full_name, details);
 		}
 
-		FatAttributeFlags find_attr = {};
-		if (DOSERR_NONE != local_drive_get_attributes(temp_name, find_attr)) {
-			continue;
+		if (details.is_hidden_by_host) {
+			continue; // No host-only hidden files
 		}
 
+		const auto find_attr = details.attributes;
 		if ((find_attr.directory && !search_attr.directory) ||
 		    (find_attr.hidden && !search_attr.hidden) ||
 		    (find_attr.system && !search_attr.system)) {
@@ -367,28 +404,16 @@ bool localDrive::FindNext(DOS_DTA& dta)
 
 		/*file is okay, setup everything to be copied in DTA Block */
 		char find_name[DOS_NAMELENGTH_ASCII] = "";
-		uint16_t find_date;
-		uint16_t find_time;
-		uint32_t find_size;
 
 		if (safe_strlen(dir_entcopy) < DOS_NAMELENGTH_ASCII) {
 			safe_strcpy(find_name, dir_entcopy);
 			upcase(find_name);
 		}
 
-		find_size = (uint32_t)stat_block.st_size;
-		struct tm datetime;
-		if (cross::localtime_r(&stat_block.st_mtime, &datetime)) {
-			find_date = DOS_PackDate(datetime);
-			find_time = DOS_PackTime(datetime);
-		} else {
-			find_time = 6;
-			find_date = 4;
-		}
 		dta.SetResult(find_name,
-		              find_size,
-		              find_date,
-		              find_time,
+		              details.size,
+		              details.date,
+		              details.time,
 		              find_attr._data);
 		return true;
 	}
@@ -552,6 +577,82 @@ localDrive::localDrive(const char* startdir, uint16_t _bytes_sector,
 	dirCache.SetBaseDir(basedir);
 }
 
+// Writes up to this size are collected in the write-behind buffer; DOS
+// programs often write records of a few bytes to a few hundred bytes each
+constexpr size_t WriteBehindBufferSize = 16 * 1024;
+
+// Buffered data is written out after this many milliseconds at the latest,
+// so the host files stay current while the program keeps them open
+constexpr int64_t WriteBehindTimeoutMs = 100;
+
+// Open files with data in their write-behind buffer, in the order their
+// buffers were started, so the oldest pending data comes first
+static std::vector<localFile*> files_with_pending_writes = {};
+
+void localFile::FlushWritesTo(const std::string& host_path)
+{
+	// Flushing removes the file from the list
+	for (size_t i = 0; i < files_with_pending_writes.size();) {
+		const auto file = files_with_pending_writes[i];
+		if (file->path_string == host_path) {
+			file->FlushHeldBackWrites();
+		} else {
+			++i;
+		}
+	}
+}
+
+void localFile::FlushStaleWrites()
+{
+	// The list is oldest first, so stop at the first file that's not due
+	while (!files_with_pending_writes.empty()) {
+		const auto file = files_with_pending_writes.front();
+		if (GetTicksSince(file->write_buffer_ticks) < WriteBehindTimeoutMs) {
+			break;
+		}
+		file->FlushHeldBackWrites();
+	}
+}
+
+bool localFile::Flush()
+{
+	FlushHeldBackWrites();
+
+	if (has_write_error) {
+		has_write_error = false;
+		return false;
+	}
+	return true;
+}
+
+void localFile::FlushHeldBackWrites()
+{
+	if (write_buffer.empty()) {
+		return;
+	}
+	assert(file_handle != InvalidNativeFileHandle);
+
+	const auto num_bytes = static_cast<int64_t>(write_buffer.size());
+	const auto ret = write_native_file(file_handle, write_buffer.data(), num_bytes);
+	write_buffer.clear();
+
+	const auto it = std::find(files_with_pending_writes.begin(),
+	                          files_with_pending_writes.end(),
+	                          this);
+	if (it != files_with_pending_writes.end()) {
+		files_with_pending_writes.erase(it);
+	}
+	if (files_with_pending_writes.empty()) {
+		TIMER_DelTickHandler(FlushStaleWrites);
+	}
+
+	if (ret.error || ret.num_bytes != num_bytes) {
+		LOG_WARNING("FS: Failed writing buffered data to file '%s'",
+		            path_string.c_str());
+		has_write_error = true;
+	}
+}
+
 bool localFile::Read(uint8_t* data, uint16_t* num_bytes)
 {
 	assert(file_handle != InvalidNativeFileHandle);
@@ -561,10 +662,14 @@ bool localFile::Read(uint8_t* data, uint16_t* num_bytes)
 		return false;
 	}
 
+	// The data might still be in the write-behind buffer of this or another
+	// handle to the same file
+	FlushWritesTo(path_string);
+
 	// Store last path to enable disk noise to choose sequential vs. random
 	// access noises
 	DiskNoises::GetInstance()->SetLastIoPath(
-	        path.string(),
+	        path_string,
 	        DiskNoiseIoType::Read,
 	        DOS_GetDiskTypeFromMediaByte(local_drive.lock()->GetMediaByte()));
 
@@ -578,10 +683,12 @@ bool localFile::Read(uint8_t* data, uint16_t* num_bytes)
 	/* Fake harddrive motion. Inspector Gadget with Sound Blaster compatible */
 	/* Same for Igor */
 	/* hardrive motion => unmask irq 2. Only do it when it's masked as
-	 * unmasking is realitively heavy to emulate */
-	uint8_t mask = IO_Read(0x21);
-	if (mask & 0x4)
-		IO_Write(0x21, mask & 0xfb);
+	 * unmasking is realitively heavy to emulate. The mask is checked
+	 * directly, as going through the port costs an emulated I/O delay on
+	 * every read */
+	if (PIC_IsIRQMasked(2)) {
+		PIC_SetIRQMask(2, false);
+	}
 
 	return true;
 }
@@ -598,10 +705,23 @@ bool localFile::Write(uint8_t* data, uint16_t* num_bytes)
 	// File should always be opened in read-only mode if on read-only drive
 	assert(!IsOnReadOnlyMedium());
 
+	// Report held back data that couldn't be written out, as the write
+	// that got it reported as done can't anymore
+	if (has_write_error) {
+		has_write_error = false;
+		*num_bytes      = 0;
+		DOS_SetError(DOSERR_ACCESS_DENIED);
+		return false;
+	}
+
 	set_archive_on_close = true;
 
 	// Truncate the file
 	if (*num_bytes == 0) {
+		if (!Flush()) {
+			DOS_SetError(DOSERR_ACCESS_DENIED);
+			return false;
+		}
 		if (!truncate_native_file(file_handle)) {
 			LOG_DEBUG("FS: Failed truncating file '%s'", name.c_str());
 			return false;
@@ -613,11 +733,32 @@ bool localFile::Write(uint8_t* data, uint16_t* num_bytes)
 	// Store last path to enable disk noise to choose sequential vs. random
 	// access noises
 	DiskNoises::GetInstance()->SetLastIoPath(
-	        path.string(),
+	        path_string,
 	        DiskNoiseIoType::Write,
 	        DOS_GetDiskTypeFromMediaByte(local_drive.lock()->GetMediaByte()));
 
-	// Otherwise we have some data to write
+	// Otherwise we have some data to write. Small writes are held back,
+	// and reported as done straight away.
+	if (write_buffer.size() + *num_bytes <= WriteBehindBufferSize) {
+		if (write_buffer.empty()) {
+			write_buffer.reserve(WriteBehindBufferSize);
+			write_buffer_ticks = GetTicks();
+
+			if (files_with_pending_writes.empty()) {
+				TIMER_AddTickHandler(FlushStaleWrites);
+			}
+			files_with_pending_writes.push_back(this);
+		}
+		write_buffer.insert(write_buffer.end(), data, data + *num_bytes);
+		return true;
+	}
+
+	// Larger writes go straight through, after what's already buffered
+	if (!Flush()) {
+		*num_bytes = 0;
+		DOS_SetError(DOSERR_ACCESS_DENIED);
+		return false;
+	}
 	const auto ret = write_native_file(file_handle, data, *num_bytes);
 	*num_bytes     = check_cast<uint16_t>(ret.num_bytes);
 	if (ret.error) {
@@ -632,6 +773,25 @@ bool localFile::Seek(uint32_t *pos_addr, uint32_t type)
 {
 	assert(file_handle != InvalidNativeFileHandle);
 
+	// Asking for the current position is common between writes, and
+	// doesn't need the buffered data written out
+	if (type == DOS_SEEK_CUR && *pos_addr == 0 && !write_buffer.empty()) {
+		const auto current_pos = get_native_file_position(file_handle);
+		if (current_pos != NativeSeekFailed) {
+			*pos_addr = check_cast<uint32_t>(
+			        current_pos + static_cast<int64_t>(write_buffer.size()));
+			return true;
+		}
+	}
+
+	// Write out the buffered data at the current position, and make sure
+	// seeking relative to the end sees what other handles wrote too
+	if (type == DOS_SEEK_END) {
+		FlushWritesTo(path_string);
+	} else {
+		FlushHeldBackWrites();
+	}
+
 	// Tested this interrupt on MS-DOS 6.22
 	// The values for SEEK_CUR and SEEK_END can be negative
 	// But some games/programs depend on the wrapping behavior of a 32-bit integer
@@ -713,6 +873,8 @@ void localFile::MaybeFlushTime()
 	// if there are no other references to the drive.
 	const auto drive_ptr = local_drive.lock();
 	if (drive_ptr) {
+		drive_ptr->dirCache.ForgetFileDetails();
+
 		auto& cache = drive_ptr->timestamp_cache;
 		auto entry  = cache.find(path.string());
 		if (entry != cache.end()) {
@@ -728,6 +890,10 @@ void localFile::Close()
 {
 	assert(file_handle != InvalidNativeFileHandle);
 
+	// DOS closes and commits the file on every close of a handle. A
+	// failure is reported by DOS_CloseFile(), which commits it first.
+	FlushHeldBackWrites();
+
 	// only close if one reference left
 	if (refCtr == 1) {
 		if (set_archive_on_close) {
@@ -740,6 +906,11 @@ void localFile::Close()
 				local_drive_set_attributes(path, attributes);
 			}
 			set_archive_on_close = false;
+
+			// The file's size may have changed too
+			if (const auto drive_ptr = local_drive.lock(); drive_ptr) {
+				drive_ptr->dirCache.ForgetFileDetails();
+			}
 		}
 
 		// Not sure if setting extended attributes modifies the time.
@@ -767,6 +938,7 @@ localFile::localFile(const char* _name, const std_fs::path& path,
           file_handle(handle),
           path(path),
           basedir(_basedir),
+          path_string(path.string()),
           read_only_medium(_read_only_medium)
 {
 	assert(file_handle != InvalidNativeFileHandle);
@@ -5,6 +5,10 @@
 #ifndef DOSBOX_DRIVE_LOCAL_H
 #define DOSBOX_DRIVE_LOCAL_H
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
 #include "dos_system.h"
 #include "drives.h"
 
@@ -21,6 +25,8 @@ public:
 	bool Write(uint8_t* data, uint16_t* size) override;
 	bool Seek(uint32_t* pos, uint32_t type) override;
 	void Close() override;
+	bool Flush() override;
+	void FlushHeldBackWrites() override;
 	uint16_t GetInformation() override;
 	bool IsOnReadOnlyMedium() const override { return read_only_medium; }
 	const char* GetBaseDir() const
@@ -36,9 +42,27 @@ public:
 
 private:
 	void MaybeFlushTime();
+	static void FlushStaleWrites();
+
+	// Writes out the write-behind buffers of the handles to a host file
+	static void FlushWritesTo(const std::string& host_path);
+
 	const std_fs::path path = {};
 	const char* basedir     = nullptr;
 
+	// Kept so the disk noise hook doesn't have to convert the path on
+	// every read and write
+	const std::string path_string = {};
+
+	// Small writes are collected here and written to the host file in one
+	// go on the next seek, read, commit or close, or after a short while.
+	std::vector<uint8_t> write_buffer = {};
+	int64_t write_buffer_ticks        = 0;
+
+	// Set when buffered data couldn't be written out, until the next
+	// write, commit or close reports it to the program
+	bool has_write_error = false;
+
 	const bool read_only_medium = false;
 	bool set_archive_on_close   = false;
 };
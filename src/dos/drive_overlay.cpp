@@ -55,6 +55,26 @@ bool logoverlay = false;
  * it changes (when deleting a file or adding one)
  */
 
+// Returns the DOS directory holding the given DOS name, or an empty string
+// for names in the root directory
+static std::string dos_parent_dir(const std::string& dos_name)
+{
+	const auto pos = dos_name.rfind('\\');
+	return (pos == std::string::npos) ? std::string() : dos_name.substr(0, pos);
+}
+
+// Checks if the DOS name lies somewhere below the DOS directory. Everything
+// lies below the root directory, which is an empty string.
+static bool is_inside_dos_dir(const std::string& dos_name, const std::string& dos_dir)
+{
+	if (dos_dir.empty()) {
+		return true;
+	}
+	return dos_name.size() > dos_dir.size() &&
+	       dos_name[dos_dir.size()] == '\\' &&
+	       dos_name.compare(0, dos_dir.size(), dos_dir) == 0;
+}
+
 
 //directories that exist only in overlay can not be added to the drive_cache currently. 
 //Either upgrade addentry to support directories. (without actually caching stuff in! (code in testing))
@@ -82,7 +102,7 @@ bool Overlay_Drive::RemoveDir(const char * dir) {
 			safe_strcat(newdir, dir);
 			CROSS_FILENAME(newdir);
 			dirCache.DeleteEntry(newdir,true);
-			update_cache(false);
+			restore_cache_entries(dos_parent_dir(dir));
 		}
 		return result_ok;
 	} else {
@@ -271,23 +291,6 @@ std::pair<NativeFileHandle, std_fs::path> Overlay_Drive::create_file_in_overlay(
 	return {file_handle, newname};
 }
 
-#ifndef BUFSIZ
-#define BUFSIZ 2048
-#endif
-
-static void copy_file_contents(const NativeFileHandle src, const NativeFileHandle dst)
-{
-	uint8_t buffer[BUFSIZ] = {};
-	while (true) {
-		const auto ret = read_native_file(src, buffer, BUFSIZ);
-		if (ret.num_bytes > 0) {
-			write_native_file(dst, buffer, ret.num_bytes);
-		} else {
-			break;
-		}
-	}
-}
-
 bool OverlayFile::create_copy()
 {
 	//test if open/valid/etc
@@ -311,6 +314,7 @@ bool OverlayFile::create_copy()
 	}
 
 	NativeFileHandle newhandle = InvalidNativeFileHandle;
+	std_fs::path newpath       = {};
 	uint8_t drive_set = GetDrive();
 	if (drive_set != 0xff && drive_set < DOS_DRIVES && Drives[drive_set]){
 		const auto od = std::dynamic_pointer_cast<Overlay_Drive>(
@@ -318,7 +322,6 @@ bool OverlayFile::create_copy()
 		if (od) {
 			FatAttributeFlags attributes = {};
 			local_drive_get_attributes(GetPath(), attributes);
-			std_fs::path newpath = {};
 			std::tie(newhandle,
 			         newpath) = od->create_file_in_overlay(GetName(),
 			                                               attributes);
@@ -329,7 +332,18 @@ bool OverlayFile::create_copy()
 		return false;
 	}
 
-	copy_file_contents(file_handle, newhandle);
+	// Large files are cloned or copied by the host where possible, so
+	// the first write to them doesn't stall the emulation for long
+	if (!copy_native_file(file_handle, newhandle)) {
+		LOG_ERR("OVERLAY: Failed copying file '%s' to the overlay: %s",
+		        GetName(),
+		        strerror(errno));
+		close_native_file(newhandle);
+
+		// Don't leave a partial copy to hide the original
+		delete_native_file(newpath);
+		return false;
+	}
 
 	//Set copied file handle to position of the old one
 	if (seek_native_file(newhandle, location_in_old_file, NativeSeek::Set) ==
@@ -368,6 +382,7 @@ Overlay_Drive::Overlay_Drive(const char *startdir,
           overlap_folder(),
           DOSnames_cache{},
           DOSdirs_cache{},
+          DOSdirs_index{},
           special_prefix("DBOVERLAY")
 {
 	//Currently this flag does nothing, as the current behavior is to not reread due to caching everything.
@@ -579,17 +594,50 @@ std::unique_ptr<DOS_File> Overlay_Drive::FileCreate(const char* name,
 }
 
 void Overlay_Drive::add_DOSname_to_cache(const char* name) {
-	for (std::vector<std::string>::const_iterator itc = DOSnames_cache.begin(); itc != DOSnames_cache.end(); ++itc){
-		if (name == (*itc)) return;
-	}
-	DOSnames_cache.push_back(name);
+	DOSnames_cache.insert(name);
 }
 
 void Overlay_Drive::remove_DOSname_from_cache(const char* name) {
-	for (std::vector<std::string>::iterator it = DOSnames_cache.begin(); it != DOSnames_cache.end(); ++it) {
-		if (name == (*it)) { DOSnames_cache.erase(it); return;}
+	DOSnames_cache.erase(name);
+}
+
+// The drive cache throws away a whole directory (including everything below
+// it) when a file in it is removed or renamed, and reads it back from the base
+// directory on the next access. This puts the overlay-only directories and
+// the overlay files in there back, without touching the rest of the cache.
+void Overlay_Drive::restore_cache_entries(const std::string& dos_dir) {
+#if OVERLAY_DIR
+	// Parents come first in DOSdirs_cache, so they are added before their
+	// subdirectories
+	for (const auto& dos_name : DOSdirs_cache) {
+		if (!is_inside_dos_dir(dos_name, dos_dir)) continue;
+		char fakename[CROSS_LEN];
+		safe_strcpy(fakename, basedir);
+		safe_strcat(fakename, dos_name.c_str());
+		CROSS_FILENAME(fakename);
+		dirCache.AddEntryDirOverlay(fakename,true);
+	}
+#endif
+
+	for (const auto& dos_name : DOSnames_cache) {
+		if (!is_inside_dos_dir(dos_name, dos_dir)) continue;
+		char fakename[CROSS_LEN];
+		safe_strcpy(fakename, basedir);
+		safe_strcat(fakename, dos_name.c_str());
+		CROSS_FILENAME(fakename);
+		dirCache.AddEntry(fakename,true);
 	}
+}
 
+// Throws away the cached directory holding the DOS name, and restores the
+// overlay entries in it.
+void Overlay_Drive::refresh_cache_of(const char* dos_name) {
+	char fakename[CROSS_LEN];
+	safe_strcpy(fakename, basedir);
+	safe_strcat(fakename, dos_name);
+	CROSS_FILENAME(fakename);
+	dirCache.CacheOut(fakename);
+	restore_cache_entries(dos_parent_dir(dos_name));
 }
 
 bool Overlay_Drive::Sync_leading_dirs(const char* dos_filename){
@@ -648,6 +696,7 @@ void Overlay_Drive::update_cache(bool read_directory_contents) {
 		//Clear all lists
 		DOSnames_cache.clear();
 		DOSdirs_cache.clear();
+		DOSdirs_index.clear();
 		deleted_files_in_base.clear();
 		deleted_paths_in_base.clear();
 		//Ensure hiding of the folder that contains the overlay, if it is part of the base folder.
@@ -670,8 +719,8 @@ void Overlay_Drive::update_cache(bool read_directory_contents) {
 
 	//Random TODO: Does the root drive under DOS have . and .. ? 
 
-	//This function needs to be called after any localDrive function calling cacheout/deleteentry, as those throw away directories.
-	//either do this with a parameter stating the part that needs to be rebuild,(directory) or clear the cache by default and do it all.
+	//This function needs to be called after the drive cache has been emptied. After a localDrive function calling cacheout/deleteentry,
+	//which throw away a single directory, restore_cache_entries() only puts back what was in that directory.
 
 	std::vector<std::string>::iterator i;
 	std::string::size_type const prefix_lengh = special_prefix.length();
@@ -694,11 +743,12 @@ void Overlay_Drive::update_cache(bool read_directory_contents) {
 		close_directory(dirp);
 		dirp = nullptr;
 
-		// parse directories to add them.
-		for (i = dirnames.begin(); i != dirnames.end(); ++i) {
-			if ((*i) == ".") continue;
-			if ((*i) == "..") continue;
-			std::string testi(*i);
+		// parse directories to add them. The subdirectories found are
+		// appended while looping, so go by index.
+		for (size_t d = 0; d < dirnames.size(); ++d) {
+			const std::string testi(dirnames[d]);
+			if (testi == ".") continue;
+			if (testi == "..") continue;
 			std::string::size_type ll = testi.length();
 			//TODO: Use the dirname\. and dirname\.. for creating fake directories in the driveCache.
 			if( ll >2 && testi[ll-1] == '.' && testi[ll-2] == CROSS_FILESPLIT) continue; 
@@ -706,16 +756,16 @@ void Overlay_Drive::update_cache(bool read_directory_contents) {
 
 #if OVERLAY_DIR
 			char tdir[CROSS_LEN];
-			safe_strcpy(tdir, (*i).c_str());
+			safe_strcpy(tdir, testi.c_str());
 			CROSS_DOSFILENAME(tdir);
 			bool dir_exists_in_base = localDrive::TestDir(tdir);
 #endif
 
 			char dir[CROSS_LEN];
 			safe_strcpy(dir, overlaydir);
-			safe_strcat(dir, (*i).c_str());
+			safe_strcat(dir, testi.c_str());
 			char dirpush[CROSS_LEN];
-			safe_strcpy(dirpush, (*i).c_str());
+			safe_strcpy(dirpush, testi.c_str());
 			static char end[2] = {CROSS_FILESPLIT,0};
 			safe_strcat(dirpush, end); // Linux ?
 
@@ -728,8 +778,6 @@ void Overlay_Drive::update_cache(bool read_directory_contents) {
 			if (!dir_exists_in_base) add_DOSdir_to_cache(tdir);
 #endif
 
-			std::string backupi(*i);
-
 			auto maybe_add_path = [&]() {
 				if ((safe_strlen(dir_name) > prefix_lengh + 5) &&
 				    strncmp(dir_name,
@@ -754,13 +802,6 @@ void Overlay_Drive::update_cache(bool read_directory_contents) {
 			}
 			close_directory(dirp);
 			dirp = nullptr;
-
-			// find current directory again, for the next round. But
-			// if it's not there, then bail out before the next
-			// round to avoid incrementing beyond the end.
-			i = std::find(dirnames.begin(), dirnames.end(), backupi);
-			if (i == dirnames.end())
-				break;
 		}
 	}
 
@@ -772,27 +813,11 @@ void Overlay_Drive::update_cache(bool read_directory_contents) {
 			upcase(dosname);  //Should not be really needed, as uppercase in the overlay is a requirement...
 			CROSS_DOSFILENAME(dosname);
 			if (logoverlay) LOG_MSG("update cache add dosname %s",dosname);
-			DOSnames_cache.push_back(dosname);
+			DOSnames_cache.insert(dosname);
 		}
 	}
 
-#if OVERLAY_DIR
-	for (i = DOSdirs_cache.begin(); i !=DOSdirs_cache.end(); ++i) {
-		char fakename[CROSS_LEN];
-		safe_strcpy(fakename, basedir);
-		safe_strcat(fakename, (*i).c_str());
-		CROSS_FILENAME(fakename);
-		dirCache.AddEntryDirOverlay(fakename,true);
-	}
-#endif
-
-	for (i = DOSnames_cache.begin(); i != DOSnames_cache.end(); ++i) {
-		char fakename[CROSS_LEN];
-		safe_strcpy(fakename, basedir);
-		safe_strcat(fakename, (*i).c_str());
-		CROSS_FILENAME(fakename);
-		dirCache.AddEntry(fakename,true);
-	}
+	restore_cache_entries("");
 
 	if (read_directory_contents) {
 		for (i = specials.begin(); i != specials.end(); ++i) {
@@ -1000,7 +1025,7 @@ bool Overlay_Drive::FileUnlink(const char * name) {
 		//Check if it exists in the base dir as well
 		dirCache.DeleteEntry(basename);
 
-		update_cache(false);
+		restore_cache_entries(dos_parent_dir(name));
 		timestamp_cache.erase(basename);
 		if (logoverlay) {
 			LOG_MSG("OPTIMISE: unlink took %" PRId64, GetTicksSince(a));
@@ -1058,10 +1083,8 @@ bool Overlay_Drive::SetFileAttr(const char* name, FatAttributeFlags attr)
 
 void Overlay_Drive::add_deleted_file(const char* name,bool create_on_disk) {
 	if (logoverlay) LOG_MSG("add del file %s",name);
-	if (!is_deleted_file(name)) {
-		deleted_files_in_base.push_back(name);
+	if (deleted_files_in_base.insert(name).second) {
 		if (create_on_disk) add_special_file_to_disk(name, "DEL");
-
 	}
 }
 
@@ -1107,53 +1130,38 @@ std::string Overlay_Drive::create_filename_of_special_operation(const char* dosn
 
 bool Overlay_Drive::is_dir_only_in_overlay(const char* name) {
 	if (!name || !*name) return false;
-	if (DOSdirs_cache.empty()) return false;
-	for(std::vector<std::string>::iterator it = DOSdirs_cache.begin(); it != DOSdirs_cache.end(); ++it) {
-		if (*it == name) return true;
-	}
-	return false;
+	return DOSdirs_index.count(name) > 0;
 }
 
 bool Overlay_Drive::is_deleted_file(const char* name) {
 	if (!name || !*name) return false;
-	if (deleted_files_in_base.empty()) return false;
-	for(std::vector<std::string>::iterator it = deleted_files_in_base.begin(); it != deleted_files_in_base.end(); ++it) {
-		if (*it == name) return true;
-	}
-	return false;
+	return deleted_files_in_base.count(name) > 0;
 }
 
 void Overlay_Drive::add_DOSdir_to_cache(const char* name) {
 	if (!name || !*name ) return; //Skip empty file.
 	LOG_MSG("Adding name to overlay_only_dir_cache %s",name);
-	if (!is_dir_only_in_overlay(name)) {
-		DOSdirs_cache.push_back(name); 
+	if (DOSdirs_index.insert(name).second) {
+		DOSdirs_cache.push_back(name);
 	}
 }
 
 void Overlay_Drive::remove_DOSdir_from_cache(const char* name) {
-	for(std::vector<std::string>::iterator it = DOSdirs_cache.begin(); it != DOSdirs_cache.end(); ++it) {
-		if ( *it == name) {
-			DOSdirs_cache.erase(it);
-			return;
-		}
-	}
+	if (DOSdirs_index.erase(name) == 0) return;
+	const auto it = std::find(DOSdirs_cache.begin(), DOSdirs_cache.end(), name);
+	if (it != DOSdirs_cache.end()) DOSdirs_cache.erase(it);
 }
 
 void Overlay_Drive::remove_deleted_file(const char* name,bool create_on_disk) {
-	for(std::vector<std::string>::iterator it = deleted_files_in_base.begin(); it != deleted_files_in_base.end(); ++it) {
-		if (*it == name) {
-			deleted_files_in_base.erase(it);
-			if (create_on_disk) remove_special_file_from_disk(name, "DEL");
-			return;
-		}
+	if (deleted_files_in_base.erase(name) > 0) {
+		if (create_on_disk) remove_special_file_from_disk(name, "DEL");
 	}
 }
 void Overlay_Drive::add_deleted_path(const char* name, bool create_on_disk) {
 	if (!name || !*name ) return; //Skip empty file.
 	if (logoverlay) LOG_MSG("add del path %s",name);
 	if (!is_deleted_path(name)) {
-		deleted_paths_in_base.push_back(name);
+		deleted_paths_in_base.insert(name);
 		//Add it to deleted files as well, so it gets skipped in FindNext. 
 		//Maybe revise that.
 		if (create_on_disk) add_special_file_to_disk(name,"RMD");
@@ -1163,26 +1171,18 @@ void Overlay_Drive::add_deleted_path(const char* name, bool create_on_disk) {
 bool Overlay_Drive::is_deleted_path(const char* name) {
 	if (!name || !*name) return false;
 	if (deleted_paths_in_base.empty()) return false;
-	std::string sname(name);
-	std::string::size_type namelen = sname.length();;
-	for(std::vector<std::string>::iterator it = deleted_paths_in_base.begin(); it != deleted_paths_in_base.end(); ++it) {
-		std::string::size_type blockedlen = (*it).length();
-		if (namelen < blockedlen) continue;
-		//See if input starts with name. 
-		std::string::size_type n = sname.find(*it);
-		if (n == 0 && ((namelen == blockedlen) || *(name + blockedlen) == '\\' )) return true;
+	//The name is deleted if it, or any of the directories leading to it, is.
+	const std::string sname(name);
+	for (auto pos = sname.find('\\'); pos != std::string::npos; pos = sname.find('\\', pos + 1)) {
+		if (deleted_paths_in_base.count(sname.substr(0, pos))) return true;
 	}
-	return false;
+	return deleted_paths_in_base.count(sname) > 0;
 }
 
 void Overlay_Drive::remove_deleted_path(const char* name, bool create_on_disk) {
-	for(std::vector<std::string>::iterator it = deleted_paths_in_base.begin(); it != deleted_paths_in_base.end(); ++it) {
-		if (*it == name) {
-			deleted_paths_in_base.erase(it);
-			remove_deleted_file(name,false); //Rethink maybe.
-			if (create_on_disk) remove_special_file_from_disk(name,"RMD");
-			break;
-		}
+	if (deleted_paths_in_base.erase(name) > 0) {
+		remove_deleted_file(name,false); //Rethink maybe.
+		if (create_on_disk) remove_special_file_from_disk(name,"RMD");
 	}
 }
 bool Overlay_Drive::check_if_leading_is_deleted(const char* name){
@@ -1283,9 +1283,16 @@ bool Overlay_Drive::Rename(const char * oldname, const char * newname) {
 			close_native_file(o);
 			return false;
 		}
-		copy_file_contents(o, n);
+		const auto copied = copy_native_file(o, n);
 		close_native_file(o);
 		close_native_file(n);
+		if (!copied) {
+			LOG_ERR("OVERLAY: Failed copying file '%s' to the overlay: %s",
+			        oldname,
+			        strerror(errno));
+			delete_native_file(path);
+			return false;
+		}
 
 		//File copied.
 		//Mark old file as deleted
@@ -1301,8 +1308,14 @@ bool Overlay_Drive::Rename(const char * oldname, const char * newname) {
 		//handle the drive_cache (a bit better)
 		//Ensure that the file is not marked as deleted anymore.
 		if (is_deleted_file(newname)) remove_deleted_file(newname,true);
-		dirCache.EmptyCache();
-		update_cache(true);
+		//The file now lives in the overlay under its new name. Only the
+		//directories of both names need refreshing.
+		remove_DOSname_from_cache(oldname);
+		add_DOSname_to_cache(newname);
+		refresh_cache_of(oldname);
+		if (dos_parent_dir(oldname) != dos_parent_dir(newname)) {
+			refresh_cache_of(newname);
+		}
 		if (logoverlay) {
 			LOG_MSG("OPTIMISE: rename took %" PRId64, GetTicksSince(a));
 		}
@@ -348,6 +348,10 @@ void MOUNT::Run(void) {
 				        readonly,
 				        section->GetBool(
 				                "allow_write_protected_files"));
+
+				if (section->GetBool("watch_mounted_dirs")) {
+					newdrive->dirCache.EnableHostWatching();
+				}
 			}
 		}
 	} else {
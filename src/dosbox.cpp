@@ -188,8 +188,9 @@ static void increase_ticks()
 	// remove the global variable.
 	ZoneScoped;
 
-	// For fast-forward mode
-	if (ticks.locked) {
+	// For fast-forward mode, and when rendering offline where the output
+	// is paced by emulated time only
+	if (ticks.locked || CAPTURE_IsOfflineRendering()) {
 		ticks.remain = 5;
 
 		// Reset any auto cycle guessing for this frame
@@ -769,6 +770,14 @@ void DOSBOX_InitAllModuleConfigsAndMessages()
 	        "Currently, you need to disable this for a few games, otherwise they will crash\n"
 	        "at startup (e.g., Deus, Ishar 3, Robinson's Requiem, Time Warriors).");
 
+	pbool = secprop->AddBool("vga_render_whole_frames", only_at_start, false);
+	pbool->SetHelp(
+	        "Draw each VGA frame in one go at the end of the frame instead of line by\n"
+	        "line, which reduces emulation overhead ('off' by default). If a game changes\n"
+	        "the VGA registers or palette while a frame is being displayed, the rest of\n"
+	        "that frame is drawn line by line as usual. Changes to the video memory are\n"
+	        "not tracked, so effects that race the beam may look different.");
+
 	pbool = secprop->AddBool("speed_mods", only_at_start, true);
 	pbool->SetHelp(
 	        "Permit changes known to improve performance ('on' by default).\n"
@@ -822,6 +831,13 @@ void DOSBOX_InitAllModuleConfigsAndMessages()
 	        "using a copy-on-write or network-based filesystem, this setting avoids\n"
 	        "triggering write operations for these write-protected files.");
 
+	pbool = secprop->AddBool("watch_mounted_dirs", only_at_start, false);
+	pbool->SetHelp(
+	        "Watch mounted host directories for changes ('off' by default). Files added,\n"
+	        "removed, or modified on the host while DOSBox is running are then picked up\n"
+	        "without having to run RESCAN, and directory listings are faster as the file\n"
+	        "details are cached. Only supported on Linux.");
+
 	pbool = secprop->AddBool("shell_config_shortcuts", when_idle, true);
 	pbool->SetHelp(
 	        "Allow shortcuts for simpler configuration management ('on' by default).\n"
@@ -1282,6 +1298,14 @@ void DOSBOX_InitAllModuleConfigsAndMessages()
 	        "(e.g., Astral Blur demo). If you experience crashes related to file\n"
 	        "permissions, you can try disabling this.");
 
+	pint = secprop->AddInt("cdrom_sector_cache", when_idle, 1024);
+	pint->SetMinMax(16, 65536);
+	pint->SetHelp(
+	        "Number of 2 KB sectors cached for each mounted CD-ROM image (1024 by default,\n"
+	        "which is 2 MB). The cache holds the directory sectors, so larger values speed\n"
+	        "up listings and file lookups on CDs with many or deep directories. Takes\n"
+	        "effect for images mounted after the change.");
+
 	// Mscdex
 	secprop->AddInitFunction(&MSCDEX_Init);
 	secprop->AddInitFunction(&DRIVES_Init);
@@ -7,6 +7,7 @@
 #include <cassert>
 #include <cmath>
 #include <cstdlib>
+#include <cstring>
 #include <memory>
 #include <mutex>
 
@@ -16,6 +17,7 @@
 #include "mapper.h"
 #include "math_utils.h"
 #include "render.h"
+#include "render_line_compare.h"
 #include "setup.h"
 #include "shader_manager.h"
 #include "shell.h"
@@ -116,26 +118,27 @@ static void empty_line_handler(const void*) {}
 static void start_line_handler(const void* s)
 {
 	if (s) {
-		auto src = static_cast<const uintptr_t*>(s);
-		auto cache = reinterpret_cast<uintptr_t*>(render.scale.cacheRead);
-		for (Bits x = render.src_start; x > 0;) {
-			const auto src_ptr = reinterpret_cast<const uint8_t*>(src);
-			const auto src_val = read_unaligned_size_t(src_ptr);
-			if (src_val != cache[0]) {
-				if (!GFX_StartUpdate(render.scale.outWrite,
-				                     render.scale.outPitch)) {
-					RENDER_DrawLine = empty_line_handler;
-					return;
-				}
-				render.scale.outWrite += render.scale.outPitch *
-				                         Scaler_ChangedLines[0];
-				RENDER_DrawLine = render.scale.lineHandler;
-				RENDER_DrawLine(s);
+		const auto first_change = find_first_line_change(
+		        static_cast<const uint8_t*>(s),
+		        render.scale.cacheRead,
+		        render.src_line_bytes);
+
+		if (first_change < render.src_line_bytes) {
+			if (!GFX_StartUpdate(render.scale.outWrite,
+			                     render.scale.outPitch)) {
+				RENDER_DrawLine = empty_line_handler;
 				return;
 			}
-			x--;
-			src++;
-			cache++;
+			render.scale.outWrite += render.scale.outPitch *
+			                         Scaler_ChangedLines[0];
+
+			// Let the scaler start at the first changed pixel
+			render.scale.skipPixels = check_cast<uint32_t>(
+			        first_change / render.src_pixel_bytes);
+
+			RENDER_DrawLine = render.scale.lineHandler;
+			RENDER_DrawLine(s);
+			return;
 		}
 	}
 	render.scale.cacheRead += render.scale.cachePitch;
@@ -147,26 +150,17 @@ static void start_line_handler(const void* s)
 static void finish_line_handler(const void* s)
 {
 	if (s) {
-		auto src = static_cast<const uintptr_t*>(s);
-		auto cache = reinterpret_cast<uintptr_t*>(render.scale.cacheRead);
-		for (Bits x = render.src_start; x > 0;) {
-			cache[0] = src[0];
-			x--;
-			src++;
-			cache++;
-		}
+		std::memcpy(render.scale.cacheRead, s, render.src_line_bytes);
 	}
 	render.scale.cacheRead += render.scale.cachePitch;
 }
 
 static void clear_cache_handler(const void* src)
 {
-	const uint32_t* srcLine = (const uint32_t*)src;
-	uint32_t* cacheLine     = (uint32_t*)render.scale.cacheRead;
-	Bitu width              = render.scale.cachePitch / 4;
-	for (Bitu x = 0; x < width; x++) {
-		cacheLine[x] = ~srcLine[x];
-	}
+	invert_line(static_cast<const uint8_t*>(src),
+	            render.scale.cacheRead,
+	            render.scale.cachePitch);
+
 	render.scale.lineHandler(src);
 }
 
@@ -362,24 +356,11 @@ static void render_reset()
 	yscale    = simpleBlock->yscale;
 	//		LOG_MSG("Scaler:%s",simpleBlock->name);
 
-	constexpr auto src_pixel_bytes = sizeof(uintptr_t);
+	// RGB555 has 15 bits per pixel but is stored in 16
+	render.src_pixel_bytes = (get_bits_per_pixel(render.src.pixel_format) + 7) / 8;
+	render.src_line_bytes  = render.src.width * render.src_pixel_bytes;
 
-	switch (render.src.pixel_format) {
-	case PixelFormat::Indexed8:
-	case PixelFormat::RGB555_Packed16:
-	case PixelFormat::RGB565_Packed16:
-		render.src_start = (render.src.width * 2) / src_pixel_bytes;
-		gfx_flags        = (gfx_flags & ~GFX_CAN_8);
-		break;
-	case PixelFormat::BGR24_ByteArray:
-		render.src_start = (render.src.width * 3) / src_pixel_bytes;
-		gfx_flags        = (gfx_flags & ~GFX_CAN_8);
-		break;
-	case PixelFormat::BGRX32_ByteArray:
-		render.src_start = (render.src.width * 4) / src_pixel_bytes;
-		gfx_flags        = (gfx_flags & ~GFX_CAN_8);
-		break;
-	}
+	gfx_flags = (gfx_flags & ~GFX_CAN_8);
 
 	gfx_flags = GFX_GetBestMode(gfx_flags);
 
@@ -553,6 +534,12 @@ static void setup_scan_and_pixel_doubling()
 		force_no_pixel_doubling = shader_info.settings.force_no_pixel_doubling;
 	} break;
 
+	case RenderingBackend::Headless:
+		// Keep the image as the emulated card outputs it
+		force_vga_single_scan   = false;
+		force_no_pixel_doubling = false;
+		break;
+
 	default: assertm(false, "Invalid RenderindBackend value");
 	}
 
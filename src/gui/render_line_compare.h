@@ -0,0 +1,95 @@
+// SPDX-FileCopyrightText:  2025-2025 The DOSBox Staging Team
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef DOSBOX_RENDER_LINE_COMPARE_H
+#define DOSBOX_RENDER_LINE_COMPARE_H
+
+/*  Render Line Compare
+ *  -------------------
+ *  The renderer keeps a copy of the previous frame's source lines, and only
+ *  scales and outputs the lines that differ from it. Most lines of a DOS
+ *  screen don't change between frames, so finding out whether a line has
+ *  changed (and where) is the most common operation of the render pipeline.
+ *
+ *  These helpers work on 16 bytes at a time regardless of the pixel format;
+ *  they only deal with raw line bytes.
+ */
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "simde/x86/sse2.h"
+
+// Returns the offset of the first byte that differs between the two lines,
+// or 'num_bytes' if they're identical.
+inline size_t find_first_line_change(const uint8_t* src, const uint8_t* cache,
+                                     const size_t num_bytes)
+{
+	constexpr size_t VectorBytes = sizeof(simde__m128i);
+	constexpr auto AllSame       = 0xffff;
+
+	size_t offset = 0;
+
+	// Check two vectors per iteration, as the lines are usually identical
+	for (; offset + 2 * VectorBytes <= num_bytes; offset += 2 * VectorBytes) {
+		const auto src_lo = simde_mm_loadu_si128(
+		        reinterpret_cast<const simde__m128i*>(src + offset));
+		const auto src_hi = simde_mm_loadu_si128(reinterpret_cast<const simde__m128i*>(
+		        src + offset + VectorBytes));
+		const auto cache_lo = simde_mm_loadu_si128(
+		        reinterpret_cast<const simde__m128i*>(cache + offset));
+		const auto cache_hi = simde_mm_loadu_si128(reinterpret_cast<const simde__m128i*>(
+		        cache + offset + VectorBytes));
+
+		const auto same = simde_mm_and_si128(simde_mm_cmpeq_epi8(src_lo, cache_lo),
+		                                     simde_mm_cmpeq_epi8(src_hi, cache_hi));
+
+		if (simde_mm_movemask_epi8(same) != AllSame) {
+			break;
+		}
+	}
+
+	for (; offset + VectorBytes <= num_bytes; offset += VectorBytes) {
+		const auto same = simde_mm_movemask_epi8(simde_mm_cmpeq_epi8(
+		        simde_mm_loadu_si128(reinterpret_cast<const simde__m128i*>(src + offset)),
+		        simde_mm_loadu_si128(reinterpret_cast<const simde__m128i*>(
+		                cache + offset))));
+
+		if (same != AllSame) {
+			const auto first_diff = std::countr_one(static_cast<uint32_t>(same));
+			return offset + static_cast<size_t>(first_diff);
+		}
+	}
+
+	for (; offset < num_bytes; ++offset) {
+		if (src[offset] != cache[offset]) {
+			break;
+		}
+	}
+	return offset;
+}
+
+// Writes the bitwise inverse of the source line into the cache, so every
+// byte of the line is guaranteed to differ on the next comparison.
+inline void invert_line(const uint8_t* src, uint8_t* cache, const size_t num_bytes)
+{
+	constexpr size_t VectorBytes = sizeof(simde__m128i);
+
+	const auto all_ones = simde_mm_set1_epi8(-1);
+
+	size_t offset = 0;
+	for (; offset + VectorBytes <= num_bytes; offset += VectorBytes) {
+		const auto pixels = simde_mm_loadu_si128(
+		        reinterpret_cast<const simde__m128i*>(src + offset));
+
+		simde_mm_storeu_si128(reinterpret_cast<simde__m128i*>(cache + offset),
+		                      simde_mm_xor_si128(pixels, all_ones));
+	}
+	for (; offset < num_bytes; ++offset) {
+		cache[offset] = static_cast<uint8_t>(~src[offset]);
+	}
+}
+
+#endif // DOSBOX_RENDER_LINE_COMPARE_H
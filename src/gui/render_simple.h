@@ -34,8 +34,15 @@ static void conc4d(SCALERNAME,SBPP,DBPP,R)(const void *s) {
 	auto cache = reinterpret_cast<SRCTYPE*>(render.scale.cacheRead);
 	render.scale.cacheRead += render.scale.cachePitch;
 	PTYPE * line0=(PTYPE *)(render.scale.outWrite);
+
+	/* Skip the start of the line that's already known to be unchanged */
+	const Bits skip = render.scale.skipPixels;
+	render.scale.skipPixels = 0;
+	src += skip;
+	cache += skip;
+	line0 += skip * SCALERWIDTH;
 #if (SBPP == 9)
-	for (Bits x=render.src.width;x>0;) {
+	for (Bits x=render.src.width - skip;x>0;) {
 		if (std::memcmp(src, cache, sizeof(uint32_t)) == 0 &&
 		    (render.pal.modified[src[0]] | render.pal.modified[src[1]] |
 		     render.pal.modified[src[2]] | render.pal.modified[src[3]]) == 0) {
@@ -46,7 +53,7 @@ static void conc4d(SCALERNAME,SBPP,DBPP,R)(const void *s) {
 #else
 	constexpr uint8_t address_step = sizeof(Bitu) / sizeof(SRCTYPE);
 
-	for (Bits x = render.src.width; x > 0;) {
+	for (Bits x = render.src.width - skip; x > 0;) {
 		const auto src_ptr = reinterpret_cast<const uint8_t *>(src);
 		const auto src_val = read_unaligned_size_t(src_ptr);
 
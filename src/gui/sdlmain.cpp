@@ -4,6 +4,7 @@
 
 #include "dosbox.h"
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cerrno>
@@ -38,6 +39,8 @@
 
 #include "../capture/capture.h"
 #include "../dos/dos_locale.h"
+#include "../hardware/voodoo.h"
+#include "../hardware/voodoo_register_stream.h"
 #include "../ints/int10.h"
 #include "control.h"
 #include "cpu.h"
@@ -1077,16 +1080,22 @@ static int benchmark_presentation_rate()
 	// so we can hit the vsync limit (if it exists).
 	render_pacer->SetTimeout(0);
 
-	// Warm-up round
-	for (auto i = 0; i < warmup_frames; ++i) {
+	// The texture backend only presents new frames, so make every frame
+	// count as new
+	auto present_frame = []() {
+		sdl.texture.has_new_frame = true;
 		sdl.frame.update(nullptr);
 		sdl.frame.present();
+	};
+
+	// Warm-up round
+	for (auto i = 0; i < warmup_frames; ++i) {
+		present_frame();
 	}
 	// Measured round
 	const auto start_us = GetTicksUs();
 	for (auto frame = 0; frame < bench_frames; ++frame) {
-		sdl.frame.update(nullptr);
-		sdl.frame.present();
+		present_frame();
 	}
 	const auto elapsed_us = std::max(static_cast<int64_t>(1L),
 	                                 GetTicksUsSince(start_us));
@@ -1286,6 +1295,19 @@ static void maybe_present_synced(const bool present_if_last_skipped)
 
 static void setup_presentation_mode(FrameMode& previous_mode)
 {
+	// Nothing is presented in headless mode, so there's no host rate to
+	// adapt to; the emulated card's rate is used throughout
+	if (sdl.rendering_backend == RenderingBackend::Headless ||
+	    sdl.want_rendering_backend == RenderingBackend::Headless) {
+		const auto dos_rate = VGA_GetPreferredRate();
+		VGA_SetHostRate(dos_rate);
+		save_rate_to_frame_period(dos_rate);
+
+		render_pacer->SetTimeout(0);
+		previous_mode = FrameMode::Vfr;
+		return;
+	}
+
 	// Always get the reported refresh rate and hint the emulated VGA side
 	// with it. This ensures the VGA side always has the host's rate
 	// prior to the next mode change.
@@ -1543,6 +1565,13 @@ static SDL_Window* create_window(const RenderingBackend rendering_backend,
 	flags |= SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI;
 	flags |= opengl_driver_crash_workaround(rendering_backend);
 
+	// The window of the headless backend is only kept around so the
+	// window-related code, such as the mouse handling, has something to
+	// query
+	if (rendering_backend == RenderingBackend::Headless) {
+		flags |= SDL_WINDOW_HIDDEN;
+	}
+
 	if (!sdl.desktop.window.show_decorations) {
 		flags |= SDL_WINDOW_BORDERLESS;
 	}
@@ -1935,12 +1964,62 @@ static void initialize_sdl_window_size(SDL_Window* sdl_window,
 // Texture update and presentation
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-static void update_frame_texture([[maybe_unused]] const uint16_t* changedLines)
+static void upload_texture_rows(const int y, const int height_px)
+{
+	const auto surface = sdl.texture.input_surface;
+	const auto pixels  = static_cast<const uint8_t*>(surface->pixels) +
+	                    y * surface->pitch;
+
+	const SDL_Rect rect = {0, y, sdl.draw.render_width_px, height_px};
+
+	SDL_UpdateTexture(sdl.texture.texture, &rect, pixels, surface->pitch);
+}
+
+static void update_frame_texture(const uint16_t* changedLines)
 {
-	SDL_UpdateTexture(sdl.texture.texture,
-	                  nullptr, // update entire texture
-	                  sdl.texture.input_surface->pixels,
-	                  sdl.texture.input_surface->pitch);
+	// Nothing has been drawn since the last update
+	if (!changedLines) {
+		return;
+	}
+
+	// Unchanged gaps up to this many lines between two changed spans are
+	// uploaded along with them; one larger upload is cheaper than several
+	// small ones
+	constexpr auto MaxMergedGapLines = 8;
+
+	// The changed lines are stored as alternating counts of unchanged and
+	// changed lines, starting with the unchanged ones
+	int y        = 0;
+	size_t index = 0;
+
+	int rect_y      = 0;
+	int rect_height = 0;
+
+	while (y < sdl.draw.render_height_px) {
+		if (!(index & 1)) {
+			y += changedLines[index];
+		} else {
+			const int height_px = changedLines[index];
+
+			if (rect_height > 0 &&
+			    y - (rect_y + rect_height) <= MaxMergedGapLines) {
+				rect_height = y + height_px - rect_y;
+			} else {
+				if (rect_height > 0) {
+					upload_texture_rows(rect_y, rect_height);
+				}
+				rect_y      = y;
+				rect_height = height_px;
+			}
+			y += height_px;
+		}
+		index++;
+	}
+
+	if (rect_height > 0) {
+		upload_texture_rows(rect_y, rect_height);
+		sdl.texture.has_new_frame = true;
+	}
 }
 
 static std::optional<RenderedImage> get_rendered_output_from_backbuffer()
@@ -1956,6 +2035,36 @@ static std::optional<RenderedImage> get_rendered_output_from_backbuffer()
 
 	RenderedImage image = {};
 
+	// The headless backend has no canvas, so the rendered image is the
+	// frame buffer itself
+	if (sdl.rendering_backend == RenderingBackend::Headless) {
+		image.params.width              = sdl.draw.render_width_px;
+		image.params.height             = sdl.draw.render_height_px;
+		image.params.double_width       = false;
+		image.params.double_height      = false;
+		image.params.pixel_aspect_ratio = {1};
+		image.params.pixel_format       = PixelFormat::BGR24_ByteArray;
+		image.params.video_mode         = *sdl.maybe_video_mode;
+
+		image.is_flipped_vertically = false;
+		image.palette_data          = nullptr;
+
+		image.pitch = image.params.width *
+		              (get_bits_per_pixel(image.params.pixel_format) / 8);
+
+		const auto image_size_bytes = check_cast<uint32_t>(
+		        image.params.height * image.pitch);
+		image.image_data = new uint8_t[image_size_bytes];
+
+		auto out = image.image_data;
+		for (const auto pixel : sdl.headless.framebuf) {
+			*out++ = static_cast<uint8_t>(pixel & 0xff);
+			*out++ = static_cast<uint8_t>((pixel >> 8) & 0xff);
+			*out++ = static_cast<uint8_t>((pixel >> 16) & 0xff);
+		}
+		return image;
+	}
+
 	// The draw rect can extends beyond the bounds of the window or the
 	// screen in fullscreen when we're "zooming into" the DOS content in
 	// `relative` viewport mode. But rendered captures should always capture
@@ -2066,8 +2175,16 @@ static std::optional<RenderedImage> get_rendered_output_from_backbuffer()
 
 static bool present_frame_texture()
 {
+	// The window still shows the last presented frame, so there's no need
+	// to draw it again if nothing has changed since
+	if (!sdl.texture.has_new_frame && !CAPTURE_IsCapturingPostRenderImage()) {
+		return false;
+	}
+
 	const auto is_presenting = render_pacer->CanRun();
 	if (is_presenting) {
+		sdl.texture.has_new_frame = false;
+
 		SDL_RenderClear(sdl.renderer);
 		SDL_RenderCopy(sdl.renderer, sdl.texture.texture, nullptr, nullptr);
 
@@ -2462,9 +2579,43 @@ uint8_t init_sdl_texture_renderer()
 	sdl.frame.update  = update_frame_texture;
 	sdl.frame.present = present_frame_texture;
 
+	// The texture is new and the viewport may have changed
+	sdl.texture.has_new_frame = true;
+
 	return flags;
 }
 
+uint8_t init_headless_renderer(const int render_width_px, const int render_height_px)
+{
+	// The window is created hidden and never drawn to
+	if (!set_window_mode(RenderingBackend::Headless,
+	                     render_width_px,
+	                     render_height_px,
+	                     false)) {
+		E_Exit("SDL: Failed to create the headless output: %s", SDL_GetError());
+	}
+
+	sdl.headless.pitch = render_width_px * static_cast<int>(sizeof(uint32_t));
+	sdl.headless.framebuf.assign(static_cast<size_t>(render_width_px) *
+	                                     static_cast<size_t>(render_height_px),
+	                             0);
+
+	// Map the mouse to the whole rendered image, as there's no canvas
+	sdl.draw_rect_px = {0, 0, render_width_px, render_height_px};
+
+	// There's nothing to upload or present
+	sdl.frame.update  = update_frame_noop;
+	sdl.frame.present = present_frame_noop;
+
+	static bool is_first_time = true;
+	if (is_first_time) {
+		LOG_MSG("SDL: Using headless output, frames are rendered into memory only");
+		is_first_time = false;
+	}
+
+	return GFX_CAN_32 | GFX_CAN_RANDOM;
+}
+
 uint8_t GFX_SetSize(const int render_width_px, const int render_height_px,
                     const Fraction& render_pixel_aspect_ratio, const uint8_t flags,
                     const VideoMode& video_mode, GFX_Callback_t callback)
@@ -2503,7 +2654,8 @@ uint8_t GFX_SetSize(const int render_width_px, const int render_height_px,
 	// texture' to 'output = opengl'), then re-initialise our vsync
 	// settings. The host OS might handles this backend differently,
 	// therefore we need a new measurement.
-	if (sdl.want_rendering_backend != sdl.rendering_backend) {
+	if (sdl.want_rendering_backend != sdl.rendering_backend &&
+	    sdl.want_rendering_backend != RenderingBackend::Headless) {
 		initialize_vsync_settings();
 	}
 
@@ -2533,9 +2685,16 @@ uint8_t GFX_SetSize(const int render_width_px, const int render_height_px,
 		retFlags = init_sdl_texture_renderer();
 	}
 
+	if (sdl.want_rendering_backend == RenderingBackend::Headless) {
+		retFlags = init_headless_renderer(render_width_px, render_height_px);
+	}
+
 	// Ensure mouse emulation knows the current parameters
 	notify_new_mouse_screen_params();
-	update_vsync_mode();
+
+	if (sdl.rendering_backend != RenderingBackend::Headless) {
+		update_vsync_mode();
+	}
 
 	if (sdl.draw.has_changed) {
 		maybe_log_display_properties();
@@ -2787,6 +2946,13 @@ bool GFX_StartUpdate(uint8_t*& pixels, int& pitch)
 		// Should never occur
 		E_Exit("SDL: OpenGL is not supported by this executable");
 #endif // C_OPENGL
+
+	case RenderingBackend::Headless:
+		pixels = reinterpret_cast<uint8_t*>(sdl.headless.framebuf.data());
+		pitch  = sdl.headless.pitch;
+
+		sdl.updating = true;
+		return true;
 	}
 	return false;
 }
@@ -2799,7 +2965,16 @@ void GFX_EndUpdate(const uint16_t* changedLines)
 
 	sdl.frame.update(changedLines);
 
-	if (CAPTURE_IsCapturingPostRenderImage()) {
+	if (sdl.rendering_backend == RenderingBackend::Headless) {
+		// Nothing is presented, so there's nothing to pace either; the
+		// rendered image is taken straight from the frame buffer
+		if (CAPTURE_IsCapturingPostRenderImage()) {
+			if (const auto image = get_rendered_output_from_backbuffer()) {
+				CAPTURE_AddPostRenderImage(*image);
+			}
+		}
+
+	} else if (CAPTURE_IsCapturingPostRenderImage()) {
 		// Always present the frame if we want to capture the next
 		// rendered frame, regardless of the presentation mode. This is
 		// necessary to keep the contents of rendered and raw/upscaled
@@ -2807,6 +2982,20 @@ void GFX_EndUpdate(const uint16_t* changedLines)
 		// multi-output image capture modes.
 		sdl.frame.present();
 
+	} else if (CAPTURE_IsOfflineRendering()) {
+		// When rendering offline, the emulation runs as fast as it can,
+		// so only present an occasional preview frame to avoid being
+		// throttled by vsync. The video capture itself is taken from
+		// the renderer and is unaffected.
+		constexpr auto PreviewIntervalUs = 100'000;
+
+		static int64_t last_preview_us = 0;
+		if (sdl.updating &&
+		    GetTicksUsSince(last_preview_us) >= PreviewIntervalUs) {
+			sdl.frame.present();
+			last_preview_us = GetTicksUs();
+		}
+
 	} else {
 		// Helper lambda indicating whether the frame should be
 		// presented. Returns true if the frame has been updated or if
@@ -2865,6 +3054,7 @@ uint32_t GFX_GetRGB(const uint8_t red, const uint8_t green, const uint8_t blue)
 		return SDL_MapRGB(sdl.texture.pixelFormat, red, green, blue);
 
 	case RenderingBackend::OpenGl:
+	case RenderingBackend::Headless:
 		return ((blue << 0) | (green << 8) | (red << 16)) | (255 << 24);
 	}
 	return 0;
@@ -3289,6 +3479,9 @@ static void set_output(Section* sec, const bool wants_aspect_ratio_correction)
 		sdl.want_rendering_backend = RenderingBackend::OpenGl;
 #endif
 
+	} else if (output == "headless") {
+		sdl.want_rendering_backend = RenderingBackend::Headless;
+
 	} else {
 		LOG_WARNING("SDL: Unsupported output device '%s', using 'texture' output mode",
 		            output.c_str());
@@ -3699,6 +3892,7 @@ static void handle_video_resize(int width, int height)
 
 	if (sdl.rendering_backend == RenderingBackend::Texture) {
 		SDL_RenderSetViewport(sdl.renderer, &sdl.draw_rect_px);
+		sdl.texture.has_new_frame = true;
 	}
 #if C_OPENGL
 	if (sdl.rendering_backend == RenderingBackend::OpenGl) {
@@ -4029,6 +4223,7 @@ static bool handle_sdl_windowevent(const SDL_Event& event)
 
 		if (sdl.rendering_backend == RenderingBackend::Texture) {
 			SDL_RenderSetViewport(sdl.renderer, &sdl.draw_rect_px);
+			sdl.texture.has_new_frame = true;
 		}
 #if C_OPENGL
 		if (sdl.rendering_backend == RenderingBackend::OpenGl) {
@@ -4311,6 +4506,11 @@ static void add_command_line_help_message()
 	        "  --list-glshaders         List all available OpenGL shaders and their paths.\n"
 	        "                           Shaders are to be used in the 'glshader' config setting.\n"
 	        "\n"
+	        "  --replay-voodoo <file>   Replay a 3dfx Voodoo register stream recorded with the\n"
+	        "                           'voodoo_register_capture' setting without a window,\n"
+	        "                           then print the frame rate, the time spent in each\n"
+	        "                           stage, and a hash of every frame.\n"
+	        "\n"
 	        "  --fullscreen             Start in fullscreen mode.\n"
 	        "\n"
 	        "  --lang <lang_file>       Start with the language specified in <lang_file>. If set to\n"
@@ -4381,6 +4581,11 @@ static void init_sdl_config_section()
 	pstring->SetOptionHelp("texturenb",
 	                       "  texturenb:  SDL's texture backend with nearest-neighbour interpolation\n"
 	                       "              (no bilinear).");
+	pstring->SetOptionHelp("headless",
+	                       "  headless:   Render into memory only, without showing a window or\n"
+	                       "              requiring a display. Captures and screenshots still work,\n"
+	                       "              and frames are never paced or presented. Useful for\n"
+	                       "              automated runs on servers.");
 #if C_OPENGL
 	pstring->SetDeprecatedWithAlternateValue("surface", "opengl");
 	pstring->SetDeprecatedWithAlternateValue("openglpp", "opengl");
@@ -4395,6 +4600,7 @@ static void init_sdl_config_section()
 #endif
 	        "texture",
 	        "texturenb",
+	        "headless",
 	});
 	pstring->SetEnabledOptions({
 #if C_OPENGL
@@ -4405,6 +4611,7 @@ static void init_sdl_config_section()
 #endif
 	        "texture",
 	        "texturenb",
+	        "headless",
 	});
 
 	pstring = sdl_sec->AddString("texture_renderer", always, "auto");
@@ -4799,6 +5006,55 @@ static void list_glshaders()
 #endif
 }
 
+static int replay_voodoo_register_stream(const std::string& path)
+{
+	const auto stream = VOODOO_LoadRegisterStream(path);
+	if (!stream) {
+		return 1;
+	}
+
+	// Use as many threads as the 'voodoo_threads = auto' setting
+	constexpr auto MaxAutoThreads = 16;
+	const auto num_threads = std::clamp(SDL_GetCPUCount(), 1, MaxAutoThreads);
+
+	const auto result = VOODOO_ReplayRegisterStream(*stream, num_threads);
+
+	const auto num_frames = result.frame_hashes.size();
+
+	printf("Replayed %lld entries over %.1f seconds of emulated time "
+	       "with %d %s\n\n",
+	       static_cast<long long>(result.num_entries),
+	       result.emulated_ms / 1000.0,
+	       num_threads,
+	       num_threads == 1 ? "thread" : "threads");
+
+	const auto print_stage = [](const char* name,
+	                            const VoodooReplayStageTiming& stage) {
+		printf("  %-16s %10lld writes %10.1f ms\n",
+		       name,
+		       static_cast<long long>(stage.num_writes),
+		       stage.elapsed_ms);
+	};
+	print_stage("Registers", result.registers);
+	print_stage("LFB", result.lfb);
+	print_stage("Textures", result.textures);
+	print_stage("Buffer swaps", result.swaps);
+
+	printf("\n  %zu frames in %.1f ms: %.1f fps\n\n",
+	       num_frames,
+	       result.elapsed_ms,
+	       result.elapsed_ms > 0.0
+	               ? static_cast<double>(num_frames) * 1000.0 / result.elapsed_ms
+	               : 0.0);
+
+	for (size_t i = 0; i < num_frames; ++i) {
+		printf("Frame %zu: %016llx\n",
+		       i + 1,
+		       static_cast<unsigned long long>(result.frame_hashes[i]));
+	}
+	return 0;
+}
+
 static void list_countries()
 {
 	const auto message_utf8 = DOS_GenerateListCountriesMessage();
@@ -4905,7 +5161,8 @@ static void init_logger(const CommandLineArguments& args, int argc, char* argv[]
 
 	if (args.version || args.help || args.printconf || args.editconf ||
 	    args.eraseconf || args.list_countries || args.list_layouts ||
-	    args.list_code_pages || args.list_glshaders || args.erasemapper) {
+	    args.list_code_pages || args.list_glshaders || args.erasemapper ||
+	    !args.replay_voodoo.empty()) {
 
 		loguru::g_stderr_verbosity = loguru::Verbosity_WARNING;
 	}
@@ -4985,6 +5242,9 @@ static std::optional<int> maybe_handle_command_line_output_only_actions(
 		list_glshaders();
 		return 0;
 	}
+	if (!args.replay_voodoo.empty()) {
+		return replay_voodoo_register_stream(args.replay_voodoo);
+	}
 	return {};
 }
 
@@ -5029,6 +5289,13 @@ static void init_sdl()
 		       "Please run: 'sudo usermod -aG input $(whoami)', then re-login and try again.");
 	}
 
+	// The headless output doesn't need a display, so don't let SDL look
+	// for one unless a video driver has been explicitly requested
+	const auto output = get_sdl_section()->GetString("output");
+	if (output == "headless" && !getenv("SDL_VIDEODRIVER")) {
+		SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+	}
+
 	// Timer is needed for title bar animations
 	if (SDL_Init(SDL_INIT_AUDIO | SDL_INIT_VIDEO | SDL_INIT_TIMER) < 0) {
 		E_Exit("SDL: Can't init SDL %s", SDL_GetError());
@@ -5297,12 +5564,13 @@ int sdl_main(int argc, char* argv[])
 		SetConsoleCtrlHandler((PHANDLER_ROUTINE)console_event_handler, TRUE);
 #endif
 
-		init_sdl();
-
 		// Handle configuration settings passed with `--set` commands
-		// from the CLI.
+		// from the CLI. This only sets the values, and needs to happen
+		// before initialising SDL so the chosen output is known.
 		handle_cli_set_commands(arguments->set);
 
+		init_sdl();
+
 		maybe_create_resource_directories();
 
 		control->ParseEnv();
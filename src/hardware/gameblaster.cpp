@@ -162,82 +162,82 @@ AudioFrame GameBlaster::RenderFrame()
 	left_accum += buf[0];
 	right_accum += buf[1];
 
-	// Increment our time datum up to which the device has rendered
-	last_rendered_ms += MsPerRender;
-
 	return {static_cast<float>(left_accum), static_cast<float>(right_accum)};
 }
 
-void GameBlaster::RenderUpToNow()
+// Called on the emulation thread
+void GameBlaster::QueueWrite(const uint8_t device, const bool is_control,
+                             const io_val_t value)
 {
-	std::lock_guard lock(mutex);
+	assert(channel);
+	channel->WakeUp();
 
-	const auto now = PIC_FullIndex();
+	const DeviceWrite write = {PIC_FullIndex(),
+	                           device,
+	                           is_control,
+	                           check_cast<uint8_t>(value)};
 
-	// Wake up the channel and update the last rendered time datum.
-	assert(channel);
-	if (channel->WakeUp()) {
-		last_rendered_ms = now;
-		return;
+	if (!write_queue.Push(write) && write_queue.GetNumDropped() == 1) {
+		LOG_WARNING("CMS: Register write queue is full, dropping writes");
 	}
-	// Keep rendering until we're current
-	while (last_rendered_ms < now) {
-		last_rendered_ms += MsPerRender;
-		fifo.emplace(RenderFrame());
+}
+
+// Called on the mixer thread
+void GameBlaster::ApplyWrite(const DeviceWrite& write)
+{
+	auto& device = devices[write.device];
+	assert(device);
+
+	if (write.is_control) {
+		device->control_w(0, 0, write.val);
+	} else {
+		device->data_w(0, 0, write.val);
 	}
 }
 
 void GameBlaster::WriteDataToLeftDevice(io_port_t, io_val_t value, io_width_t)
 {
-	RenderUpToNow();
-	devices[0]->data_w(0, 0, check_cast<uint8_t>(value));
+	QueueWrite(0, false, value);
 }
 
 void GameBlaster::WriteControlToLeftDevice(io_port_t, io_val_t value, io_width_t)
 {
-	RenderUpToNow();
-	devices[0]->control_w(0, 0, check_cast<uint8_t>(value));
+	QueueWrite(0, true, value);
 }
 
 void GameBlaster::WriteDataToRightDevice(io_port_t, io_val_t value, io_width_t)
 {
-	RenderUpToNow();
-	devices[1]->data_w(0, 0, check_cast<uint8_t>(value));
+	QueueWrite(1, false, value);
 }
 
 void GameBlaster::WriteControlToRightDevice(io_port_t, io_val_t value, io_width_t)
 {
-	RenderUpToNow();
-	devices[1]->control_w(0, 0, check_cast<uint8_t>(value));
+	QueueWrite(1, true, value);
 }
 
 void GameBlaster::AudioCallback(const int requested_frames)
 {
 	assert(channel);
 
-	std::lock_guard lock(mutex);
+	// Map the requested frames onto the emulated time leading up to now,
+	// then apply each queued write right before the frame it belongs to.
+	const auto now_ms = PIC_AtomicIndex();
+	auto frame_ms     = now_ms - requested_frames * MsPerRender;
 
-#if 0
-	if (fifo.size()) {
-		LOG_MSG("CMS: Queued %2lu cycle-accurate frames", fifo.size());
-	}
-#endif
+	const auto apply_write = [this](const DeviceWrite& write) {
+		ApplyWrite(write);
+	};
 
-	auto frames_remaining = requested_frames;
+	render_buffer.resize(check_cast<size_t>(requested_frames));
 
-	// First, add any frames we've queued since the last callback
-	while (frames_remaining && fifo.size()) {
-		channel->AddSamples_sfloat(1, &fifo.front()[0]);
-		fifo.pop();
-		--frames_remaining;
-	}
-	// If the queue's run dry, render the remainder and sync-up our time datum
-	while (frames_remaining) {
-		auto frame = RenderFrame();
-		channel->AddSamples_sfloat(1, &frame[0]);
-		--frames_remaining;
+	for (auto& frame : render_buffer) {
+		frame_ms += MsPerRender;
+		write_queue.ApplyUpTo(frame_ms, apply_write);
+
+		frame = RenderFrame();
 	}
-	last_rendered_ms = PIC_AtomicIndex();
+
+	channel->AddAudioFrames(render_buffer);
 }
 
 void GameBlaster::WriteToDetectionPort(io_port_t port, io_val_t value, io_width_t)
@@ -286,6 +286,10 @@ void GameBlaster::Close()
 	MIXER_DeregisterChannel(channel);
 	channel.reset();
 
+	// Discard any writes the mixer thread hasn't picked up yet; it's
+	// locked out, so we can safely act as the consumer here
+	write_queue.ApplyAll([](const DeviceWrite&) {});
+
 	// Remove the SAA-1099 devices
 	devices[0].reset();
 	devices[1].reset();
@@ -8,7 +8,6 @@
 
 #include <array>
 #include <memory>
-#include <queue>
 #include <string>
 #include <vector>
 
@@ -16,6 +15,7 @@
 #include "inout.h"
 #include "math_utils.h"
 #include "mixer.h"
+#include "spsc_queue.h"
 #include "support.h"
 
 #include "mame/emu.h"
@@ -37,7 +37,18 @@ private:
 	// Audio rendering
 	AudioFrame RenderFrame();
 	void AudioCallback(const int requested_frames);
-	void RenderUpToNow();
+
+	// Register writes are made on the emulation thread and applied to the
+	// SAA-1099 devices on the mixer thread
+	struct DeviceWrite {
+		double timestamp_ms = 0.0;
+		uint8_t device      = 0;
+		bool is_control     = false;
+		uint8_t val         = 0;
+	};
+	void QueueWrite(const uint8_t device, const bool is_control,
+	                const io_val_t value);
+	void ApplyWrite(const DeviceWrite& write);
 
 	// IO callbacks to the left SAA1099 device
 	void WriteDataToLeftDevice(io_port_t port, io_val_t value, io_width_t width);
@@ -64,9 +75,11 @@ private:
 
 	std::unique_ptr<saa1099_device> devices[2] = {};
 
-	std::queue<AudioFrame> fifo = {};
+	static constexpr size_t WriteQueueSize = 4096;
+
+	TimedWriteQueue<DeviceWrite, WriteQueueSize> write_queue = {};
 
-	std::mutex mutex = {};
+	std::vector<AudioFrame> render_buffer = {};
 
 	// Static rate-related configuration
 	static constexpr auto ChipClockHz   = 14318180 / 2;
@@ -75,7 +88,6 @@ private:
 	static constexpr auto MsPerRender = MillisInSecond / RenderRateHz;
 
 	// Runtime states
-	double last_rendered_ms        = 0;
 	io_port_t base_port            = 0;
 	bool is_standalone_gameblaster = false;
 	bool is_open                   = false;
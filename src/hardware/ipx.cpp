@@ -8,10 +8,14 @@
 
 #include <SDL_net.h>
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cinttypes>
 #include <cstdio>
 #include <cstring>
 #include <ctime>
+#include <thread>
 
 #include "cross.h"
 #include "string_utils.h"
@@ -28,6 +32,8 @@
 #include "timer.h"
 #include "programs.h"
 #include "pic.h"
+#include "spsc_queue.h"
+#include "support.h"
 
 #define SOCKTABLESIZE	150 // DOS IPX driver was limited to 150 open sockets
 
@@ -42,7 +48,6 @@ bool isIpxConnected;
 IPaddress ipxServConnIp;			// IPAddress for client connection to server
 UDPsocket ipxClientSocket;
 int UDPChannel;						// Channel used by UDP connection
-uint8_t recvBuffer[IPXBUFFERSIZE];	// Incoming packet buffer
 
 static RealPt ipx_callback;
 
@@ -50,6 +55,24 @@ SDLNet_SocketSet clientSocketSet;
 
 packetBuffer incomingPacket;
 
+// The client's network thread receives every datagram as soon as it
+// arrives and queues it; the emulation thread delivers the queued
+// datagrams to the listening ECBs on each tick.
+struct ipxDatagram {
+	std::array<uint8_t, IPXBUFFERSIZE> data = {};
+	int16_t len = 0;
+};
+
+static SpscQueue<ipxDatagram, 256> clientRxQueue;
+static std::thread clientNetworkThread;
+static std::atomic<bool> clientNetworkRunning = false;
+
+static struct {
+	std::atomic<uint64_t> queued  = 0; // received and queued by the thread
+	std::atomic<uint64_t> dropped = 0; // lost because the queue was full
+	uint64_t delivered            = 0; // handed to the emulated IPX stack
+} clientRxStats;
+
 static uint16_t socketCount;
 static uint16_t opensockets[SOCKTABLESIZE];
 
@@ -115,7 +138,7 @@ ECBClass::ECBClass(uint16_t segment, uint16_t offset)
 	mysocket = getSocket();
 }
 
-void ECBClass::writeDataBuffer(uint8_t* buffer, uint16_t length) {
+void ECBClass::writeDataBuffer(const uint8_t* buffer, uint16_t length) {
 	delete[] databuffer;
 	databuffer = new uint8_t[length];
 	memcpy(databuffer,buffer,length);
@@ -557,13 +580,13 @@ static void pingSend(void) {
 		LOG_MSG("IPX: Failed to send a ping packet: %s", SDLNet_GetError());
 }
 
-static void receivePacket(uint8_t *buffer, int16_t bufSize) {
+static void receivePacket(const uint8_t *buffer, int16_t bufSize) {
 	ECBClass *useECB;
 	ECBClass *nextECB;
-	uint16_t *bufword = (uint16_t *)buffer;
+	const uint16_t *bufword = (const uint16_t *)buffer;
 	uint16_t useSocket = swapByte(bufword[8]);
-	IPXHeader * tmpHeader;
-	tmpHeader = (IPXHeader *)buffer;
+	const IPXHeader * tmpHeader;
+	tmpHeader = (const IPXHeader *)buffer;
 
 	// Check to see if ping packet
 	if(useSocket == 0x2) {
@@ -592,24 +615,77 @@ static void receivePacket(uint8_t *buffer, int16_t bufSize) {
 	LOG_IPX("IPX: RX Packet loss!");
 }
 
-static void IPX_ClientLoop(void) {
-	int numrecv;
+static void IPX_ClientNetworkLoop() {
+	ipxDatagram datagram;
 	UDPpacket inPacket;
-	inPacket.data = (Uint8 *)recvBuffer;
+	inPacket.data = datagram.data.data();
 	inPacket.maxlen = IPXBUFFERSIZE;
 	inPacket.channel = UDPChannel;
 
-	// Its amazing how much simpler UDP is than TCP
-	numrecv = SDLNet_UDP_Recv(ipxClientSocket, &inPacket);
-	if(numrecv) receivePacket(inPacket.data, inPacket.len);
+	while (clientNetworkRunning) {
+		// Time out now and then to check whether we should stop
+		const int numready = SDLNet_CheckSockets(clientSocketSet, 100);
+		if (numready < 0) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			continue;
+		}
+		if (numready == 0) {
+			continue;
+		}
+
+		// Its amazing how much simpler UDP is than TCP
+		while (SDLNet_UDP_Recv(ipxClientSocket, &inPacket) > 0) {
+			datagram.len = static_cast<int16_t>(inPacket.len);
+			if (clientRxQueue.Push(datagram)) {
+				++clientRxStats.queued;
+			} else {
+				++clientRxStats.dropped;
+				LOG_IPX("IPX: RX queue full, packet dropped");
+			}
+		}
+	}
+}
+
+static void IPX_ClientLoop(void) {
+	while (const auto datagram = clientRxQueue.Front()) {
+		receivePacket(datagram->data.data(), datagram->len);
+		clientRxQueue.Pop();
+		++clientRxStats.delivered;
+	}
 }
 
+static void StartClientNetworkThread() {
+	clientSocketSet = SDLNet_AllocSocketSet(1);
+	SDLNet_UDP_AddSocket(clientSocketSet, ipxClientSocket);
+
+	clientNetworkRunning = true;
+	clientNetworkThread = std::thread(IPX_ClientNetworkLoop);
+	set_thread_name(clientNetworkThread, "dosbox:ipxnet");
+	TIMER_AddTickHandler(&IPX_ClientLoop);
+}
+
+static void StopClientNetworkThread() {
+	TIMER_DelTickHandler(&IPX_ClientLoop);
+	if (clientNetworkThread.joinable()) {
+		clientNetworkRunning = false;
+		clientNetworkThread.join();
+	}
+	if (clientSocketSet) {
+		SDLNet_FreeSocketSet(clientSocketSet);
+		clientSocketSet = nullptr;
+	}
+
+	// Anything still queued was meant for the old connection
+	while (clientRxQueue.Front()) {
+		clientRxQueue.Pop();
+	}
+}
 
 void DisconnectFromServer(bool unexpected) {
 	if(unexpected) LOG_MSG("IPX: Server disconnected unexpectedly");
 	if(incomingPacket.connected) {
 		incomingPacket.connected = false;
-		TIMER_DelTickHandler(&IPX_ClientLoop);
+		StopClientNetworkThread();
 		SDLNet_UDP_Close(ipxClientSocket);
 	}
 }
@@ -723,21 +799,19 @@ static void sendPacket(ECBClass* sendecb) {
 	sendecb->NotifyESR();
 }
 
+// Takes the next datagram off the receive queue, instead of delivering it
+// to an ECB, so only use this while IPX_ClientLoop isn't running
 static bool pingCheck(IPXHeader * outHeader) {
-	char buffer[1024];
-	UDPpacket regPacket;
-	IPXHeader *regHeader;
-	regPacket.data = (Uint8 *)buffer;
-	regPacket.maxlen = sizeof(buffer);
-	regPacket.channel = UDPChannel;
-	regHeader = (IPXHeader *)buffer;
-
-	const int result = SDLNet_UDP_Recv(ipxClientSocket, &regPacket);
-	if (result != 0) {
-		memcpy(outHeader, regHeader, sizeof(IPXHeader));
-		return true;
+	const auto datagram = clientRxQueue.Front();
+	if (!datagram) {
+		return false;
 	}
-	return false;
+	const auto is_complete = (datagram->len >= static_cast<int16_t>(sizeof(IPXHeader)));
+	if (is_complete) {
+		memcpy(outHeader, datagram->data.data(), sizeof(IPXHeader));
+	}
+	clientRxQueue.Pop();
+	return is_complete;
 }
 
 bool ConnectToServer(const char* strAddr)
@@ -811,7 +885,7 @@ bool ConnectToServer(const char* strAddr)
 				LOG_MSG("IPX: Connected to server.  IPX address is %d:%d:%d:%d:%d:%d", CONVIPX(localIpxAddr.netnode));
 
 				incomingPacket.connected = true;
-				TIMER_AddTickHandler(&IPX_ClientLoop);
+				StartClientNetworkThread();
 				return true;
 			}
 		} else {
@@ -1006,6 +1080,10 @@ public:
 				WriteOut("Client status: ");
 				if(incomingPacket.connected) {
 					WriteOut("CONNECTED -- Server at %d.%d.%d.%d port %d\n", CONVIP(ipxServConnIp.host), udpPort);
+					WriteOut("Packets received: %llu, delivered: %llu, dropped: %llu\n",
+					         static_cast<unsigned long long>(clientRxStats.queued),
+					         static_cast<unsigned long long>(clientRxStats.delivered),
+					         static_cast<unsigned long long>(clientRxStats.dropped));
 				} else {
 					WriteOut("DISCONNECTED\n");
 				}
@@ -7,6 +7,7 @@
 
 #include <atomic>
 #include <thread>
+#include <unordered_map>
 
 #include "ipx.h"
 #include "ipxserver.h"
@@ -20,12 +21,39 @@ static SDLNet_SocketSet socket_set = nullptr;
 
 static packetBuffer connBuffer[SOCKETTABLESIZE];
 
-static uint8_t inBuffer[IPXBUFFERSIZE];
 static IPaddress ipconn[SOCKETTABLESIZE]; // Active TCP/IP connection
 
+// Maps the UDP address of each connected client to its slot in ipconn, so
+// unicast packets and registrations don't have to scan the whole table
+static std::unordered_map<uint64_t, uint16_t> connIndex;
+
+// Up to this many datagrams are taken per SDLNet_UDP_RecvV() call. SDL_net
+// still does one recvfrom() per datagram, as SDLNet_UDP_SendV() does one
+// sendto() per recipient; the vector calls save looping over SDL_net, not
+// system calls.
+static constexpr int MaxPacketsPerRecv = 32;
+
+static uint8_t inBuffers[MaxPacketsPerRecv][IPXBUFFERSIZE];
+static UDPpacket inPackets[MaxPacketsPerRecv];
+static UDPpacket *inPacketV[MaxPacketsPerRecv + 1]; // null-terminated
+
+static UDPpacket outPackets[SOCKETTABLESIZE];
+static UDPpacket *outPacketV[SOCKETTABLESIZE];
+
 static std::thread ipx_server_thread;
 static std::atomic_bool ipx_server_running = false;
 
+static uint64_t addressKey(uint32_t host, uint16_t port)
+{
+	return (static_cast<uint64_t>(host) << 16) | port;
+}
+
+int findConnection(uint32_t host, uint16_t port)
+{
+	const auto it = connIndex.find(addressKey(host, port));
+	return (it == connIndex.end()) ? -1 : it->second;
+}
+
 uint8_t packetCRC(uint8_t* buffer, uint16_t bufSize)
 {
 	uint8_t tmpCRC = 0;
@@ -54,11 +82,6 @@ static void closeSocket(uint16_t sockidx) {
 static void sendIPXPacket(uint8_t *buffer, int16_t bufSize) {
 	uint16_t srcport, destport;
 	uint32_t srchost, desthost;
-	UDPpacket outPacket;
-	outPacket.channel = -1;
-	outPacket.data = buffer;
-	outPacket.len = bufSize;
-	outPacket.maxlen = bufSize;
 	IPXHeader *tmpHeader;
 	tmpHeader = (IPXHeader *)buffer;
 
@@ -68,37 +91,42 @@ static void sendIPXPacket(uint8_t *buffer, int16_t bufSize) {
 	srcport = tmpHeader->src.addr.byIP.port;
 	destport = tmpHeader->dest.addr.byIP.port;
 
+	// Collect every recipient first, so they can be passed to SDL_net in
+	// a single call
+	int numPackets = 0;
+	const auto addRecipient = [&](const IPaddress &address) {
+		UDPpacket &outPacket = outPackets[numPackets];
+		outPacket.channel = UDP_UNICAST;
+		outPacket.data = buffer;
+		outPacket.len = bufSize;
+		outPacket.maxlen = bufSize;
+		outPacket.address = address;
+		outPacketV[numPackets++] = &outPacket;
+	};
+
 	if(desthost == 0xffffffff) {
 		// Broadcast
 		for (uint16_t i = 0; i < SOCKETTABLESIZE; ++i) {
 			if(connBuffer[i].connected && ((ipconn[i].host != srchost)||(ipconn[i].port!=srcport))) {
-				outPacket.address = ipconn[i];
-				const int result = SDLNet_UDP_Send(ipxServerSocket,
-				                                   UDP_UNICAST,
-				                                   &outPacket);
-				if (result == 0) {
-					LOG_MSG("IPXSERVER: %s", SDLNet_GetError());
-					continue;
-				}
+				addRecipient(ipconn[i]);
 				//LOG_MSG("IPXSERVER: Packet of %d bytes sent from %d.%d.%d.%d to %d.%d.%d.%d (BROADCAST) (%x CRC)", bufSize, CONVIP(srchost), CONVIP(ipconn[i].host), packetCRC(&buffer[30], bufSize-30));
 			}
 		}
 	} else {
 		// Specific address
-		for (uint16_t i = 0; i < SOCKETTABLESIZE; ++i) {
-			if((connBuffer[i].connected) && (ipconn[i].host == desthost) && (ipconn[i].port == destport)) {
-				outPacket.address = ipconn[i];
-				const int result = SDLNet_UDP_Send(ipxServerSocket,
-				                                   UDP_UNICAST,
-				                                   &outPacket);
-				if (result == 0) {
-					LOG_MSG("IPXSERVER: %s", SDLNet_GetError());
-					continue;
-				}
-				//LOG_MSG("IPXSERVER: Packet sent from %d.%d.%d.%d to %d.%d.%d.%d", CONVIP(srchost), CONVIP(desthost));
-			}
+		const int i = findConnection(desthost, destport);
+		if (i >= 0) {
+			addRecipient(ipconn[i]);
+			//LOG_MSG("IPXSERVER: Packet sent from %d.%d.%d.%d to %d.%d.%d.%d", CONVIP(srchost), CONVIP(desthost));
 		}
 	}
+
+	if (numPackets == 0) {
+		return;
+	}
+	if (SDLNet_UDP_SendV(ipxServerSocket, outPacketV, numPackets) < numPackets) {
+		LOG_MSG("IPXSERVER: %s", SDLNet_GetError());
+	}
 }
 
 bool IPX_isConnectedToServer(Bits tableNum, IPaddress ** ptrAddr) {
@@ -134,58 +162,77 @@ static void ackClient(IPaddress clientAddr) {
 		        SDLNet_GetError());
 }
 
-static void IPX_ServerLoop() {
-	UDPpacket inPacket;
+void registerClient(const UDPpacket &inPacket) {
+	const IPXHeader *tmpHeader = (const IPXHeader *)inPacket.data;
 	IPaddress tmpAddr;
+	UnpackIP(tmpHeader->src.addr.byIP, &tmpAddr);
 
-	//char regString[] = "IPX Register\0";
+	// A client registering again from the same address keeps its slot
+	int i = findConnection(inPacket.address.host, inPacket.address.port);
+	if (i < 0) {
+		i = findConnection(tmpAddr.host, tmpAddr.port);
+	}
+	if (i >= 0) {
+		LOG_MSG("IPXSERVER: Reconnect from %d.%d.%d.%d", CONVIP(tmpAddr.host));
+		// Update anonymous port number if changed
+		connIndex.erase(addressKey(ipconn[i].host, ipconn[i].port));
+		ipconn[i].port = inPacket.address.port;
+		connIndex[addressKey(ipconn[i].host, ipconn[i].port)] = static_cast<uint16_t>(i);
+		ackClient(inPacket.address);
+		return;
+	}
 
-	uint32_t host;
+	for (uint16_t slot = 0; slot < SOCKETTABLESIZE; ++slot) {
+		if(!connBuffer[slot].connected) {
+			// Use prefered host IP rather than the reported source IP
+			// It may be better to use the reported source
+			ipconn[slot] = inPacket.address;
+			connIndex[addressKey(ipconn[slot].host, ipconn[slot].port)] = slot;
+
+			connBuffer[slot].connected = true;
+			LOG_MSG("IPXSERVER: Connect from %d.%d.%d.%d", CONVIP(ipconn[slot].host));
+			ackClient(inPacket.address);
+			return;
+		}
+	}
+	LOG_WARNING("IPXSERVER: No free connection for %d.%d.%d.%d, the server is limited to %d clients",
+	            CONVIP(inPacket.address.host), SOCKETTABLESIZE);
+}
+
+static void IPX_ServerLoop() {
+	// Handle everything that's arrived, up to MaxPacketsPerRecv at a time
+	while (true) {
+		const int numPackets = SDLNet_UDP_RecvV(ipxServerSocket, inPacketV);
+		if (numPackets <= 0) {
+			if (numPackets < 0) {
+				LOG_MSG("IPXSERVER: %s", SDLNet_GetError());
+			}
+			return;
+		}
+
+		for (int n = 0; n < numPackets; ++n) {
+			const UDPpacket &inPacket = inPackets[n];
+
+			// Check to see if incoming packet is a registration packet
+			// For this, I just spoofed the echo protocol packet designation 0x02
+			const IPXHeader *tmpHeader = (const IPXHeader *)inPacket.data;
 
-	inPacket.channel = -1;
-	inPacket.data = &inBuffer[0];
-	inPacket.maxlen = IPXBUFFERSIZE;
-
-	const int result = SDLNet_UDP_Recv(ipxServerSocket, &inPacket);
-	if (result != 0) {
-		// Check to see if incoming packet is a registration packet
-		// For this, I just spoofed the echo protocol packet designation 0x02
-		IPXHeader *tmpHeader;
-		tmpHeader = (IPXHeader *)&inBuffer[0];
-
-		// Check to see if echo packet
-		if(SDLNet_Read16(tmpHeader->dest.socket) == 0x2) {
-			// Null destination node means its a server registration packet
-			if(tmpHeader->dest.addr.byIP.host == 0x0) {
-				UnpackIP(tmpHeader->src.addr.byIP, &tmpAddr);
-				for (uint16_t i = 0; i < SOCKETTABLESIZE; ++i) {
-					if(!connBuffer[i].connected) {
-						// Use prefered host IP rather than the reported source IP
-						// It may be better to use the reported source
-						ipconn[i] = inPacket.address;
-
-						connBuffer[i].connected = true;
-						host = ipconn[i].host;
-						LOG_MSG("IPXSERVER: Connect from %d.%d.%d.%d", CONVIP(host));
-						ackClient(inPacket.address);
-						return;
-					} else {
-						if((ipconn[i].host == tmpAddr.host) && (ipconn[i].port == tmpAddr.port)) {
-
-							LOG_MSG("IPXSERVER: Reconnect from %d.%d.%d.%d", CONVIP(tmpAddr.host));
-							// Update anonymous port number if changed
-							ipconn[i].port = inPacket.address.port;
-							ackClient(inPacket.address);
-							return;
-						}
-					}
-				}
+			// Check to see if echo packet, and a null destination
+			// node means its a server registration packet
+			if ((SDLNet_Read16(tmpHeader->dest.socket) == 0x2) &&
+			    (tmpHeader->dest.addr.byIP.host == 0x0)) {
+				registerClient(inPacket);
+				continue;
 			}
+
+			// IPX packet is complete.  Now interpret IPX header and send to respective IP address
+			sendIPXPacket((uint8_t*)inPacket.data,
+			              static_cast<int16_t>(inPacket.len));
 		}
 
-		// IPX packet is complete.  Now interpret IPX header and send to respective IP address
-		sendIPXPacket((uint8_t*)inPacket.data,
-		              static_cast<int16_t>(inPacket.len));
+		if (numPackets < MaxPacketsPerRecv) {
+			return;
+		}
 	}
 }
 
@@ -199,6 +246,7 @@ void IPX_StopServer() {
 	SDLNet_FreeSocketSet(socket_set);
 	SDLNet_UDP_Close(ipxServerSocket);
 	socket_set = nullptr;
+	connIndex.clear();
 }
 
 bool IPX_StartServer(uint16_t portnum)
@@ -211,6 +259,15 @@ bool IPX_StartServer(uint16_t portnum)
 		for (auto& i : connBuffer) {
 			i.connected = false;
 		}
+		connIndex.clear();
+
+		for (int i = 0; i < MaxPacketsPerRecv; ++i) {
+			inPackets[i].channel = -1;
+			inPackets[i].data = inBuffers[i];
+			inPackets[i].maxlen = IPXBUFFERSIZE;
+			inPacketV[i] = &inPackets[i];
+		}
+		inPacketV[MaxPacketsPerRecv] = nullptr;
 
 		if (!socket_set) {
 			socket_set = SDLNet_AllocSocketSet(1);
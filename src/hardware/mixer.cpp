@@ -199,6 +199,10 @@ struct MixerSettings {
 
 	std::atomic<bool> fast_forward_mode = false;
 
+	// Mix on the main thread in emulated time instead of on the mixer
+	// thread paced by the audio device (see CAPTURE_IsOfflineRendering)
+	bool offline_mode = false;
+
 	std::recursive_mutex mutex = {};
 };
 
@@ -261,6 +265,11 @@ bool MIXER_FastForwardModeEnabled()
 	return mixer.fast_forward_mode;
 }
 
+bool MIXER_OfflineModeEnabled()
+{
+	return mixer.offline_mode;
+}
+
 // The queues listed here are for audio devices that run on the main thread.
 // The mixer thread can be waiting on the main thread to produce audio in these
 // queues. We need to stop them before aquiring a mutex lock to avoid a
@@ -2505,20 +2514,28 @@ static void mix_samples(const int frames_requested)
 			        static_cast<int16_t>(host_to_le16(right)));
 		}
 
-		if (mixer.capture_queue.Size() + mixer.capture_buffer.size() >
+		// In offline mode the caller hands the capture buffer
+		// straight to the capture module
+		if (mixer.offline_mode) {
+			// Nothing to queue
+
+		} else if (mixer.capture_queue.Size() + mixer.capture_buffer.size() >
 		    mixer.capture_queue.MaxCapacity()) {
 
 			// We're producing more audio than the capture is
 			// consuming. This usually happens when the main thread
-			// is being slowed down by video encoding (e.g., slow
-			// host CPU or using zlib rather than zlib_ng). Not
+			// is being held up by the video encoder thread falling
+			// behind (e.g., slow host CPU or using zlib rather than
+			// zlib_ng). Not
 			// ideal as this results in an audible "skip forward".
 			// Without this, it's a complete stuttery mess though so
 			// it's the lesser of two evils.
 			//
 			mixer.capture_queue.Clear();
 		}
-		mixer.capture_queue.NonblockingBulkEnqueue(mixer.capture_buffer);
+		if (!mixer.offline_mode) {
+			mixer.capture_queue.NonblockingBulkEnqueue(mixer.capture_buffer);
+		}
 	}
 
 	// Normalize the final output before sending to SDL
@@ -2528,9 +2545,47 @@ static void mix_samples(const int frames_requested)
 	}
 }
 
+// In offline mode, the main thread mixes exactly one tick's worth of audio at
+// the end of every emulated millisecond and feeds it straight to the capture.
+// This makes the audio output independent from the host's speed and
+// scheduling.
+static void mix_offline_tick()
+{
+	static float frame_counter = 0.0f;
+	frame_counter += get_mixer_frames_per_tick();
+
+	const int num_frames = ifloor(frame_counter);
+	if (num_frames <= 0) {
+		return;
+	}
+	frame_counter -= static_cast<float>(num_frames);
+
+	// Channels rendering in emulated time (e.g., the OPL) use the atomic
+	// index to position their frames; make it exact for this tick.
+	PIC_UpdateAtomicIndex();
+
+	std::lock_guard lock(mixer.mutex);
+
+	mix_samples(num_frames);
+
+	if (CAPTURE_IsCapturingAudio() || CAPTURE_IsCapturingVideo()) {
+		assert(mixer.capture_buffer.size() ==
+		       check_cast<size_t>(num_frames * 2));
+
+		CAPTURE_AddAudioData(mixer.sample_rate_hz,
+		                     num_frames,
+		                     mixer.capture_buffer.data());
+	}
+}
+
 // Run in the main thread by a PIC Callback
 static void capture_callback()
 {
+	if (mixer.offline_mode) {
+		mix_offline_tick();
+		return;
+	}
+
 	if (!(CAPTURE_IsCapturingAudio() || CAPTURE_IsCapturingVideo())) {
 		return;
 	}
@@ -2924,7 +2979,15 @@ void MIXER_Init(Section* sec)
 		mixer.sample_rate_hz = secprop->GetInt("rate");
 		mixer.blocksize      = secprop->GetInt("blocksize");
 
-		if (mixer_state == MixerState::NoSound) {
+		mixer.offline_mode = CAPTURE_IsOfflineRendering();
+
+		if (mixer.offline_mode) {
+			LOG_MSG("MIXER: Sound output disabled; mixing in emulated "
+			        "time for offline rendering");
+
+			mixer.state = MixerState::NoSound;
+
+		} else if (mixer_state == MixerState::NoSound) {
 			set_no_sound();
 
 		} else {
@@ -2954,8 +3017,11 @@ void MIXER_Init(Section* sec)
 		// One second of audio
 		mixer.capture_queue.Resize(mixer.sample_rate_hz * 2);
 
-		mixer.thread = std::thread(mixer_thread_loop);
-		set_thread_name(mixer.thread, "dosbox:mixer");
+		// In offline mode, the main thread does all the mixing
+		if (!mixer.offline_mode) {
+			mixer.thread = std::thread(mixer_thread_loop);
+			set_thread_name(mixer.thread, "dosbox:mixer");
+		}
 
 		TIMER_AddTickHandler(capture_callback);
 	}
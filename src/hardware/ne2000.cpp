@@ -7,6 +7,7 @@
 
 #include "ne2000.h"
 
+#include <algorithm>
 #include <cstdarg>
 #include <cstdio>
 #include <cstring>
@@ -15,6 +16,7 @@
 #include "cpu.h"
 #include "ethernet.h"
 #include "inout.h"
+#include "mem_host.h"
 #include "pic.h"
 #include "setup.h"
 #include "string_utils.h"
@@ -245,7 +247,14 @@ bx_ne2k_c::write_cr(io_val_t data)
       // Send the packet to the system driver
       // BX_NE2K_THIS ethdev->sendpkt(& BX_NE2K_THIS s.mem[BX_NE2K_THIS
       // s.tx_page_start*256 - BX_NE2K_MEMSTART], BX_NE2K_THIS s.tx_bytes);
-      ethernet->SendPacket(&s.mem[s.tx_page_start * 256 - BX_NE2K_MEMSTART], s.tx_bytes);
+      const auto tx_start = s.tx_page_start * 256;
+      if (tx_start < BX_NE2K_MEMSTART ||
+          tx_start + s.tx_bytes > BX_NE2K_MEMEND) {
+        BX_ERROR("transmit buffer outside of on-chip memory, page %02x length %d",
+                 s.tx_page_start, s.tx_bytes);
+      } else {
+        ethernet->SendPacket(&s.mem[tx_start - BX_NE2K_MEMSTART], s.tx_bytes);
+      }
       // s.tx_timer_index = (64 + 96 + 4*8 + BX_NE2K_THIS s.tx_bytes*8)/10;
       s.tx_timer_active = 1;
 
@@ -302,16 +311,16 @@ io_val_t bx_ne2k_c::chipmem_read(io_port_t address, io_width_t io_len)
     return (retval);
   }
 
-  if ((address >= BX_NE2K_MEMSTART) && (address < BX_NE2K_MEMEND)) {
-    retval = BX_NE2K_THIS s.mem[address - BX_NE2K_MEMSTART];
-    if ((io_len == io_width_t::word) || (io_len == io_width_t::dword)) {
-      retval |= (unsigned int)(BX_NE2K_THIS s.mem[address - BX_NE2K_MEMSTART + 1] << 8u);
+  // The whole access has to fit in the buffer memory, which is read
+  // directly as a little-endian byte array
+  if ((address >= BX_NE2K_MEMSTART) &&
+      (address + enum_val(io_len) <= BX_NE2K_MEMEND)) {
+    const uint8_t *mem = &BX_NE2K_THIS s.mem[address - BX_NE2K_MEMSTART];
+    switch (io_len) {
+    case io_width_t::byte: return host_readb(mem);
+    case io_width_t::word: return host_readw(mem);
+    case io_width_t::dword: return host_readd(mem);
     }
-	if (io_len == io_width_t::dword) {
-       retval |= (unsigned int)(BX_NE2K_THIS s.mem[address - BX_NE2K_MEMSTART + 2] << 16u);
-       retval |= (unsigned int)(BX_NE2K_THIS s.mem[address - BX_NE2K_MEMSTART + 3] << 24u);
-    }
-    return (retval);
   }
 
   BX_DEBUG("out-of-bounds chipmem read, %04X", address);
@@ -326,10 +335,13 @@ bx_ne2k_c::chipmem_write(io_port_t address, io_val_t data, io_width_t io_len)
   if ((io_len == io_width_t::word) && (address & 0x1))
     BX_PANIC(("unaligned chipmem word write"));
 
-  if ((address >= BX_NE2K_MEMSTART) && (address < BX_NE2K_MEMEND)) {
-    BX_NE2K_THIS s.mem[address - BX_NE2K_MEMSTART] = value & 0xff;
+  if ((address >= BX_NE2K_MEMSTART) &&
+      (address + enum_val(io_len) <= BX_NE2K_MEMEND)) {
+    uint8_t *mem = &BX_NE2K_THIS s.mem[address - BX_NE2K_MEMSTART];
     if (io_len == io_width_t::word)
-      BX_NE2K_THIS s.mem[address - BX_NE2K_MEMSTART + 1] = value >> 8;
+      host_writew(mem, value);
+    else
+      host_writeb(mem, value & 0xff);
   } else
     BX_DEBUG("out-of-bounds chipmem write, %04X", address);
 }
@@ -1202,7 +1214,7 @@ bx_ne2k_c::rx_handler(void *arg, const void *buf, unsigned len)
  * rx ring has enough room, it is copied into it and
  * the receive process is updated
  */
-int bx_ne2k_c::rx_frame(const void *buf, unsigned io_len)
+Ne2kRxResult bx_ne2k_c::rx_frame(const void *buf, unsigned io_len)
 {
   int pages;
   int avail;
@@ -1211,7 +1223,6 @@ int bx_ne2k_c::rx_frame(const void *buf, unsigned io_len)
   uint8_t nextpage;
   uint8_t pkthdr[4];
   const auto *pktbuf = (const uint8_t *) buf;
-  uint8_t *startptr;
   static uint8_t bcast_addr[6] = {0xff,0xff,0xff,0xff,0xff,0xff};
 
   if(io_len != 60) {
@@ -1225,13 +1236,41 @@ int bx_ne2k_c::rx_frame(const void *buf, unsigned io_len)
       (BX_NE2K_THIS s.page_start == 0) /*||
       ((BX_NE2K_THIS s.DCR.loop == 0) &&
        (BX_NE2K_THIS s.TCR.loop_cntl != 0))*/) {
-	  return -1;
+	  return Ne2kRxResult::Dropped;
+  }
+
+  // The ring is set up by the guest, so check that it and the current
+  // page lie within the on-chip memory before writing anything to it
+  const unsigned ring_start = BX_NE2K_THIS s.page_start * 256u;
+  const unsigned ring_end   = BX_NE2K_THIS s.page_stop * 256u;
+  if ((ring_start < BX_NE2K_MEMSTART) || (ring_end > BX_NE2K_MEMEND) ||
+      (BX_NE2K_THIS s.curr_page < BX_NE2K_THIS s.page_start) ||
+      (BX_NE2K_THIS s.curr_page >= BX_NE2K_THIS s.page_stop)) {
+	BX_DEBUG("receive ring outside of on-chip memory");
+	return Ne2kRxResult::Dropped;
   }
 
   // Add the pkt header + CRC to the length, and work
   // out how many 256-byte pages the frame would occupy
   pages = (int)((io_len + 4u + 4u + 255u)/256u);
 
+  // A frame that can never fit in the ring, or a boundary pointer outside
+  // of it, won't be fixed by waiting for the guest to empty the ring
+  const int ring_pages = BX_NE2K_THIS s.page_stop - BX_NE2K_THIS s.page_start;
+  if ((pages > ring_pages)
+#if BX_NE2K_NEVER_FULL_RING
+      || (pages == ring_pages)
+#endif
+      ) {
+	BX_DEBUG("frame of %d pages can't fit in a ring of %d", pages, ring_pages);
+	return Ne2kRxResult::Dropped;
+  }
+  if ((BX_NE2K_THIS s.bound_ptr < BX_NE2K_THIS s.page_start) ||
+      (BX_NE2K_THIS s.bound_ptr >= BX_NE2K_THIS s.page_stop)) {
+	BX_DEBUG("boundary pointer outside of the receive ring");
+	return Ne2kRxResult::Dropped;
+  }
+
   if (BX_NE2K_THIS s.curr_page < BX_NE2K_THIS s.bound_ptr) {
     avail = BX_NE2K_THIS s.bound_ptr - BX_NE2K_THIS s.curr_page;
   } else {
@@ -1249,38 +1288,39 @@ int bx_ne2k_c::rx_frame(const void *buf, unsigned io_len)
 #endif
       ) {
 	BX_DEBUG("no space");
-	return -1;
+	return Ne2kRxResult::NoSpace;
   }
 
   if ((io_len < 40/*60*/) && !BX_NE2K_THIS s.RCR.runts_ok) {
     BX_DEBUG("rejected small packet, length %d", io_len);
-    return -1;
+    return Ne2kRxResult::Dropped;
   }
   // some computers don't care...
+  const unsigned frame_len = io_len;
   if (io_len < 60) io_len=60;
 
   // Do address filtering if not in promiscuous mode
   if (! BX_NE2K_THIS s.RCR.promisc) {
     if (!memcmp(buf, bcast_addr, 6)) {
       if (!BX_NE2K_THIS s.RCR.broadcast) {
-	      return -1;
+	      return Ne2kRxResult::Dropped;
       }
     } else if (pktbuf[0] & 0x01) {
 	if (! BX_NE2K_THIS s.RCR.multicast) {
-		return -1;
+		return Ne2kRxResult::Dropped;
 	}
       idx = mcast_index(buf);
       if (!(BX_NE2K_THIS s.mchash[idx >> 3] & (1 << (idx & 0x7)))) {
-	      return -1;
+	      return Ne2kRxResult::Dropped;
       }
     } else if (0 != memcmp(buf, BX_NE2K_THIS s.physaddr, 6)) {
-	    return -1;
+	    return Ne2kRxResult::Dropped;
     }
   } else {
       BX_DEBUG(("rx_frame promiscuous receive"));
   }
 
-    BX_INFO("rx_frame %d to %x:%x:%x:%x:%x:%x from %x:%x:%x:%x:%x:%x",
+    BX_DEBUG("rx_frame %d to %x:%x:%x:%x:%x:%x from %x:%x:%x:%x:%x:%x",
   	   io_len,
   	   pktbuf[0], pktbuf[1], pktbuf[2], pktbuf[3], pktbuf[4], pktbuf[5],
   	   pktbuf[6], pktbuf[7], pktbuf[8], pktbuf[9], pktbuf[10], pktbuf[11]);
@@ -1301,25 +1341,30 @@ int bx_ne2k_c::rx_frame(const void *buf, unsigned io_len)
   pkthdr[2] = (io_len + 4) & 0xff;	// length-low
   pkthdr[3] = check_cast<uint8_t>((io_len + 4) >> 8);	// length-hi
 
-  // copy into buffer, update curpage, and signal interrupt if config'd
-  startptr = & BX_NE2K_THIS s.mem[BX_NE2K_THIS s.curr_page * 256 -
-			       BX_NE2K_MEMSTART];
-  if ((nextpage > BX_NE2K_THIS s.curr_page) ||
-      ((BX_NE2K_THIS s.curr_page + pages) == BX_NE2K_THIS s.page_stop)) {
-    memcpy(startptr, pkthdr, 4);
-    memcpy(startptr + 4, buf, io_len);
-    BX_NE2K_THIS s.curr_page = nextpage;
-  } else {
-    unsigned int endbytes = (unsigned int)(BX_NE2K_THIS s.page_stop - BX_NE2K_THIS s.curr_page)
-      * 256u;
-    memcpy(startptr, pkthdr, 4);
-    memcpy(startptr + 4, buf, (size_t)(endbytes - 4u));
-    startptr = & BX_NE2K_THIS s.mem[BX_NE2K_THIS s.page_start * 256u -
-				 BX_NE2K_MEMSTART];
-    memcpy(startptr, (const void *)(pktbuf + endbytes - 4u),
-	   io_len - endbytes + 8u);
-    BX_NE2K_THIS s.curr_page = nextpage;
-  }
+  // Copy the header and the frame into the ring in a single pass, wrapping
+  // from the end of the ring back to its start. Runt frames are padded
+  // with zeroes instead of reading past the end of the source buffer.
+  uint8_t *ring = BX_NE2K_THIS s.mem + (ring_start - BX_NE2K_MEMSTART);
+  const unsigned ring_size = ring_end - ring_start;
+  unsigned pos = BX_NE2K_THIS s.curr_page * 256u - ring_start;
+
+  const auto copy_to_ring = [&](const uint8_t *src, unsigned len) {
+    while (len > 0) {
+      const auto chunk = std::min(len, ring_size - pos);
+      if (src) {
+        memcpy(ring + pos, src, chunk);
+        src += chunk;
+      } else {
+        memset(ring + pos, 0, chunk);
+      }
+      len -= chunk;
+      pos = (pos + chunk) % ring_size;
+    }
+  };
+  copy_to_ring(pkthdr, 4);
+  copy_to_ring(pktbuf, frame_len);
+  copy_to_ring(nullptr, io_len - frame_len);
+  BX_NE2K_THIS s.curr_page = nextpage;
 
   BX_NE2K_THIS s.RSR.rx_ok = 1;
   if (pktbuf[0] & 0x80) {
@@ -1333,7 +1378,7 @@ int bx_ne2k_c::rx_frame(const void *buf, unsigned io_len)
 	  PIC_ActivateIRQ(s.base_irq);
     //DEV_pic_raise_irq(BX_NE2K_THIS s.base_irq);
   } //else LOG_MSG("no packet rx interrupt");
-  return static_cast<int>(io_len);
+  return Ne2kRxResult::Received;
 }
 
 //uint8_t macaddr[6] = { 0xAC, 0xDE, 0x48, 0x8E, 0x89, 0x19 };
@@ -1345,6 +1390,17 @@ io_val_t dosbox_read(io_port_t port, io_width_t width)
 	//	port, retval, len, theNE2kDevice->s.CR.pgsel,SegValue(cs),reg_eip);
 	return retval;
 }
+// The remote DMA data port is accessed once per word of every frame the
+// driver moves with REP INSW/OUTSW, so it bypasses the register decoding
+static io_val_t dosbox_data_read([[maybe_unused]] io_port_t port, io_width_t width)
+{
+	return theNE2kDevice->asic_read(0x0, width);
+}
+static void dosbox_data_write([[maybe_unused]] io_port_t port, io_val_t value,
+                              io_width_t width)
+{
+	theNE2kDevice->asic_write(0x0, check_cast<uint16_t>(value), width);
+}
 void dosbox_write(io_port_t port, io_val_t value, io_width_t width)
 {
   const auto val = check_cast<uint16_t>(value);
@@ -1411,14 +1467,35 @@ static void NE2000_TX_Event([[maybe_unused]] uint32_t val)
 }
 
 static void NE2000_Poller(void) {
-	ethernet->GetPackets([](const uint8_t *packet, int len) {
-		//LOG_MSG("NE2000: Received %d bytes", header->len);
-
-		// don't receive in loopback modes
-		if((theNE2kDevice->s.DCR.loop == 0) || (theNE2kDevice->s.TCR.loop_cntl != 0))
-			return -1;
-		return theNE2kDevice->rx_frame(packet, check_cast<uint16_t>(len));
-	});
+	// Frames are copied straight from the connection's queue into the
+	// receive ring. Once the ring is full, the rest stay queued until
+	// the driver has made room for them.
+	constexpr size_t BatchSize = 16;
+	EthernetPacket packets[BatchSize];
+
+	size_t num_packets = 0;
+	while ((num_packets = ethernet->PeekPackets(packets, BatchSize)) > 0) {
+		size_t num_consumed = 0;
+		for (; num_consumed < num_packets; ++num_consumed) {
+			const auto& packet = packets[num_consumed];
+
+			// don't receive in loopback modes
+			if ((theNE2kDevice->s.DCR.loop == 0) ||
+			    (theNE2kDevice->s.TCR.loop_cntl != 0)) {
+				continue;
+			}
+			const auto result = theNE2kDevice->rx_frame(
+			        packet.data, check_cast<uint16_t>(packet.size));
+			if (result == Ne2kRxResult::NoSpace) {
+				break;
+			}
+		}
+		ethernet->ReleasePackets(num_consumed);
+
+		if (num_consumed < num_packets) {
+			break;
+		}
+	}
 }
 
 class NE2K final : public ModuleBase {
@@ -1494,8 +1571,15 @@ public:
 		// install I/O-handlers and timer
 		for(io_port_t i = 0; i < 0x20; ++i) {
       const auto port_num = static_cast<io_port_t>(i + theNE2kDevice->s.base_address);
-			ReadHandler8[i].Install(port_num, dosbox_read, io_width_t::word);
-			WriteHandler8[i].Install(port_num, dosbox_write, io_width_t::word);
+			const auto is_data_port = (i == 0x10);
+			ReadHandler8[i].Install(port_num,
+			                        is_data_port ? io_read_f(dosbox_data_read)
+			                                     : io_read_f(dosbox_read),
+			                        io_width_t::word);
+			WriteHandler8[i].Install(port_num,
+			                         is_data_port ? io_write_f(dosbox_data_write)
+			                                      : io_write_f(dosbox_write),
+			                         io_width_t::word);
 		}
 		TIMER_AddTickHandler(NE2000_Poller);
 	}
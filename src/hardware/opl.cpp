@@ -259,6 +259,7 @@ void Opl::Init()
 
 	if (opl.mode == OplMode::Esfm) {
 		ESFM_init(&esfm.chip);
+		ESFM_init(&esfm.shadow);
 	} else {
 		OPL3_Reset(&opl.chip, OplSampleRateHz);
 
@@ -297,29 +298,85 @@ void Opl::Init()
 void Opl::WriteReg(const io_port_t selected_reg, const uint8_t val)
 {
 	if (opl.mode == OplMode::Esfm) {
-		ESFM_write_reg_buffered_fast(&esfm.chip, selected_reg, val);
-
-
+		ESFM_write_reg(&esfm.shadow, selected_reg, val);
 	} else { // OPL
-		OPL3_WriteRegBuffered(&opl.chip, selected_reg, val);
 		if (selected_reg == 0x105) {
 			opl.newm = selected_reg & 0x01;
 		}
 	}
+	QueueWrite(OplWriteType::Register, selected_reg, val);
+}
+
+// Called on the emulation thread
+void Opl::QueueWrite(const OplWriteType type, const uint16_t reg, const uint8_t val)
+{
+	const OplWrite write = {PIC_FullIndex(), reg, val, type};
+
+	if (!write_queue.Push(write) && write_queue.GetNumDropped() == 1) {
+		LOG_WARNING("%s: Register write queue is full, dropping writes",
+		            channel->GetName().c_str());
+	}
+}
+
+// Called on the mixer thread
+void Opl::ApplyWrite(const OplWrite& write)
+{
+	switch (write.type) {
+	case OplWriteType::Register:
+		if (opl.mode == OplMode::Esfm) {
+			ESFM_write_reg_buffered_fast(&esfm.chip, write.reg, write.val);
+		} else {
+			OPL3_WriteRegBuffered(&opl.chip, write.reg, write.val);
+		}
+		break;
+
+	case OplWriteType::EsfmPort:
+		ESFM_write_port(&esfm.chip, check_cast<uint8_t>(write.reg), write.val);
+		break;
+
+	case OplWriteType::AdlibGoldControl:
+		assert(adlib_gold);
+		switch (write.reg) {
+		case 0x04:
+			adlib_gold->StereoControlWrite(
+			        StereoProcessorControlReg::VolumeLeft, write.val);
+			break;
+		case 0x05:
+			adlib_gold->StereoControlWrite(
+			        StereoProcessorControlReg::VolumeRight, write.val);
+			break;
+		case 0x06:
+			adlib_gold->StereoControlWrite(StereoProcessorControlReg::Bass,
+			                               write.val);
+			break;
+		case 0x07:
+			adlib_gold->StereoControlWrite(StereoProcessorControlReg::Treble,
+			                               write.val);
+			break;
+		case 0x08:
+			adlib_gold->StereoControlWrite(
+			        StereoProcessorControlReg::SwitchFunctions, write.val);
+			break;
+		case 0x18: adlib_gold->SurroundControlWrite(write.val); break;
+		}
+		break;
+	}
 }
 
 io_port_t Opl::WriteAddr(const io_port_t port, const uint8_t val)
 {
 	if (opl.mode == OplMode::Esfm) {
 		uint16_t addr;
-		if (esfm.chip.native_mode) {
-			ESFM_write_port(&esfm.chip,
-			                check_cast<uint8_t>((port & 3) | 2),
-			                val);
-			return check_cast<io_port_t>(esfm.chip.addr_latch & 0x7ff);
+		if (esfm.shadow.native_mode) {
+			const auto offset = check_cast<uint8_t>((port & 3) | 2);
+
+			ESFM_write_port(&esfm.shadow, offset, val);
+			QueueWrite(OplWriteType::EsfmPort, offset, val);
+
+			return check_cast<io_port_t>(esfm.shadow.addr_latch & 0x7ff);
 		} else {
 			addr = val;
-			if ((port & 2) && (addr == 0x05 || esfm.chip.emu_newmode)) {
+			if ((port & 2) && (addr == 0x05 || esfm.shadow.emu_newmode)) {
 				addr |= 0x100;
 			}
 			return addr;
@@ -336,7 +393,8 @@ io_port_t Opl::WriteAddr(const io_port_t port, const uint8_t val)
 
 void Opl::EsfmSetLegacyMode()
 {
-	ESFM_write_port(&esfm.chip, 0, 0);
+	ESFM_write_port(&esfm.shadow, 0, 0);
+	QueueWrite(OplWriteType::EsfmPort, 0, 0);
 }
 
 template <LineIndex line_index>
@@ -410,49 +468,30 @@ AudioFrame Opl::RenderFrame()
 	}
 }
 
-void Opl::RenderUpToNow()
-{
-	const auto now = PIC_FullIndex();
-
-	// Wake up the channel and update the last rendered time datum.
-	assert(channel);
-	if (channel->WakeUp()) {
-		last_rendered_ms = now;
-		return;
-	}
-	// Keep rendering until we're current
-	while (last_rendered_ms < now) {
-		last_rendered_ms += ms_per_frame;
-		fifo.emplace(RenderFrame());
-	}
-}
-
 void Opl::AudioCallback(const int requested_frames)
 {
-	std::lock_guard lock(mutex);
 	assert(channel);
-#if 0
-	if (fifo.size()) {
-		LOG_MSG("%s: Queued %2lu cycle-accurate frames",
-		        channel->GetName().c_str(),
-		        fifo.size());
-	}
-#endif
-	auto frames_remaining = requested_frames;
-
-	// First, send any frames we've queued since the last callback
-	while (frames_remaining && fifo.size()) {
-		channel->AddSamples_sfloat(1, &fifo.front()[0]);
-		fifo.pop();
-		--frames_remaining;
-	}
-	// If the queue's run dry, render the remainder and sync-up our time datum
-	while (frames_remaining) {
-		const auto frame = RenderFrame();
-		channel->AddSamples_sfloat(1, &frame[0]);
-		--frames_remaining;
+
+	// Map the requested frames onto the emulated time leading up to now,
+	// then apply each queued register write right before the frame it
+	// belongs to.
+	const auto now_ms = PIC_AtomicIndex();
+	auto frame_ms     = now_ms - requested_frames * ms_per_frame;
+
+	const auto apply_write = [this](const OplWrite& write) {
+		ApplyWrite(write);
+	};
+
+	render_buffer.resize(check_cast<size_t>(requested_frames));
+
+	for (auto& frame : render_buffer) {
+		frame_ms += ms_per_frame;
+		write_queue.ApplyUpTo(frame_ms, apply_write);
+
+		frame = RenderFrame();
 	}
-	last_rendered_ms = PIC_AtomicIndex();
+
+	channel->AddAudioFrames(render_buffer);
 }
 
 void Opl::CacheWrite(const io_port_t port, const uint8_t val)
@@ -498,25 +537,13 @@ void Opl::DualWrite(const uint8_t index, const uint8_t port, const uint8_t value
 void Opl::AdlibGoldControlWrite(const uint8_t val)
 {
 	switch (ctrl.index) {
-	case 0x04:
-		adlib_gold->StereoControlWrite(StereoProcessorControlReg::VolumeLeft,
-		                               val);
-		break;
+	case 0x04: // Stereo processor registers
 	case 0x05:
-		adlib_gold->StereoControlWrite(StereoProcessorControlReg::VolumeRight,
-		                               val);
-		break;
 	case 0x06:
-		adlib_gold->StereoControlWrite(StereoProcessorControlReg::Bass, val);
-		break;
-
 	case 0x07:
-		adlib_gold->StereoControlWrite(StereoProcessorControlReg::Treble, val);
-		break;
-
 	case 0x08:
-		adlib_gold->StereoControlWrite(StereoProcessorControlReg::SwitchFunctions,
-		                               val);
+	case 0x18: // Surround
+		QueueWrite(OplWriteType::AdlibGoldControl, ctrl.index, val);
 		break;
 
 	case 0x09: // Left FM Volume
@@ -535,9 +562,6 @@ void Opl::AdlibGoldControlWrite(const uint8_t val)
 			         static_cast<float>(ctrl.rvol & 0x1f) / 31.0f});
 		}
 		break;
-
-	case 0x18: // Surround
-		adlib_gold->SurroundControlWrite(val);
 	}
 }
 
@@ -565,8 +589,10 @@ uint8_t Opl::AdlibGoldControlRead()
 
 void Opl::PortWrite(const io_port_t port, const io_val_t value, const io_width_t)
 {
-	std::lock_guard lock(mutex);
-	RenderUpToNow();
+	// The chip is rendered on the mixer thread; we only need to make sure
+	// the channel is awake to pick up the queued writes.
+	assert(channel);
+	channel->WakeUp();
 
 	const auto val = check_cast<uint8_t>(value);
 
@@ -764,7 +790,7 @@ uint8_t Opl::PortRead(const io_port_t port, const io_width_t)
 					return chip[0].EsfmReadbackReg(
 					        reg.normal & 0xff);
 				}
-				return ESFM_readback_reg(&esfm.chip, reg.normal);
+				return ESFM_readback_reg(&esfm.shadow, reg.normal);
 			} else {
 				return 0x00;
 			}
@@ -8,7 +8,7 @@
 
 #include <cmath>
 #include <memory>
-#include <queue>
+#include <vector>
 
 #include "adlib_gold.h"
 #include "hardware.h"
@@ -16,6 +16,7 @@
 #include "mixer.h"
 #include "pic.h"
 #include "setup.h"
+#include "spsc_queue.h"
 
 #include "ESFMu/esfm.h"
 #include "nuked/opl3.h"
@@ -82,6 +83,17 @@ class OplCapture;
 
 enum class EsfmMode { Legacy, Native };
 
+// Register writes are made on the emulation thread but applied to the chip on
+// the mixer thread, so they're passed across in timestamped form.
+enum class OplWriteType : uint8_t { Register, EsfmPort, AdlibGoldControl };
+
+struct OplWrite {
+	double timestamp_ms = 0.0;
+	uint16_t reg        = 0;
+	uint8_t val         = 0;
+	OplWriteType type   = OplWriteType::Register;
+};
+
 class Opl {
 public:
 	MixerChannelPtr channel = {};
@@ -103,8 +115,13 @@ private:
 	IO_ReadHandleObject ReadHandler[3];
 	IO_WriteHandleObject WriteHandler[3];
 
-	std::queue<AudioFrame> fifo = {};
-	std::mutex mutex = {};
+	// Enough to hold several seconds of even the most write-heavy music
+	// drivers, should the mixer thread ever fall behind.
+	static constexpr size_t WriteQueueSize = 16384;
+
+	TimedWriteQueue<OplWrite, WriteQueueSize> write_queue = {};
+
+	std::vector<AudioFrame> render_buffer = {};
 
 	OplChip chip[2]  = {};
 
@@ -117,13 +134,18 @@ private:
 	std::unique_ptr<AdlibGold> adlib_gold = {};
 
 	struct {
+		// Rendered by the mixer thread
 		esfm_chip chip = {};
-		EsfmMode mode  = EsfmMode::Legacy;
+
+		// Mirrors the register state on the emulation thread for the
+		// address latch and register readback; never rendered
+		esfm_chip shadow = {};
+
+		EsfmMode mode = EsfmMode::Legacy;
 	} esfm = {};
 
 	// Playback related
-	double last_rendered_ms = 0.0;
-	double ms_per_frame     = 0.0;
+	double ms_per_frame = 0.0;
 
 	// Last selected address in the chip for the different modes
 	union {
@@ -147,7 +169,9 @@ private:
 
 	void AudioCallback(const int frames);
 	AudioFrame RenderFrame();
-	void RenderUpToNow();
+
+	void QueueWrite(const OplWriteType type, const uint16_t reg, const uint8_t val);
+	void ApplyWrite(const OplWrite& write);
 
 	void PortWrite(const io_port_t port, const io_val_t value,
 	               const io_width_t width);
@@ -420,6 +420,13 @@ void PIC_SetIRQMask(uint32_t irq, bool masked)
 	pic->set_imr(newmask);
 }
 
+bool PIC_IsIRQMasked(uint32_t irq)
+{
+	const uint32_t t = irq > 7 ? (irq - 8) : irq;
+	const PIC_Controller* pic = &pics[irq > 7 ? 1 : 0];
+	return (pic->imr & (1 << t)) != 0;
+}
+
 static void AddEntry(PICEntry * entry) {
 	PICEntry * find_entry=pic_queue.next_entry;
 	if (find_entry == nullptr) {
@@ -90,10 +90,36 @@ static uint8_t read_p3c0(io_port_t, io_width_t)
 	return retval;
 }
 
+static uint8_t read_p3c1(io_port_t, io_width_t);
+
+// Whether writing 'val' to port 3C0h changes the picture. An index write
+// only does when it toggles the palette address source, which enables or
+// disables the screen. A data write only does when it changes the stored
+// value, and palette writes only take effect while the screen is disabled.
+bool attr_write_changes_picture(const uint8_t val)
+{
+	if (vga.attr.is_address_mode) {
+		const auto reg             = AttributeAddressRegister{val};
+		const bool is_enabled      = !(vga.attr.disabled & 1);
+		const bool becomes_enabled = reg.palette_address_source;
+		return is_enabled != becomes_enabled;
+	}
+
+	constexpr auto LastPaletteIndex = 0x0f;
+	if (vga.attr.index <= LastPaletteIndex && !vga.attr.disabled) {
+		return false;
+	}
+	return read_p3c1(0, io_width_t::byte) != val;
+}
+
 static void write_p3c0(io_port_t, io_val_t value, io_width_t)
 {
 	auto val = check_cast<uint8_t>(value);
 
+	if (attr_write_changes_picture(val)) {
+		VGA_CatchUpDrawing();
+	}
+
 	if (vga.attr.is_address_mode) {
 		vga.attr.is_address_mode = false;
 
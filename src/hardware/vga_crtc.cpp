@@ -12,7 +12,6 @@
 void VGA_MapMMIO(void);
 void VGA_UnmapMMIO(void);
 
-void vga_write_p3d5(io_port_t port, io_val_t value, io_width_t);
 
 void vga_write_p3d4(io_port_t, io_val_t value, io_width_t)
 {
@@ -25,9 +24,35 @@ uint8_t vga_read_p3d4(io_port_t, io_width_t)
 	return vga.crtc.index;
 }
 
+// Whether writing 'val' to the selected register changes the picture. The
+// start address is only latched at vertical retrace, so page-flipping
+// programs can set it while the frame is drawn. Rewriting the value a
+// register already holds doesn't change anything either. The SVGA
+// registers are left to always catch up.
+bool crtc_write_changes_picture(const uint8_t val)
+{
+	constexpr auto LastVgaIndex = 0x18;
+
+	switch (vga.crtc.index) {
+	case 0x0c: // Start Address High Register
+	case 0x0d: // Start Address Low Register
+		return false;
+	default:
+		if (vga.crtc.index > LastVgaIndex) {
+			return true;
+		}
+		return vga_read_p3d5(0, io_width_t::byte) != val;
+	}
+}
+
 void vga_write_p3d5(io_port_t, io_val_t value, io_width_t)
 {
 	const auto val = check_cast<uint8_t>(value);
+
+	if (crtc_write_changes_picture(val)) {
+		VGA_CatchUpDrawing();
+	}
+
 	// if (vga.crtc.index > 0x18) {
 	// 	LOG_MSG("VGA crtc write %" sBitfs(X) " to reg %X", val, vga.crtc.index)
 	// }
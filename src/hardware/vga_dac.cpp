@@ -175,6 +175,8 @@ static void write_p3c6(io_port_t, io_val_t value, io_width_t)
 {
 	const auto val = check_cast<uint8_t>(value);
 	if (vga.dac.pel_mask != val) {
+		VGA_CatchUpDrawing();
+
 #if 0
 		LOG_MSG("VGA:DCA: PEL mask set to %Xh", val);
 #endif
@@ -229,6 +231,16 @@ static void write_p3c9(io_port_t, io_val_t value, io_width_t)
 	auto val = check_cast<uint8_t>(value);
 	val &= 0x3f;
 
+	// Rewriting the colour component a DAC entry already holds is common
+	// when programs upload whole palettes, and doesn't change the picture
+	const auto& rgb = vga.dac.rgb[vga.dac.write_index];
+	const auto current = (vga.dac.pel_index == 0) ? rgb.red
+	                   : (vga.dac.pel_index == 1) ? rgb.green
+	                                              : rgb.blue;
+	if (current != val) {
+		VGA_CatchUpDrawing();
+	}
+
 	switch (vga.dac.pel_index) {
 	case 0:
 		vga.dac.rgb[vga.dac.write_index].red = val;
@@ -20,6 +20,7 @@
 #include "render.h"
 #include "rgb565.h"
 #include "vga.h"
+#include "vga_line_expand.h"
 #include "video.h"
 
 // #define DEBUG_VGA_DRAW
@@ -260,33 +261,48 @@ static uint8_t *VGA_Draw_CGA4_Composite_Line(Bitu vidstart, Bitu line)
 	return Composite_Process(vga.tandy.color_select & 0x0f, vga.draw.blocks, true);
 }
 
+// Calls 'draw(offset, done, len)' for each contiguous run of the
+// 'num_units' units from 'start' onwards, as the address wraps at 'mask'
+template <typename DrawRun>
+static void for_each_unwrapped_run(const Bitu start, const Bitu mask,
+                                   const size_t num_units, DrawRun draw)
+{
+	size_t done = 0;
+	while (done < num_units) {
+		const Bitu offset = (start + done) & mask;
+		const Bitu to_end = mask - offset;
+
+		const auto left  = num_units - done;
+		const size_t len = (left - 1 <= to_end) ? left : to_end + 1;
+
+		draw(offset, done, len);
+		done += len;
+	}
+}
+
+static PackedPixelTable tandy_pixel_table = {};
+
 static uint8_t * VGA_Draw_4BPP_Line(Bitu vidstart, Bitu line) {
 	const uint8_t *base = vga.tandy.draw_base + ((line & vga.tandy.line_mask) << vga.tandy.line_shift);
-	uint8_t* draw=TempLine;
-	Bitu end = vga.draw.blocks*2;
-	while(end) {
-		uint8_t byte = base[vidstart & vga.tandy.addr_mask];
-		*draw++=vga.attr.palette[byte >> 4];
-		*draw++=vga.attr.palette[byte & 0x0f];
-		++vidstart;
-		--end;
-	}
+
+	tandy_pixel_table.Update(vga.attr.palette);
+
+	const auto draw_run = [&](const Bitu offset, const size_t done, const size_t len) {
+		tandy_pixel_table.Expand(base + offset, TempLine + done * 2, len);
+	};
+	for_each_unwrapped_run(vidstart, vga.tandy.addr_mask, vga.draw.blocks * 2, draw_run);
 	return TempLine;
 }
 
 static uint8_t * VGA_Draw_4BPP_Line_Double(Bitu vidstart, Bitu line) {
 	const uint8_t *base = vga.tandy.draw_base + ((line & vga.tandy.line_mask) << vga.tandy.line_shift);
-	uint8_t* draw=TempLine;
-	Bitu end = vga.draw.blocks;
-	while(end) {
-		uint8_t byte = base[vidstart & vga.tandy.addr_mask];
-		uint8_t data = vga.attr.palette[byte >> 4];
-		*draw++ = data; *draw++ = data;
-		data = vga.attr.palette[byte & 0x0f];
-		*draw++ = data; *draw++ = data;
-		++vidstart;
-		--end;
-	}
+
+	tandy_pixel_table.Update(vga.attr.palette);
+
+	const auto draw_run = [&](const Bitu offset, const size_t done, const size_t len) {
+		tandy_pixel_table.ExpandDoubled(base + offset, TempLine + done * 4, len);
+	};
+	for_each_unwrapped_run(vidstart, vga.tandy.addr_mask, vga.draw.blocks, draw_run);
 	return TempLine;
 }
 
@@ -362,28 +378,17 @@ static uint8_t* draw_unwrapped_line_from_dac_palette(Bitu vidstart,
 	// Video mode-specific line variables
 	const auto pixels_in_line = static_cast<uint16_t>(vga.draw.line_length /
 	                                                  bytes_per_pixel);
-	const auto video_end = vidstart + pixels_in_line;
-
-	// The line address is where the RGB888 palettized pixel is written.
-	// It's incremented forward per pixel.
-	auto line_addr = reinterpret_cast<uint32_t*>(TempLine);
-
-	auto linear_pos = vidstart;
-
-	// Draw in batches of four to let the host pipeline deeper.
-	constexpr auto num_repeats = 4;
-	assert(pixels_in_line % num_repeats == 0);
 
 	// This function typically runs on 640+-wide lines and is a rendering
-	// bottleneck.
-	while (linear_pos < video_end) {
-		auto repeats = num_repeats;
-		while (repeats--) {
-			const auto masked_pos    = linear_pos++ & linear_mask;
-			const auto palette_index = *(linear_addr + masked_pos);
-			*line_addr++ = *(palette_map + palette_index);
-		}
-	}
+	// bottleneck, so expand the contiguous runs between the wrap points
+	// rather than masking each pixel's address.
+	const auto draw_run = [&](const Bitu offset, const size_t done, const size_t len) {
+		expand_palette_indices(linear_addr + offset,
+		                       palette_map,
+		                       TempLine + done * bytes_per_pixel,
+		                       len);
+	};
+	for_each_unwrapped_run(vidstart, linear_mask, pixels_in_line, draw_run);
 
 	return TempLine;
 }
@@ -394,17 +399,15 @@ static uint8_t* draw_linear_line_from_dac_palette(Bitu vidstart, Bitu /*line*/)
 	constexpr auto palette_map        = vga.dac.palette_map;
 	constexpr uint8_t bytes_per_pixel = sizeof(palette_map[0]);
 
-	// The line address is where the RGB888 palettized pixel is written.
-	// It's incremented forward per pixel.
+	// The line address is where the RGB888 palettized pixels are written.
+	// It's moved forward past each expanded chunk.
 	auto line_addr = TempLine;
 
-	// The palette index iterator is used to lookup the DAC palette colour.
-	// It starts at the current VGA line's offset and is incremented per
-	// pixel.
-	auto palette_index_it = vga.draw.linear_base + offset;
+	// The palette indices of the current VGA line start at its offset
+	const auto palette_index_it = vga.draw.linear_base + offset;
 
 	// Pixels remaining starts as the total pixels in this current line and
-	// is decremented per pixel rendered. It acts as a lower-bound cutoff
+	// is reduced by each chunk rendered. It acts as a lower-bound cutoff
 	// regardless of how long the wrapped and unwrapped regions are.
 	auto pixels_remaining = check_cast<uint16_t>(vga.draw.line_length /
 	                                             bytes_per_pixel);
@@ -431,36 +434,18 @@ static uint8_t* draw_linear_line_from_dac_palette(Bitu vidstart, Bitu /*line*/)
 		        vga.draw.line_length - wrapped_len);
 
 		// unwrapped chunk: to top of memory block
-		auto palette_index_end = palette_index_it +
-		                         std::min(unwrapped_len, pixels_remaining);
-		while (palette_index_it != palette_index_end) {
-			memcpy(line_addr,
-			       palette_map + *palette_index_it++,
-			       bytes_per_pixel);
-			line_addr += bytes_per_pixel;
-			--pixels_remaining;
-		}
+		const auto num_unwrapped = std::min(unwrapped_len, pixels_remaining);
+		expand_palette_indices(palette_index_it, palette_map, line_addr, num_unwrapped);
+
+		line_addr += num_unwrapped * bytes_per_pixel;
+		pixels_remaining -= num_unwrapped;
 
 		// wrapped chunk: from the base of the memory block
-		palette_index_it  = vga.draw.linear_base;
-		palette_index_end = palette_index_it +
-		                    std::min(wrapped_len, pixels_remaining);
-		while (palette_index_it != palette_index_end) {
-			memcpy(line_addr,
-			       palette_map + *palette_index_it++,
-			       bytes_per_pixel);
-			line_addr += bytes_per_pixel;
-			--pixels_remaining;
-		}
+		const auto num_wrapped = std::min(wrapped_len, pixels_remaining);
+		expand_palette_indices(vga.draw.linear_base, palette_map, line_addr, num_wrapped);
 
 	} else {
-		auto palette_index_end = palette_index_it + pixels_remaining;
-		while (palette_index_it != palette_index_end) {
-			memcpy(line_addr,
-			       palette_map + *palette_index_it++,
-			       bytes_per_pixel);
-			line_addr += bytes_per_pixel;
-		}
+		expand_palette_indices(palette_index_it, palette_map, line_addr, pixels_remaining);
 	}
 	return TempLine;
 }
@@ -802,7 +787,7 @@ static uint8_t* draw_text_line_from_dac_palette(Bitu vidstart, Bitu line)
 		const auto chr  = *vidmem++;
 		const auto attr = *vidmem++;
 		// the font pattern
-		uint16_t font = vga.draw.font_tables[(attr >> 3) & 1][(chr << 5) + line];
+		const uint8_t font = vga.draw.font_tables[(attr >> 3) & 1][(chr << 5) + line];
 
 		uint8_t bg_palette_idx = attr >> 4;
 		// if blinking is enabled bit7 is not mapped to attributes
@@ -825,27 +810,22 @@ static uint8_t* draw_text_line_from_dac_palette(Bitu vidstart, Bitu line)
 		const auto fg_colour = palette_map[fg_palette_idx];
 		const auto bg_colour = palette_map[bg_palette_idx];
 
-		if (vga.seq.clocking_mode.is_eight_dot_mode) {
-			for (auto n = 0; n < 8; ++n) {
-				const auto color = (font & 0x80) ? fg_colour
-				                                 : bg_colour;
-				write_unaligned_uint32_at(TempLine, draw_idx++, color);
-				font <<= 1;
-			}
-		} else {
-			font <<= 1; // 9 pixels
-			// Extend to the 9th pixel if needed
-			if ((font & 0x2) &&
-			    vga.attr.mode_control.is_line_graphics_enabled &&
-			    (chr >= 0xc0) && (chr <= 0xdf)) {
-				font |= 1;
-			}
-			for (auto n = 0; n < 9; ++n) {
-				const auto color = (font & 0x100) ? fg_colour
-				                                  : bg_colour;
-				write_unaligned_uint32_at(TempLine, draw_idx++, color);
-				font <<= 1;
-			}
+		expand_glyph_row(font,
+		                 fg_colour,
+		                 bg_colour,
+		                 TempLine + draw_idx * sizeof(uint32_t));
+		draw_idx += 8;
+
+		if (!vga.seq.clocking_mode.is_eight_dot_mode) {
+			// The 9th pixel repeats the 8th for the line graphics
+			// characters, and is background otherwise
+			const auto is_extended = (font & 0x1) &&
+			                         vga.attr.mode_control.is_line_graphics_enabled &&
+			                         (chr >= 0xc0) && (chr <= 0xdf);
+
+			write_unaligned_uint32_at(TempLine,
+			                          draw_idx++,
+			                          is_extended ? fg_colour : bg_colour);
 		}
 	}
 	// draw the text mode cursor if needed
@@ -1035,7 +1015,7 @@ static void VGA_DrawEGASingleLine(uint32_t /*blah*/)
 	} else RENDER_EndUpdate(false);
 }
 
-static void VGA_DrawPart(uint32_t lines)
+static void draw_part_lines(uint32_t lines)
 {
 	while (lines--) {
 		uint8_t * data=VGA_DrawLine( vga.draw.address, vga.draw.address_line );
@@ -1056,17 +1036,77 @@ static void VGA_DrawPart(uint32_t lines)
 #endif
 		}
 	}
-	if (--vga.draw.parts_left) {
-		PIC_AddEvent(VGA_DrawPart, vga.draw.delay.parts,
-		             (vga.draw.parts_left != 1)
-		                     ? vga.draw.parts_lines
-		                     : (vga.draw.lines_total - vga.draw.lines_done));
-	} else {
+}
+
+// The number of lines drawn by the next part; the last part draws whatever
+// is left over
+static uint32_t get_next_part_lines()
+{
+	return (vga.draw.parts_left != 1) ? vga.draw.parts_lines
+	                                  : (vga.draw.lines_total - vga.draw.lines_done);
+}
+
+static void finish_parts()
+{
 #ifdef VGA_KEEP_CHANGES
-		VGA_ChangesEnd();
+	VGA_ChangesEnd();
 #endif
-		RENDER_EndUpdate(false);
+	RENDER_EndUpdate(false);
+}
+
+static void VGA_DrawPart(uint32_t lines)
+{
+	draw_part_lines(lines);
+
+	if (--vga.draw.parts_left) {
+		PIC_AddEvent(VGA_DrawPart, vga.draw.delay.parts, get_next_part_lines());
+	} else {
+		finish_parts();
+	}
+}
+
+// Draws all the parts of a frame that was deferred to the end of the active
+// display period
+static void VGA_DrawDeferredFrame(uint32_t /*val*/)
+{
+	vga.draw.is_frame_deferred = false;
+
+	while (vga.draw.parts_left) {
+		draw_part_lines(get_next_part_lines());
+		--vga.draw.parts_left;
 	}
+	finish_parts();
+}
+
+void VGA_CatchUpDrawing()
+{
+	if (!vga.draw.is_frame_deferred) {
+		return;
+	}
+	vga.draw.is_frame_deferred = false;
+	PIC_RemoveEvents(VGA_DrawDeferredFrame);
+
+	// Draw the parts the beam has already passed with the current state,
+	// as per-part rendering would have done
+	const auto elapsed = PIC_FullIndex() - vga.draw.delay.drawstart;
+
+	auto parts_done = vga.draw.parts_total - static_cast<int>(vga.draw.parts_left);
+	while (vga.draw.parts_left &&
+	       elapsed >= vga.draw.delay.parts * (parts_done + 1)) {
+		draw_part_lines(get_next_part_lines());
+		--vga.draw.parts_left;
+		++parts_done;
+	}
+
+	if (!vga.draw.parts_left) {
+		finish_parts();
+		return;
+	}
+
+	// Draw the rest of the frame part by part, so later changes to the
+	// registers also take effect at the right line
+	const auto next_part_delay = vga.draw.delay.parts * (parts_done + 1) - elapsed;
+	PIC_AddEvent(VGA_DrawPart, next_part_delay, get_next_part_lines());
 }
 
 void VGA_SetBlinking(const uint8_t enabled)
@@ -1309,11 +1349,26 @@ static void VGA_VerticalTimer(uint32_t /*val*/)
 		if (vga.draw.parts_left) {
 			LOG(LOG_VGAMISC, LOG_NORMAL)("Parts left: %u", vga.draw.parts_left);
 			PIC_RemoveEvents(VGA_DrawPart);
+			PIC_RemoveEvents(VGA_DrawDeferredFrame);
+			vga.draw.is_frame_deferred = false;
 			RENDER_EndUpdate(true);
 		}
 		vga.draw.lines_done = 0;
 		vga.draw.parts_left = vga.draw.parts_total;
-		PIC_AddEvent(VGA_DrawPart, vga.draw.delay.parts + draw_skip, vga.draw.parts_lines);
+
+		if (vga.draw.render_whole_frames) {
+			// Draw the whole frame when the last part would be drawn,
+			// unless the registers change before then
+			vga.draw.is_frame_deferred = true;
+			vga.draw.delay.drawstart = vga.draw.delay.framestart + draw_skip;
+
+			PIC_AddEvent(VGA_DrawDeferredFrame,
+			             vga.draw.delay.parts * vga.draw.parts_total + draw_skip);
+		} else {
+			PIC_AddEvent(VGA_DrawPart,
+			             vga.draw.delay.parts + draw_skip,
+			             vga.draw.parts_lines);
+		}
 		break;
 	case DRAWLINE:
 	case EGALINE:
@@ -1463,6 +1518,9 @@ static void setup_line_drawing_delays(const uint32_t total_lines)
 		vga.draw.parts_total = total_lines;
 	}
 
+	vga.draw.render_whole_frames = (vga.draw.mode == PART) &&
+	                               section->GetBool("vga_render_whole_frames");
+
 	vga.draw.delay.parts = vga.draw.delay.vdend / vga.draw.parts_total;
 
 	assert(total_lines > 0 && total_lines <= SCALER_MAXHEIGHT);
@@ -3011,8 +3069,10 @@ void VGA_SetupDrawing(uint32_t /*val*/)
 
 void VGA_KillDrawing(void) {
 	PIC_RemoveEvents(VGA_DrawPart);
+	PIC_RemoveEvents(VGA_DrawDeferredFrame);
 	PIC_RemoveEvents(VGA_DrawSingleLine);
 	PIC_RemoveEvents(VGA_DrawEGASingleLine);
+	vga.draw.is_frame_deferred = false;
 	vga.draw.parts_left = 0;
 	vga.draw.lines_done = ~0;
 	if (!vga.draw.vga_override) RENDER_EndUpdate(true);
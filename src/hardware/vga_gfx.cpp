@@ -20,9 +20,28 @@ static uint8_t read_p3ce(io_port_t, io_width_t)
 	return gfx(index);
 }
 
-static void write_p3cf(io_port_t, io_val_t value, io_width_t)
+// Whether writing 'val' to the selected register changes the picture. Only
+// some bits of the mode and miscellaneous registers do; planar and Mode X
+// code rewrites the read and write modes mid-frame to access video memory.
+bool gfx_write_changes_picture(const uint8_t val)
+{
+	switch (gfx(index)) {
+	case 5: /* Mode Register: odd/even, CGA and 256 colour modes */
+		return (gfx(mode) ^ val) & 0xf0;
+	case 6: /* Miscellaneous Register: graphics mode, odd/even, memory map */
+		return (gfx(miscellaneous) ^ val) & 0x0f;
+	default: return false;
+	}
+}
+
+void write_p3cf(io_port_t, io_val_t value, io_width_t)
 {
 	const auto val = check_cast<uint8_t>(value);
+
+	if (gfx_write_changes_picture(val)) {
+		VGA_CatchUpDrawing();
+	}
+
 	switch (gfx(index)) {
 	case 0:	/* Set/Reset Register */
 		gfx(set_reset)=val & 0x0f;
@@ -0,0 +1,152 @@
+// SPDX-FileCopyrightText:  2025-2025 The DOSBox Staging Team
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef DOSBOX_VGA_LINE_EXPAND_H
+#define DOSBOX_VGA_LINE_EXPAND_H
+
+/*  VGA Line Expansion
+ *  ------------------
+ *  The inner loops of the VGA line drawers: turning a run of palette indices,
+ *  a row of font bits, or a run of packed 4-bit pixels into output pixels.
+ *  They run for every pixel of every visible line, so they work on several
+ *  pixels at once.
+ *
+ *  SSE2 has no byte shuffle or gather, so palette lookups are still done one
+ *  index at a time; the speedup comes from fewer loads of the indices, wide
+ *  stores, and branch-free colour selection. EGA and VGA planar pixels don't
+ *  need a bit-plane transpose here as they're already stored as one index per
+ *  byte when written (see Expand16Table in vga_memory.cpp).
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "bgrx8888.h"
+
+#include "simde/x86/sse2.h"
+
+// Looks up each 8-bit index in the 256-entry palette, and writes the 32-bit
+// colours to 'out'.
+inline void expand_palette_indices(const uint8_t* indices,
+                                   const Bgrx8888* palette, uint8_t* out,
+                                   const size_t num_pixels)
+{
+	constexpr size_t PixelsPerVector = sizeof(simde__m128i) / sizeof(uint32_t);
+	constexpr size_t PixelsPerBatch  = 4 * PixelsPerVector;
+
+	const auto lookup = [palette](const uint64_t packed, const int byte) {
+		return static_cast<int32_t>(static_cast<uint32_t>(
+		        palette[(packed >> (byte * 8)) & 0xff]));
+	};
+
+	size_t x = 0;
+	for (; x + PixelsPerBatch <= num_pixels; x += PixelsPerBatch) {
+		uint64_t packed[2] = {};
+		std::memcpy(packed, indices + x, sizeof(packed));
+
+		for (auto half = 0; half < 2; ++half) {
+			const auto p = packed[half];
+
+			const auto lo = simde_mm_set_epi32(lookup(p, 3),
+			                                   lookup(p, 2),
+			                                   lookup(p, 1),
+			                                   lookup(p, 0));
+			const auto hi = simde_mm_set_epi32(lookup(p, 7),
+			                                   lookup(p, 6),
+			                                   lookup(p, 5),
+			                                   lookup(p, 4));
+
+			auto dest = out + (x + half * 8) * sizeof(uint32_t);
+			simde_mm_storeu_si128(reinterpret_cast<simde__m128i*>(dest), lo);
+			simde_mm_storeu_si128(reinterpret_cast<simde__m128i*>(
+			                              dest + sizeof(simde__m128i)),
+			                      hi);
+		}
+	}
+	for (; x < num_pixels; ++x) {
+		const uint32_t colour = palette[indices[x]];
+		std::memcpy(out + x * sizeof(uint32_t), &colour, sizeof(colour));
+	}
+}
+
+// Expands one row of a text mode glyph into 8 pixels, using the foreground
+// colour where the font bit is set and the background colour elsewhere. The
+// leftmost pixel is the top bit.
+inline void expand_glyph_row(const uint8_t font_bits, const uint32_t fg_colour,
+                             const uint32_t bg_colour, uint8_t* out)
+{
+	const auto bits = simde_mm_set1_epi32(font_bits);
+	const auto fg   = simde_mm_set1_epi32(static_cast<int32_t>(fg_colour));
+	const auto bg   = simde_mm_set1_epi32(static_cast<int32_t>(bg_colour));
+
+	const auto left_mask  = simde_mm_set_epi32(0x10, 0x20, 0x40, 0x80);
+	const auto right_mask = simde_mm_set_epi32(0x01, 0x02, 0x04, 0x08);
+
+	const auto select = [&](const simde__m128i mask) {
+		const auto is_fg = simde_mm_cmpeq_epi32(simde_mm_and_si128(bits, mask),
+		                                        mask);
+		return simde_mm_or_si128(simde_mm_and_si128(is_fg, fg),
+		                         simde_mm_andnot_si128(is_fg, bg));
+	};
+
+	simde_mm_storeu_si128(reinterpret_cast<simde__m128i*>(out),
+	                      select(left_mask));
+	simde_mm_storeu_si128(reinterpret_cast<simde__m128i*>(
+	                              out + sizeof(simde__m128i)),
+	                      select(right_mask));
+}
+
+// Maps every byte of the Tandy and PCjr 16-colour modes, which pack two 4-bit
+// pixels per byte, to both of its 8-bit palette colours at once. The tables
+// are only rebuilt when the palette changes.
+class PackedPixelTable {
+public:
+	void Update(const uint8_t* palette)
+	{
+		if (is_valid && std::memcmp(palette, cached_palette, sizeof(cached_palette)) == 0) {
+			return;
+		}
+		std::memcpy(cached_palette, palette, sizeof(cached_palette));
+
+		for (auto byte = 0; byte < 256; ++byte) {
+			const uint8_t left  = palette[byte >> 4];
+			const uint8_t right = palette[byte & 0x0f];
+
+			// Stored in memory order, so they can be copied out as-is
+			const uint8_t single[2]  = {left, right};
+			const uint8_t doubled[4] = {left, left, right, right};
+
+			std::memcpy(&pairs[byte], single, sizeof(single));
+			std::memcpy(&doubled_pairs[byte], doubled, sizeof(doubled));
+		}
+		is_valid = true;
+	}
+
+	// Writes two pixels per source byte
+	void Expand(const uint8_t* src, uint8_t* out, const size_t num_bytes) const
+	{
+		for (size_t i = 0; i < num_bytes; ++i) {
+			std::memcpy(out + i * sizeof(pairs[0]), &pairs[src[i]], sizeof(pairs[0]));
+		}
+	}
+
+	// Writes every pixel twice, so four pixels per source byte
+	void ExpandDoubled(const uint8_t* src, uint8_t* out, const size_t num_bytes) const
+	{
+		for (size_t i = 0; i < num_bytes; ++i) {
+			std::memcpy(out + i * sizeof(doubled_pairs[0]),
+			            &doubled_pairs[src[i]],
+			            sizeof(doubled_pairs[0]));
+		}
+	}
+
+private:
+	uint16_t pairs[256]         = {};
+	uint32_t doubled_pairs[256] = {};
+
+	uint8_t cached_palette[16] = {};
+	bool is_valid              = false;
+};
+
+#endif // DOSBOX_VGA_LINE_EXPAND_H
@@ -10,8 +10,6 @@
 
 void vga_write_p3d4(io_port_t port, io_val_t value, io_width_t);
 uint8_t vga_read_p3d4(io_port_t port, io_width_t);
-void vga_write_p3d5(io_port_t port, io_val_t value, io_width_t);
-uint8_t vga_read_p3d5(io_port_t port, io_width_t);
 
 uint8_t vga_read_p3da(io_port_t, io_width_t)
 {
@@ -43,6 +41,8 @@ uint8_t vga_read_p3da(io_port_t, io_width_t)
 static void write_p3c2(io_port_t, io_val_t value, io_width_t)
 {
 	const auto val = check_cast<uint8_t>(value);
+
+	VGA_CatchUpDrawing();
 	/*
 	   Bit  Description
 	    0   If set: Color Emulation with base Address=3Dxh.
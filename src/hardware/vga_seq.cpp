@@ -19,9 +19,27 @@ void write_p3c4(io_port_t, io_val_t value, io_width_t)
 	seq(index) = val;
 }
 
+// Whether writing 'val' to the selected register changes the picture. The
+// map mask is changed all the time to write planar video memory but doesn't
+// affect the picture, and rewriting the value a register already holds
+// doesn't either.
+bool seq_write_changes_picture(const uint8_t val)
+{
+	constexpr auto MapMaskIndex = 2;
+	if (seq(index) == MapMaskIndex) {
+		return false;
+	}
+	return read_p3c5(0, io_width_t::byte) != val;
+}
+
 void write_p3c5(io_port_t, io_val_t value, io_width_t)
 {
 	auto val = check_cast<uint8_t>(value);
+
+	if (seq_write_changes_picture(val)) {
+		VGA_CatchUpDrawing();
+	}
+
 	//	LOG_MSG("SEQ WRITE reg %X val %X",seq(index),val);
 	switch (seq(index)) {
 	case 0: /* Reset */ seq(reset) = val; break;
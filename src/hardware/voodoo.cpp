@@ -62,15 +62,21 @@
 #include <atomic>
 #include <bit>
 #include <cassert>
+#include <chrono>
+#include <cinttypes>
 #include <cmath>
 #include <condition_variable>
 #include <cstdlib>
 #include <cstring>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <vector>
 
 #include <SDL.h>
 #include <SDL_cpuinfo.h> // for proper SSE defines for MSVC
 
+#include "../capture/capture.h"
 #include "bitops.h"
 #include "byteorder.h"
 #include "control.h"
@@ -86,6 +92,8 @@
 #include "simde/x86/sse2.h"
 #include "support.h"
 #include "vga.h"
+#include "voodoo.h"
+#include "voodoo_register_stream.h"
 
 #ifndef DOSBOX_VOODOO_TYPES_H
 #define DOSBOX_VOODOO_TYPES_H
@@ -262,10 +270,10 @@ enum VoodooModel
 #ifdef C_ENABLE_VOODOO_OPENGL
 /* maximum number of rasterizers */
 #define MAX_RASTERIZERS			1024
+#endif
 
 /* size of the rasterizer hash table */
 #define RASTER_HASH_SIZE		97
-#endif
 
 /* flags for LFB writes */
 #define LFB_RGB_PRESENT			1
@@ -691,8 +699,12 @@ struct stats_block {
 	// int32_t clip_fail;       // clipping fail statistic
 	// int32_t stipple_count;   // stipple statistic
 
+	// Textures found fully decoded in, or decoded into, the texture cache
+	int32_t tex_cache_hits   = 0;
+	int32_t tex_cache_misses = 0;
+
 	// pad this structure to 64 bytes
-	int32_t filler[64 / 4 - 5] = {};
+	int32_t filler[64 / 4 - 7] = {};
 };
 static_assert(sizeof(stats_block) == 64);
 
@@ -722,6 +734,43 @@ struct ncc_table
 
 using mem_buffer_t = std::unique_ptr<uint8_t[]>;
 
+// Texture RAM decoded to ARGB texels as one texture format, so the texture
+// pipeline reads finished texels instead of looking up every raw texel in
+// the format's table. The texels are at the same index as the raw texels in
+// texture RAM (the byte address for 8-bit formats, half of it for 16-bit
+// ones).
+//
+// Pages are decoded on the emulation thread when a primitive using them is
+// set up, and again after the texture RAM or the format's palette or NCC
+// table changes. Both of those flush the rasterizer threads first, so a page
+// is never decoded while queued primitives read it.
+struct decoded_texture_ram {
+	std::unique_ptr<rgb_t[]> texels = {};
+
+	// Version of each texture RAM page the decoded page was made from
+	std::vector<uint32_t> page_versions = {};
+
+	// Palette and NCC table changes the pages were decoded after
+	uint32_t lookup_generation = 0;
+
+	// When a primitive last used the layout, for evicting the least
+	// recently used one
+	uint64_t last_used = 0;
+};
+
+constexpr uint32_t TexCachePageShift = 12;
+constexpr uint32_t TexCachePageSize  = 1 << TexCachePageShift;
+
+// One layout per texture format, plus the NCC formats using table 1
+constexpr auto NumDecodedLayouts = 18;
+
+// Each layout reserves ARGB texels for all of the TMU's texture RAM: four
+// times its size for 8-bit formats and twice for 16-bit ones. Keeping every
+// layout would reserve up to 216 MB per TMU with 4 MB of texture RAM, so only
+// this many stay allocated; with 8-bit formats that's at most 96 MB per TMU.
+// Games rarely use more formats than this at once.
+constexpr auto MaxAllocatedDecodedLayouts = 6;
+
 struct tmu_state
 {
 	uint8_t*				ram;					/* pointer to aligned RAM */
@@ -762,6 +811,19 @@ struct tmu_state
 
 	rgb_t				palette[256];			/* palette lookup table */
 	rgb_t				palettea[256];			/* palette+alpha lookup table */
+
+	uint32_t texture_bytes = 0; /* texture RAM used by all LODs of the texture */
+
+	/* decoded texels of the current texture, or nullptr if not cached */
+	const rgb_t* decoded = nullptr;
+
+	/* incremented whenever a page of texture RAM is written */
+	std::vector<uint32_t> page_versions = {};
+
+	std::array<decoded_texture_ram, NumDecodedLayouts> decoded_layouts = {};
+
+	/* incremented whenever a primitive uses a decoded layout */
+	uint64_t decoded_layout_uses = 0;
 };
 
 struct tmu_shared_state
@@ -890,52 +952,249 @@ struct draw_state {
 	bool screen_update_pending   = false;
 };
 
-struct triangle_worker
+// Texture pipeline state of a TMU captured when a primitive is queued. The
+// field names match tmu_state so the TEXTURE_PIPELINE macro reads either.
+struct tmu_raster_params {
+	uint8_t* ram  = {};
+	uint32_t mask = {};
+
+	int64_t starts = {};
+	int64_t startt = {};
+	int64_t startw = {};
+	int64_t dsdx   = {};
+	int64_t dtdx   = {};
+	int64_t dwdx   = {};
+	int64_t dsdy   = {};
+	int64_t dtdy   = {};
+	int64_t dwdy   = {};
+
+	int32_t lodmin        = {};
+	int32_t lodmax        = {};
+	int32_t lodbias       = {};
+	uint32_t lodmask      = {};
+	uint32_t lodoffset[9] = {};
+	int32_t lodbasetemp   = {};
+	int32_t detailmax     = {};
+	int32_t detailbias    = {};
+	uint8_t detailscale   = {};
+
+	uint32_t wmask        = {};
+	uint32_t hmask        = {};
+	uint8_t bilinear_mask = {};
+
+	const rgb_t* lookup  = {};
+	const rgb_t* decoded = {};
+};
+
+// Frame buffer layout, iterated parameters and fog table captured when a
+// primitive is queued. The field names match fbi_state.
+struct fbi_raster_params {
+	uint8_t* ram       = {};
+	uint32_t mask      = {};
+	uint32_t auxoffs   = {};
+	uint32_t rowpixels = {};
+	uint32_t yorigin   = {};
+
+	int16_t ax = {};
+	int16_t ay = {};
+
+	int32_t startr = {};
+	int32_t startg = {};
+	int32_t startb = {};
+	int32_t starta = {};
+	int32_t startz = {};
+	int64_t startw = {};
+	int32_t drdx   = {};
+	int32_t dgdx   = {};
+	int32_t dbdx   = {};
+	int32_t dadx   = {};
+	int32_t dzdx   = {};
+	int64_t dwdx   = {};
+	int32_t drdy   = {};
+	int32_t dgdy   = {};
+	int32_t dbdy   = {};
+	int32_t dady   = {};
+	int32_t dzdy   = {};
+	int64_t dwdy   = {};
+
+	uint8_t fogblend[64]  = {};
+	uint8_t fogdelta[64]  = {};
+	uint8_t fogdelta_mask = {};
+};
+
+// Everything the span rasterizers read, so the emulation thread can keep
+// writing registers while queued primitives are still being rendered.
+struct raster_params {
+	uint32_t r_fbzColorPath  = {};
+	uint32_t r_fbzMode       = {};
+	uint32_t r_alphaMode     = {};
+	uint32_t r_fogMode       = {};
+	uint32_t r_zaColor       = {};
+	uint32_t r_stipple       = {};
+	uint32_t r_clipLeftRight = {};
+	uint32_t r_clipLowYHighY = {};
+
+	rgb_union r_color0      = {};
+	rgb_union r_color1      = {};
+	rgb_union r_chromaKey   = {};
+	rgb_union r_chromaRange = {};
+	rgb_union r_fogColor    = {};
+
+	uint32_t tmus     = {};
+	uint32_t texmode0 = {};
+	uint32_t texmode1 = {};
+
+	bool send_config    = {};
+	uint32_t tmu_config = {};
+
+	uint16_t* drawbuf = {};
+
+	fbi_raster_params fbi          = {};
+	tmu_raster_params tmu[MAX_TMU] = {};
+};
+
+// Draws one scanline of a triangle
+using raster_span_func = void (*)(const raster_params& rp, int32_t y,
+                                  const poly_extent* extent, stats_block& stats);
+
+enum class RasterCommand : uint8_t { Triangle, Fastfill };
+
+struct raster_command {
+	RasterCommand type   = {};
+	raster_params params = {};
+
+	// Span rasterizer matching the triangle's pipeline state
+	raster_span_func span = nullptr;
+
+	// Triangle vertices sorted by Y
+	poly_vertex v1 = {};
+	poly_vertex v2 = {};
+	poly_vertex v3 = {};
+
+	// Fastfill extent and dither pattern
+	int32_t startx = 0;
+	int32_t stopx  = 0;
+
+	alignas(sizeof(uint64_t)) uint16_t dither[16] = {};
+
+	// Scanlines covered by the command
+	int32_t v1y = 0;
+	int32_t v3y = 0;
+
+	// Screen rows [min_row, max_row) the scanlines map to, used to bin
+	// the command into tiles. The rows wrap around if the Y origin is
+	// flipped and the command crosses it.
+	int32_t min_row = 0;
+	int32_t max_row = 0;
+	bool rows_wrap  = false;
+};
+
+// Triangles and fastfills are appended to a command FIFO and rendered
+// asynchronously in batches. The screen rows touched by a batch are split
+// into horizontal tiles; a worker claims a tile and renders every command
+// of the batch that overlaps it, in submission order. Tiles never share
+// pixels, so the workers don't need to coordinate beyond claiming tiles.
+//
+// The emulation thread only waits for the workers when something is about
+// to read or modify what they're working on: LFB accesses, texture
+// uploads, palette changes, buffer swaps, and statistics or status reads.
+struct raster_worker
 {
-	triangle_worker(const int num_threads_)
+	raster_worker(const int num_threads_)
 	        : num_threads(num_threads_),
-	          // I measured 4x the thread count to be the sweet spot, after which performance degrades.
-	          // This gives about 20% more FPS in Descent II over the old 1x count.
-	          num_work_units((num_threads + 1) * 4),
-	          threads(num_threads)
+	          // 4x the thread count was measured to be the sweet spot when
+	          // splitting single triangles, and it also keeps the tiles
+	          // small enough to balance uneven scenes.
+	          num_tiles((num_threads + 1) * 4),
+	          threads(num_threads),
+	          next_tile(num_tiles)
 	{
-		assert(num_work_units > num_threads);
+		assert(num_tiles > num_threads);
+		queued.reserve(MaxQueuedCommands);
+		batch.reserve(MaxQueuedCommands);
 	}
 
-	triangle_worker()                                  = delete;
-	triangle_worker(const triangle_worker&)            = delete;
-	triangle_worker& operator=(const triangle_worker&) = delete;
+	raster_worker()                                = delete;
+	raster_worker(const raster_worker&)            = delete;
+	raster_worker& operator=(const raster_worker&) = delete;
+
+	// Queued commands are handed to the workers in batches of this size
+	static constexpr size_t MaxQueuedCommands = 128;
 
 	const int num_threads = 0;
-	const int num_work_units = 0;
+	const int num_tiles   = 0;
 
 	bool disable_bilinear_filter = {};
 
 	std::atomic_bool threads_active = {};
 
-	uint16_t* drawbuf = {};
+	std::vector<std::thread> threads = {};
 
-	poly_vertex v1 = {};
-	poly_vertex v2 = {};
-	poly_vertex v3 = {};
+	// Commands queued by the emulation thread
+	std::vector<raster_command> queued = {};
 
-	int32_t v1y      = 0;
-	int32_t v3y      = 0;
-	int32_t totalpix = 0;
+	// Batch of commands being rendered by the workers
+	std::vector<raster_command> batch = {};
 
-	std::vector<std::thread> threads = {};
+	bool batch_in_flight = false;
+
+	int32_t batch_first_row = 0;
+	int32_t tile_rows       = 0;
+
+	// Set if a queued command draws to the front buffer
+	bool front_buffer_dirty = false;
+
+	// Workers wake up when this is incremented
+	std::atomic<uint32_t> batch_generation = 0;
+
+	// Workers start claiming tiles when this gets reset to 0
+	std::atomic<int> next_tile;
+
+	std::atomic<int> tiles_done = 0;
+};
+
+// Effective (normalised) fbzColorPath, alphaMode, fogMode, fbzMode, and
+// textureMode values of both TMUs, which select the span rasterizer
+using raster_state_key = std::array<uint32_t, 6>;
+
+// Number of triangles drawn with the generic rasterizer in one pipeline
+// state; a zero count marks an unused entry
+struct generic_state_count {
+	raster_state_key key = {};
+	int64_t count        = 0;
+};
+
+constexpr size_t NumCountedGenericStates = 128;
+
+// Entries of the generic state table tried before a state goes uncounted
+constexpr size_t MaxGenericStateProbes = 8;
+
+// How many triangles were drawn with the specialised and generic span
+// rasterizers, and the pipeline states that needed the generic one
+struct rasterizer_stats {
+	int64_t num_specialised = 0;
+	int64_t num_generic     = 0;
 
-	// Worker threads start working when this gets reset to 0
-	std::atomic<int> work_index = INT_MAX;
+	// Open-addressed by the raster hash of the state, so counting a
+	// triangle doesn't allocate; states that find no free entry only count
+	// towards num_generic
+	std::array<generic_state_count, NumCountedGenericStates> generic_states = {};
+};
+
+// Texture cache use since startup
+struct texture_cache_stats {
+	int64_t hits          = 0;
+	int64_t misses        = 0;
+	int64_t pages_decoded = 0;
 
-	std::atomic<int> done_count = 0;
+	int64_t layouts_evicted = 0;
 };
 
 struct voodoo_state
 {
 	voodoo_state(const int num_threads)
-	        : tworker(num_threads),
-	          thread_stats(tworker.num_work_units)
+	        : rworker(num_threads),
+	          thread_stats(rworker.num_tiles)
 	{
 		assert(!thread_stats.empty());
 	}
@@ -979,8 +1238,25 @@ struct voodoo_state
 #endif
 
 	draw_state draw = {};
-	triangle_worker tworker;
+	raster_worker rworker;
+
+	rasterizer_stats raster_stats = {};
 	std::vector<stats_block> thread_stats = {};
+
+	// Gathered on the emulation thread while setting up primitives
+	stats_block setup_stats = {};
+
+	texture_cache_stats tex_cache_stats = {};
+
+	// Incremented when a palette or NCC table changes, which invalidates
+	// the textures decoded with them
+	uint32_t texture_lookup_generation = 1;
+
+	// Number of buffer swaps since startup
+	uint32_t num_swaps = 0;
+
+	// Records the guest's writes to the card when capturing them
+	std::unique_ptr<VoodooStreamWriter> recorder = {};
 };
 
 #ifdef C_ENABLE_VOODOO_OPENGL
@@ -1180,14 +1456,13 @@ inline int64_t float_to_int64(uint32_t data, int fixedbits)
 
 
 
-#ifdef C_ENABLE_VOODOO_OPENGL
 /*************************************
  *
  *  Rasterizer inlines
  *
  *************************************/
 
-inline uint32_t normalize_color_path(uint32_t eff_color_path)
+constexpr uint32_t normalize_color_path(uint32_t eff_color_path)
 {
 	/* ignore the subpixel adjust and texture enable flags */
 	eff_color_path &= ~((1 << 26) | (1 << 27));
@@ -1195,7 +1470,7 @@ inline uint32_t normalize_color_path(uint32_t eff_color_path)
 	return eff_color_path;
 }
 
-inline uint32_t normalize_alpha_mode(uint32_t eff_alpha_mode)
+constexpr uint32_t normalize_alpha_mode(uint32_t eff_alpha_mode)
 {
 	/* always ignore alpha ref value */
 	eff_alpha_mode &= ~(0xff << 24);
@@ -1211,7 +1486,7 @@ inline uint32_t normalize_alpha_mode(uint32_t eff_alpha_mode)
 	return eff_alpha_mode;
 }
 
-inline uint32_t normalize_fog_mode(uint32_t eff_fog_mode)
+constexpr uint32_t normalize_fog_mode(uint32_t eff_fog_mode)
 {
 	/* if not doing fogging, ignore all the other fog bits */
 	if (!FOGMODE_ENABLE_FOG(eff_fog_mode))
@@ -1220,7 +1495,7 @@ inline uint32_t normalize_fog_mode(uint32_t eff_fog_mode)
 	return eff_fog_mode;
 }
 
-inline uint32_t normalize_fbz_mode(uint32_t eff_fbz_mode)
+constexpr uint32_t normalize_fbz_mode(uint32_t eff_fbz_mode)
 {
 	/* ignore the draw buffer */
 	eff_fbz_mode &= ~(3 << 14);
@@ -1228,7 +1503,7 @@ inline uint32_t normalize_fbz_mode(uint32_t eff_fbz_mode)
 	return eff_fbz_mode;
 }
 
-inline uint32_t normalize_tex_mode(uint32_t eff_tex_mode)
+constexpr uint32_t normalize_tex_mode(uint32_t eff_tex_mode)
 {
 	/* ignore the NCC table and seq_8_downld flags */
 	eff_tex_mode &= ~((1 << 5) | (1 << 31));
@@ -1244,25 +1519,41 @@ inline uint32_t normalize_tex_mode(uint32_t eff_tex_mode)
 	return eff_tex_mode;
 }
 
-inline uint32_t compute_raster_hash(const raster_info* info)
+constexpr uint32_t compute_raster_hash(const uint32_t eff_color_path,
+                                       const uint32_t eff_alpha_mode,
+                                       const uint32_t eff_fog_mode,
+                                       const uint32_t eff_fbz_mode,
+                                       const uint32_t eff_tex_mode_0,
+                                       const uint32_t eff_tex_mode_1)
 {
 	uint32_t hash;
 
 	/* make a hash */
-	hash = info->eff_color_path;
+	hash = eff_color_path;
 	hash = (hash << 1) | (hash >> 31);
-	hash ^= info->eff_fbz_mode;
+	hash ^= eff_fbz_mode;
 	hash = (hash << 1) | (hash >> 31);
-	hash ^= info->eff_alpha_mode;
+	hash ^= eff_alpha_mode;
 	hash = (hash << 1) | (hash >> 31);
-	hash ^= info->eff_fog_mode;
+	hash ^= eff_fog_mode;
 	hash = (hash << 1) | (hash >> 31);
-	hash ^= info->eff_tex_mode_0;
+	hash ^= eff_tex_mode_0;
 	hash = (hash << 1) | (hash >> 31);
-	hash ^= info->eff_tex_mode_1;
+	hash ^= eff_tex_mode_1;
 
 	return hash % RASTER_HASH_SIZE;
 }
+
+#ifdef C_ENABLE_VOODOO_OPENGL
+inline uint32_t compute_raster_hash(const raster_info* info)
+{
+	return compute_raster_hash(info->eff_color_path,
+	                           info->eff_alpha_mode,
+	                           info->eff_fog_mode,
+	                           info->eff_fbz_mode,
+	                           info->eff_tex_mode_0,
+	                           info->eff_tex_mode_1);
+}
 #endif
 
 
@@ -1466,15 +1757,15 @@ while (0)
 #define ADD_STAT_COUNT(STATS, STATNAME) (STATS).STATNAME++;
 //#define ADD_STAT_COUNT(STATS, STATNAME)
 
-#define APPLY_CHROMAKEY(VV, STATS, FBZMODE, COLOR)								\
+#define APPLY_CHROMAKEY(STATS, FBZMODE, CHROMAKEY, CHROMARANGE, COLOR)			\
 do																				\
 {																				\
 	if (FBZMODE_ENABLE_CHROMAKEY(FBZMODE))										\
 	{																			\
 		/* non-range version */													\
-		if (!CHROMARANGE_ENABLE((VV)->reg[chromaRange].u))						\
+		if (!CHROMARANGE_ENABLE((CHROMARANGE).u))						\
 		{																		\
-			if ((((COLOR).u ^ (VV)->reg[chromaKey].u) & 0xffffff) == 0)			\
+			if ((((COLOR).u ^ (CHROMAKEY).u) & 0xffffff) == 0)			\
 			{																	\
 				ADD_STAT_COUNT(STATS, chroma_fail)								\
 				goto skipdrawdepth;												\
@@ -1488,30 +1779,30 @@ do																				\
 			int results = 0;													\
 																				\
 			/* check blue */													\
-			low = (VV)->reg[chromaKey].rgb.b;									\
-			high = (VV)->reg[chromaRange].rgb.b;								\
+			low = (CHROMAKEY).rgb.b;									\
+			high = (CHROMARANGE).rgb.b;								\
 			test = (COLOR).rgb.b;													\
 			results = (test >= low && test <= high);							\
-			results ^= CHROMARANGE_BLUE_EXCLUSIVE((VV)->reg[chromaRange].u);	\
+			results ^= CHROMARANGE_BLUE_EXCLUSIVE((CHROMARANGE).u);	\
 			results <<= 1;														\
 																				\
 			/* check green */													\
-			low = (VV)->reg[chromaKey].rgb.g;									\
-			high = (VV)->reg[chromaRange].rgb.g;								\
+			low = (CHROMAKEY).rgb.g;									\
+			high = (CHROMARANGE).rgb.g;								\
 			test = (COLOR).rgb.g;													\
 			results |= (test >= low && test <= high);							\
-			results ^= CHROMARANGE_GREEN_EXCLUSIVE((VV)->reg[chromaRange].u);	\
+			results ^= CHROMARANGE_GREEN_EXCLUSIVE((CHROMARANGE).u);	\
 			results <<= 1;														\
 																				\
 			/* check red */														\
-			low = (VV)->reg[chromaKey].rgb.r;									\
-			high = (VV)->reg[chromaRange].rgb.r;								\
+			low = (CHROMAKEY).rgb.r;									\
+			high = (CHROMARANGE).rgb.r;								\
 			test = (COLOR).rgb.r;													\
 			results |= (test >= low && test <= high);							\
-			results ^= CHROMARANGE_RED_EXCLUSIVE((VV)->reg[chromaRange].u);		\
+			results ^= CHROMARANGE_RED_EXCLUSIVE((CHROMARANGE).u);		\
 																				\
 			/* final result */													\
-			if (CHROMARANGE_UNION_MODE((VV)->reg[chromaRange].u))				\
+			if (CHROMARANGE_UNION_MODE((CHROMARANGE).u))				\
 			{																	\
 				if (results != 0)												\
 				{																\
@@ -1540,7 +1831,7 @@ while (0)
  *
  *************************************/
 
-#define APPLY_ALPHAMASK(VV, STATS, FBZMODE, AA)									\
+#define APPLY_ALPHAMASK(STATS, FBZMODE, AA)										\
 do																				\
 {																				\
 	if (FBZMODE_ENABLE_ALPHA_MASK(FBZMODE))										\
@@ -1562,12 +1853,12 @@ while (0)
  *
  *************************************/
 
-#define APPLY_ALPHATEST(VV, STATS, ALPHAMODE, AA)								\
+#define APPLY_ALPHATEST(STATS, ALPHAMODE, ALPHAREF, AA)							\
 do																				\
 {																				\
 	if (ALPHAMODE_ALPHATEST(ALPHAMODE))											\
 	{																			\
-		uint8_t alpharef = (VV)->reg[alphaMode].rgb.a;							\
+		const auto alpharef = static_cast<uint8_t>(ALPHAREF);					\
 		switch (ALPHAMODE_ALPHAFUNCTION(ALPHAMODE))								\
 		{																		\
 			case 0:		/* alphaOP = never */									\
@@ -1795,12 +2086,12 @@ while (0)
  *
  *************************************/
 
-#define APPLY_FOGGING(VV, FOGMODE, FBZCP, XX, DITHER4, RR, GG, BB, ITERZ, ITERW, ITERAXXX)	\
+#define APPLY_FOGGING(FBI, FOGCOLOR, FOGMODE, FBZCP, XX, DITHER4, RR, GG, BB, ITERZ, ITERW, ITERAXXX)	\
 do																				\
 {																				\
 	if (FOGMODE_ENABLE_FOG(FOGMODE))											\
 	{																			\
-		rgb_union fogcolor = (VV)->reg[fogColor];								\
+		const rgb_union fogcolor = (FOGCOLOR);									\
 		int32_t fr, fg, fb;														\
 																				\
 		/* constant fog bypasses everything else */								\
@@ -1839,11 +2130,11 @@ do																				\
 			{																	\
 				case 0:		/* fog table */										\
 				{																\
-					int32_t delta = (VV)->fbi.fogdelta[wfloat >> 10];				\
+					int32_t delta = (FBI).fogdelta[wfloat >> 10];					\
 					int32_t deltaval;												\
 																				\
 					/* perform the multiply against lower 8 bits of wfloat */	\
-					deltaval = (delta & (VV)->fbi.fogdelta_mask) *				\
+					deltaval = (delta & (FBI).fogdelta_mask) *					\
 								((wfloat >> 2) & 0xff);							\
 																				\
 					/* fog zones allow for negating this value */				\
@@ -1858,7 +2149,7 @@ do																				\
 					deltaval >>= 4;												\
 																				\
 					/* add to the blending factor */							\
-					fogblend = (VV)->fbi.fogblend[wfloat >> 10] + deltaval;		\
+					fogblend = (FBI).fogblend[wfloat >> 10] + deltaval;			\
 					break;														\
 				}																\
 																				\
@@ -1989,7 +2280,14 @@ do																				\
 		t *= smax + 1;															\
 																				\
 		/* fetch texel data */													\
-		if (TEXMODE_FORMAT(TEXMODE) < 8)										\
+		if ((TT)->decoded)														\
+		{																		\
+			if (TEXMODE_FORMAT(TEXMODE) < 8)									\
+				c_local.u = (TT)->decoded[(texbase + t + s) & (TT)->mask];		\
+			else																\
+				c_local.u = (TT)->decoded[((texbase + 2*(t + s)) & (TT)->mask) >> 1];\
+		}																		\
+		else if (TEXMODE_FORMAT(TEXMODE) < 8)									\
 		{																		\
 			texel0 = (TT)->ram[(texbase + t + s) & (TT)->mask];					\
 			c_local.u = (LOOKUP)[texel0];										\
@@ -2050,7 +2348,24 @@ do																				\
 		t1 *= smax + 1;															\
 																				\
 		/* fetch texel data */													\
-		if (TEXMODE_FORMAT(TEXMODE) < 8)										\
+		if ((TT)->decoded)														\
+		{																		\
+			if (TEXMODE_FORMAT(TEXMODE) < 8)									\
+			{																	\
+				texel0 = (TT)->decoded[(texbase + t + s) & (TT)->mask];			\
+				texel1 = (TT)->decoded[(texbase + t + s1) & (TT)->mask];		\
+				texel2 = (TT)->decoded[(texbase + t1 + s) & (TT)->mask];		\
+				texel3 = (TT)->decoded[(texbase + t1 + s1) & (TT)->mask];		\
+			}																	\
+			else																\
+			{																	\
+				texel0 = (TT)->decoded[((texbase + 2*(t + s)) & (TT)->mask) >> 1];\
+				texel1 = (TT)->decoded[((texbase + 2*(t + s1)) & (TT)->mask) >> 1];\
+				texel2 = (TT)->decoded[((texbase + 2*(t1 + s)) & (TT)->mask) >> 1];\
+				texel3 = (TT)->decoded[((texbase + 2*(t1 + s1)) & (TT)->mask) >> 1];\
+			}																	\
+		}																		\
+		else if (TEXMODE_FORMAT(TEXMODE) < 8)									\
 		{																		\
 			texel0 = (TT)->ram[(texbase + t + s) & (TT)->mask];					\
 			texel1 = (TT)->ram[(texbase + t + s1) & (TT)->mask];				\
@@ -2256,7 +2571,27 @@ while (0)
  *
  *************************************/
 
-#define PIXEL_PIPELINE_BEGIN(VV, STATS, XX, YY, FBZCOLORPATH, FBZMODE, ITERZ, ITERW, ZACOLOR, STIPPLE)	\
+// Computes the "floating point" W value used for depth and fog
+static inline int32_t compute_wfloat(const int64_t iterw)
+{
+	if (iterw & LONGTYPE(0xffff00000000)) {
+		return 0x0000;
+	}
+	const auto temp = static_cast<uint32_t>(iterw);
+	if ((temp & 0xffff0000) == 0) {
+		return 0xffff;
+	}
+	const auto exp         = std::countl_zero(temp);
+	const auto right_shift = std::max(0, 19 - exp);
+
+	int32_t wfloat = ((exp << 12) | ((~temp >> right_shift) & 0xfff));
+	if (wfloat < 0xffff) {
+		wfloat++;
+	}
+	return wfloat;
+}
+
+#define PIXEL_PIPELINE_BEGIN(STATS, XX, YY, FBZCOLORPATH, FBZMODE, ITERZ, ITERW, ZACOLOR, STIPPLE)	\
 do																				\
 {																				\
 	int32_t depthval, wfloat;														\
@@ -2291,21 +2626,7 @@ do																				\
 	}																			\
 																				\
 	/* compute "floating point" W value (used for depth and fog) */				\
-	if ((ITERW) & LONGTYPE(0xffff00000000))										\
-		wfloat = 0x0000;														\
-	else																		\
-	{																			\
-		uint32_t temp = (uint32_t)(ITERW);											\
-		if ((temp & 0xffff0000) == 0)											\
-			wfloat = 0xffff;													\
-		else																	\
-		{																		\
-			const auto exp = std::countl_zero(temp);	                        \
-			const auto right_shift = std::max(0, 19 - exp);	                    \
-			wfloat = ((exp << 12) | ((~temp >> right_shift) & 0xfff));          \
-			if (wfloat < 0xffff) wfloat++;										\
-		}																		\
-	}																			\
+	wfloat = compute_wfloat(ITERW);												\
 																				\
 	/* compute depth value (W or Z) for this pixel */							\
 	if (FBZMODE_WBUFFER_SELECT(FBZMODE) == 0)									\
@@ -2417,20 +2738,20 @@ do																				\
 	}
 
 
-#define PIXEL_PIPELINE_MODIFY(VV, DITHER, DITHER4, XX, FBZMODE, FBZCOLORPATH, ALPHAMODE, FOGMODE, ITERZ, ITERW, ITERAXXX) \
+#define PIXEL_PIPELINE_MODIFY(FBI, FOGCOLOR, DITHER, DITHER4, XX, FBZMODE, FBZCOLORPATH, ALPHAMODE, FOGMODE, ITERZ, ITERW, ITERAXXX) \
 																				\
 	/* perform fogging */														\
 	prefogr = r;																\
 	prefogg = g;																\
 	prefogb = b;																\
-	APPLY_FOGGING(VV, FOGMODE, FBZCOLORPATH, XX, DITHER4, r, g, b,				\
+	APPLY_FOGGING(FBI, FOGCOLOR, FOGMODE, FBZCOLORPATH, XX, DITHER4, r, g, b,				\
 					ITERZ, ITERW, ITERAXXX);									\
 																				\
 	/* perform alpha blending */												\
 	APPLY_ALPHA_BLEND(FBZMODE, ALPHAMODE, XX, DITHER, r, g, b, a);
 
 
-#define PIXEL_PIPELINE_FINISH(VV, DITHER_LOOKUP, XX, dest, depth, FBZMODE)		\
+#define PIXEL_PIPELINE_FINISH(DITHER_LOOKUP, XX, dest, depth, FBZMODE)			\
 																				\
 	/* write to framebuffer */													\
 	if (FBZMODE_RGB_BUFFER_MASK(FBZMODE))										\
@@ -3015,6 +3336,23 @@ static auto vtype = VOODOO_1;
 
 static auto voodoo_bilinear_filtering = false;
 
+// Can be turned off to benchmark the specialised rasterizers against the
+// generic one
+static auto voodoo_specialised_rasterizers = true;
+
+// Can be turned off to compare the SIMD pixel pipeline against the scalar
+// one
+static auto voodoo_simd_rasterizers = true;
+
+// Can be turned off to benchmark decoding texels on every fetch
+static auto voodoo_texture_cache = true;
+
+static auto voodoo_register_capture = false;
+
+// Emulated time source of the register stream recorder; the benchmark
+// substitutes its own frame clock
+static double (*recorder_time_ms)() = PIC_FullIndex;
+
 #define LOG_VOODOO LOG_PCI
 enum {
 	LOG_VBLANK_SWAP = 0,
@@ -3032,6 +3370,7 @@ enum {
 
 /* drawing */
 static void Voodoo_UpdateScreenStart();
+static void raster_worker_flush(raster_worker& rworker);
 static bool Voodoo_GetRetrace();
 static double Voodoo_GetVRetracePosition();
 static double Voodoo_GetHRetracePosition();
@@ -3043,9 +3382,217 @@ static double Voodoo_GetHRetracePosition();
 static dither_lut_t dither2_lookup = {};
 static dither_lut_t dither4_lookup = {};
 
-static inline void raster_generic(const voodoo_state* vs, uint32_t TMUS, uint32_t TEXMODE0,
-                                  uint32_t TEXMODE1, void* destbase, int32_t y,
-                                  const poly_extent* extent, stats_block& stats)
+// Normalised textureMode value of a TMU that isn't used
+constexpr uint32_t TexModeUnused = 0xffffffff;
+
+/***************************************************************************
+    SIMD PIXEL PIPELINE
+***************************************************************************/
+
+// The SIMD span rasterizer runs the pixel pipeline on four pixels at a time,
+// one 32-bit lane per pixel. It's written against SSE2 through simde, which
+// maps it onto NEON on ARM. Pixels that fail the depth or alpha test are
+// masked out of the final writes instead of being branched around, and only
+// the texture fetches remain per pixel. The results are identical to the
+// scalar pipeline.
+//
+// Stippling, chroma keying, alpha masking, alpha planes, fogging, and a few
+// rarely used colour combine modes aren't vectorised; triangles using them
+// are drawn with the scalar pipeline.
+//
+constexpr bool is_simd_raster_state(const uint32_t eff_color_path,
+                                    const uint32_t eff_fog_mode,
+                                    const uint32_t eff_fbz_mode)
+{
+	return !FBZCP_CC_LOCALSELECT_OVERRIDE(eff_color_path) &&
+	       FBZCP_CCA_LOCALSELECT(eff_color_path) != 3 &&
+	       !FOGMODE_ENABLE_FOG(eff_fog_mode) &&
+	       !FBZMODE_ENABLE_CHROMAKEY(eff_fbz_mode) &&
+	       !FBZMODE_ENABLE_STIPPLE(eff_fbz_mode) &&
+	       !FBZMODE_ENABLE_ALPHA_MASK(eff_fbz_mode) &&
+	       !FBZMODE_ENABLE_ALPHA_PLANES(eff_fbz_mode) &&
+	       !(FBZMODE_WBUFFER_SELECT(eff_fbz_mode) &&
+	         FBZMODE_DEPTH_FLOAT_SELECT(eff_fbz_mode));
+}
+
+constexpr auto SimdLanes = 4;
+
+static inline simde__m128i simd_select(const simde__m128i mask,
+                                       const simde__m128i a, const simde__m128i b)
+{
+	return simde_mm_or_si128(simde_mm_and_si128(mask, a),
+	                         simde_mm_andnot_si128(mask, b));
+}
+
+static inline simde__m128i simd_clamp(const simde__m128i val,
+                                      const int32_t min_val, const int32_t max_val)
+{
+	const auto min_v = simde_mm_set1_epi32(min_val);
+	const auto max_v = simde_mm_set1_epi32(max_val);
+
+	const auto clamped = simd_select(simde_mm_cmplt_epi32(val, min_v), min_v, val);
+	return simd_select(simde_mm_cmpgt_epi32(clamped, max_v), max_v, clamped);
+}
+
+// Clamps four channels to 0-255 at once with saturating packs
+static inline void simd_clamp_to_uint8(simde__m128i& r, simde__m128i& g,
+                                       simde__m128i& b, simde__m128i& a)
+{
+	const auto zero   = simde_mm_setzero_si128();
+	const auto packed = simde_mm_packus_epi16(simde_mm_packs_epi32(r, g),
+	                                          simde_mm_packs_epi32(b, a));
+
+	const auto rg = simde_mm_unpacklo_epi8(packed, zero);
+	const auto ba = simde_mm_unpackhi_epi8(packed, zero);
+
+	r = simde_mm_unpacklo_epi16(rg, zero);
+	g = simde_mm_unpackhi_epi16(rg, zero);
+	b = simde_mm_unpacklo_epi16(ba, zero);
+	a = simde_mm_unpackhi_epi16(ba, zero);
+}
+
+// Returns (val * factor) >> 8 for values in the 16-bit signed range and
+// factors up to 256. The high halves of the factors are zero, so the pairwise
+// multiply-add yields the exact 32-bit products.
+static inline simde__m128i simd_scale(const simde__m128i val, const simde__m128i factor)
+{
+	return simde_mm_srai_epi32(simde_mm_madd_epi16(val, factor), 8);
+}
+
+// The values of an iterated parameter at the four pixels of a group
+static inline simde__m128i simd_lane_offsets(const int32_t delta)
+{
+	const auto d = static_cast<uint32_t>(delta);
+	return simde_mm_setr_epi32(0,
+	                           static_cast<int32_t>(d),
+	                           static_cast<int32_t>(d * 2),
+	                           static_cast<int32_t>(d * 3));
+}
+
+// Vectorised CLAMPED_ARGB for one colour channel
+static inline simde__m128i simd_clamped_argb(const simde__m128i iter, const bool clamp)
+{
+	const auto val = simde_mm_srai_epi32(iter, 12);
+	if (clamp) {
+		return simd_clamp(val, 0, 0xff);
+	}
+	const auto wrapped = simde_mm_and_si128(val, simde_mm_set1_epi32(0xfff));
+	const auto is_underflow = simde_mm_cmpeq_epi32(wrapped, simde_mm_set1_epi32(0xfff));
+	const auto is_overflow = simde_mm_cmpeq_epi32(wrapped, simde_mm_set1_epi32(0x100));
+
+	const auto result = simd_select(is_overflow,
+	                                simde_mm_set1_epi32(0xff),
+	                                simde_mm_and_si128(wrapped,
+	                                                   simde_mm_set1_epi32(0xff)));
+	return simde_mm_andnot_si128(is_underflow, result);
+}
+
+// Vectorised CLAMPED_Z
+static inline simde__m128i simd_clamped_z(const simde__m128i iter, const bool clamp)
+{
+	const auto val = simde_mm_srai_epi32(iter, 12);
+	if (clamp) {
+		return simd_clamp(val, 0, 0xffff);
+	}
+	const auto wrapped = simde_mm_and_si128(val, simde_mm_set1_epi32(0xfffff));
+	const auto is_underflow = simde_mm_cmpeq_epi32(wrapped,
+	                                               simde_mm_set1_epi32(0xfffff));
+	const auto is_overflow = simde_mm_cmpeq_epi32(wrapped,
+	                                              simde_mm_set1_epi32(0x10000));
+
+	const auto result = simd_select(is_overflow,
+	                                simde_mm_set1_epi32(0xffff),
+	                                simde_mm_and_si128(wrapped,
+	                                                   simde_mm_set1_epi32(0xffff)));
+	return simde_mm_andnot_si128(is_underflow, result);
+}
+
+// Lane masks of the depth and alpha test functions; both have the same
+// encoding
+static inline simde__m128i simd_compare(const uint32_t function,
+                                        const simde__m128i a, const simde__m128i b)
+{
+	const auto all_ones = simde_mm_set1_epi32(-1);
+
+	switch (function) {
+	case 0: /* never */ return simde_mm_setzero_si128();
+	case 1: /* less than */ return simde_mm_cmplt_epi32(a, b);
+	case 2: /* equal */ return simde_mm_cmpeq_epi32(a, b);
+	case 3: /* less than or equal */
+		return simde_mm_xor_si128(simde_mm_cmpgt_epi32(a, b), all_ones);
+	case 4: /* greater than */ return simde_mm_cmpgt_epi32(a, b);
+	case 5: /* not equal */
+		return simde_mm_xor_si128(simde_mm_cmpeq_epi32(a, b), all_ones);
+	case 6: /* greater than or equal */
+		return simde_mm_xor_si128(simde_mm_cmplt_epi32(a, b), all_ones);
+	default: /* always */ return all_ones;
+	}
+}
+
+// One bit per lane that's set in the mask
+static inline int simd_lane_bits(const simde__m128i mask)
+{
+	return simde_mm_movemask_ps(simde_mm_castsi128_ps(mask));
+}
+
+// Number of lanes that are set in the mask. Looked up rather than using
+// std::popcount, which is a library call without a POPCNT target.
+static inline int simd_num_lanes(const simde__m128i mask)
+{
+	constexpr uint8_t NumBitsSet[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+	return NumBitsSet[simd_lane_bits(mask)];
+}
+
+static inline simde__m128i simd_load_u16(const uint16_t* src)
+{
+	return simde_mm_unpacklo_epi16(simde_mm_loadl_epi64(
+	                                       reinterpret_cast<const simde__m128i*>(src)),
+	                               simde_mm_setzero_si128());
+}
+
+// Stores the low 16 bits of the lanes that are set in the mask
+static inline void simd_store_u16_masked(uint16_t* dst, const simde__m128i val,
+                                         const simde__m128i mask)
+{
+	// Sign-extend the low halves so the saturating pack keeps them intact
+	const auto low_halves = simde_mm_srai_epi32(simde_mm_slli_epi32(val, 16), 16);
+
+	const auto packed = simde_mm_packs_epi32(low_halves, low_halves);
+	const auto mask16 = simde_mm_packs_epi32(mask, mask);
+	const auto old    = simde_mm_loadl_epi64(reinterpret_cast<const simde__m128i*>(dst));
+
+	simde_mm_storel_epi64(reinterpret_cast<simde__m128i*>(dst),
+	                      simd_select(mask16, packed, old));
+}
+
+struct simd_rgba {
+	simde__m128i r = {};
+	simde__m128i g = {};
+	simde__m128i b = {};
+	simde__m128i a = {};
+};
+
+static inline simd_rgba simd_broadcast(const rgb_union color)
+{
+	return {simde_mm_set1_epi32(static_cast<int32_t>(RGB_RED(color.u))),
+	        simde_mm_set1_epi32(static_cast<int32_t>(RGB_GREEN(color.u))),
+	        simde_mm_set1_epi32(static_cast<int32_t>(RGB_BLUE(color.u))),
+	        simde_mm_set1_epi32(static_cast<int32_t>(RGB_ALPHA(color.u)))};
+}
+
+// The span rasterizer behind both the generic and specialised rasterizers.
+// The generic one decodes the mode registers of each triangle at runtime,
+// while the specialised ones get the normalised modes as template arguments
+// so the compiler can fold away the per-pixel mode checks. Values that are
+// normalised out (e.g., the alpha reference) are always read at runtime.
+// With Simd set, the pixels are processed in groups of four with the SIMD
+// pixel pipeline, and only the remainder goes through the scalar one; the
+// caller must have checked the state with is_simd_raster_state().
+template <bool Specialised, bool Simd, uint32_t FbzColorPath = 0, uint32_t AlphaMode = 0,
+          uint32_t FogMode = 0, uint32_t FbzMode = 0, uint32_t TexMode0 = 0,
+          uint32_t TexMode1 = 0>
+static inline void raster_span(const raster_params& rp, int32_t y,
+                               const poly_extent* extent, stats_block& stats)
 {
 	const uint8_t* dither_lookup = nullptr;
 	const uint8_t* dither4       = nullptr;
@@ -3056,18 +3603,25 @@ static inline void raster_generic(const voodoo_state* vs, uint32_t TMUS, uint32_
 	int32_t stopx = extent->stopx;
 
 	// Quick references
-	const auto regs  = vs->reg;
-	const auto& fbi  = vs->fbi;
-	const auto& tmu0 = vs->tmu[0];
-	const auto& tmu1 = vs->tmu[1];
+	const auto& fbi  = rp.fbi;
+	const auto& tmu0 = rp.tmu[0];
+	const auto& tmu1 = rp.tmu[1];
+
+	constexpr uint32_t SpecialisedTmus = (TexMode0 == TexModeUnused) ? 0
+	                                   : (TexMode1 == TexModeUnused) ? 1
+	                                                                 : 2;
+
+	const uint32_t TMUS     = Specialised ? SpecialisedTmus : rp.tmus;
+	const uint32_t TEXMODE0 = Specialised ? TexMode0 : rp.texmode0;
+	const uint32_t TEXMODE1 = Specialised ? TexMode1 : rp.texmode1;
 
-	const uint32_t r_fbzColorPath = regs[fbzColorPath].u;
-	const uint32_t r_fbzMode      = regs[fbzMode].u;
-	const uint32_t r_alphaMode    = regs[alphaMode].u;
-	const uint32_t r_fogMode      = regs[fogMode].u;
-	const uint32_t r_zaColor      = regs[zaColor].u;
+	const uint32_t r_fbzColorPath = Specialised ? FbzColorPath : rp.r_fbzColorPath;
+	const uint32_t r_fbzMode   = Specialised ? FbzMode : rp.r_fbzMode;
+	const uint32_t r_alphaMode = Specialised ? AlphaMode : rp.r_alphaMode;
+	const uint32_t r_fogMode   = Specialised ? FogMode : rp.r_fogMode;
+	const uint32_t r_zaColor   = rp.r_zaColor;
 
-	uint32_t r_stipple = regs[stipple].u;
+	uint32_t r_stipple = rp.r_stipple;
 
 	/* determine the screen Y */
 	if (FBZMODE_Y_ORIGIN(r_fbzMode)) {
@@ -3094,21 +3648,21 @@ static inline void raster_generic(const voodoo_state* vs, uint32_t TMUS, uint32_
 	if (FBZMODE_ENABLE_CLIPPING(r_fbzMode))
 	{
 		/* Y clipping buys us the whole scanline */
-		if (scry < (int32_t)((regs[clipLowYHighY].u >> 16) & 0x3ff) ||
-		    scry >= (int32_t)(regs[clipLowYHighY].u & 0x3ff)) {
+		if (scry < (int32_t)((rp.r_clipLowYHighY >> 16) & 0x3ff) ||
+		    scry >= (int32_t)(rp.r_clipLowYHighY & 0x3ff)) {
 			stats.pixels_in += stopx - startx;
 			//stats.clip_fail += stopx - startx;
 			return;
 		}
 
 		/* X clipping */
-		int32_t tempclip = (regs[clipLeftRight].u >> 16) & 0x3ff;
+		int32_t tempclip = (rp.r_clipLeftRight >> 16) & 0x3ff;
 		if (startx < tempclip)
 		{
 			stats.pixels_in += tempclip - startx;
 			startx = tempclip;
 		}
-		tempclip = regs[clipLeftRight].u & 0x3ff;
+		tempclip = rp.r_clipLeftRight & 0x3ff;
 		if (stopx >= tempclip)
 		{
 			stats.pixels_in += stopx - tempclip;
@@ -3117,7 +3671,7 @@ static inline void raster_generic(const voodoo_state* vs, uint32_t TMUS, uint32_
 	}
 
 	/* get pointers to the target buffer and depth buffer */
-	uint16_t* dest  = (uint16_t*)destbase + scry * fbi.rowpixels;
+	uint16_t* dest  = rp.drawbuf + scry * fbi.rowpixels;
 	uint16_t* depth = (fbi.auxoffs != (uint32_t)(~0))
 	                        ? ((uint16_t*)(fbi.ram + fbi.auxoffs) +
 	                           scry * fbi.rowpixels)
@@ -3152,40 +3706,493 @@ static inline void raster_generic(const voodoo_state* vs, uint32_t TMUS, uint32_
 		itert1 = tmu1.startt + dy * tmu1.dtdy + dx * tmu1.dtdx;
 	}
 
-	/* loop in X */
-	for (int32_t x = startx; x < stopx; x++)
-	{
-		rgb_union iterargb = { 0 };
-		rgb_union texel = { 0 };
-
-		/* pixel pipeline part 1 handles depth testing and stippling */
-		PIXEL_PIPELINE_BEGIN(vs, stats, x, y, r_fbzColorPath, r_fbzMode, iterz, iterw, r_zaColor, r_stipple);
+	// Runs the texture pipeline for the pixel at x, or the pixel the given
+	// number of lanes further along the span
+	const auto fetch_texel = [&](const int32_t x, const int32_t lane) {
+		rgb_union texel = {0};
 
 		/* run the texture pipeline on TMU1 to produce a value in texel */
 		/* note that they set LOD min to 8 to "disable" a TMU */
-
-		if (TMUS >= 2 && vs->tmu[1].lodmin < (8 << 8)) {
-			const tmu_state* const tmus = &vs->tmu[1];
+		if (TMUS >= 2 && tmu1.lodmin < (8 << 8)) {
+			const auto tmus = &tmu1;
 			const rgb_t* const lookup = tmus->lookup;
 			TEXTURE_PIPELINE(tmus, x, dither4, TEXMODE1, texel,
 								lookup, tmus->lodbasetemp,
-								iters1, itert1, iterw1, texel);
+								iters1 + lane * tmu1.dsdx,
+								itert1 + lane * tmu1.dtdx,
+								iterw1 + lane * tmu1.dwdx, texel);
 		}
 
 		/* run the texture pipeline on TMU0 to produce a final */
 		/* result in texel */
 		/* note that they set LOD min to 8 to "disable" a TMU */
 		if (TMUS >= 1 && tmu0.lodmin < (8 << 8)) {
-			if (!vs->send_config) {
-				const tmu_state* const tmus = &tmu0;
+			if (!rp.send_config) {
+				const auto tmus = &tmu0;
 				const rgb_t* const lookup = tmus->lookup;
 				TEXTURE_PIPELINE(tmus, x, dither4, TEXMODE0, texel,
 								lookup, tmus->lodbasetemp,
-								iters0, itert0, iterw0, texel);
+								iters0 + lane * tmu0.dsdx,
+								itert0 + lane * tmu0.dtdx,
+								iterw0 + lane * tmu0.dwdx, texel);
 			} else {	/* send config data to the frame buffer */
-				texel.u=vs->tmu_config;
+				texel.u = rp.tmu_config;
 			}
 		}
+		return texel;
+	};
+
+	int32_t x = startx;
+
+	if constexpr (Simd) {
+		const auto zero    = simde_mm_setzero_si128();
+		const auto one     = simde_mm_set1_epi32(1);
+		const auto mask_ff = simde_mm_set1_epi32(0xff);
+
+		const bool rgbzw_clamp = FBZCP_RGBZW_CLAMP(r_fbzColorPath);
+
+		const auto offsets_r = simd_lane_offsets(fbi.drdx);
+		const auto offsets_g = simd_lane_offsets(fbi.dgdx);
+		const auto offsets_b = simd_lane_offsets(fbi.dbdx);
+		const auto offsets_a = simd_lane_offsets(fbi.dadx);
+		const auto offsets_z = simd_lane_offsets(fbi.dzdx);
+
+		// The groups are four pixels apart, so the dither values of
+		// their lanes are the same along the span
+		const auto dither_amounts = dither ? simde_mm_setr_epi32(dither[x & 3],
+		                                                         dither[(x + 1) & 3],
+		                                                         dither[(x + 2) & 3],
+		                                                         dither[(x + 3) & 3])
+		                                   : zero;
+
+		const auto const_color0 = simd_broadcast(rp.r_color0);
+		const auto const_color1 = simd_broadcast(rp.r_color1);
+
+		// Runs the pixel pipeline on the group of pixels starting at x
+		const auto render_group = [&]() {
+			/* compute depth value (W or Z) for these pixels */
+			const auto iterated_z = simde_mm_add_epi32(simde_mm_set1_epi32(iterz),
+			                                           offsets_z);
+			simde__m128i depthval = {};
+			if (FBZMODE_WBUFFER_SELECT(r_fbzMode) == 0) {
+				depthval = simd_clamped_z(iterated_z, rgbzw_clamp);
+			} else {
+				depthval = simde_mm_setr_epi32(compute_wfloat(iterw),
+				                               compute_wfloat(iterw + fbi.dwdx),
+				                               compute_wfloat(iterw + 2 * fbi.dwdx),
+				                               compute_wfloat(iterw + 3 * fbi.dwdx));
+			}
+
+			/* add the bias */
+			if (FBZMODE_ENABLE_DEPTH_BIAS(r_fbzMode)) {
+				const auto bias = simde_mm_set1_epi32(static_cast<int16_t>(r_zaColor));
+				depthval = simd_clamp(simde_mm_add_epi32(depthval, bias), 0, 0xffff);
+			}
+
+			/* handle depth buffer testing */
+			auto pass = simde_mm_set1_epi32(-1);
+			if (FBZMODE_ENABLE_DEPTHBUF(r_fbzMode)) {
+				const auto function = FBZMODE_DEPTH_FUNCTION(r_fbzMode);
+
+				// Without a depth buffer only the never function fails
+				if (depth || function == 0) {
+					const auto depthsource =
+					        (FBZMODE_DEPTH_SOURCE_COMPARE(r_fbzMode) == 0)
+					                ? depthval
+					                : simde_mm_set1_epi32(
+					                          static_cast<uint16_t>(r_zaColor));
+					pass = simd_compare(function,
+					                    depthsource,
+					                    depth ? simd_load_u16(depth + x) : zero);
+				}
+				stats.zfunc_fail += SimdLanes - simd_num_lanes(pass);
+			}
+			const auto depth_pass_bits = simd_lane_bits(pass);
+			if (depth_pass_bits == 0) {
+				return;
+			}
+
+			/* run the texture pipeline on the pixels that passed */
+			alignas(16) uint32_t texels[SimdLanes] = {};
+			if (TMUS >= 1) {
+				for (auto lane = 0; lane < SimdLanes; ++lane) {
+					if (depth_pass_bits & (1 << lane)) {
+						texels[lane] = fetch_texel(x + lane, lane).u;
+					}
+				}
+			}
+			const auto texel_v = simde_mm_load_si128(
+			        reinterpret_cast<const simde__m128i*>(texels));
+
+			const simd_rgba texel = {
+			        simde_mm_and_si128(simde_mm_srli_epi32(texel_v, 16), mask_ff),
+			        simde_mm_and_si128(simde_mm_srli_epi32(texel_v, 8), mask_ff),
+			        simde_mm_and_si128(texel_v, mask_ff),
+			        simde_mm_srli_epi32(texel_v, 24)};
+
+			/* colorpath pipeline selects source colors and does blending */
+			const auto iterated_channel = [&](const int32_t iter,
+			                                  const simde__m128i offsets) {
+				return simd_clamped_argb(simde_mm_add_epi32(simde_mm_set1_epi32(iter),
+				                                            offsets),
+				                         rgbzw_clamp);
+			};
+			const simd_rgba iterargb = {iterated_channel(iterr, offsets_r),
+			                            iterated_channel(iterg, offsets_g),
+			                            iterated_channel(iterb, offsets_b),
+			                            iterated_channel(itera, offsets_a)};
+
+			/* compute c_other */
+			simd_rgba c_other = {zero, zero, zero, zero};
+			switch (FBZCP_CC_RGBSELECT(r_fbzColorPath)) {
+			case 0: /* iterated RGB */ c_other = iterargb; break;
+			case 1: /* texture RGB */ c_other = texel; break;
+			case 2: /* color1 RGB */ c_other = const_color1; break;
+			}
+
+			/* compute a_other */
+			switch (FBZCP_CC_ASELECT(r_fbzColorPath)) {
+			case 0: /* iterated alpha */ c_other.a = iterargb.a; break;
+			case 1: /* texture alpha */ c_other.a = texel.a; break;
+			case 2: /* color1 alpha */ c_other.a = const_color1.a; break;
+			case 3: /* reserved */ c_other.a = zero; break;
+			}
+
+			/* handle alpha test */
+			if (ALPHAMODE_ALPHATEST(r_alphaMode)) {
+				const auto alpharef = simde_mm_set1_epi32(
+				        static_cast<int32_t>(ALPHAMODE_ALPHAREF(rp.r_alphaMode)));
+
+				const auto alpha_pass = simde_mm_and_si128(
+				        pass,
+				        simd_compare(ALPHAMODE_ALPHAFUNCTION(r_alphaMode),
+				                     c_other.a,
+				                     alpharef));
+
+				stats.afunc_fail += simd_num_lanes(pass) -
+				                    simd_num_lanes(alpha_pass);
+				pass = alpha_pass;
+
+				if (simd_lane_bits(pass) == 0) {
+					return;
+				}
+			}
+
+			/* compute c_local */
+			auto c_local = FBZCP_CC_LOCALSELECT(r_fbzColorPath) ? const_color0
+			                                                     : iterargb;
+
+			/* compute a_local */
+			switch (FBZCP_CCA_LOCALSELECT(r_fbzColorPath)) {
+			case 0: /* iterated alpha */ c_local.a = iterargb.a; break;
+			case 1: /* color0 alpha */ c_local.a = const_color0.a; break;
+			case 2: /* clamped iterated Z[27:20] */
+				c_local.a = simde_mm_and_si128(simd_clamped_z(iterated_z,
+				                                              rgbzw_clamp),
+				                               mask_ff);
+				break;
+			}
+
+			/* select zero or c_other */
+			auto r = FBZCP_CC_ZERO_OTHER(r_fbzColorPath) ? zero : c_other.r;
+			auto g = FBZCP_CC_ZERO_OTHER(r_fbzColorPath) ? zero : c_other.g;
+			auto b = FBZCP_CC_ZERO_OTHER(r_fbzColorPath) ? zero : c_other.b;
+
+			/* select zero or a_other */
+			auto a = FBZCP_CCA_ZERO_OTHER(r_fbzColorPath) ? zero : c_other.a;
+
+			/* subtract c_local */
+			if (FBZCP_CC_SUB_CLOCAL(r_fbzColorPath)) {
+				r = simde_mm_sub_epi32(r, c_local.r);
+				g = simde_mm_sub_epi32(g, c_local.g);
+				b = simde_mm_sub_epi32(b, c_local.b);
+			}
+
+			/* subtract a_local */
+			if (FBZCP_CCA_SUB_CLOCAL(r_fbzColorPath)) {
+				a = simde_mm_sub_epi32(a, c_local.a);
+			}
+
+			/* blend RGB */
+			simd_rgba blend = {zero, zero, zero, zero};
+			switch (FBZCP_CC_MSELECT(r_fbzColorPath)) {
+			case 1: /* c_local */ blend = c_local; break;
+			case 2: /* a_other */ blend.r = blend.g = blend.b = c_other.a; break;
+			case 3: /* a_local */ blend.r = blend.g = blend.b = c_local.a; break;
+			case 4: /* texture alpha */ blend.r = blend.g = blend.b = texel.a; break;
+			case 5: /* texture RGB (Voodoo 2 only) */ blend = texel; break;
+			}
+
+			/* blend alpha */
+			switch (FBZCP_CCA_MSELECT(r_fbzColorPath)) {
+			default: /* reserved */
+			case 0: /* 0 */ blend.a = zero; break;
+			case 1: /* a_local */
+			case 3: blend.a = c_local.a; break;
+			case 2: /* a_other */ blend.a = c_other.a; break;
+			case 4: /* texture alpha */ blend.a = texel.a; break;
+			}
+
+			/* reverse the RGB blend */
+			if (!FBZCP_CC_REVERSE_BLEND(r_fbzColorPath)) {
+				blend.r = simde_mm_xor_si128(blend.r, mask_ff);
+				blend.g = simde_mm_xor_si128(blend.g, mask_ff);
+				blend.b = simde_mm_xor_si128(blend.b, mask_ff);
+			}
+
+			/* reverse the alpha blend */
+			if (!FBZCP_CCA_REVERSE_BLEND(r_fbzColorPath)) {
+				blend.a = simde_mm_xor_si128(blend.a, mask_ff);
+			}
+
+			/* do the blend */
+			r = simd_scale(r, simde_mm_add_epi32(blend.r, one));
+			g = simd_scale(g, simde_mm_add_epi32(blend.g, one));
+			b = simd_scale(b, simde_mm_add_epi32(blend.b, one));
+			a = simd_scale(a, simde_mm_add_epi32(blend.a, one));
+
+			/* add clocal or alocal to RGB */
+			switch (FBZCP_CC_ADD_ACLOCAL(r_fbzColorPath)) {
+			case 1: /* add c_local */
+				r = simde_mm_add_epi32(r, c_local.r);
+				g = simde_mm_add_epi32(g, c_local.g);
+				b = simde_mm_add_epi32(b, c_local.b);
+				break;
+			case 2: /* add_alocal */
+				r = simde_mm_add_epi32(r, c_local.a);
+				g = simde_mm_add_epi32(g, c_local.a);
+				b = simde_mm_add_epi32(b, c_local.a);
+				break;
+			}
+
+			/* add clocal or alocal to alpha */
+			if (FBZCP_CCA_ADD_ACLOCAL(r_fbzColorPath)) {
+				a = simde_mm_add_epi32(a, c_local.a);
+			}
+
+			/* clamp */
+			simd_clamp_to_uint8(r, g, b, a);
+
+			/* invert */
+			if (FBZCP_CC_INVERT_OUTPUT(r_fbzColorPath)) {
+				r = simde_mm_xor_si128(r, mask_ff);
+				g = simde_mm_xor_si128(g, mask_ff);
+				b = simde_mm_xor_si128(b, mask_ff);
+			}
+			if (FBZCP_CCA_INVERT_OUTPUT(r_fbzColorPath)) {
+				a = simde_mm_xor_si128(a, mask_ff);
+			}
+
+			/* perform alpha blending; the alpha planes are never
+			 * enabled here, so the destination alpha is always 0xff */
+			if (ALPHAMODE_ALPHABLEND(r_alphaMode)) {
+				const auto dpix = simd_load_u16(dest + x);
+
+				auto dr = simde_mm_and_si128(simde_mm_srli_epi32(dpix, 8),
+				                             simde_mm_set1_epi32(0xf8));
+				auto dg = simde_mm_and_si128(simde_mm_srli_epi32(dpix, 3),
+				                             simde_mm_set1_epi32(0xfc));
+				auto db = simde_mm_and_si128(simde_mm_slli_epi32(dpix, 3),
+				                             simde_mm_set1_epi32(0xf8));
+				const auto da = mask_ff;
+
+				const auto sr = r;
+				const auto sg = g;
+				const auto sb = b;
+				const auto sa = a;
+
+				/* apply dither subtraction */
+				if (FBZMODE_ALPHA_DITHER_SUBTRACT(r_fbzMode) && dither) {
+					const auto subtract_dither = [&](const simde__m128i d,
+					                                 const int shift) {
+						const auto dithered = simde_mm_sub_epi32(
+						        simde_mm_add_epi32(simde_mm_slli_epi32(d, shift),
+						                           simde_mm_set1_epi32(15)),
+						        dither_amounts);
+						return simde_mm_srai_epi32(dithered, shift);
+					};
+					dr = subtract_dither(dr, 1);
+					dg = subtract_dither(dg, 2);
+					db = subtract_dither(db, 1);
+				}
+
+				const auto plus_one = [&](const simde__m128i factor) {
+					return simde_mm_add_epi32(factor, one);
+				};
+				const auto one_minus = [&](const simde__m128i factor) {
+					return simde_mm_sub_epi32(simde_mm_set1_epi32(0x100), factor);
+				};
+
+				/* compute source portion */
+				switch (ALPHAMODE_SRCRGBBLEND(r_alphaMode)) {
+				default: /* reserved */
+				case 0: /* AZERO */ r = g = b = zero; break;
+				case 1: /* ASRC_ALPHA */
+					r = simd_scale(sr, plus_one(sa));
+					g = simd_scale(sg, plus_one(sa));
+					b = simd_scale(sb, plus_one(sa));
+					break;
+				case 2: /* A_COLOR */
+					r = simd_scale(sr, plus_one(dr));
+					g = simd_scale(sg, plus_one(dg));
+					b = simd_scale(sb, plus_one(db));
+					break;
+				case 3: /* ADST_ALPHA */
+					r = simd_scale(sr, plus_one(da));
+					g = simd_scale(sg, plus_one(da));
+					b = simd_scale(sb, plus_one(da));
+					break;
+				case 4: /* AONE */ break;
+				case 5: /* AOMSRC_ALPHA */
+					r = simd_scale(sr, one_minus(sa));
+					g = simd_scale(sg, one_minus(sa));
+					b = simd_scale(sb, one_minus(sa));
+					break;
+				case 6: /* AOM_COLOR */
+					r = simd_scale(sr, one_minus(dr));
+					g = simd_scale(sg, one_minus(dg));
+					b = simd_scale(sb, one_minus(db));
+					break;
+				case 7: /* AOMDST_ALPHA */
+					r = simd_scale(sr, one_minus(da));
+					g = simd_scale(sg, one_minus(da));
+					b = simd_scale(sb, one_minus(da));
+					break;
+				case 15: /* ASATURATE */
+				{
+					const auto ta = simd_select(simde_mm_cmplt_epi32(sa, one_minus(da)),
+					                            sa,
+					                            one_minus(da));
+					r = simd_scale(sr, plus_one(ta));
+					g = simd_scale(sg, plus_one(ta));
+					b = simd_scale(sb, plus_one(ta));
+					break;
+				}
+				}
+
+				/* add in dest portion */
+				const auto add_dest = [&](const simde__m128i fr,
+				                          const simde__m128i fg,
+				                          const simde__m128i fb) {
+					r = simde_mm_add_epi32(r, simd_scale(dr, fr));
+					g = simde_mm_add_epi32(g, simd_scale(dg, fg));
+					b = simde_mm_add_epi32(b, simd_scale(db, fb));
+				};
+				switch (ALPHAMODE_DSTRGBBLEND(r_alphaMode)) {
+				default: /* reserved */
+				case 0: /* AZERO */ break;
+				case 1: /* ASRC_ALPHA */
+					add_dest(plus_one(sa), plus_one(sa), plus_one(sa));
+					break;
+				case 2: /* A_COLOR */
+				// Without fogging the colour before fog is the
+				// source colour
+				case 15: /* A_COLORBEFOREFOG */
+					add_dest(plus_one(sr), plus_one(sg), plus_one(sb));
+					break;
+				case 3: /* ADST_ALPHA */
+					add_dest(plus_one(da), plus_one(da), plus_one(da));
+					break;
+				case 4: /* AONE */
+					r = simde_mm_add_epi32(r, dr);
+					g = simde_mm_add_epi32(g, dg);
+					b = simde_mm_add_epi32(b, db);
+					break;
+				case 5: /* AOMSRC_ALPHA */
+					add_dest(one_minus(sa), one_minus(sa), one_minus(sa));
+					break;
+				case 6: /* AOM_COLOR */
+					add_dest(one_minus(sr), one_minus(sg), one_minus(sb));
+					break;
+				case 7: /* AOMDST_ALPHA */
+					add_dest(one_minus(da), one_minus(da), one_minus(da));
+					break;
+				}
+
+				/* blend the source and dest alpha */
+				a = zero;
+				if (ALPHAMODE_SRCALPHABLEND(r_alphaMode) == 4) {
+					a = sa;
+				}
+				if (ALPHAMODE_DSTALPHABLEND(r_alphaMode) == 4) {
+					a = simde_mm_add_epi32(a, da);
+				}
+
+				/* clamp */
+				simd_clamp_to_uint8(r, g, b, a);
+			}
+
+			/* write to framebuffer */
+			if (FBZMODE_RGB_BUFFER_MASK(r_fbzMode)) {
+				simde__m128i pixels = {};
+				if (FBZMODE_ENABLE_DITHERING(r_fbzMode)) {
+					// Computes what the dither lookup tables hold
+					const auto dither_channel = [&](const simde__m128i c,
+					                                const int shift) {
+						const auto dithered = simde_mm_add_epi32(
+						        simde_mm_add_epi32(
+						                simde_mm_sub_epi32(simde_mm_slli_epi32(c, shift),
+						                                   simde_mm_srli_epi32(c, 4)),
+						                simde_mm_srli_epi32(c, 8 - shift)),
+						        dither_amounts);
+						return simde_mm_srli_epi32(dithered, 4);
+					};
+					pixels = simde_mm_or_si128(
+					        simde_mm_or_si128(simde_mm_slli_epi32(dither_channel(r, 1), 11),
+					                          simde_mm_slli_epi32(dither_channel(g, 2), 5)),
+					        dither_channel(b, 1));
+				} else {
+					pixels = simde_mm_or_si128(
+					        simde_mm_or_si128(
+					                simde_mm_slli_epi32(simde_mm_srli_epi32(r, 3), 11),
+					                simde_mm_slli_epi32(simde_mm_srli_epi32(g, 2), 5)),
+					        simde_mm_srli_epi32(b, 3));
+				}
+				simd_store_u16_masked(dest + x, pixels, pass);
+			}
+
+			/* write to aux buffer */
+			if (depth && FBZMODE_AUX_BUFFER_MASK(r_fbzMode)) {
+				simd_store_u16_masked(depth + x, depthval, pass);
+			}
+
+			/* track pixel writes to the frame buffer regardless of mask */
+			stats.pixels_out += simd_num_lanes(pass);
+		};
+
+		for (; x + SimdLanes <= stopx; x += SimdLanes) {
+			render_group();
+
+			/* update the iterated parameters */
+			iterr += SimdLanes * fbi.drdx;
+			iterg += SimdLanes * fbi.dgdx;
+			iterb += SimdLanes * fbi.dbdx;
+			itera += SimdLanes * fbi.dadx;
+			iterz += SimdLanes * fbi.dzdx;
+			iterw += SimdLanes * fbi.dwdx;
+			if (TMUS >= 1) {
+				iterw0 += SimdLanes * tmu0.dwdx;
+				iters0 += SimdLanes * tmu0.dsdx;
+				itert0 += SimdLanes * tmu0.dtdx;
+			}
+			if (TMUS >= 2) {
+				iterw1 += SimdLanes * tmu1.dwdx;
+				iters1 += SimdLanes * tmu1.dsdx;
+				itert1 += SimdLanes * tmu1.dtdx;
+			}
+		}
+	}
+
+	/* loop in X */
+	for (; x < stopx; x++)
+	{
+		rgb_union iterargb = { 0 };
+		rgb_union texel = { 0 };
+
+		/* pixel pipeline part 1 handles depth testing and stippling */
+		PIXEL_PIPELINE_BEGIN(stats, x, y, r_fbzColorPath, r_fbzMode, iterz, iterw, r_zaColor, r_stipple);
+
+		texel = fetch_texel(x, 0);
 
 		/* colorpath pipeline selects source colors and does blending */
 		CLAMPED_ARGB(iterr, iterg, iterb, itera, r_fbzColorPath, iterargb);
@@ -3208,7 +4215,7 @@ static inline void raster_generic(const voodoo_state* vs, uint32_t TMUS, uint32_
 				c_other.u = texel.u;
 				break;
 			case 2:		/* color1 RGB */
-			        c_other.u = regs[color1].u;
+			        c_other.u = rp.r_color1.u;
 			        break;
 			case 3:	/* reserved */
 				c_other.u = 0;
@@ -3216,7 +4223,7 @@ static inline void raster_generic(const voodoo_state* vs, uint32_t TMUS, uint32_
 		}
 
 		/* handle chroma key */
-		APPLY_CHROMAKEY(vs, stats, r_fbzMode, c_other);
+		APPLY_CHROMAKEY(stats, r_fbzMode, rp.r_chromaKey, rp.r_chromaRange, c_other);
 
 		/* compute a_other */
 		switch (FBZCP_CC_ASELECT(r_fbzColorPath))
@@ -3228,7 +4235,7 @@ static inline void raster_generic(const voodoo_state* vs, uint32_t TMUS, uint32_
 				c_other.rgb.a = texel.rgb.a;
 				break;
 			case 2:		/* color1 alpha */
-			        c_other.rgb.a = regs[color1].rgb.a;
+			        c_other.rgb.a = rp.r_color1.rgb.a;
 			        break;
 			case 3:	/* reserved */
 				c_other.rgb.a = 0;
@@ -3236,10 +4243,13 @@ static inline void raster_generic(const voodoo_state* vs, uint32_t TMUS, uint32_
 		}
 
 		/* handle alpha mask */
-		APPLY_ALPHAMASK(vs, stats, r_fbzMode, c_other.rgb.a);
+		APPLY_ALPHAMASK(stats, r_fbzMode, c_other.rgb.a);
 
 		/* handle alpha test */
-		APPLY_ALPHATEST(vs, stats, r_alphaMode, c_other.rgb.a);
+		APPLY_ALPHATEST(stats,
+		                r_alphaMode,
+		                ALPHAMODE_ALPHAREF(rp.r_alphaMode),
+		                c_other.rgb.a);
 
 		/* compute c_local */
 		if (FBZCP_CC_LOCALSELECT_OVERRIDE(r_fbzColorPath) == 0)
@@ -3249,7 +4259,7 @@ static inline void raster_generic(const voodoo_state* vs, uint32_t TMUS, uint32_
 				c_local.u = iterargb.u;
 			} else {
 				// color0 RGB
-				c_local.u = regs[color0].u;
+				c_local.u = rp.r_color0.u;
 			}
 		}
 		else
@@ -3259,7 +4269,7 @@ static inline void raster_generic(const voodoo_state* vs, uint32_t TMUS, uint32_
 				c_local.u = iterargb.u;
 			} else {
 				// color0 RGB
-				c_local.u = regs[color0].u;
+				c_local.u = rp.r_color0.u;
 			}
 		}
 
@@ -3270,7 +4280,7 @@ static inline void raster_generic(const voodoo_state* vs, uint32_t TMUS, uint32_
 				c_local.rgb.a = iterargb.rgb.a;
 				break;
 			case 1:		/* color0 alpha */
-			        c_local.rgb.a = regs[color0].rgb.a;
+			        c_local.rgb.a = rp.r_color0.rgb.a;
 			        break;
 			case 2:		/* clamped iterated Z[27:20] */
 			{
@@ -3425,10 +4435,10 @@ static inline void raster_generic(const voodoo_state* vs, uint32_t TMUS, uint32_
 		}
 
 		/* pixel pipeline part 2 handles fog, alpha, and final output */
-		PIXEL_PIPELINE_MODIFY(vs, dither, dither4, x,
+		PIXEL_PIPELINE_MODIFY(fbi, rp.r_fogColor, dither, dither4, x,
 							r_fbzMode, r_fbzColorPath, r_alphaMode, r_fogMode,
 							iterz, iterw, iterargb);
-		PIXEL_PIPELINE_FINISH(vs, dither_lookup, x, dest, depth, r_fbzMode);
+		PIXEL_PIPELINE_FINISH(dither_lookup, x, dest, depth, r_fbzMode);
 		PIXEL_PIPELINE_END(stats);
 
 		/* update the iterated parameters */
@@ -3453,6 +4463,214 @@ static inline void raster_generic(const voodoo_state* vs, uint32_t TMUS, uint32_
 	}
 }
 
+static void raster_generic(const raster_params& rp, const int32_t y,
+                           const poly_extent* extent, stats_block& stats)
+{
+	raster_span<false, false>(rp, y, extent, stats);
+}
+
+static void raster_generic_simd(const raster_params& rp, const int32_t y,
+                                const poly_extent* extent, stats_block& stats)
+{
+	raster_span<false, true>(rp, y, extent, stats);
+}
+
+/***************************************************************************
+    SPECIALISED RASTERIZERS
+***************************************************************************/
+
+struct specialised_rasterizer {
+	uint32_t eff_color_path = 0;
+	uint32_t eff_alpha_mode = 0;
+	uint32_t eff_fog_mode   = 0;
+	uint32_t eff_fbz_mode   = 0;
+	uint32_t eff_tex_mode_0 = 0;
+	uint32_t eff_tex_mode_1 = 0;
+
+	raster_span_func callback = nullptr;
+
+	// Same as the callback if the state can't use the SIMD pixel pipeline
+	raster_span_func simd_callback = nullptr;
+};
+
+#define RASTERIZER_ENTRY(fbzcp, alphamode, fogmode, fbzmode, texmode0, texmode1) \
+	specialised_rasterizer{fbzcp, alphamode, fogmode, fbzmode, texmode0, texmode1, \
+	        raster_span<true, false, fbzcp, alphamode, fogmode, fbzmode, texmode0, texmode1>, \
+	        raster_span<true, is_simd_raster_state(fbzcp, fogmode, fbzmode), \
+	                    fbzcp, alphamode, fogmode, fbzmode, texmode0, texmode1>}
+
+// Pipeline states with a rasterizer compiled for them, in the spirit of
+// MAME's precompiled rasterizer table. These are the common Glide 2 states:
+// textured triangles modulated by the iterated colour, decals, and Gouraud
+// shading, with Z or W buffering and the usual alpha blending modes. The
+// values must be normalised; states that end up on the generic rasterizer
+// are logged at shutdown and are candidates for new entries.
+//
+static constexpr specialised_rasterizer specialised_rasterizers[] = {
+	//               fbzColorPath alphaMode   fogMode     fbzMode     textureMode0 textureMode1
+	/* textured, modulated by the iterated colour */
+	RASTERIZER_ENTRY(0x00c22401, 0x00000000, 0x00000000, 0x00000731, 0x0c261a0f, TexModeUnused),
+	RASTERIZER_ENTRY(0x00c22401, 0x00000000, 0x00000000, 0x00000731, 0x0c261a09, TexModeUnused),
+	RASTERIZER_ENTRY(0x00c22401, 0x00000000, 0x00000000, 0x00000731, 0x0c26100f, TexModeUnused),
+	RASTERIZER_ENTRY(0x00c22401, 0x00000000, 0x00000000, 0x00000731, 0x0c261009, TexModeUnused),
+	RASTERIZER_ENTRY(0x00c22401, 0x00000000, 0x00000000, 0x00000739, 0x0c261a0f, TexModeUnused),
+	RASTERIZER_ENTRY(0x00c22401, 0x00000000, 0x00000000, 0x00000739, 0x0c261a09, TexModeUnused),
+	RASTERIZER_ENTRY(0x00c22401, 0x00000000, 0x00000000, 0x00000739, 0x0c26100f, TexModeUnused),
+	RASTERIZER_ENTRY(0x00c22401, 0x00000000, 0x00000000, 0x00000739, 0x0c261009, TexModeUnused),
+	RASTERIZER_ENTRY(0x00c22401, 0x00000000, 0x00000000, 0x00000301, 0x0c261a0f, TexModeUnused),
+	RASTERIZER_ENTRY(0x00c22401, 0x00000000, 0x00000000, 0x00000301, 0x0c261a09, TexModeUnused),
+	RASTERIZER_ENTRY(0x00c22401, 0x00000000, 0x00000001, 0x00000731, 0x0c261a0f, TexModeUnused),
+	RASTERIZER_ENTRY(0x00c22401, 0x00000000, 0x00000001, 0x00000739, 0x0c261a0f, TexModeUnused),
+	/* textured and alpha blended, without depth writes */
+	RASTERIZER_ENTRY(0x00482405, 0x00045110, 0x00000000, 0x00000331, 0x0c261a0f, TexModeUnused),
+	RASTERIZER_ENTRY(0x00482405, 0x00045110, 0x00000000, 0x00000339, 0x0c261a0f, TexModeUnused),
+	RASTERIZER_ENTRY(0x00482405, 0x00045110, 0x00000000, 0x00000301, 0x0c261a0f, TexModeUnused),
+	/* decals: texture colour, with alpha testing or blending */
+	RASTERIZER_ENTRY(0x00000005, 0x00000000, 0x00000000, 0x00000731, 0x0c261a0f, TexModeUnused),
+	RASTERIZER_ENTRY(0x00000005, 0x00000009, 0x00000000, 0x00000731, 0x0c261a0f, TexModeUnused),
+	RASTERIZER_ENTRY(0x00000005, 0x00000009, 0x00000000, 0x00000739, 0x0c261a0f, TexModeUnused),
+	RASTERIZER_ENTRY(0x00000005, 0x00045110, 0x00000000, 0x00000301, 0x0c261a0f, TexModeUnused),
+	/* untextured, Gouraud and flat shaded */
+	RASTERIZER_ENTRY(0x00c26100, 0x00000000, 0x00000000, 0x00000731, TexModeUnused, TexModeUnused),
+	RASTERIZER_ENTRY(0x00c26100, 0x00000000, 0x00000000, 0x00000739, TexModeUnused, TexModeUnused),
+	RASTERIZER_ENTRY(0x00c26100, 0x00000000, 0x00000000, 0x00000301, TexModeUnused, TexModeUnused),
+	RASTERIZER_ENTRY(0x00c26100, 0x00045110, 0x00000000, 0x00000301, TexModeUnused, TexModeUnused),
+	RASTERIZER_ENTRY(0x00c26130, 0x00000000, 0x00000000, 0x00000301, TexModeUnused, TexModeUnused),
+};
+
+#undef RASTERIZER_ENTRY
+
+constexpr bool is_normalised(const specialised_rasterizer& r)
+{
+	const auto is_normalised_tex_mode = [](const uint32_t tex_mode) {
+		return tex_mode == TexModeUnused ||
+		       tex_mode == normalize_tex_mode(tex_mode);
+	};
+	return r.eff_color_path == normalize_color_path(r.eff_color_path) &&
+	       r.eff_alpha_mode == normalize_alpha_mode(r.eff_alpha_mode) &&
+	       r.eff_fog_mode == normalize_fog_mode(r.eff_fog_mode) &&
+	       r.eff_fbz_mode == normalize_fbz_mode(r.eff_fbz_mode) &&
+	       is_normalised_tex_mode(r.eff_tex_mode_0) &&
+	       is_normalised_tex_mode(r.eff_tex_mode_1);
+}
+static_assert(std::all_of(std::begin(specialised_rasterizers),
+                          std::end(specialised_rasterizers),
+                          is_normalised),
+              "Specialised rasterizer states must be normalised");
+
+using specialised_rasterizer_hash_t =
+        std::array<std::vector<const specialised_rasterizer*>, RASTER_HASH_SIZE>;
+
+static const specialised_rasterizer_hash_t& get_specialised_rasterizer_hash()
+{
+	static const auto hash_table = [] {
+		specialised_rasterizer_hash_t table = {};
+		for (const auto& r : specialised_rasterizers) {
+			const auto hash = compute_raster_hash(r.eff_color_path,
+			                                      r.eff_alpha_mode,
+			                                      r.eff_fog_mode,
+			                                      r.eff_fbz_mode,
+			                                      r.eff_tex_mode_0,
+			                                      r.eff_tex_mode_1);
+			table[hash].push_back(&r);
+		}
+		return table;
+	}();
+	return hash_table;
+}
+
+// Returns the span rasterizer for the pipeline state of a triangle: a
+// specialised one if there's one for the state, otherwise the generic one.
+// Either way, the SIMD pixel pipeline is used if the state allows it.
+static raster_span_func select_rasterizer(voodoo_state* vs, const raster_params& rp)
+{
+	const raster_state_key key = {
+	        normalize_color_path(rp.r_fbzColorPath),
+	        normalize_alpha_mode(rp.r_alphaMode),
+	        normalize_fog_mode(rp.r_fogMode),
+	        normalize_fbz_mode(rp.r_fbzMode),
+	        (rp.tmus >= 1) ? normalize_tex_mode(rp.texmode0) : TexModeUnused,
+	        (rp.tmus >= 2) ? normalize_tex_mode(rp.texmode1) : TexModeUnused,
+	};
+
+	auto& stats = vs->raster_stats;
+
+	const auto use_simd = voodoo_simd_rasterizers &&
+	                      is_simd_raster_state(key[0], key[2], key[3]);
+
+	const auto hash = compute_raster_hash(
+	        key[0], key[1], key[2], key[3], key[4], key[5]);
+
+	if (voodoo_specialised_rasterizers) {
+		for (const auto r : get_specialised_rasterizer_hash()[hash]) {
+			if (r->eff_color_path == key[0] && r->eff_alpha_mode == key[1] &&
+			    r->eff_fog_mode == key[2] && r->eff_fbz_mode == key[3] &&
+			    r->eff_tex_mode_0 == key[4] && r->eff_tex_mode_1 == key[5]) {
+				++stats.num_specialised;
+				return use_simd ? r->simd_callback : r->callback;
+			}
+		}
+	}
+
+	++stats.num_generic;
+
+	for (size_t i = 0; i < MaxGenericStateProbes; ++i) {
+		auto& entry = stats.generic_states[(hash + i) % NumCountedGenericStates];
+		if (entry.count == 0) {
+			entry.key = key;
+		}
+		if (entry.key == key) {
+			++entry.count;
+			break;
+		}
+	}
+	return use_simd ? raster_generic_simd : raster_generic;
+}
+
+// Logs how many triangles were drawn with the generic rasterizer, and the
+// most common pipeline states that had no specialised rasterizer
+static void log_rasterizer_stats(const rasterizer_stats& stats)
+{
+	const auto num_triangles = stats.num_specialised + stats.num_generic;
+	if (stats.num_generic == 0) {
+		return;
+	}
+
+	LOG_MSG("VOODOO: %" PRId64 " of %" PRId64
+	        " triangles were drawn with the generic rasterizer",
+	        stats.num_generic,
+	        num_triangles);
+
+	std::vector<generic_state_count> states = {};
+	for (const auto& entry : stats.generic_states) {
+		if (entry.count > 0) {
+			states.push_back(entry);
+		}
+	}
+
+	std::sort(states.begin(), states.end(), [](const auto& a, const auto& b) {
+		return a.count > b.count;
+	});
+
+	constexpr size_t MaxLoggedStates = 10;
+	if (states.size() > MaxLoggedStates) {
+		states.resize(MaxLoggedStates);
+	}
+
+	LOG_MSG("VOODOO: fbzColorPath alphaMode fogMode  fbzMode  texMode0 texMode1 triangles");
+
+	for (const auto& [key, count] : states) {
+		LOG_MSG("VOODOO: %08x     %08x  %08x %08x %08x %08x %" PRId64,
+		        key[0],
+		        key[1],
+		        key[2],
+		        key[3],
+		        key[4],
+		        key[5],
+		        count);
+	}
+}
+
 #ifdef C_ENABLE_VOODOO_OPENGL
 /*-------------------------------------------------
     add_rasterizer - add a rasterizer to our
@@ -3568,7 +4786,7 @@ static raster_info *find_rasterizer(voodoo_state *vs, int texcount)
     raster_fastfill - per-scanline
     implementation of the 'fastfill' command
 -------------------------------------------------*/
-static void raster_fastfill(void *destbase, int32_t y, const poly_extent *extent, const uint16_t* extra_dither)
+static void raster_fastfill(const raster_params& rp, int32_t y, const poly_extent *extent, const uint16_t* extra_dither)
 {
 	stats_block stats = {};
 	const int32_t startx = extent->startx;
@@ -3578,20 +4796,19 @@ static void raster_fastfill(void *destbase, int32_t y, const poly_extent *extent
 
 	/* determine the screen Y */
 	scry = y;
-	if (FBZMODE_Y_ORIGIN(v->reg[fbzMode].u)) {
-		scry = (v->fbi.yorigin - y) & 0x3ff;
+	if (FBZMODE_Y_ORIGIN(rp.r_fbzMode)) {
+		scry = (rp.fbi.yorigin - y) & 0x3ff;
 	}
 
 	/* fill this RGB row */
-	if (FBZMODE_RGB_BUFFER_MASK(v->reg[fbzMode].u))
+	if (FBZMODE_RGB_BUFFER_MASK(rp.r_fbzMode))
 	{
 		const uint16_t* ditherow = &extra_dither[(y & 3) * 4];
 
 		const auto expanded = read_unaligned_uint64(
 		        reinterpret_cast<const uint8_t*>(ditherow));
 
-		uint16_t* dest = reinterpret_cast<uint16_t*>(destbase) +
-		                 scry * v->fbi.rowpixels;
+		uint16_t* dest = rp.drawbuf + scry * rp.fbi.rowpixels;
 
 		for (x = startx; x < stopx && (x & 3) != 0; x++) {
 			dest[x] = ditherow[x & 3];
@@ -3606,21 +4823,21 @@ static void raster_fastfill(void *destbase, int32_t y, const poly_extent *extent
 	}
 
 	/* fill this dest buffer row */
-	if (FBZMODE_AUX_BUFFER_MASK(v->reg[fbzMode].u) && v->fbi.auxoffs != (uint32_t)(~0))
+	if (FBZMODE_AUX_BUFFER_MASK(rp.r_fbzMode) && rp.fbi.auxoffs != (uint32_t)(~0))
 	{
-		const auto color = static_cast<uint16_t>(v->reg[zaColor].u & 0xffff);
+		const auto color = static_cast<uint16_t>(rp.r_zaColor & 0xffff);
 
 		const uint64_t expanded = (static_cast<uint64_t>(color) << 48) |
 		                          (static_cast<uint64_t>(color) << 32) |
 		                          (static_cast<uint32_t>(color) << 16) |
 		                          color;
 
-		uint16_t* dest = reinterpret_cast<uint16_t*>(v->fbi.ram +
-		                                             v->fbi.auxoffs) +
-		                 scry * v->fbi.rowpixels;
+		uint16_t* dest = reinterpret_cast<uint16_t*>(rp.fbi.ram +
+		                                             rp.fbi.auxoffs) +
+		                 scry * rp.fbi.rowpixels;
 
-		if (v->fbi.auxoffs + 2 * (scry * v->fbi.rowpixels + stopx) >= v->fbi.mask) {
-			stopx = (v->fbi.mask - v->fbi.auxoffs) / 2 - scry * v->fbi.rowpixels;
+		if (rp.fbi.auxoffs + 2 * (scry * rp.fbi.rowpixels + stopx) >= rp.fbi.mask) {
+			stopx = (rp.fbi.mask - rp.fbi.auxoffs) / 2 - scry * rp.fbi.rowpixels;
 			if ((stopx < 0) || (stopx < startx)) {
 				return;
 			}
@@ -3758,6 +4975,9 @@ static void init_tmu(voodoo_state *vs, tmu_state *t, voodoo_reg *reg, int tmem)
 
 	t->mask = (uint32_t)(tmem - 1);
 	t->reg = reg;
+
+	// Start every page at a version the decoded texture cache doesn't have
+	t->page_versions.assign(tmem >> TexCachePageShift, 1);
 	t->regdirty = true;
 	t->bilinear_mask = (vtype >= VOODOO_2) ? 0xff : 0xf0;
 
@@ -3815,6 +5035,11 @@ static void voodoo_swap_buffers(voodoo_state *vs)
 	}
 #endif
 
+	/* finish drawing the frame before swapping */
+	raster_worker_flush(vs->rworker);
+
+	++vs->num_swaps;
+
 	/* keep a history of swap intervals */
 	const auto regs = vs->reg;
 
@@ -3843,6 +5068,9 @@ static void voodoo_swap_buffers(voodoo_state *vs)
 
 static void recompute_video_memory(voodoo_state *vs)
 {
+	/* don't move the buffers under the workers' feet */
+	raster_worker_flush(vs->rworker);
+
 	const auto regs = vs->reg;
 
 	const uint32_t buffer_pages = FBIINIT2_VIDEO_BUFFER_OFFSET(regs[fbiInit2].u);
@@ -3964,9 +5192,13 @@ static void ncc_table_write(ncc_table *n, uint32_t regnum, uint32_t data)
 
 		const rgb_t palette_entry = 0xff000000 | data;
 
+		/* queued triangles may still be reading the palette */
+		raster_worker_flush(v->rworker);
+
 		if (n->palette[index] != palette_entry) {
 			/* set the ARGB for this palette index */
 			n->palette[index] = palette_entry;
+			++v->texture_lookup_generation;
 #ifdef C_ENABLE_VOODOO_OPENGL
 			v->ogl_palette_changed = true;
 #endif
@@ -3987,7 +5219,11 @@ static void ncc_table_write(ncc_table *n, uint32_t regnum, uint32_t data)
 			const uint32_t b = ((data << 2) & 0xfc) |
 			                   ((data >> 4) & 0x03);
 
-			n->palettea[index] = MAKE_ARGB(a, r, g, b);
+			const auto palettea_entry = MAKE_ARGB(a, r, g, b);
+			if (n->palettea[index] != palettea_entry) {
+				n->palettea[index] = palettea_entry;
+				++v->texture_lookup_generation;
+			}
 		}
 
 		/* this doesn't dirty the table or go to the registers, so bail */
@@ -4039,6 +5275,9 @@ static void ncc_table_update(ncc_table *n)
 	int b;
 	int i;
 
+	/* queued triangles may still be reading the table */
+	raster_worker_flush(v->rworker);
+
 	/* generte all 256 possibilities */
 	for (i = 0; i < 256; i++)
 	{
@@ -4062,6 +5301,9 @@ static void ncc_table_update(ncc_table *n)
 		n->texel[i] = MAKE_ARGB(0xff, r, g, b);
 	}
 
+	/* textures decoded with the old table are stale */
+	++v->texture_lookup_generation;
+
 	/* no longer dirty */
 	n->dirty = false;
 }
@@ -4191,6 +5433,16 @@ static void recompute_texture_params(tmu_state *t)
 		t->lodoffset[lod] = base & t->mask;
 	}
 
+	/* find the extent of the texture RAM read by all LODs */
+	t->texture_bytes = 0;
+	for (lod = 0; lod <= 8; lod++)
+	{
+		const uint32_t size = ((t->wmask >> lod) + 1) * ((t->hmask >> lod) + 1);
+		const uint32_t end = ((t->lodoffset[lod] - t->lodoffset[0]) & t->mask) +
+		                     (size << bppscale);
+		t->texture_bytes = std::max(t->texture_bytes, end);
+	}
+
 	/* set the NCC lookup appropriately */
 	t->texel[1] = t->texel[9] = t->ncc[TEXMODE_NCC_TABLE_SELECT(t->reg[textureMode].u)].texel;
 
@@ -4252,6 +5504,166 @@ static void prepare_tmu(tmu_state *t)
 	t->lodbasetemp = (-lodbase + (12 << 8)) / 2;
 }
 
+/*************************************
+ *
+ *  Texture cache
+ *
+ *************************************/
+
+// Formats whose lookup tables can be changed by the guest
+constexpr bool has_mutable_lookup(const uint32_t format)
+{
+	switch (format) {
+	case 1:  // YIQ 4-2-2 (NCC)
+	case 5:  // 8-bit palette
+	case 6:  // 8-bit palette with alpha
+	case 9:  // AYIQ 8-4-2-2 (NCC)
+	case 14: // alpha + 8-bit palette
+		return true;
+	default: return false;
+	}
+}
+
+static void decode_texture_page(const tmu_state& t, const uint32_t format,
+                                decoded_texture_ram& layout, const uint32_t page)
+{
+	const auto lookup = t.lookup;
+	const auto start  = page << TexCachePageShift;
+	const auto end    = start + TexCachePageSize;
+
+	if (format < 8) {
+		for (auto addr = start; addr < end; ++addr) {
+			layout.texels[addr] = lookup[t.ram[addr]];
+		}
+	} else if (format >= 10 && format <= 12) {
+		for (auto addr = start; addr < end; addr += 2) {
+			const auto texel = *(uint16_t*)&t.ram[addr];
+			layout.texels[addr >> 1] = lookup[texel];
+		}
+	} else {
+		for (auto addr = start; addr < end; addr += 2) {
+			const auto texel = *(uint16_t*)&t.ram[addr];
+			layout.texels[addr >> 1] = (lookup[texel & 0xff] & 0xffffff) |
+			                           ((texel & 0xff00) << 16);
+		}
+	}
+}
+
+// Frees the least recently used decoded layout of the TMU if it already has
+// as many as it may keep allocated
+static void evict_decoded_layout_if_full(voodoo_state* vs, tmu_state* t)
+{
+	auto num_allocated = 0;
+	decoded_texture_ram* oldest = nullptr;
+
+	for (auto& layout : t->decoded_layouts) {
+		if (!layout.texels) {
+			continue;
+		}
+		++num_allocated;
+		if (!oldest || layout.last_used < oldest->last_used) {
+			oldest = &layout;
+		}
+	}
+
+	if (num_allocated < MaxAllocatedDecodedLayouts) {
+		return;
+	}
+	assert(oldest);
+
+	// Queued primitives may still read the layout's texels
+	raster_worker_flush(vs->rworker);
+
+	*oldest = {};
+	++vs->tex_cache_stats.layouts_evicted;
+}
+
+// Makes sure the current texture of the TMU is decoded, and points the
+// texture pipeline at it
+static void prepare_decoded_texture(voodoo_state* vs, tmu_state* t)
+{
+	const auto texture_mode = t->reg[textureMode].u;
+	const auto format       = TEXMODE_FORMAT(texture_mode);
+
+	if (!voodoo_texture_cache || !t->lookup) {
+		t->decoded = nullptr;
+		return;
+	}
+
+	const auto is_ncc_table_1 = ((format & 7) == 1 &&
+	                             TEXMODE_NCC_TABLE_SELECT(texture_mode));
+
+	auto& layout = t->decoded_layouts[is_ncc_table_1 ? 16 + (format >> 3) : format];
+
+	const auto ram_bytes = t->mask + 1;
+	const auto num_pages = ram_bytes >> TexCachePageShift;
+
+	if (!layout.texels) {
+		evict_decoded_layout_if_full(vs, t);
+
+		// Left uninitialised so only the pages in use take up memory
+		const auto num_texels = (format < 8) ? ram_bytes : ram_bytes / 2;
+		layout.texels = std::unique_ptr<rgb_t[]>(new rgb_t[num_texels]);
+		layout.page_versions.assign(num_pages, 0);
+	}
+
+	if (has_mutable_lookup(format) &&
+	    layout.lookup_generation != vs->texture_lookup_generation) {
+		std::fill(layout.page_versions.begin(), layout.page_versions.end(), 0);
+		layout.lookup_generation = vs->texture_lookup_generation;
+	}
+	layout.last_used = ++t->decoded_layout_uses;
+
+	// Decode the pages of the texture that are missing or stale; the
+	// texture may wrap around the end of the texture RAM
+	const auto base       = t->lodoffset[0];
+	const auto first_page = base >> TexCachePageShift;
+	const auto last_page  = (base + t->texture_bytes - 1) >> TexCachePageShift;
+
+	auto is_hit = true;
+	for (auto i = first_page; i <= last_page; ++i) {
+		const auto page = i & (num_pages - 1);
+		if (layout.page_versions[page] != t->page_versions[page]) {
+			decode_texture_page(*t, format, layout, page);
+			layout.page_versions[page] = t->page_versions[page];
+
+			++vs->tex_cache_stats.pages_decoded;
+			is_hit = false;
+		}
+	}
+
+	if (is_hit) {
+		++vs->setup_stats.tex_cache_hits;
+	} else {
+		++vs->setup_stats.tex_cache_misses;
+	}
+
+	t->decoded = layout.texels.get();
+}
+
+// Marks the page of texture RAM containing the address as changed
+static void invalidate_decoded_texture_page(tmu_state* t, const uint32_t addr)
+{
+	++t->page_versions[(addr & t->mask) >> TexCachePageShift];
+}
+
+static void log_texture_cache_stats(const voodoo_state* vs)
+{
+	const auto hits   = vs->tex_cache_stats.hits + vs->setup_stats.tex_cache_hits;
+	const auto misses = vs->tex_cache_stats.misses +
+	                    vs->setup_stats.tex_cache_misses;
+	if (hits + misses == 0) {
+		return;
+	}
+
+	LOG_MSG("VOODOO: Texture cache hit rate was %.1f%%, %" PRId64
+	        " pages of texture RAM were decoded, %" PRId64
+	        " decoded formats were evicted",
+	        100.0 * static_cast<double>(hits) / static_cast<double>(hits + misses),
+	        vs->tex_cache_stats.pages_decoded,
+	        vs->tex_cache_stats.layouts_evicted);
+}
+
 static inline int32_t round_coordinate(float value)
 {
 	// This is not proper rounding algorithm akin to std::lround (it works
@@ -4279,6 +5691,8 @@ static void sum_statistics(stats_block *target, const stats_block *source)
 	target->chroma_fail += source->chroma_fail;
 	target->zfunc_fail += source->zfunc_fail;
 	target->afunc_fail += source->afunc_fail;
+	target->tex_cache_hits += source->tex_cache_hits;
+	target->tex_cache_misses += source->tex_cache_misses;
 }
 
 static void accumulate_statistics(voodoo_state *vs, const stats_block *stats)
@@ -4295,6 +5709,9 @@ static void accumulate_statistics(voodoo_state *vs, const stats_block *stats)
 
 static void update_statistics(voodoo_state *vs, bool accumulate)
 {
+	/* the workers must be done with everything queued so far */
+	raster_worker_flush(vs->rworker);
+
 	/* accumulate/reset statistics from all units */
 	for (auto& thread_stat : vs->thread_stats) {
 		if (accumulate) {
@@ -4310,39 +5727,91 @@ static void update_statistics(voodoo_state *vs, bool accumulate)
 		accumulate_statistics(vs, &fbi.lfb_stats);
 	}
 	fbi.lfb_stats = {};
+
+	/* keep the texture cache totals */
+	vs->tex_cache_stats.hits += vs->setup_stats.tex_cache_hits;
+	vs->tex_cache_stats.misses += vs->setup_stats.tex_cache_misses;
+	vs->setup_stats = {};
 }
 
 /***************************************************************************
     COMMAND HANDLERS
 ***************************************************************************/
 
-static void triangle_worker_work(const triangle_worker& tworker,
-                                 const int32_t work_start, const int32_t work_end)
+// Maps a scanline to the frame buffer row it's drawn to
+static inline int32_t screen_row(const raster_params& rp, const int32_t y)
 {
-	/* determine the number of TMUs involved */
-	uint32_t tmus     = 0;
-	uint32_t texmode0 = 0;
-	uint32_t texmode1 = 0;
-	if (!FBIINIT3_DISABLE_TMUS(v->reg[fbiInit3].u) && FBZCP_TEXTURE_ENABLE(v->reg[fbzColorPath].u))
-	{
-		tmus = 1;
-		texmode0 = v->tmu[0].reg[textureMode].u;
-		if ((v->chipmask & 0x04) != 0)
-		{
-			tmus = 2;
-			texmode1 = v->tmu[1].reg[textureMode].u;
-		}
-		if (tworker.disable_bilinear_filter) //force disable bilinear filter
-		{
-			texmode0 &= ~6;
-			texmode1 &= ~6;
+	if (FBZMODE_Y_ORIGIN(rp.r_fbzMode)) {
+		return (static_cast<int32_t>(rp.fbi.yorigin) - y) & 0x3ff;
+	}
+	return y;
+}
+
+static void set_command_rows(raster_command& cmd)
+{
+	cmd.rows_wrap = false;
+
+	if (!FBZMODE_Y_ORIGIN(cmd.params.r_fbzMode)) {
+		cmd.min_row = cmd.v1y;
+		cmd.max_row = cmd.v3y;
+		return;
+	}
+
+	const auto yorigin = static_cast<int32_t>(cmd.params.fbi.yorigin);
+
+	const auto top    = yorigin - (cmd.v3y - 1);
+	const auto bottom = yorigin - cmd.v1y;
+
+	if (top >= 0 && bottom <= 0x3ff) {
+		cmd.min_row = top;
+		cmd.max_row = bottom + 1;
+	} else {
+		cmd.min_row   = 0;
+		cmd.max_row   = 0x400;
+		cmd.rows_wrap = true;
+	}
+}
+
+// Renders the scanlines of a command that land on the screen rows
+// [first_row, last_row)
+static void raster_command_rows(const raster_command& cmd, const int32_t first_row,
+                                const int32_t last_row, stats_block& stats)
+{
+	const auto& rp = cmd.params;
+
+	// Narrow down the scanlines to the ones that can hit the rows
+	int32_t y_begin = cmd.v1y;
+	int32_t y_end   = cmd.v3y;
+
+	if (!FBZMODE_Y_ORIGIN(rp.r_fbzMode)) {
+		y_begin = std::max(y_begin, first_row);
+		y_end   = std::min(y_end, last_row);
+	} else if (!cmd.rows_wrap) {
+		const auto yorigin = static_cast<int32_t>(rp.fbi.yorigin);
+
+		y_begin = std::max(y_begin, yorigin - last_row + 1);
+		y_end   = std::min(y_end, yorigin - first_row + 1);
+	}
+
+	if (cmd.type == RasterCommand::Fastfill) {
+		for (auto y = y_begin; y < y_end; ++y) {
+			const auto scry = screen_row(rp, y);
+			if (scry < first_row || scry >= last_row) {
+				continue;
+			}
+			poly_extent extent = {};
+			extent.startx      = cmd.startx;
+			extent.stopx       = cmd.stopx;
+
+			raster_fastfill(rp, y, &extent, cmd.dither);
 		}
+		return;
 	}
 
 	/* compute the slopes for each portion of the triangle */
-	const poly_vertex v1 = tworker.v1;
-	const poly_vertex v2 = tworker.v2;
-	const poly_vertex v3 = tworker.v3;
+	const poly_vertex v1 = cmd.v1;
+	const poly_vertex v2 = cmd.v2;
+	const poly_vertex v3 = cmd.v3;
 
 	const float dxdy_v1v2 = (v2.y == v1.y) ? 0.0f
 	                                       : (v2.x - v1.x) / (v2.y - v1.y);
@@ -4351,22 +5820,11 @@ static void triangle_worker_work(const triangle_worker& tworker,
 	const float dxdy_v2v3 = (v3.y == v2.y) ? 0.0f
 	                                       : (v3.x - v2.x) / (v3.y - v2.y);
 
-	stats_block my_stats = {};
-
-	// The number of workers represents the total work, while the start and
-	// end represent a fraction (up to 100%) of the total total.
-	assert(work_end > 0 && tworker.num_work_units >= work_end);
-
-	// The following suppresses div-by-0 false positive reported in Clang
-	// analysis. This is confirmed fixed in Clang v18.
-	const auto num_work_units = tworker.num_work_units ? tworker.num_work_units : 1;
-
-	const int32_t from = tworker.totalpix * work_start / num_work_units;
-	const int32_t to   = tworker.totalpix * work_end / num_work_units;
-
-	for (int32_t curscan = tworker.v1y, scanend = tworker.v3y, sumpix = 0, lastsum = 0;
-	     curscan != scanend && lastsum < to;
-	     lastsum = sumpix, curscan++) {
+	for (auto curscan = y_begin; curscan < y_end; ++curscan) {
+		const auto scry = screen_row(rp, curscan);
+		if (scry < first_row || scry >= last_row) {
+			continue;
+		}
 
 		const float fully = (float)(curscan) + 0.5f;
 
@@ -4391,21 +5849,8 @@ static void triangle_worker_work(const triangle_worker& tworker,
 			std::swap(extent.startx, extent.stopx);
 		}
 
-		sumpix += (extent.stopx - extent.startx);
-
-		if (sumpix <= from) {
-			continue;
-		}
-		if (lastsum < from) {
-			extent.startx += (from - lastsum);
-		}
-		if (sumpix > to) {
-			extent.stopx -= (sumpix - to);
-		}
-
-		raster_generic(v, tmus, texmode0, texmode1, tworker.drawbuf, curscan, &extent, my_stats);
+		cmd.span(rp, curscan, &extent, stats);
 	}
-	sum_statistics(&v->thread_stats[work_start], &my_stats);
 }
 
 // NOTE (weirddan455): In case anyone wants to optimize this further on ARM:
@@ -4433,134 +5878,259 @@ static void triangle_worker_work(const triangle_worker& tworker,
 // Loads should be either acquire or relaxed.
 // Stores should be either release or relaxed.
 // Fetch+Modify+Store operations (like fetch_add) can be acq_rel, acquire, release, or relaxed.
-static int do_triangle_work(triangle_worker& tworker)
+static void raster_worker_render_tiles(raster_worker& rworker)
 {
 	// Extra load but this should ensure we don't overflow the index,
 	// with the fetch_add below in case of spurious wake-ups.
-	int i = tworker.work_index.load(std::memory_order_acquire);
-	if (i >= tworker.num_work_units) {
-		return i;
+	if (rworker.next_tile.load(std::memory_order_acquire) >= rworker.num_tiles) {
+		return;
 	}
 
-	i = tworker.work_index.fetch_add(1, std::memory_order_acq_rel);
-	if (i < tworker.num_work_units) {
-		triangle_worker_work(tworker, i, i + 1);
-		int done = tworker.done_count.fetch_add(1, std::memory_order_acq_rel) + 1;
-		if (done >= tworker.num_work_units) {
-			tworker.done_count.notify_all();
+	while (true) {
+		const auto tile = rworker.next_tile.fetch_add(1, std::memory_order_acq_rel);
+		if (tile >= rworker.num_tiles) {
+			return;
 		}
-	}
 
-	// fetch_add returns the previous worker index.
-	// We want to return the current.
-	return i + 1;
+		const auto first_row = rworker.batch_first_row + tile * rworker.tile_rows;
+		const auto last_row = first_row + rworker.tile_rows;
+
+		stats_block my_stats = {};
+		for (const auto& cmd : rworker.batch) {
+			if (cmd.max_row > first_row && cmd.min_row < last_row) {
+				raster_command_rows(cmd, first_row, last_row, my_stats);
+			}
+		}
+		sum_statistics(&v->thread_stats[tile], &my_stats);
+
+		const auto done = rworker.tiles_done.fetch_add(1, std::memory_order_acq_rel) + 1;
+		if (done >= rworker.num_tiles) {
+			rworker.tiles_done.notify_all();
+		}
+	}
 }
 
-static int triangle_worker_thread_func()
+static void raster_worker_thread_func()
 {
-	triangle_worker& tworker = v->tworker;
-	while (tworker.threads_active.load(std::memory_order_acquire)) {
-		int i = do_triangle_work(tworker);
-		if (i >= tworker.num_work_units) {
-			tworker.work_index.wait(i, std::memory_order_acquire);
+	raster_worker& rworker = v->rworker;
+
+	uint32_t generation = 0;
+	while (true) {
+		rworker.batch_generation.wait(generation, std::memory_order_acquire);
+		generation = rworker.batch_generation.load(std::memory_order_acquire);
+
+		if (!rworker.threads_active.load(std::memory_order_acquire)) {
+			return;
 		}
+		raster_worker_render_tiles(rworker);
 	}
-	return 0;
 }
 
-static void triangle_worker_shutdown(triangle_worker& tworker)
-{
-	if (!tworker.threads_active.load(std::memory_order_acquire)) {
-		return;
+// Waits until the batch in flight has been rendered
+static void raster_worker_wait(raster_worker& rworker)
+{
+	if (!rworker.batch_in_flight) {
+		return;
+	}
+
+	// Main thread also does the same work as the worker threads
+	raster_worker_render_tiles(rworker);
+
+	// Wait until all work has been completed by the worker threads
+	int i;
+	while ((i = rworker.tiles_done.load(std::memory_order_acquire)) < rworker.num_tiles) {
+		rworker.tiles_done.wait(i, std::memory_order_acquire);
+	}
+	rworker.batch_in_flight = false;
+}
+
+// Hands the queued commands to the workers as a new batch
+static void raster_worker_submit(raster_worker& rworker)
+{
+	if (rworker.queued.empty()) {
+		return;
+	}
+
+	// Only one batch is rendered at a time
+	raster_worker_wait(rworker);
+
+	std::swap(rworker.batch, rworker.queued);
+	rworker.queued.clear();
+
+	// Split the rows touched by the batch evenly across the tiles
+	auto first_row = rworker.batch.front().min_row;
+	auto last_row  = rworker.batch.front().max_row;
+	for (const auto& cmd : rworker.batch) {
+		first_row = std::min(first_row, cmd.min_row);
+		last_row  = std::max(last_row, cmd.max_row);
 	}
-	tworker.threads_active.store(false, std::memory_order_release);
-	tworker.work_index.store(0, std::memory_order_release);
-	tworker.work_index.notify_all();
+	rworker.batch_first_row = first_row;
+	rworker.tile_rows = std::max(1, ceil_sdivide(last_row - first_row, rworker.num_tiles));
 
-	for (auto& thread : tworker.threads) {
-		if (thread.joinable()) {
-			thread.join();
+	// The main thread is the only one who sets threads_active (here and in shutdown) so there is no race condition.
+	if (!rworker.threads_active.load(std::memory_order_acquire)) {
+		rworker.threads_active.store(true, std::memory_order_release);
+
+		for (auto& thread : rworker.threads) {
+			thread = std::thread([] { raster_worker_thread_func(); });
+			set_thread_name(thread, "dosbox:voodoo");
 		}
 	}
+
+	rworker.batch_in_flight = true;
+	rworker.tiles_done.store(0, std::memory_order_release);
+
+	// Reseting this index lets the workers start claiming tiles
+	rworker.next_tile.store(0, std::memory_order_release);
+
+	rworker.batch_generation.fetch_add(1, std::memory_order_acq_rel);
+	rworker.batch_generation.notify_all();
 }
 
-static void triangle_worker_run(triangle_worker& tworker)
+// Queues the command last added to the FIFO
+static void raster_worker_commit(raster_worker& rworker, const bool draws_to_front_buffer)
 {
-	if (!tworker.num_threads) {
+	auto& cmd = rworker.queued.back();
+	set_command_rows(cmd);
+
+	if (!rworker.num_threads) {
 		// do not use threaded calculation
-		tworker.totalpix = 0xFFFFFFF;
-		triangle_worker_work(tworker, 0, tworker.num_work_units);
+		stats_block stats = {};
+		raster_command_rows(cmd, cmd.min_row, cmd.max_row, stats);
+		sum_statistics(&v->thread_stats[0], &stats);
+
+		rworker.queued.clear();
 		return;
 	}
 
-	/* compute the slopes for each portion of the triangle */
-	const poly_vertex v1 = tworker.v1;
-	const poly_vertex v2 = tworker.v2;
-	const poly_vertex v3 = tworker.v3;
-
-	const float dxdy_v1v2 = (v2.y == v1.y) ? 0.0f
-	                                       : (v2.x - v1.x) / (v2.y - v1.y);
-	const float dxdy_v1v3 = (v3.y == v1.y) ? 0.0f
-	                                       : (v3.x - v1.x) / (v3.y - v1.y);
-	const float dxdy_v2v3 = (v3.y == v2.y) ? 0.0f
-	                                       : (v3.x - v2.x) / (v3.y - v2.y);
+	rworker.front_buffer_dirty |= draws_to_front_buffer;
 
-	int32_t pixsum = 0;
-	for (int32_t curscan = tworker.v1y, scanend = tworker.v3y; curscan != scanend; curscan++)
-	{
-		const float fully  = (float)(curscan) + 0.5f;
-		const float startx = v1.x + (fully - v1.y) * dxdy_v1v3;
+	if (rworker.queued.size() >= raster_worker::MaxQueuedCommands) {
+		raster_worker_submit(rworker);
+	}
+}
 
-		/* compute the ending X based on which part of the triangle we're in */
-		const float stopx = (fully < v2.y
-		                             ? (v1.x + (fully - v1.y) * dxdy_v1v2)
-		                             : (v2.x + (fully - v2.y) * dxdy_v2v3));
+// Renders everything queued so far and waits for it to finish. This must be
+// called before anything outside the workers reads or writes the frame
+// buffer or texture memory, or modifies tables the queued commands point to.
+static void raster_worker_flush(raster_worker& rworker)
+{
+	raster_worker_submit(rworker);
+	raster_worker_wait(rworker);
 
-		/* clamp to full pixels */
-		const int32_t istartx = round_coordinate(startx);
-		const int32_t istopx  = round_coordinate(stopx);
+	rworker.front_buffer_dirty = false;
+}
 
-		/* force start < stop */
-		pixsum += (istartx > istopx ? istartx - istopx : istopx - istartx);
-	}
-	tworker.totalpix = pixsum;
+static void raster_worker_shutdown(raster_worker& rworker)
+{
+	raster_worker_flush(rworker);
 
-	// Don't wake up threads for just a few pixels
-	if (tworker.totalpix <= 200)
-	{
-		triangle_worker_work(tworker, 0, tworker.num_work_units);
+	if (!rworker.threads_active.load(std::memory_order_acquire)) {
 		return;
 	}
+	rworker.threads_active.store(false, std::memory_order_release);
 
-	// The main thread is the only one who sets threads_active (here and in shutdown) so there is no race condition.
-	// In the future, if this changes, this will need to be an atomic compare_exchange.
-	// For now, this is better because 99% of the time threads_active == true.
-	// We only spin up the threads once and a load is much faster than a compare_exchange.
-	if (!tworker.threads_active.load(std::memory_order_acquire))
-	{
-		tworker.threads_active.store(true, std::memory_order_release);
+	rworker.batch_generation.fetch_add(1, std::memory_order_acq_rel);
+	rworker.batch_generation.notify_all();
 
-		for (auto& triangle_worker : tworker.threads) {
-			triangle_worker = std::thread([] {
-				triangle_worker_thread_func();
-			});
+	for (auto& thread : rworker.threads) {
+		if (thread.joinable()) {
+			thread.join();
 		}
 	}
+}
 
-	tworker.done_count.store(0, std::memory_order_release);
-
-	// Reseting this index triggers the worker threads to start working
-	tworker.work_index.store(0, std::memory_order_release);
-	tworker.work_index.notify_all();
-
-	// Main thread also does the same work as the worker threads
-	while (do_triangle_work(tworker) < tworker.num_work_units);
+// Captures the register and frame buffer state used by the span rasterizers
+static void capture_raster_params(const voodoo_state* vs, uint16_t* drawbuf,
+                                  raster_params& rp)
+{
+	const auto regs = vs->reg;
+	const auto& fbi = vs->fbi;
+
+	rp.r_fbzColorPath  = regs[fbzColorPath].u;
+	rp.r_fbzMode       = regs[fbzMode].u;
+	rp.r_alphaMode     = regs[alphaMode].u;
+	rp.r_fogMode       = regs[fogMode].u;
+	rp.r_zaColor       = regs[zaColor].u;
+	rp.r_stipple       = regs[stipple].u;
+	rp.r_clipLeftRight = regs[clipLeftRight].u;
+	rp.r_clipLowYHighY = regs[clipLowYHighY].u;
+
+	rp.r_color0      = regs[color0];
+	rp.r_color1      = regs[color1];
+	rp.r_chromaKey   = regs[chromaKey];
+	rp.r_chromaRange = regs[chromaRange];
+	rp.r_fogColor    = regs[fogColor];
+
+	rp.send_config = vs->send_config;
+	rp.tmu_config  = vs->tmu_config;
+
+	rp.drawbuf = drawbuf;
+
+	auto& f     = rp.fbi;
+	f.ram       = fbi.ram;
+	f.mask      = fbi.mask;
+	f.auxoffs   = fbi.auxoffs;
+	f.rowpixels = fbi.rowpixels;
+	f.yorigin   = fbi.yorigin;
+
+	f.ax     = fbi.ax;
+	f.ay     = fbi.ay;
+	f.startr = fbi.startr;
+	f.startg = fbi.startg;
+	f.startb = fbi.startb;
+	f.starta = fbi.starta;
+	f.startz = fbi.startz;
+	f.startw = fbi.startw;
+	f.drdx   = fbi.drdx;
+	f.dgdx   = fbi.dgdx;
+	f.dbdx   = fbi.dbdx;
+	f.dadx   = fbi.dadx;
+	f.dzdx   = fbi.dzdx;
+	f.dwdx   = fbi.dwdx;
+	f.drdy   = fbi.drdy;
+	f.dgdy   = fbi.dgdy;
+	f.dbdy   = fbi.dbdy;
+	f.dady   = fbi.dady;
+	f.dzdy   = fbi.dzdy;
+	f.dwdy   = fbi.dwdy;
+
+	std::memcpy(f.fogblend, fbi.fogblend, sizeof(f.fogblend));
+	std::memcpy(f.fogdelta, fbi.fogdelta, sizeof(f.fogdelta));
+	f.fogdelta_mask = fbi.fogdelta_mask;
+}
 
-	// Wait until all work has been completed by the worker thread.
-	int i;
-	while ((i = tworker.done_count.load(std::memory_order_acquire)) < tworker.num_work_units) {
-		tworker.done_count.wait(i, std::memory_order_acquire);
-	}
+static void capture_tmu_params(const tmu_state& tmu, tmu_raster_params& t)
+{
+	t.ram  = tmu.ram;
+	t.mask = tmu.mask;
+
+	t.starts = tmu.starts;
+	t.startt = tmu.startt;
+	t.startw = tmu.startw;
+	t.dsdx   = tmu.dsdx;
+	t.dtdx   = tmu.dtdx;
+	t.dwdx   = tmu.dwdx;
+	t.dsdy   = tmu.dsdy;
+	t.dtdy   = tmu.dtdy;
+	t.dwdy   = tmu.dwdy;
+
+	t.lodmin      = tmu.lodmin;
+	t.lodmax      = tmu.lodmax;
+	t.lodbias     = tmu.lodbias;
+	t.lodmask     = tmu.lodmask;
+	t.lodbasetemp = tmu.lodbasetemp;
+	t.detailmax   = tmu.detailmax;
+	t.detailbias  = tmu.detailbias;
+	t.detailscale = tmu.detailscale;
+	std::memcpy(t.lodoffset, tmu.lodoffset, sizeof(t.lodoffset));
+
+	t.wmask         = tmu.wmask;
+	t.hmask         = tmu.hmask;
+	t.bilinear_mask = tmu.bilinear_mask;
+
+	t.lookup  = tmu.lookup;
+	t.decoded = tmu.decoded;
 }
 
 /*-------------------------------------------------
@@ -4760,17 +6330,47 @@ static void triangle(voodoo_state *vs)
 	if (texcount >= 1)
 	{
 		prepare_tmu(&tmu0);
+		prepare_decoded_texture(vs, &tmu0);
 		if (texcount >= 2) {
 			prepare_tmu(&tmu1);
+			prepare_decoded_texture(vs, &tmu1);
+		}
+	}
+
+	/* queue the triangle with a snapshot of the state it's drawn with */
+	auto& rworker = vs->rworker;
+
+	auto& cmd = rworker.queued.emplace_back();
+	cmd.type  = RasterCommand::Triangle;
+
+	auto& rp = cmd.params;
+	capture_raster_params(vs, drawbuf, rp);
+
+	if (texcount >= 1) {
+		rp.tmus     = 1;
+		rp.texmode0 = tmu0.reg[textureMode].u;
+		capture_tmu_params(tmu0, rp.tmu[0]);
+
+		if (texcount >= 2) {
+			rp.tmus     = 2;
+			rp.texmode1 = tmu1.reg[textureMode].u;
+			capture_tmu_params(tmu1, rp.tmu[1]);
+		}
+		if (rworker.disable_bilinear_filter) { // force disable bilinear filter
+			rp.texmode0 &= ~6;
+			rp.texmode1 &= ~6;
 		}
 	}
+	cmd.span = select_rasterizer(vs, rp);
 
-	triangle_worker& tworker = vs->tworker;
-	tworker.v1 = *v1, tworker.v2 = *v2, tworker.v3 = *v3;
-	tworker.drawbuf = drawbuf;
-	tworker.v1y = v1y;
-	tworker.v3y = v3y;
-	triangle_worker_run(tworker);
+	cmd.v1  = *v1;
+	cmd.v2  = *v2;
+	cmd.v3  = *v3;
+	cmd.v1y = v1y;
+	cmd.v3y = v3y;
+
+	const auto draws_to_front_buffer = (FBZMODE_DRAW_BUFFER(regs[fbzMode].u) == 0);
+	raster_worker_commit(rworker, draws_to_front_buffer);
 
 	/* update stats */
 	regs[fbiTrianglesOut].u++;
@@ -5034,16 +6634,11 @@ static void fastfill(voodoo_state *vs)
 {
 	const auto regs = vs->reg;
 
-	const int sx = (regs[clipLeftRight].u >> 16) & 0x3ff;
-	const int ex = (regs[clipLeftRight].u >> 0) & 0x3ff;
+	int sx = (regs[clipLeftRight].u >> 16) & 0x3ff;
+	int ex = (regs[clipLeftRight].u >> 0) & 0x3ff;
 	const int sy = (regs[clipLowYHighY].u >> 16) & 0x3ff;
 	const int ey = (regs[clipLowYHighY].u >> 0) & 0x3ff;
 
-	poly_extent extents[64] = {};
-
-	// Align to 64-bit because that's the maximum type written
-	alignas(sizeof(uint64_t)) static uint16_t dithermatrix[16] = {};
-
 	uint16_t* drawbuf = nullptr;
 	int x;
 	int y;
@@ -5054,6 +6649,22 @@ static void fastfill(voodoo_state *vs)
 		return;
 	}
 
+#ifdef C_ENABLE_VOODOO_OPENGL
+	if (vs->ogl && vs->active) {
+		voodoo_ogl_fastfill();
+		return;
+	}
+#endif
+
+	if (ey <= sy) {
+		return;
+	}
+
+	auto& rworker = vs->rworker;
+
+	auto& cmd = rworker.queued.emplace_back();
+	cmd.type  = RasterCommand::Fastfill;
+
 	/* are we clearing the RGB buffer? */
 	if (FBZMODE_RGB_BUFFER_MASK(regs[fbzMode].u)) {
 		/* determine the draw buffer */
@@ -5088,56 +6699,25 @@ static void fastfill(voodoo_state *vs)
 				int b = regs[color1].rgb.b;
 
 				APPLY_DITHER(regs[fbzMode].u, x, dither_lookup, r, g, b);
-				dithermatrix[y*4 + x] = (uint16_t)((r << 11) | (g << 5) | b);
+				cmd.dither[y*4 + x] = (uint16_t)((r << 11) | (g << 5) | b);
 			}
 		}
 	}
 
-	/* fill in a block of extents */
-	extents[0].startx = sx;
-	extents[0].stopx = ex;
-
-	constexpr auto num_extents = static_cast<int>(ARRAY_LEN(extents));
-
-	for (auto extnum = 1; extnum < num_extents; ++extnum) {
-		extents[extnum] = extents[0];
-	}
+	capture_raster_params(vs, drawbuf, cmd.params);
 
-#ifdef C_ENABLE_VOODOO_OPENGL
-	if (vs->ogl && vs->active) {
-		voodoo_ogl_fastfill();
-		return;
+	/* force start < stop */
+	if (sx > ex) {
+		std::swap(sx, ex);
 	}
-#endif
-
-	/* iterate over blocks of extents */
-	for (y = sy; y < ey; y += num_extents) {
-		const auto count = std::min<int>(ey - y, num_extents);
-		void *dest = drawbuf;
-
-		const int startscanline = y;
-		const int numscanlines  = count;
-
-		const int32_t v1yclip = startscanline;
-		const int32_t v3yclip = startscanline + numscanlines;
-
-		if (v3yclip - v1yclip <= 0) {
-			return;
-		}
-
-		for (int32_t curscan = v1yclip; curscan < v3yclip; curscan++)
-		{
-			auto extent = &extents[curscan - startscanline];
-
-			/* force start < stop */
-			if (extent->startx > extent->stopx) {
-				std::swap(extent->startx, extent->stopx);
-			}
+	cmd.startx = sx;
+	cmd.stopx  = ex;
+	cmd.v1y    = sy;
+	cmd.v3y    = ey;
 
-			/* set the extent and update the total pixel count */
-			raster_fastfill(dest,curscan,extent,dithermatrix);
-		}
-	}
+	const auto draws_to_front_buffer = FBZMODE_RGB_BUFFER_MASK(regs[fbzMode].u) &&
+	                                   FBZMODE_DRAW_BUFFER(regs[fbzMode].u) == 0;
+	raster_worker_commit(rworker, draws_to_front_buffer);
 }
 
 /*-------------------------------------------------
@@ -6010,6 +7590,8 @@ default_case:
  *************************************/
 static void lfb_w(uint32_t offset, uint32_t data, uint32_t mem_mask) {
 	//LOG(LOG_VOODOO,LOG_WARN)("V3D:WR LFB offset %X value %08X", offset, data);
+	raster_worker_flush(v->rworker);
+
 	uint16_t* dest  = {};
 	uint16_t* depth = {};
 
@@ -6404,7 +7986,7 @@ static void lfb_w(uint32_t offset, uint32_t data, uint32_t mem_mask) {
 
 				/* pixel pipeline part 1 handles depth testing and stippling */
 				// TODO: in the v->ogl case this macro doesn't really work with depth testing
-				PIXEL_PIPELINE_BEGIN(v, stats, x, y, v->reg[fbzColorPath].u, v->reg[fbzMode].u, iterz, iterw, v->reg[zaColor].u, v->reg[stipple].u);
+				PIXEL_PIPELINE_BEGIN(stats, x, y, v->reg[fbzColorPath].u, v->reg[fbzMode].u, iterz, iterw, v->reg[zaColor].u, v->reg[stipple].u);
 
 				color.rgb.r = static_cast<uint8_t>(sr[pix]);
 				color.rgb.g = static_cast<uint8_t>(sg[pix]);
@@ -6412,11 +7994,14 @@ static void lfb_w(uint32_t offset, uint32_t data, uint32_t mem_mask) {
 				color.rgb.a = static_cast<uint8_t>(sa[pix]);
 
 				/* apply chroma key */
-				APPLY_CHROMAKEY(v, stats, v->reg[fbzMode].u, color);
+				APPLY_CHROMAKEY(stats, v->reg[fbzMode].u, v->reg[chromaKey], v->reg[chromaRange], color);
 
 				/* apply alpha mask, and alpha testing */
-				APPLY_ALPHAMASK(v, stats, v->reg[fbzMode].u, color.rgb.a);
-				APPLY_ALPHATEST(v, stats, v->reg[alphaMode].u, color.rgb.a);
+				APPLY_ALPHAMASK(stats, v->reg[fbzMode].u, color.rgb.a);
+				APPLY_ALPHATEST(stats,
+				                v->reg[alphaMode].u,
+				                ALPHAMODE_ALPHAREF(v->reg[alphaMode].u),
+				                color.rgb.a);
 
 				/*
 				if (FBZCP_CC_MSELECT(v->reg[fbzColorPath].u) != 0) maybe_log_debug("lfbw fpp mselect %8x",FBZCP_CC_MSELECT(v->reg[fbzColorPath].u));
@@ -6648,9 +8233,9 @@ static void lfb_w(uint32_t offset, uint32_t data, uint32_t mem_mask) {
 #endif
 				{
 					/* pixel pipeline part 2 handles color combine, fog, alpha, and final output */
-					PIXEL_PIPELINE_MODIFY(v, dither, dither4, x, v->reg[fbzMode].u, v->reg[fbzColorPath].u, v->reg[alphaMode].u, v->reg[fogMode].u, iterz, iterw, v->reg[zaColor]);
+					PIXEL_PIPELINE_MODIFY(v->fbi, v->reg[fogColor], dither, dither4, x, v->reg[fbzMode].u, v->reg[fbzColorPath].u, v->reg[alphaMode].u, v->reg[fogMode].u, iterz, iterw, v->reg[zaColor]);
 
-					PIXEL_PIPELINE_FINISH(v, dither_lookup, x, dest, depth, v->reg[fbzMode].u);
+					PIXEL_PIPELINE_FINISH(dither_lookup, x, dest, depth, v->reg[fbzMode].u);
 				}
 
 				PIXEL_PIPELINE_END(stats);
@@ -6675,6 +8260,9 @@ static int32_t texture_w(uint32_t offset, uint32_t data) {
 	// LOG(LOG_VOODOO,LOG_WARN)("V3D:write TMU%x offset %X value %X",
 	// tmunum, offset, data);
 
+	// Queued triangles may still be reading the texture memory
+	raster_worker_flush(v->rworker);
+
 	/* point to the right TMU */
 	if ((v->chipmask & (2 << tmu_num)) == 0) {
 		return 0;
@@ -6737,7 +8325,7 @@ static int32_t texture_w(uint32_t offset, uint32_t data) {
 		dest = t->ram;
 		tbaseaddr &= t->mask;
 
-		[[maybe_unused]] bool changed = false;
+		bool changed = false;
 		if (dest[BYTE4_XOR_LE(tbaseaddr + 0)] != ((data >> 0) & 0xff)) {
 			dest[BYTE4_XOR_LE(tbaseaddr + 0)] = static_cast<uint8_t>((data >> 0) & 0xff);
 			changed = true;
@@ -6754,6 +8342,9 @@ static int32_t texture_w(uint32_t offset, uint32_t data) {
 			dest[BYTE4_XOR_LE(tbaseaddr + 3)] = static_cast<uint8_t>((data >> 24) & 0xff);
 			changed = true;
 		}
+		if (changed) {
+			invalidate_decoded_texture_page(t, tbaseaddr);
+		}
 
 #ifdef C_ENABLE_VOODOO_OPENGL
 		if (changed && v->ogl && v->active) {
@@ -6797,9 +8388,10 @@ static int32_t texture_w(uint32_t offset, uint32_t data) {
 		/* write the two words in little-endian order */
 		dest = (uint16_t *)t->ram;
 		tbaseaddr &= t->mask;
+		const auto byte_addr = tbaseaddr;
 		tbaseaddr >>= 1;
 
-		[[maybe_unused]] bool changed = false;
+		bool changed = false;
 		if (dest[BYTE_XOR_LE(tbaseaddr + 0)] != ((data >> 0) & 0xffff)) {
 			dest[BYTE_XOR_LE(tbaseaddr + 0)] = static_cast<uint16_t>((data >> 0) & 0xffff);
 			changed = true;
@@ -6808,6 +8400,9 @@ static int32_t texture_w(uint32_t offset, uint32_t data) {
 			dest[BYTE_XOR_LE(tbaseaddr + 1)] = static_cast<uint16_t>((data >> 16) & 0xffff);
 			changed = true;
 		}
+		if (changed) {
+			invalidate_decoded_texture_page(t, byte_addr);
+		}
 
 #ifdef C_ENABLE_VOODOO_OPENGL
 		if (changed && v->ogl && v->active) {
@@ -6846,6 +8441,9 @@ static uint32_t register_r(const uint32_t offset)
 	switch (regnum)
 	{
 		case status:
+			/* the game is polling for the graphics engine to be
+			 * idle, so finish all queued drawing */
+			raster_worker_flush(v->rworker);
 
 			/* start with a blank slate */
 			result = 0;
@@ -6940,6 +8538,8 @@ static uint32_t register_r(const uint32_t offset)
 static uint32_t lfb_r(const uint32_t offset)
 {
 	//LOG(LOG_VOODOO,LOG_WARN)("Voodoo:read LFB offset %X", offset);
+	raster_worker_flush(v->rworker);
+
 	uint16_t* buffer = {};
 	uint32_t bufmax  = 0;
 	uint32_t data    = 0;
@@ -7027,6 +8627,10 @@ static void voodoo_w(const uint32_t addr, const uint32_t data, const uint32_t ma
 {
 	const auto offset = (addr >> 2) & offset_mask;
 
+	if (v->recorder) [[unlikely]] {
+		v->recorder->AddWrite(recorder_time_ms(), offset, data, mask);
+	}
+
 	if ((offset & offset_base) == 0) {
 		register_w(offset, data);
 	} else if ((offset & lfb_base) == 0) {
@@ -7036,6 +8640,14 @@ static void voodoo_w(const uint32_t addr, const uint32_t data, const uint32_t ma
 	}
 }
 
+static void voodoo_set_init_enable(const uint32_t value)
+{
+	if (v->recorder) [[unlikely]] {
+		v->recorder->AddInitEnable(recorder_time_ms(), value);
+	}
+	v->pci.init_enable = value;
+}
+
 static constexpr uint32_t voodoo_r(const uint32_t addr)
 {
 	const auto offset = (addr >> 2) & offset_mask;
@@ -7101,12 +8713,10 @@ static int get_num_total_threads()
 /*-------------------------------------------------
     device start callback
 -------------------------------------------------*/
-static void voodoo_init() {
+static void voodoo_init(const int num_additional_threads)
+{
 	assert(!v);
 
-	// Deduct 1 because the main thread is always present
-	const auto num_additional_threads = get_num_total_threads() - 1;
-
 	v = new voodoo_state(num_additional_threads);
 
 #ifdef C_ENABLE_VOODOO_OPENGL
@@ -7349,6 +8959,11 @@ static void Voodoo_VerticalTimer(uint32_t /*val*/)
 		r.max_y = (int)v->fbi.height;
 #endif
 
+		// Finish queued drawing to the buffer being displayed
+		if (v->rworker.front_buffer_dirty) {
+			raster_worker_flush(v->rworker);
+		}
+
 		// draw all lines at once
 		auto* viewbuf = (uint16_t*)(v->fbi.ram +
 		                            v->fbi.rgboffs[v->fbi.frontbuf]);
@@ -7775,7 +9390,7 @@ struct PCI_SSTDevice : public PCI_Device {
 			return value;
 		case 0x40:
 			Voodoo_Startup();
-			v->pci.init_enable = (uint32_t)(value & 7);
+			voodoo_set_init_enable(static_cast<uint32_t>(value & 7));
 			break;
 		case 0x41:
 		case 0x42:
@@ -7848,7 +9463,10 @@ static void voodoo_shutdown()
 #endif
 
 	v->active = false;
-	triangle_worker_shutdown(v->tworker);
+	raster_worker_shutdown(v->rworker);
+
+	log_rasterizer_stats(v->raster_stats);
+	log_texture_cache_stats(v);
 
 	delete v;
 	v = nullptr;
@@ -7862,11 +9480,27 @@ static void Voodoo_Startup() {
 		return;
 	}
 
-	voodoo_init();
+	// Deduct 1 because the main thread is always present
+	voodoo_init(get_num_total_threads() - 1);
 
 	v->draw = {};
 
-	v->tworker.disable_bilinear_filter = (voodoo_bilinear_filtering == false);
+	v->rworker.disable_bilinear_filter = (voodoo_bilinear_filtering == false);
+
+	// Record from the card's reset state so the stream can be replayed
+	if (voodoo_register_capture) {
+		if (auto file = CAPTURE_CreateFile(CaptureType::VoodooRegisterStream)) {
+			VoodooStreamHeader header = {};
+
+			header.model = (vtype == VOODOO_1_DTMU)
+			                     ? VoodooStreamModel::Voodoo1Dtmu
+			                     : VoodooStreamModel::Voodoo1;
+
+			header.bilinear_filtering = voodoo_bilinear_filtering;
+
+			v->recorder = std::make_unique<VoodooStreamWriter>(file, header);
+		}
+	}
 
 	// Switch the pagehandler now that v has been allocated and is in use
 	voodoo_pagehandler = &voodoo_real_pagehandler;
@@ -7895,6 +9529,7 @@ static void voodoo_init(Section* sec)
 	vtype = (memsize_pref == "4" ? VOODOO_1 : VOODOO_1_DTMU);
 
 	voodoo_bilinear_filtering = section->GetBool("voodoo_bilinear_filtering");
+	voodoo_register_capture = section->GetBool("voodoo_register_capture");
 
 	sec->AddDestroyFunction(&voodoo_destroy, false);
 
@@ -7960,6 +9595,454 @@ static void init_voodoo_dosbox_settings(SectionProp& secprop)
 	        "Use bilinear filtering to emulate the 3dfx Voodoo's texture smoothing effect\n"
 	        "('on' by default). Bilinear filtering can impact frame rates on slower systems;\n"
 	        "try turning it off if you're not getting adequate performance.");
+
+	bool_prop = secprop.AddBool("voodoo_register_capture", OnlyAtStart, false);
+	bool_prop->SetHelp(
+	        "Record everything sent to the 3dfx Voodoo card to a register stream file in\n"
+	        "the capture directory ('off' by default). Recording starts when a game first\n"
+	        "uses the card. Replay the stream with the '--replay-voodoo' command line\n"
+	        "option to benchmark the Voodoo emulation or compare its output.");
+}
+
+/***************************************************************************
+    RASTERIZER BENCHMARK
+***************************************************************************/
+
+struct benchmark_vertex {
+	float x = 0.0f;
+	float y = 0.0f;
+	float r = 0.0f;
+	float g = 0.0f;
+	float b = 0.0f;
+	float a = 0.0f;
+	float z = 0.0f;
+	float s = 0.0f;
+	float t = 0.0f;
+	float w = 1.0f;
+};
+
+// The benchmark sends everything through voodoo_w() like the guest does, so
+// it can be recorded as a register stream
+static void benchmark_register_w(const uint32_t regnum, const uint32_t data)
+{
+	voodoo_w(regnum << 2, data, 0xffffffff);
+}
+
+static void benchmark_texture_w(const uint32_t offset, const uint32_t data)
+{
+	voodoo_w((lfb_base | offset) << 2, data, 0xffffffff);
+}
+
+static void benchmark_write_float(const uint32_t regnum, const float value)
+{
+	benchmark_register_w(regnum, std::bit_cast<uint32_t>(value));
+}
+
+// Emulated time of the benchmark's register stream, advanced by a 60 Hz frame
+// at every buffer swap
+static double benchmark_time_ms = 0.0;
+
+// FNV-1a hash
+constexpr uint64_t FnvOffsetBasis = 0xcbf29ce484222325;
+
+static uint64_t fnv1a_hash(uint64_t hash, const uint8_t* data, const size_t size)
+{
+	constexpr uint64_t FnvPrime = 0x100000001b3;
+
+	for (size_t i = 0; i < size; ++i) {
+		hash = (hash ^ data[i]) * FnvPrime;
+	}
+	return hash;
+}
+
+// Sets up the start values and gradients of a triangle from its vertices
+// the way the Glide driver does, then draws it
+static void benchmark_draw_triangle(const benchmark_vertex& va,
+                                    const benchmark_vertex& vb,
+                                    const benchmark_vertex& vc)
+{
+	const auto dx1 = vb.x - va.x;
+	const auto dy1 = vb.y - va.y;
+	const auto dx2 = vc.x - va.x;
+	const auto dy2 = vc.y - va.y;
+
+	const auto area = dx1 * dy2 - dx2 * dy1;
+	if (std::fabs(area) < 1.0f) {
+		return;
+	}
+
+	const auto set_gradients = [&](const float benchmark_vertex::*attr,
+	                               const uint32_t start_reg,
+	                               const uint32_t dx_reg,
+	                               const uint32_t dy_reg) {
+		const auto d1 = vb.*attr - va.*attr;
+		const auto d2 = vc.*attr - va.*attr;
+
+		benchmark_write_float(start_reg, va.*attr);
+		benchmark_write_float(dx_reg, (d1 * dy2 - d2 * dy1) / area);
+		benchmark_write_float(dy_reg, (d2 * dx1 - d1 * dx2) / area);
+	};
+
+	benchmark_write_float(fvertexAx, va.x);
+	benchmark_write_float(fvertexAy, va.y);
+	benchmark_write_float(fvertexBx, vb.x);
+	benchmark_write_float(fvertexBy, vb.y);
+	benchmark_write_float(fvertexCx, vc.x);
+	benchmark_write_float(fvertexCy, vc.y);
+
+	set_gradients(&benchmark_vertex::r, fstartR, fdRdX, fdRdY);
+	set_gradients(&benchmark_vertex::g, fstartG, fdGdX, fdGdY);
+	set_gradients(&benchmark_vertex::b, fstartB, fdBdX, fdBdY);
+	set_gradients(&benchmark_vertex::a, fstartA, fdAdX, fdAdY);
+	set_gradients(&benchmark_vertex::z, fstartZ, fdZdX, fdZdY);
+	set_gradients(&benchmark_vertex::s, fstartS, fdSdX, fdSdY);
+	set_gradients(&benchmark_vertex::t, fstartT, fdTdX, fdTdY);
+	set_gradients(&benchmark_vertex::w, fstartW, fdWdX, fdWdY);
+
+	benchmark_register_w(ftriangleCMD, std::bit_cast<uint32_t>(area));
+}
+
+// Pipeline state of the benchmark scenes
+struct benchmark_scene_state {
+	uint32_t fbz_color_path = 0;
+	uint32_t fbz_mode       = 0;
+	uint32_t alpha_mode     = 0;
+};
+
+static benchmark_scene_state get_benchmark_scene_state(const VoodooBenchmarkScene scene)
+{
+	switch (scene) {
+	case VoodooBenchmarkScene::Textured:
+		// Textured and modulated by the iterated colour, Z-buffered
+		// with depth writes, dithered, drawn to the back buffer
+		return {0x08c22401, 0x00004731, 0};
+	case VoodooBenchmarkScene::TexturedWBuffered:
+		// Same with W-buffering and perspective correct texturing
+		return {0x08c22401, 0x00004739, 0};
+	case VoodooBenchmarkScene::Gouraud:
+		// Iterated colour only
+		return {0x00c26100, 0x00004731, 0};
+	case VoodooBenchmarkScene::AlphaBlended:
+		// Textured colour with the iterated alpha, alpha tested and
+		// blended with dither subtraction, without depth writes
+		return {0x08482401, 0x00084331, 0x20045119};
+	}
+	return {};
+}
+
+VoodooBenchmarkResult VOODOO_RunRasterizerBenchmark(const VoodooBenchmarkOptions& options)
+{
+	assert(!v);
+	assert(options.num_threads >= 1);
+
+	voodoo_specialised_rasterizers = options.use_specialised_rasterizers;
+	voodoo_simd_rasterizers        = options.use_simd_rasterizers;
+	voodoo_texture_cache           = options.use_texture_cache;
+	voodoo_init(options.num_threads - 1);
+
+	if (!options.record_path.empty()) {
+		if (auto file = open_file(options.record_path.c_str(), "wb")) {
+			VoodooStreamHeader header = {};
+
+			header.model = (vtype == VOODOO_1_DTMU)
+			                     ? VoodooStreamModel::Voodoo1Dtmu
+			                     : VoodooStreamModel::Voodoo1;
+
+			header.bilinear_filtering = !v->rworker.disable_bilinear_filter;
+
+			v->recorder = std::make_unique<VoodooStreamWriter>(file, header);
+
+			benchmark_time_ms = 0.0;
+			recorder_time_ms  = [] { return benchmark_time_ms; };
+		} else {
+			LOG_WARNING("VOODOO: Can't create register stream '%s'",
+			            options.record_path.c_str());
+		}
+	}
+
+	// 640x480 with two colour buffers and a depth buffer, as set up by
+	// the Glide driver
+	constexpr auto Width  = 640;
+	constexpr auto Height = 480;
+
+	constexpr uint32_t XTiles      = Width / 64;
+	constexpr uint32_t BufferPages = Width * Height * 2 / 0x1000;
+
+	const auto regs = v->reg;
+
+	// Enable writes to the fbiInit registers
+	voodoo_set_init_enable(1);
+
+	benchmark_register_w(fbiInit1,
+	                     (regs[fbiInit1].u & ~(0xf << 4)) | (XTiles << 4));
+	benchmark_register_w(fbiInit2,
+	                     (regs[fbiInit2].u & ~(0x1ff << 11)) | (BufferPages << 11));
+
+	benchmark_register_w(clipLeftRight, Width);
+	benchmark_register_w(clipLowYHighY, Height);
+
+	// 64x64 RGB565 texture at LOD 2 in TMU 0
+	constexpr auto TexSize = 64;
+	constexpr uint32_t Lod = 2;
+
+	// The LOD fields are in 4.2 fixed point
+	constexpr uint32_t Lod42 = Lod << 2;
+
+	benchmark_register_w(texBaseAddr, 0);
+	benchmark_register_w(tLOD, Lod42 | (Lod42 << 6));
+
+	// Perspective correction with bilinear filtering, passing the texel
+	// through the TMU's texture combine unit
+	benchmark_register_w(textureMode, 0x0c261a0f);
+
+	for (auto t = 0; t < TexSize; ++t) {
+		for (auto s = 0; s < TexSize; s += 2) {
+			const auto texel = [&](const int ts) {
+				const auto checker = ((ts / 8) + (t / 8)) % 2;
+				const auto r = check_cast<uint16_t>(checker ? 0x1f : (ts / 2));
+				const auto g = check_cast<uint16_t>(t);
+				const auto b = check_cast<uint16_t>(checker ? ts / 2 : 0x1f);
+				return static_cast<uint32_t>((r << 11) | (g << 5) | b);
+			};
+			const auto offset = (Lod << 15) | (t << 7) | (s >> 1);
+			benchmark_texture_w(offset, texel(s) | (texel(s + 1) << 16));
+		}
+	}
+
+	const auto state = get_benchmark_scene_state(options.scene);
+
+	benchmark_register_w(fbzColorPath, state.fbz_color_path);
+	benchmark_register_w(fbzMode, state.fbz_mode);
+	benchmark_register_w(alphaMode, state.alpha_mode);
+	benchmark_register_w(fogMode, 0);
+
+	const auto is_w_buffered = (options.scene ==
+	                            VoodooBenchmarkScene::TexturedWBuffered);
+	const auto is_alpha_blended = (options.scene ==
+	                               VoodooBenchmarkScene::AlphaBlended);
+
+	VoodooBenchmarkResult result = {};
+
+	// Deterministic pseudo-random triangles of various sizes and depths
+	uint32_t seed = 1;
+	const auto random = [&seed](const float max_value) {
+		seed = seed * 1664525 + 1013904223;
+		return static_cast<float>(seed >> 8) / static_cast<float>(1 << 24) * max_value;
+	};
+
+	constexpr auto TrianglesPerFrame = 1000;
+
+	const auto start = std::chrono::steady_clock::now();
+
+	for (auto frame = 0; frame < options.num_frames; ++frame) {
+		// Clear the colour and depth buffers
+		benchmark_register_w(fbzMode, state.fbz_mode | (1 << 9) | (1 << 10));
+		benchmark_register_w(color1, 0x00203040);
+		benchmark_register_w(zaColor, 0xffff);
+		benchmark_register_w(fastfillCMD, 0);
+		benchmark_register_w(fbzMode, state.fbz_mode);
+
+		for (auto i = 0; i < TrianglesPerFrame; ++i) {
+			const auto size = 8.0f + random(120.0f);
+			const auto cx   = random(Width);
+			const auto cy   = random(Height);
+
+			benchmark_vertex verts[3] = {};
+			for (auto& vert : verts) {
+				vert.x = cx + random(size) - size / 2;
+				vert.y = cy + random(size) - size / 2;
+				vert.r = random(255.0f);
+				vert.g = random(255.0f);
+				vert.b = random(255.0f);
+				vert.a = is_alpha_blended ? random(255.0f) : 255.0f;
+				vert.z = random(65535.0f);
+				vert.s = random(256.0f);
+				vert.t = random(256.0f);
+
+				// W is 1/w as set up by Glide, below 1.0
+				vert.w = is_w_buffered ? 0.05f + random(0.9f) : 1.0f;
+			}
+			benchmark_draw_triangle(verts[0], verts[1], verts[2]);
+			++result.num_triangles;
+		}
+
+		// Swapping the buffers waits for the frame to be drawn
+		benchmark_register_w(swapbufferCMD, 0);
+		benchmark_time_ms += 1000.0 / 60;
+
+		for (const auto& stats : v->thread_stats) {
+			result.pixels_out += stats.pixels_out;
+			result.zfunc_fail += stats.zfunc_fail;
+			result.afunc_fail += stats.afunc_fail;
+		}
+		update_statistics(v, false);
+	}
+
+	const std::chrono::duration<double, std::milli> elapsed =
+	        std::chrono::steady_clock::now() - start;
+	result.elapsed_ms = elapsed.count();
+
+	// Hash the frame and depth buffers
+	result.buffer_hash = fnv1a_hash(FnvOffsetBasis, v->fbi.ram, v->fbi.mask + 1);
+
+	result.num_generic = v->raster_stats.num_generic;
+
+	result.tex_cache_hits   = v->tex_cache_stats.hits;
+	result.tex_cache_misses = v->tex_cache_stats.misses;
+
+	raster_worker_shutdown(v->rworker);
+	delete v;
+	v = nullptr;
+
+	voodoo_specialised_rasterizers = true;
+	voodoo_simd_rasterizers        = true;
+	voodoo_texture_cache           = true;
+	recorder_time_ms               = PIC_FullIndex;
+
+	return result;
+}
+
+/***************************************************************************
+    REGISTER STREAM REPLAY
+***************************************************************************/
+
+enum class replay_stage { Registers, Lfb, Textures, Swaps };
+
+static replay_stage get_replay_stage(const VoodooStreamEntry& entry)
+{
+	if (entry.type == VoodooStreamEntryType::InitEnable) {
+		return replay_stage::Registers;
+	}
+	if ((entry.offset & offset_base) == 0) {
+		return ((entry.offset & 0xff) == swapbufferCMD)
+		             ? replay_stage::Swaps
+		             : replay_stage::Registers;
+	}
+	if ((entry.offset & lfb_base) == 0) {
+		return replay_stage::Lfb;
+	}
+	return replay_stage::Textures;
+}
+
+// Hashes the visible area of the front buffer
+static uint64_t hash_front_buffer(const voodoo_state* vs)
+{
+	const auto& fbi = vs->fbi;
+
+	const auto base = fbi.rgboffs[fbi.frontbuf];
+	if (base == static_cast<uint32_t>(~0)) {
+		return 0;
+	}
+
+	constexpr uint32_t BytesPerPixel = 2;
+
+	const auto row_bytes     = fbi.width * BytesPerPixel;
+	const auto row_pitch     = fbi.rowpixels * BytesPerPixel;
+	const auto num_ram_bytes = fbi.mask + 1;
+
+	auto hash = FnvOffsetBasis;
+	for (uint32_t y = 0; y < fbi.height; ++y) {
+		const auto row_start = base + y * row_pitch;
+		if (row_start + row_bytes > num_ram_bytes) {
+			break;
+		}
+		hash = fnv1a_hash(hash, fbi.ram + row_start, row_bytes);
+	}
+	return hash;
+}
+
+VoodooReplayResult VOODOO_ReplayRegisterStream(const VoodooRegisterStream& stream,
+                                               const int num_threads)
+{
+	assert(!v);
+	assert(num_threads >= 1);
+
+	const auto prev_vtype = vtype;
+
+	vtype = (stream.header.model == VoodooStreamModel::Voodoo1Dtmu)
+	              ? VOODOO_1_DTMU
+	              : VOODOO_1;
+
+	voodoo_init(num_threads - 1);
+
+	v->draw = {};
+	v->rworker.disable_bilinear_filter = !stream.header.bilinear_filtering;
+
+	VoodooReplayResult result = {};
+
+	result.num_entries = static_cast<int64_t>(stream.entries.size());
+	if (!stream.entries.empty()) {
+		result.emulated_ms = static_cast<double>(stream.entries.back().time_us) /
+		                     1000.0;
+	}
+
+	// Only look at the clock when switching stages, so timing the stages
+	// doesn't slow down runs of small register writes
+	VoodooReplayStageTiming* stage_timings[] = {&result.registers,
+	                                            &result.lfb,
+	                                            &result.textures,
+	                                            &result.swaps};
+
+	auto stage       = replay_stage::Registers;
+	auto stage_start = std::chrono::steady_clock::now();
+
+	const auto end_stage = [&](const replay_stage next_stage) {
+		const auto now = std::chrono::steady_clock::now();
+
+		const std::chrono::duration<double, std::milli> elapsed = now - stage_start;
+		stage_timings[static_cast<size_t>(stage)]->elapsed_ms += elapsed.count();
+
+		stage       = next_stage;
+		stage_start = now;
+	};
+
+	auto num_swaps = v->num_swaps;
+
+	for (const auto& entry : stream.entries) {
+		if (const auto entry_stage = get_replay_stage(entry);
+		    entry_stage != stage) {
+			end_stage(entry_stage);
+		}
+		++stage_timings[static_cast<size_t>(stage)]->num_writes;
+
+		if (entry.type == VoodooStreamEntryType::InitEnable) {
+			voodoo_set_init_enable(entry.data);
+		} else {
+			voodoo_w(entry.offset << 2, entry.data, entry.mask);
+		}
+
+		if (v->num_swaps != num_swaps) {
+			num_swaps = v->num_swaps;
+
+			// Don't count the hashing towards the stage
+			end_stage(stage);
+			result.frame_hashes.push_back(hash_front_buffer(v));
+			stage_start = std::chrono::steady_clock::now();
+		}
+	}
+
+	// Count waiting for the last primitives as part of the swaps
+	end_stage(replay_stage::Swaps);
+	raster_worker_flush(v->rworker);
+	end_stage(replay_stage::Swaps);
+
+	for (const auto timing : stage_timings) {
+		result.elapsed_ms += timing->elapsed_ms;
+	}
+
+	result.buffer_hash = fnv1a_hash(FnvOffsetBasis, v->fbi.ram, v->fbi.mask + 1);
+
+	if (v->draw.screen_update_pending) {
+		PIC_RemoveEvents(Voodoo_CheckScreenUpdate);
+	}
+
+	raster_worker_shutdown(v->rworker);
+	delete v;
+	v = nullptr;
+
+	vtype = prev_vtype;
+
+	return result;
 }
 
 void VOODOO_AddConfigSection(const ConfigPtr& conf)
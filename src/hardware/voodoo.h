@@ -4,8 +4,92 @@
 #ifndef DOSBOX_VOODOO_H
 #define DOSBOX_VOODOO_H
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
 #include "control.h"
 
+struct VoodooRegisterStream;
+
 void VOODOO_AddConfigSection(const ConfigPtr& conf);
 
+enum class VoodooBenchmarkScene {
+	Textured,
+	TexturedWBuffered,
+	Gouraud,
+	AlphaBlended,
+};
+
+struct VoodooBenchmarkOptions {
+	int num_frames  = 1;
+	int num_threads = 1;
+
+	bool use_specialised_rasterizers = true;
+	bool use_simd_rasterizers        = true;
+	bool use_texture_cache           = true;
+
+	VoodooBenchmarkScene scene = VoodooBenchmarkScene::Textured;
+
+	// Also record the benchmark to this register stream file, if set
+	std::string record_path = {};
+};
+
+struct VoodooBenchmarkResult {
+	int num_triangles    = 0;
+	int64_t num_generic  = 0;
+	int64_t pixels_out   = 0;
+	int64_t zfunc_fail   = 0;
+	int64_t afunc_fail   = 0;
+	double elapsed_ms    = 0.0;
+
+	// Textured triangles whose texture was already decoded, and those that
+	// needed at least one page of texture RAM decoding first
+	int64_t tex_cache_hits   = 0;
+	int64_t tex_cache_misses = 0;
+
+	// Hash of the frame and depth buffers after the last frame
+	uint64_t buffer_hash = 0;
+};
+
+// Draws frames of random triangles in one of a few common pipeline states
+// with a standalone Voodoo instance that isn't attached to the PCI bus, to
+// benchmark and compare the software rasterizers. Must not be called while
+// the emulated card is active.
+VoodooBenchmarkResult VOODOO_RunRasterizerBenchmark(const VoodooBenchmarkOptions& options);
+
+struct VoodooReplayStageTiming {
+	int64_t num_writes = 0;
+	double elapsed_ms  = 0.0;
+};
+
+struct VoodooReplayResult {
+	int64_t num_entries = 0;
+
+	// Emulated duration of the recording, and how long the replay took
+	double emulated_ms = 0.0;
+	double elapsed_ms  = 0.0;
+
+	// Register writes, including triangle setup and dispatch
+	VoodooReplayStageTiming registers = {};
+
+	VoodooReplayStageTiming lfb      = {};
+	VoodooReplayStageTiming textures = {};
+
+	// Buffer swaps, which wait for the rasterizer to finish the frame
+	VoodooReplayStageTiming swaps = {};
+
+	// Hash of the visible front buffer after each swap
+	std::vector<uint64_t> frame_hashes = {};
+
+	// Hash of the frame and depth buffers at the end
+	uint64_t buffer_hash = 0;
+};
+
+// Feeds a recorded register stream into a standalone Voodoo instance as fast
+// as possible, timing each stage and hashing every frame. Must not be called
+// while the emulated card is active.
+VoodooReplayResult VOODOO_ReplayRegisterStream(const VoodooRegisterStream& stream,
+                                               const int num_threads);
+
 #endif // DOSBOX_VOODOO_H
@@ -0,0 +1,287 @@
+// SPDX-FileCopyrightText:  2025-2025 The DOSBox Staging Team
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "voodoo_register_stream.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+
+#include "checks.h"
+#include "dosbox.h"
+#include "logging.h"
+#include "mem_host.h"
+#include "support.h"
+
+CHECK_NARROWING();
+
+constexpr uint8_t Magic[]   = {'V', 'D', 'R', 'S'};
+constexpr uint16_t Version  = 1;
+constexpr size_t HeaderSize = sizeof(Magic) + 4;
+
+constexpr uint8_t FlagBilinearFiltering = 1 << 0;
+
+// Write the buffered entries out in chunks of about this size
+constexpr size_t FlushThreshold = 64 * 1024;
+
+VoodooStreamWriter::VoodooStreamWriter(FILE* _file, const VoodooStreamHeader& header)
+        : file(_file)
+{
+	assert(file);
+
+	buffer.reserve(FlushThreshold + 32);
+	buffer.insert(buffer.end(), std::begin(Magic), std::end(Magic));
+
+	buffer.push_back(static_cast<uint8_t>(Version & 0xff));
+	buffer.push_back(static_cast<uint8_t>(Version >> 8));
+	buffer.push_back(static_cast<uint8_t>(header.model));
+	buffer.push_back(header.bilinear_filtering ? FlagBilinearFiltering : 0);
+}
+
+VoodooStreamWriter::~VoodooStreamWriter()
+{
+	Flush();
+	fclose(file);
+
+	LOG_MSG("CAPTURE: Stopped capturing Voodoo register stream, %lld entries written",
+	        static_cast<long long>(num_entries));
+}
+
+void VoodooStreamWriter::AddWrite(const double time_ms, const uint32_t offset,
+                                  const uint32_t data, const uint32_t mask)
+{
+	const auto is_masked = (mask != 0xffffffff);
+
+	AddEntryStart(is_masked ? VoodooStreamEntryType::MaskedWrite
+	                        : VoodooStreamEntryType::Write,
+	              time_ms);
+	AddVarint(offset);
+	AddUint32(data);
+	if (is_masked) {
+		AddUint32(mask);
+	}
+}
+
+void VoodooStreamWriter::AddInitEnable(const double time_ms, const uint32_t value)
+{
+	AddEntryStart(VoodooStreamEntryType::InitEnable, time_ms);
+	AddVarint(value);
+}
+
+void VoodooStreamWriter::AddEntryStart(const VoodooStreamEntryType type,
+                                       const double time_ms)
+{
+	if (buffer.size() >= FlushThreshold) {
+		Flush();
+	}
+	if (!start_ms) {
+		start_ms = time_ms;
+	}
+
+	// Store the time relative to the first entry, and clamp it so the
+	// deltas never go negative
+	const auto time_us = static_cast<uint64_t>(
+	        std::llround(std::max(0.0, (time_ms - *start_ms) * 1000.0)));
+
+	const auto delta_us = (time_us > last_time_us) ? time_us - last_time_us : 0;
+	last_time_us += delta_us;
+
+	buffer.push_back(static_cast<uint8_t>(type));
+	AddVarint(delta_us);
+
+	++num_entries;
+}
+
+void VoodooStreamWriter::AddVarint(uint64_t value)
+{
+	while (value >= 0x80) {
+		buffer.push_back(static_cast<uint8_t>((value & 0x7f) | 0x80));
+		value >>= 7;
+	}
+	buffer.push_back(static_cast<uint8_t>(value));
+}
+
+void VoodooStreamWriter::AddUint32(const uint32_t value)
+{
+	const auto pos = buffer.size();
+	buffer.resize(pos + sizeof(value));
+	host_writed(&buffer[pos], value);
+}
+
+void VoodooStreamWriter::Flush()
+{
+	if (buffer.empty()) {
+		return;
+	}
+	if (fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+		LOG_WARNING("CAPTURE: Failed writing Voodoo register stream");
+	}
+	buffer.clear();
+}
+
+namespace {
+
+class StreamDecoder {
+public:
+	StreamDecoder(const std::vector<uint8_t>& _data, const size_t start_pos)
+	        : data(_data),
+	          pos(start_pos)
+	{}
+
+	size_t GetPos() const
+	{
+		return pos;
+	}
+
+	bool IsAtEnd() const
+	{
+		return pos >= data.size();
+	}
+
+	std::optional<uint8_t> ReadUint8()
+	{
+		if (pos + 1 > data.size()) {
+			return {};
+		}
+		return data[pos++];
+	}
+
+	std::optional<uint32_t> ReadUint32()
+	{
+		if (pos + sizeof(uint32_t) > data.size()) {
+			return {};
+		}
+		const auto value = host_readd(&data[pos]);
+		pos += sizeof(uint32_t);
+		return value;
+	}
+
+	std::optional<uint64_t> ReadVarint()
+	{
+		uint64_t value = 0;
+		for (auto shift = 0; shift < 64; shift += 7) {
+			const auto byte = ReadUint8();
+			if (!byte) {
+				return {};
+			}
+			value |= static_cast<uint64_t>(*byte & 0x7f) << shift;
+			if ((*byte & 0x80) == 0) {
+				return value;
+			}
+		}
+		return {};
+	}
+
+private:
+	const std::vector<uint8_t>& data;
+	size_t pos = 0;
+};
+
+} // namespace
+
+static std::optional<VoodooStreamEntry> decode_entry(StreamDecoder& decoder,
+                                                     uint64_t& time_us)
+{
+	const auto type_byte = decoder.ReadUint8();
+	const auto delta_us  = decoder.ReadVarint();
+	if (!type_byte || !delta_us) {
+		return {};
+	}
+	time_us += *delta_us;
+
+	VoodooStreamEntry entry = {};
+	entry.type    = static_cast<VoodooStreamEntryType>(*type_byte);
+	entry.time_us = time_us;
+
+	switch (entry.type) {
+	case VoodooStreamEntryType::Write:
+	case VoodooStreamEntryType::MaskedWrite: {
+		const auto offset = decoder.ReadVarint();
+		const auto data   = decoder.ReadUint32();
+		if (!offset || !data || *offset > UINT32_MAX) {
+			return {};
+		}
+		entry.offset = static_cast<uint32_t>(*offset);
+		entry.data   = *data;
+
+		if (entry.type == VoodooStreamEntryType::MaskedWrite) {
+			const auto mask = decoder.ReadUint32();
+			if (!mask) {
+				return {};
+			}
+			entry.mask = *mask;
+		}
+		return entry;
+	}
+	case VoodooStreamEntryType::InitEnable: {
+		const auto value = decoder.ReadVarint();
+		if (!value || *value > UINT32_MAX) {
+			return {};
+		}
+		entry.data = static_cast<uint32_t>(*value);
+		return entry;
+	}
+	}
+	return {};
+}
+
+std::optional<VoodooRegisterStream> VOODOO_LoadRegisterStream(const std_fs::path& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		LOG_WARNING("VOODOO: Can't open register stream '%s'",
+		            path.string().c_str());
+		return {};
+	}
+
+	const std::vector<uint8_t> data(std::istreambuf_iterator<char>(file), {});
+
+	if (data.size() < HeaderSize || !std::equal(std::begin(Magic),
+	                                            std::end(Magic),
+	                                            data.begin())) {
+		LOG_WARNING("VOODOO: '%s' isn't a Voodoo register stream",
+		            path.string().c_str());
+		return {};
+	}
+
+	const auto version = static_cast<uint16_t>(data[4] | (data[5] << 8));
+	const auto model   = data[6];
+	const auto flags   = data[7];
+
+	if (version != Version ||
+	    model > static_cast<uint8_t>(VoodooStreamModel::Voodoo1Dtmu)) {
+		LOG_WARNING("VOODOO: Unsupported register stream version %d in '%s'",
+		            version,
+		            path.string().c_str());
+		return {};
+	}
+
+	VoodooRegisterStream stream = {};
+
+	stream.header.model = static_cast<VoodooStreamModel>(model);
+	stream.header.bilinear_filtering = (flags & FlagBilinearFiltering) != 0;
+
+	// Most entries take 7 to 11 bytes
+	stream.entries.reserve(data.size() / 7);
+
+	StreamDecoder decoder(data, HeaderSize);
+
+	uint64_t time_us = 0;
+	while (!decoder.IsAtEnd()) {
+		const auto entry_pos = decoder.GetPos();
+
+		const auto entry = decode_entry(decoder, time_us);
+		if (!entry) {
+			LOG_WARNING("VOODOO: Register stream '%s' is truncated or corrupt "
+			            "at byte %zu, replaying the %zu entries before it",
+			            path.string().c_str(),
+			            entry_pos,
+			            stream.entries.size());
+			break;
+		}
+		stream.entries.push_back(*entry);
+	}
+	return stream;
+}
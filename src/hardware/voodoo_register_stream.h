@@ -0,0 +1,120 @@
+// SPDX-FileCopyrightText:  2025-2025 The DOSBox Staging Team
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#ifndef DOSBOX_VOODOO_REGISTER_STREAM_H
+#define DOSBOX_VOODOO_REGISTER_STREAM_H
+
+/*  Voodoo Register Stream
+ *  ----------------------
+ *  A compact binary recording of everything the guest sends to the 3dfx
+ *  Voodoo card: register writes (which include the triangle, fastfill and
+ *  buffer swap commands), linear frame buffer writes, texture uploads, and
+ *  changes to the PCI initEnable register. Every entry is tagged with the
+ *  emulated time it was made at.
+ *
+ *  Recording starts when the card is first brought up, so feeding the stream
+ *  into a freshly initialised Voodoo reproduces the same frames without the
+ *  rest of the emulator or the game that produced them. Reads aren't
+ *  recorded as they don't affect what's drawn.
+ *
+ *  File layout (all fixed-size values are little-endian):
+ *
+ *    header:   "VDRS" magic, uint16 version, uint8 model, uint8 flags
+ *    entries:  uint8 type, varint time delta in microseconds, then
+ *                Write:        varint offset, uint32 data
+ *                MaskedWrite:  varint offset, uint32 data, uint32 mask
+ *                InitEnable:   varint value
+ *
+ *  Offsets are in 32-bit words from the start of the card's memory window,
+ *  as decoded by voodoo_w(). Varints are LEB128 encoded, so most register
+ *  writes take 7 bytes.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <vector>
+
+#include "std_filesystem.h"
+
+enum class VoodooStreamModel : uint8_t {
+	// 4 MB, one TMU
+	Voodoo1 = 0,
+	// 12 MB, two TMUs
+	Voodoo1Dtmu = 1,
+};
+
+struct VoodooStreamHeader {
+	VoodooStreamModel model = VoodooStreamModel::Voodoo1;
+
+	bool bilinear_filtering = true;
+};
+
+enum class VoodooStreamEntryType : uint8_t {
+	Write       = 0,
+	MaskedWrite = 1,
+	InitEnable  = 2,
+};
+
+struct VoodooStreamEntry {
+	VoodooStreamEntryType type = VoodooStreamEntryType::Write;
+
+	// Emulated time since the start of the recording
+	uint64_t time_us = 0;
+
+	// Word offset of the register, LFB or texture write
+	uint32_t offset = 0;
+
+	// Data of the write, or the new initEnable value
+	uint32_t data = 0;
+	uint32_t mask = 0xffffffff;
+};
+
+struct VoodooRegisterStream {
+	VoodooStreamHeader header = {};
+
+	std::vector<VoodooStreamEntry> entries = {};
+};
+
+class VoodooStreamWriter {
+public:
+	// Takes ownership of the file and writes the stream header to it
+	VoodooStreamWriter(FILE* file, const VoodooStreamHeader& header);
+	~VoodooStreamWriter();
+
+	VoodooStreamWriter(const VoodooStreamWriter&)            = delete;
+	VoodooStreamWriter& operator=(const VoodooStreamWriter&) = delete;
+
+	void AddWrite(const double time_ms, const uint32_t offset,
+	              const uint32_t data, const uint32_t mask);
+
+	void AddInitEnable(const double time_ms, const uint32_t value);
+
+	int64_t GetNumEntries() const
+	{
+		return num_entries;
+	}
+
+private:
+	void AddEntryStart(const VoodooStreamEntryType type, const double time_ms);
+	void AddVarint(uint64_t value);
+	void AddUint32(const uint32_t value);
+	void Flush();
+
+	FILE* file = nullptr;
+
+	std::vector<uint8_t> buffer = {};
+
+	std::optional<double> start_ms = {};
+	uint64_t last_time_us          = 0;
+
+	int64_t num_entries = 0;
+};
+
+// Loads and decodes a whole register stream into memory, so replaying it
+// isn't held up by disk reads. Logs a warning and returns nothing if the
+// file can't be read or isn't a register stream. A truncated last entry, as
+// left behind by a crash, is dropped.
+std::optional<VoodooRegisterStream> VOODOO_LoadRegisterStream(const std_fs::path& path);
+
+#endif // DOSBOX_VOODOO_REGISTER_STREAM_H
@@ -3,6 +3,7 @@
 
 #include "zmbv.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstdio>
@@ -14,6 +15,8 @@
 #include "support.h"
 #include "checks.h"
 
+#include "simde/x86/sse2.h"
+
 CHECK_NARROWING();
 
 constexpr uint8_t DBZV_VERSION_HIGH = 0;
@@ -26,11 +29,25 @@ constexpr uint8_t Mask_DeltaPalette = 0x02;
 
 // Compression flags
 constexpr uint8_t COMPRESSION_ZLIB     = 1;
-constexpr int ZLIB_COMPRESSION_LEVEL   = 6;          // 0 to 9 (0 = no compression)
 constexpr auto ZLIB_COMPRESSION_METHOD = Z_DEFLATED; // currently the only option
+constexpr int ZLIB_WINDOW_BITS         = 15;         // 8 to 15 (32 KB window)
 constexpr int ZLIB_MEM_LEVEL           = 9;          // 1 to 9 (default 8)
-constexpr auto ZLIB_STRATEGY           = Z_FILTERED; // Z_DEFAULT_STRATEGY, Z_FILTERED,
-                                                     // Z_HUFFMAN_ONLY, Z_RLE, Z_FIXED
+
+struct ZlibSettings {
+	int level    = 0; // 0 to 9 (0 = no compression)
+	int strategy = 0; // Z_DEFAULT_STRATEGY, Z_FILTERED, Z_HUFFMAN_ONLY,
+	                  // Z_RLE, Z_FIXED
+};
+
+static ZlibSettings to_zlib_settings(const ZMBV_COMPRESSION compression)
+{
+	switch (compression) {
+	case ZMBV_COMPRESSION::FAST: return {1, Z_FILTERED};
+	case ZMBV_COMPRESSION::BALANCED: return {6, Z_FILTERED};
+	case ZMBV_COMPRESSION::BEST: return {9, Z_DEFAULT_STRATEGY};
+	}
+	return {6, Z_FILTERED};
+}
 
 ZMBV_FORMAT BPPFormat(const int bpp)
 {
@@ -102,6 +119,8 @@ bool VideoCodec::SetupBuffers(const ZMBV_FORMAT _format, const int blockwidth, c
 
 	const auto blocks_needed = check_cast<uint32_t>(xblocks * yblocks);
 	blocks.resize(blocks_needed);
+	blockVectors.resize(blocks_needed);
+	blocksPerRow = xblocks;
 
 	size_t i = 0;
 	for (auto y = 0; y < yblocks; ++y) {
@@ -163,21 +182,66 @@ int VideoCodec::PossibleBlock(const int vx, const int vy, const FrameBlock & blo
 	return ret;
 }
 
+// Counts the pixels that differ between the new block and the old block
+// displaced by the vector. Compares 16 bytes at a time; only the right edge
+// blocks narrower than a vector fall back to per-pixel comparison.
 template <class P>
 int VideoCodec::CompareBlock(const int vx, const int vy, const FrameBlock & block)
 {
+	constexpr int PixelsPerVector = sizeof(simde__m128i) / sizeof(P);
+
+	// The unused top byte of 32-bit pixels must be ignored
+	const auto pixel_mask = simde_mm_set1_epi32(sizeof(P) == 4 ? 0x00ffffff : -1);
+	const auto zero       = simde_mm_setzero_si128();
+
+	// Each lane counts down by one for every matching pixel. A block has
+	// at most 16 rows of 16 pixels, so even 8-bit lanes can't overflow.
+	auto num_same = simde_mm_setzero_si128();
+	int num_vectors = 0;
 	int diff_count = 0;
+
 	P *pold = reinterpret_cast<P *>(oldframe) + block.start + (vy * pitch) + vx;
 	P *pnew = reinterpret_cast<P *>(newframe) + block.start;
 
 	for (auto y = 0; y < block.dy; y++) {
-		for (auto x = 0; x < block.dx; x++) {
+		auto x = 0;
+		for (; x + PixelsPerVector <= block.dx; x += PixelsPerVector) {
+			const auto old_pixels = simde_mm_loadu_si128(
+			        reinterpret_cast<const simde__m128i *>(pold + x));
+			const auto new_pixels = simde_mm_loadu_si128(
+			        reinterpret_cast<const simde__m128i *>(pnew + x));
+
+			const auto diff = simde_mm_and_si128(
+			        simde_mm_xor_si128(old_pixels, new_pixels), pixel_mask);
+
+			if constexpr (sizeof(P) == 1) {
+				num_same = simde_mm_add_epi8(num_same, simde_mm_cmpeq_epi8(diff, zero));
+			} else if constexpr (sizeof(P) == 2) {
+				num_same = simde_mm_add_epi16(num_same, simde_mm_cmpeq_epi16(diff, zero));
+			} else {
+				num_same = simde_mm_add_epi32(num_same, simde_mm_cmpeq_epi32(diff, zero));
+			}
+			++num_vectors;
+		}
+		for (; x < block.dx; x++) {
 			diff_count += ((pold[x] ^ pnew[x]) & 0x00ffffff) != 0;
 		}
 		pold += pitch;
 		pnew += pitch;
 	}
-	return diff_count;
+	if (num_vectors == 0) {
+		return diff_count;
+	}
+
+	// Sum the negative lane counts
+	alignas(16) P lanes[PixelsPerVector];
+	simde_mm_store_si128(reinterpret_cast<simde__m128i *>(lanes), num_same);
+
+	int same_count = 0;
+	for (const auto lane : lanes) {
+		same_count += static_cast<P>(0 - lane);
+	}
+	return diff_count + num_vectors * PixelsPerVector - same_count;
 }
 
 template <class P>
@@ -200,15 +264,17 @@ void VideoCodec::AlignWork(size_t & offset) {
 	offset = (offset + blocks.size() * 2u + 3u) & ~3u;
 }
 
+// Find the best motion vector for each block in a row of blocks. Only reads
+// the frames, so the tiles can be searched concurrently.
 template <class P>
-void VideoCodec::AddXorFrame()
+void VideoCodec::SearchTile(const int tile)
 {
-	auto vectors = &work[workUsed];
+	const auto first = static_cast<size_t>(tile * blocksPerRow);
+	const auto last  = std::min(first + static_cast<size_t>(blocksPerRow),
+	                            blocks.size());
 
-	AlignWork(workUsed);
-
-	size_t b = 0;
-	for (const auto & block : blocks) {
+	for (auto b = first; b < last; ++b) {
+		const auto & block = blocks[b];
 
 		int8_t bestvx   = 0;
 		int8_t bestvy   = 0;
@@ -232,25 +298,140 @@ void VideoCodec::AddXorFrame()
 				}
 			}
 		}
-		vectors[b * 2 + 0] = static_cast<uint8_t>(left_shift_signed(bestvx, 1));
-		vectors[b * 2 + 1] = static_cast<uint8_t>(left_shift_signed(bestvy, 1));
-		if (bestchange) {
+		blockVectors[b] = {bestvx, bestvy, bestchange != 0};
+	}
+}
+
+template <class P>
+void VideoCodec::AddXorFrame()
+{
+	SearchAllTiles(&VideoCodec::SearchTile<P>);
+
+	auto vectors = &work[workUsed];
+
+	AlignWork(workUsed);
+
+	// Writing the vectors and the XOR data is sequential by nature
+	size_t b = 0;
+	for (const auto & block : blocks) {
+		const auto & v = blockVectors[b];
+
+		vectors[b * 2 + 0] = static_cast<uint8_t>(left_shift_signed(v.vx, 1));
+		vectors[b * 2 + 1] = static_cast<uint8_t>(left_shift_signed(v.vy, 1));
+		if (v.changed) {
 			vectors[b * 2 + 0] |= 1;
-			AddXorBlock<P>(bestvx, bestvy, block);
+			AddXorBlock<P>(v.vx, v.vy, block);
 		}
 		++b;
 	}
 }
 
-bool VideoCodec::SetupCompress(const int _width, const int _height)
+void VideoCodec::StartSearchWorkers()
+{
+	if (!search.workers.empty()) {
+		return;
+	}
+
+	// The compressing thread searches too, so a few helpers are plenty;
+	// the deflate step that follows is single-threaded anyway.
+	constexpr unsigned MaxHelpers = 3;
+
+	const auto num_cpus = std::thread::hardware_concurrency();
+	const auto num_helpers = num_cpus > 2 ? std::min(num_cpus - 2, MaxHelpers) : 0;
+
+	search.should_quit = false;
+	for (unsigned i = 0; i < num_helpers; ++i) {
+		search.workers.emplace_back(&VideoCodec::SearchWorkerLoop, this);
+		set_thread_name(search.workers.back(), "dosbox:zmbv");
+	}
+}
+
+void VideoCodec::StopSearchWorkers()
+{
+	{
+		std::lock_guard lock(search.mutex);
+		search.should_quit = true;
+	}
+	search.start.notify_all();
+
+	for (auto & worker : search.workers) {
+		worker.join();
+	}
+	search.workers.clear();
+}
+
+void VideoCodec::RunSearchTiles()
+{
+	while (true) {
+		const auto tile = search.next_tile.fetch_add(1);
+		if (tile >= search.num_tiles) {
+			break;
+		}
+		(this->*search.search_tile)(tile);
+	}
+}
+
+void VideoCodec::SearchWorkerLoop()
+{
+	uint32_t last_generation = 0;
+
+	std::unique_lock lock(search.mutex);
+	while (true) {
+		search.start.wait(lock, [&] {
+			return search.should_quit || search.generation != last_generation;
+		});
+		if (search.should_quit) {
+			return;
+		}
+		last_generation = search.generation;
+
+		lock.unlock();
+		RunSearchTiles();
+		lock.lock();
+
+		if (--search.num_busy == 0) {
+			search.done.notify_one();
+		}
+	}
+}
+
+void VideoCodec::SearchAllTiles(void (VideoCodec::*search_tile)(int))
+{
+	search.search_tile = search_tile;
+	search.num_tiles   = check_cast<int>(blocks.size()) / blocksPerRow;
+	search.next_tile   = 0;
+
+	if (search.workers.empty()) {
+		RunSearchTiles();
+		return;
+	}
+
+	{
+		std::lock_guard lock(search.mutex);
+		search.num_busy = check_cast<int>(search.workers.size());
+		++search.generation;
+	}
+	search.start.notify_all();
+
+	RunSearchTiles();
+
+	// Wait until the helpers are done with their last tiles
+	std::unique_lock lock(search.mutex);
+	search.done.wait(lock, [&] { return search.num_busy == 0; });
+}
+
+bool VideoCodec::SetupCompress(const int _width, const int _height, const ZMBV_COMPRESSION compression)
 {
 	width  = _width;
 	height = _height;
 	pitch  = _width + 2 * MAX_VECTOR;
 	format = ZMBV_FORMAT::NONE;
-	if (deflateInit2(&zstream, ZLIB_COMPRESSION_LEVEL, ZLIB_COMPRESSION_METHOD, ZLIB_MEM_LEVEL, ZLIB_MEM_LEVEL, ZLIB_STRATEGY) !=
+
+	const auto zlib = to_zlib_settings(compression);
+	if (deflateInit2(&zstream, zlib.level, ZLIB_COMPRESSION_METHOD, ZLIB_WINDOW_BITS, ZLIB_MEM_LEVEL, zlib.strategy) !=
 	    Z_OK)
 		return false;
+	StartSearchWorkers();
 	return true;
 }
 
@@ -592,3 +773,8 @@ VideoCodec::VideoCodec()
 	CreateVectorTable();
 	memset(&zstream, 0, sizeof(zstream));
 }
+
+VideoCodec::~VideoCodec()
+{
+	StopSearchWorkers();
+}
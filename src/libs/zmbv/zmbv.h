@@ -4,7 +4,11 @@
 #ifndef DOSBOX_ZMBV_H
 #define DOSBOX_ZMBV_H
 
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include "config.h"
@@ -37,6 +41,13 @@ enum class ZMBV_FORMAT : uint8_t {
 	BPP_32 = 0x08,
 };
 
+// Trade-off between encoding speed and file size
+enum class ZMBV_COMPRESSION : uint8_t {
+	FAST,
+	BALANCED,
+	BEST,
+};
+
 void Msg(const char fmt[], ...);
 
 class VideoCodec {
@@ -67,6 +78,30 @@ private:
 		uint8_t *writeBuf = nullptr;
 	};
 
+	// Result of the motion search for a single block
+	struct BlockVector {
+		int8_t vx = 0;
+		int8_t vy = 0;
+		bool changed = false;
+	};
+
+	// The motion search is split into tiles (rows of blocks) that are
+	// handed out to a small pool of worker threads. The thread compressing
+	// the frame works on the tiles too, then waits for the workers.
+	struct MotionSearch {
+		std::vector<std::thread> workers = {};
+		std::mutex mutex = {};
+		std::condition_variable start = {};
+		std::condition_variable done = {};
+		uint32_t generation = 0;
+		int num_busy = 0;
+		bool should_quit = false;
+
+		void (VideoCodec::*search_tile)(int) = nullptr;
+		std::atomic<int> next_tile = 0;
+		int num_tiles = 0;
+	};
+
 
 	static constexpr uint8_t keyframeHeaderBytes = {sizeof(KeyframeHeader)};
 
@@ -81,6 +116,8 @@ private:
 	uint32_t bufsize = 0;
 
 	std::vector<FrameBlock> blocks = {};
+	std::vector<BlockVector> blockVectors = {};
+	int blocksPerRow = 0;
 	size_t workUsed = 0;
 	size_t workPos = 0;
 
@@ -95,6 +132,8 @@ private:
 	Compress compress = {};
 	z_stream zstream = {};
 
+	MotionSearch search = {};
+
 	// methods
 	void CreateVectorTable();
 	bool SetupBuffers(ZMBV_FORMAT format, int blockwidth, int blockheight);
@@ -102,6 +141,8 @@ private:
 	template <class P>
 	void AddXorFrame();
 	template <class P>
+	void SearchTile(int tile);
+	template <class P>
 	void UnXorFrame();
 	template <class P>
 	int PossibleBlock(int vx, int vy, const FrameBlock & block);
@@ -116,13 +157,21 @@ private:
 
 	void AlignWork(size_t & offset);
 
+	void StartSearchWorkers();
+	void StopSearchWorkers();
+	void SearchWorkerLoop();
+	void RunSearchTiles();
+	void SearchAllTiles(void (VideoCodec::*search_tile)(int));
+
 public:
 	VideoCodec();
+	~VideoCodec();
 
 	VideoCodec(const VideoCodec &) = delete;            // prevent copy
 	VideoCodec &operator=(const VideoCodec &) = delete; // prevent assignment
 
-	bool SetupCompress(int _width, int _height);
+	bool SetupCompress(int _width, int _height,
+	                   ZMBV_COMPRESSION compression = ZMBV_COMPRESSION::BALANCED);
 	bool SetupDecompress(int _width, int _height);
 	ZMBV_FORMAT BPPFormat(int bpp);
 	int NeededSize(int _width, int _height, ZMBV_FORMAT _format);
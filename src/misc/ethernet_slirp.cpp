@@ -4,6 +4,9 @@
 #include "config.h"
 
 #include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
 #include <map>
 #include <stdexcept>
 
@@ -11,11 +14,17 @@
 #include <sys/socket.h> // AF_INET
 #endif
 
+#ifndef WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #include "dosbox.h"
 #include "dynlib.h"
 #include "ethernet_slirp.h"
 #include "setup.h"
 #include "string_utils.h"
+#include "support.h"
 #include "timer.h"
 
 /**
@@ -191,8 +200,27 @@ SlirpEthernetConnection::SlirpEthernetConnection()
 
 SlirpEthernetConnection::~SlirpEthernetConnection()
 {
+	StopIoThread();
+
 	if (slirp)
 		LibSlirp::slirp_cleanup(slirp);
+
+#ifndef WIN32
+	for (auto& fd : wakeup_fds) {
+		if (fd >= 0) {
+			close(fd);
+			fd = -1;
+		}
+	}
+#endif
+
+	if (num_rx_frames || num_tx_frames) {
+		LOG_MSG("SLIRP: Received %llu frames (%llu dropped), sent %llu frames (%llu dropped)",
+		        static_cast<unsigned long long>(num_rx_frames),
+		        static_cast<unsigned long long>(num_rx_dropped),
+		        static_cast<unsigned long long>(num_tx_frames),
+		        static_cast<unsigned long long>(num_tx_dropped));
+	}
 }
 
 bool SlirpEthernetConnection::Initialize(Section *dosbox_config)
@@ -225,6 +253,7 @@ bool SlirpEthernetConnection::Initialize(Section *dosbox_config)
 	constexpr auto ethernet_frame_size = 14 + 1500; // header + payload
 	config.if_mtu = ethernet_frame_size;
 	config.if_mru = ethernet_frame_size;
+	static_assert(ethernet_frame_size <= sizeof(slirp_frame::data));
 
 	config.enable_emu = false; // buggy - keep this at false
 	config.in_enabled = true;
@@ -267,6 +296,21 @@ bool SlirpEthernetConnection::Initialize(Section *dosbox_config)
 		ClearPortForwards(is_udp, forwarded_udp_ports);
 		forwarded_udp_ports = SetupPortForwards(is_udp, section->GetString("udp_port_forwards"));
 
+#ifndef WIN32
+		if (pipe(wakeup_fds) != 0) {
+			LOG_ERR("SLIRP: Failed to create the I/O thread's wakeup pipe: %s",
+			        safe_strerror(errno).c_str());
+			return false;
+		}
+		for (const auto fd : wakeup_fds) {
+			fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+		}
+#endif
+		// From here on libslirp is only touched by the I/O thread
+		is_running = true;
+		io_thread = std::thread(&SlirpEthernetConnection::IoLoop, this);
+		set_thread_name(io_thread, "dosbox:slirp");
+
 		LOG_MSG("SLIRP: Successfully initialized");
 		return true;
 	} else {
@@ -418,19 +462,108 @@ void SlirpEthernetConnection::SendPacket(const uint8_t *packet, int len)
 		            len, GetMTU());
 		return;
 	}
-	LibSlirp::slirp_input(slirp, packet, len);
+
+	slirp_frame frame = {};
+	std::memcpy(frame.data.data(), packet, static_cast<size_t>(len));
+	frame.len = len;
+
+	if (tx_frames.Push(frame)) {
+		++num_tx_frames;
+		WakeIoThread();
+	} else {
+		++num_tx_dropped;
+	}
+}
+
+size_t SlirpEthernetConnection::PeekPackets(EthernetPacket *packets, size_t max_packets)
+{
+	// The frames are read in place; the I/O thread can't reuse their
+	// slots until they're released
+	size_t num_packets = 0;
+	while (num_packets < max_packets) {
+		const auto frame = rx_frames.Peek(num_packets);
+		if (!frame)
+			break;
+		packets[num_packets++] = {frame->data.data(), frame->len};
+	}
+	return num_packets;
+}
+
+void SlirpEthernetConnection::ReleasePackets(size_t num_packets)
+{
+	assert(num_packets <= rx_frames.Size());
+	rx_frames.Pop(num_packets);
+}
+
+void SlirpEthernetConnection::InputQueuedFrames()
+{
+	while (const auto frame = tx_frames.Front()) {
+		LibSlirp::slirp_input(slirp, frame->data.data(), frame->len);
+		tx_frames.Pop();
+	}
+}
+
+void SlirpEthernetConnection::IoLoop()
+{
+	// libslirp and the pending timers shorten this as needed. Windows
+	// has no wakeup pipe, so there we come back quickly to pick up the
+	// frames queued by SendPacket.
+#ifndef WIN32
+	constexpr uint32_t MaxPollTimeoutMs = 100;
+#else
+	constexpr uint32_t MaxPollTimeoutMs = 1;
+#endif
+
+	while (is_running) {
+		InputQueuedFrames();
+
+		uint32_t timeout_ms = TimersGetTimeoutMs(MaxPollTimeoutMs);
+		PollsClear();
+#ifndef WIN32
+		PollAdd(wakeup_fds[0], SLIRP_POLL_IN);
+#endif
+		PollsAddRegistered();
+		LibSlirp::slirp_pollfds_fill(slirp, &timeout_ms, db_slirp_add_poll, this);
+
+		const bool poll_failed = !PollsPoll(timeout_ms);
+		DrainWakeups();
+
+		LibSlirp::slirp_pollfds_poll(slirp, poll_failed, db_slirp_get_revents, this);
+		TimersRun();
+
+		// select() fails straight away if there's nothing to wait on,
+		// so don't let that turn into a busy loop
+		if (poll_failed) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+}
+
+void SlirpEthernetConnection::WakeIoThread()
+{
+#ifndef WIN32
+	// A full pipe means a wakeup is already pending, so failing is fine
+	const uint8_t byte = 0;
+	[[maybe_unused]] const auto ret = write(wakeup_fds[1], &byte, sizeof(byte));
+#endif
+}
+
+void SlirpEthernetConnection::DrainWakeups()
+{
+#ifndef WIN32
+	uint8_t buf[64];
+	while (read(wakeup_fds[0], buf, sizeof(buf)) > 0) {
+	}
+#endif
 }
 
-void SlirpEthernetConnection::GetPackets(std::function<int(const uint8_t *, int)> callback)
+void SlirpEthernetConnection::StopIoThread()
 {
-	get_packet_callback = callback;
-	uint32_t timeout_ms = 0;
-	PollsClear();
-	PollsAddRegistered();
-	LibSlirp::slirp_pollfds_fill(slirp, &timeout_ms, db_slirp_add_poll, this);
-	const bool poll_failed = !PollsPoll(timeout_ms);
-	LibSlirp::slirp_pollfds_poll(slirp, poll_failed, db_slirp_get_revents, this);
-	TimersRun();
+	if (!io_thread.joinable())
+		return;
+	is_running = false;
+	WakeIoThread();
+	io_thread.join();
 }
 
 int SlirpEthernetConnection::ReceivePacket(const uint8_t *packet, int len)
@@ -443,7 +576,17 @@ int SlirpEthernetConnection::ReceivePacket(const uint8_t *packet, int len)
 		            len, GetMRU());
 		return -1;
 	}
-	return get_packet_callback(packet, len);
+
+	slirp_frame frame = {};
+	std::memcpy(frame.data.data(), packet, static_cast<size_t>(len));
+	frame.len = len;
+
+	if (!rx_frames.Push(frame)) {
+		++num_rx_dropped;
+		return -1;
+	}
+	++num_rx_frames;
+	return len;
 }
 
 struct slirp_timer *SlirpEthernetConnection::TimerNew(SlirpTimerCb cb, void *cb_opaque)
@@ -480,6 +623,18 @@ void SlirpEthernetConnection::TimersRun()
 	}
 }
 
+uint32_t SlirpEthernetConnection::TimersGetTimeoutMs(const uint32_t max_timeout_ms) const
+{
+	const int64_t now = db_slirp_clock_get_ns(nullptr);
+	int64_t timeout_ns = static_cast<int64_t>(max_timeout_ms) * 1'000'000;
+	for (const struct slirp_timer *timer : timers) {
+		if (timer->expires_ns)
+			timeout_ns = std::min(timeout_ns, std::max<int64_t>(timer->expires_ns - now, 0));
+	}
+	// Round up so we don't wake just before the timer is due
+	return static_cast<uint32_t>((timeout_ns + 999'999) / 1'000'000);
+}
+
 void SlirpEthernetConnection::TimersClear()
 {
 	for (auto *timer : timers)
@@ -6,14 +6,18 @@
 
 #include "dosbox.h"
 
+#include <array>
+#include <atomic>
 #include <map>
 #include <deque>
+#include <thread>
 #include <vector>
 
 #include <slirp/libslirp.h>
 
 #include "config.h"
 #include "ethernet.h"
+#include "spsc_queue.h"
 
 /*
  * libslirp really wants a poll() API, so we'll use that when we're
@@ -40,10 +44,25 @@ struct slirp_timer {
 	                              callback */
 };
 
+/** An Ethernet frame in transit between libslirp and the emulated NIC
+ * Sized for the largest frame we allow (14-byte header plus 1500-byte
+ * payload), so the queues never allocate.
+ */
+struct slirp_frame {
+	std::array<uint8_t, 14 + 1500> data = {};
+	int len = 0;
+};
+
 /** A libslirp-based Ethernet connection
  * This backend uses a virtual Ethernet device. Only TCP, UDP and some ICMP
  * work over this interface. This is because libslirp terminates guest
  * connections during routing and passes them to sockets created in the host.
+ *
+ * libslirp runs on its own I/O thread, which sleeps in poll() until a host
+ * socket is ready, a libslirp timer is due, or the guest sends a frame. The
+ * emulation thread never calls into libslirp after initialisation: frames
+ * are handed over in both directions through lock-free queues, so the NIC
+ * only has to drain the receive queue on each tick.
  */
 class SlirpEthernetConnection : public EthernetConnection {
 public:
@@ -57,9 +76,10 @@ public:
 
 	bool Initialize(Section* config) override;
 	void SendPacket(const uint8_t* packet, int len) override;
-	void GetPackets(std::function<int(const uint8_t*, int)> callback) override;
+	size_t PeekPackets(EthernetPacket* packets, size_t max_packets) override;
+	void ReleasePackets(size_t num_packets) override;
 
-	/* Called by libslirp when it has a packet for us */
+	/* Called by libslirp on the I/O thread when it has a packet for us */
 	int ReceivePacket(const uint8_t* packet, int len);
 
 	// Used in callbacks to bounds-check packet lengths
@@ -84,9 +104,19 @@ public:
 	void PollUnregister(int fd);
 
 private:
+	/* The I/O thread's main loop, and the means to interrupt its poll() */
+	void IoLoop();
+	void WakeIoThread();
+	void DrainWakeups();
+	void StopIoThread();
+
+	/* Passes the frames queued by SendPacket on to libslirp */
+	void InputQueuedFrames();
+
 	/* Runs and clears all the timers*/
 	void TimersRun();
 	void TimersClear();
+	uint32_t TimersGetTimeoutMs(uint32_t max_timeout_ms) const;
 
 	void ClearPortForwards(const bool is_udp, std::map<int, int> &existing_port_forwards);
 	std::map<int, int> SetupPortForwards(const bool is_udp, const std::string &port_forward_rules);
@@ -101,15 +131,23 @@ private:
 	SlirpCb slirp_callbacks = {};  /*!< Callbacks used by libslirp */
 	std::deque<struct slirp_timer *> timers = {}; /*!< Stored timers */
 
-	/** The GetPacket callback
-	 * When libslirp has a new packet for us it calls ReceivePacket,
-	 * but the EthernetConnection interface requires users to poll
-	 * for new packets using GetPackets. We temporarily store the
-	 * callback from GetPackets here for ReceivePacket.
-	 * This might seem racy, but keep in mind we control when
-	 * libslirp sends us packets via our polling system.
+	/** Frames queued between the threads
+	 * The I/O thread is the only producer of rx_frames and the only
+	 * consumer of tx_frames; the emulation thread is the other side of
+	 * both. A full queue drops the frame, like a real NIC would.
 	 */
-	std::function<int(const uint8_t *, int)> get_packet_callback = nullptr;
+	static constexpr size_t FrameQueueSize = 128;
+	SpscQueue<slirp_frame, FrameQueueSize> rx_frames = {};
+	SpscQueue<slirp_frame, FrameQueueSize> tx_frames = {};
+
+	std::thread io_thread = {};
+	std::atomic<bool> is_running = false;
+
+	/* Frame counters, reported when the connection is closed */
+	std::atomic<uint64_t> num_rx_frames = 0;
+	std::atomic<uint64_t> num_rx_dropped = 0;
+	uint64_t num_tx_frames = 0;
+	uint64_t num_tx_dropped = 0;
 
 	std::deque<int> registered_fds = {}; /*!< File descriptors to watch */
 
@@ -119,6 +157,9 @@ private:
 
 #ifndef WIN32
 	std::vector<struct pollfd> polls = {}; /*!< Descriptors for poll() */
+
+	/* Self-pipe used to wake the I/O thread when there's a frame to send */
+	int wakeup_fds[2] = {-1, -1};
 #else
 	fd_set readfds = {};   /*!< Read descriptors for select() */
 	fd_set writefds = {};  /*!< Write descriptors for select() */
@@ -13,11 +13,17 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <vector>
 
 #if defined(HAVE_SYS_XATTR_H)
 #include <sys/xattr.h>
 #endif
 
+#if defined(LINUX)
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+
 #include "dos_inc.h"
 #include "logging.h"
 #include "string_utils.h"
@@ -438,6 +444,53 @@ bool truncate_native_file(const NativeFileHandle handle)
 	return ftruncate(handle, current_position) == 0;
 }
 
+bool copy_native_file(const NativeFileHandle src, const NativeFileHandle dst)
+{
+	if (lseek(src, 0, SEEK_SET) < 0 || lseek(dst, 0, SEEK_SET) < 0) {
+		return false;
+	}
+
+#if defined(FICLONE)
+	// On copy-on-write filesystems (such as Btrfs and XFS) the copy can
+	// share the data blocks of the original, so nothing needs copying
+	if (ioctl(dst, FICLONE, src) == 0) {
+		return lseek(src, 0, SEEK_END) >= 0 && lseek(dst, 0, SEEK_END) >= 0;
+	}
+#endif
+
+#if defined(HAVE_COPY_FILE_RANGE)
+	// Otherwise let the kernel copy the data, without passing it through
+	// user space. Falls back to reading and writing when the filesystems
+	// don't support it, carrying on from wherever it stopped.
+	constexpr size_t MaxChunkSize = 1024 * 1024 * 1024;
+	while (true) {
+		const auto num_bytes = copy_file_range(src, nullptr, dst, nullptr, MaxChunkSize, 0);
+		if (num_bytes == 0) {
+			return true;
+		}
+		if (num_bytes < 0) {
+			break;
+		}
+	}
+#endif
+
+	constexpr int64_t BufferSize = 64 * 1024;
+	std::vector<uint8_t> buffer(BufferSize);
+	while (true) {
+		const auto ret = read_native_file(src, buffer.data(), BufferSize);
+		if (ret.error) {
+			return false;
+		}
+		if (ret.num_bytes == 0) {
+			return true;
+		}
+		if (write_native_file(dst, buffer.data(), ret.num_bytes).num_bytes !=
+		    ret.num_bytes) {
+			return false;
+		}
+	}
+}
+
 DosDateTime get_dos_file_time(const NativeFileHandle handle)
 {
 	// Legal defaults if we're unable to populate them
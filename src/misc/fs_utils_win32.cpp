@@ -9,6 +9,7 @@
 #include <fcntl.h>
 #include <io.h>
 #include <sys/stat.h>
+#include <vector>
 
 #include "compiler.h"
 #include "dos_inc.h"
@@ -202,6 +203,30 @@ bool truncate_native_file(const NativeFileHandle handle)
 	return SetEndOfFile(handle);
 }
 
+bool copy_native_file(const NativeFileHandle src, const NativeFileHandle dst)
+{
+	if (seek_native_file(src, 0, NativeSeek::Set) == NativeSeekFailed ||
+	    seek_native_file(dst, 0, NativeSeek::Set) == NativeSeekFailed) {
+		return false;
+	}
+
+	constexpr int64_t BufferSize = 64 * 1024;
+	std::vector<uint8_t> buffer(BufferSize);
+	while (true) {
+		const auto ret = read_native_file(src, buffer.data(), BufferSize);
+		if (ret.error) {
+			return false;
+		}
+		if (ret.num_bytes == 0) {
+			return true;
+		}
+		if (write_native_file(dst, buffer.data(), ret.num_bytes).num_bytes !=
+		    ret.num_bytes) {
+			return false;
+		}
+	}
+}
+
 DosDateTime get_dos_file_time(const NativeFileHandle handle)
 {
 	// Legal defaults if we're unable to populate them
@@ -3,6 +3,7 @@
 
 #include "rwqueue.h"
 
+#include "../capture/capture_video.h"
 #include "../capture/image/image_saver.h"
 
 #include <cassert>
@@ -322,6 +323,7 @@ template class RWQueue<MidiWork>;
 
 #include "render.h"
 template class RWQueue<SaveImageTask>;
+template class RWQueue<VideoFrameTask>;
 
 //PC Speaker
 template class RWQueue<float>;
@@ -1992,6 +1992,8 @@ void Config::ParseArguments()
 	arguments.lang    = cmdline->FindRemoveStringArgument("lang");
 	arguments.machine = cmdline->FindRemoveStringArgument("machine");
 
+	arguments.replay_voodoo = cmdline->FindRemoveStringArgument("replay-voodoo");
+
 	arguments.socket   = cmdline->FindRemoveIntArgument("socket");
 	arguments.wait_pid = cmdline->FindRemoveIntArgument("waitpid");
 
@@ -20,8 +20,12 @@
 
 #include "dos_inc.h"
 
+#include <algorithm>
+#include <fstream>
 #include <iterator>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -29,9 +33,11 @@
 #include "dos_system.h"
 #include "drives.h"
 #include "shell.h"
+#include "std_filesystem.h"
 #include "string_utils.h"
 
 #include "dosbox_test_fixture.h"
+#include "../src/dos/drive_local.h"
 #include "../src/dos/dos_files.cpp"
 
 namespace {
@@ -343,4 +349,238 @@ TEST_F(DOS_FilesTest, VFILE_Register)
 	EXPECT_TRUE(DOS_FindFirst("Z:\\TEST\\FILENA~3.TXT", 0, false));
 }
 
+std::string read_host_file(const std_fs::path& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	return std::string(std::istreambuf_iterator<char>(file), {});
+}
+
+TEST_F(DOS_FilesTest, LocalFile_WriteBehind)
+{
+	const auto dir = std_fs::temp_directory_path() / "dosbox_write_behind_test";
+	std_fs::remove_all(dir);
+	std_fs::create_directory(dir);
+
+	const auto drive = std::make_shared<localDrive>(
+	        (dir.string() + CROSS_FILESPLIT).c_str(), 512, 32, 32765, 16000, 0xf8, false);
+
+	auto file = drive->FileCreate("LOG.TXT", {});
+	ASSERT_TRUE(file);
+	file->AddRef();
+
+	std::string expected = {};
+
+	auto write = [&](std::string data) {
+		auto num_bytes = static_cast<uint16_t>(data.size());
+		EXPECT_TRUE(file->Write(reinterpret_cast<uint8_t*>(data.data()), &num_bytes));
+		EXPECT_EQ(num_bytes, data.size());
+		expected += data;
+	};
+
+	for (auto i = 0; i < 100; ++i) {
+		write("record " + std::to_string(i) + "\r\n");
+	}
+
+	// The small writes are held back, but the position includes them
+	uint32_t pos = 0;
+	EXPECT_TRUE(file->Seek(&pos, DOS_SEEK_CUR));
+	EXPECT_EQ(pos, expected.size());
+	EXPECT_EQ(read_host_file(dir / "LOG.TXT"), "");
+
+	// Committing the file writes them out
+	EXPECT_TRUE(file->Flush());
+	EXPECT_EQ(read_host_file(dir / "LOG.TXT"), expected);
+
+	// Another handle to the same file sees the held back writes
+	write("tail");
+
+	auto reader = drive->FileOpen("LOG.TXT", OPEN_READ);
+	ASSERT_TRUE(reader);
+	reader->AddRef();
+
+	std::string read_back(expected.size(), '\0');
+	auto num_bytes = static_cast<uint16_t>(read_back.size());
+	EXPECT_TRUE(reader->Read(reinterpret_cast<uint8_t*>(read_back.data()), &num_bytes));
+	EXPECT_EQ(read_back, expected);
+	reader->Close();
+
+	// Closing the file writes out the rest
+	write("last");
+	file->Close();
+	EXPECT_EQ(read_host_file(dir / "LOG.TXT"), expected);
+
+	reader.reset();
+	file.reset();
+	std_fs::remove_all(dir);
+}
+
+TEST_F(DOS_FilesTest, LocalFile_WriteBehindOnlyFlushesSameFile)
+{
+	const auto dir = std_fs::temp_directory_path() / "dosbox_write_behind_same_file_test";
+	std_fs::remove_all(dir);
+	std_fs::create_directory(dir);
+	std::ofstream(dir / "DATA.DAT") << "data";
+
+	const auto drive = std::make_shared<localDrive>(
+	        (dir.string() + CROSS_FILESPLIT).c_str(), 512, 32, 32765, 16000, 0xf8, false);
+
+	auto log = drive->FileCreate("LOG.TXT", {});
+	ASSERT_TRUE(log);
+	log->AddRef();
+
+	auto data = drive->FileOpen("DATA.DAT", OPEN_READ);
+	ASSERT_TRUE(data);
+	data->AddRef();
+
+	std::string record = "record\r\n";
+	auto num_bytes = static_cast<uint16_t>(record.size());
+	EXPECT_TRUE(log->Write(reinterpret_cast<uint8_t*>(record.data()), &num_bytes));
+
+	// Reading and seeking another file keeps the log's write held back
+	uint8_t buffer[4] = {};
+	num_bytes         = sizeof(buffer);
+	EXPECT_TRUE(data->Read(buffer, &num_bytes));
+	uint32_t pos = 0;
+	EXPECT_TRUE(data->Seek(&pos, DOS_SEEK_END));
+	EXPECT_EQ(read_host_file(dir / "LOG.TXT"), "");
+
+	data->Close();
+	log->Close();
+	EXPECT_EQ(read_host_file(dir / "LOG.TXT"), record);
+
+	data.reset();
+	log.reset();
+	std_fs::remove_all(dir);
+}
+
+TEST_F(DOS_FilesTest, LocalFile_WriteBehindReportsErrors)
+{
+	const auto dir = std_fs::temp_directory_path() / "dosbox_write_behind_error_test";
+	std_fs::remove_all(dir);
+	std_fs::create_directory(dir);
+	std::ofstream(dir / "LOG.TXT");
+
+	const auto base_dir = dir.string() + CROSS_FILESPLIT;
+	const auto drive    = std::make_shared<localDrive>(
+	        base_dir.c_str(), 512, 32, 32765, 16000, 0xf8, false);
+
+	// A handle the host refuses writes to, as it would on a full disk
+	const auto handle = open_native_file(dir / "LOG.TXT", false);
+	ASSERT_NE(handle, InvalidNativeFileHandle);
+
+	localFile file("LOG.TXT", dir / "LOG.TXT", handle, base_dir.c_str(),
+	               false, drive, {}, OPEN_READWRITE);
+	file.AddRef();
+
+	std::string data = "record\r\n";
+	auto write = [&]() {
+		auto num_bytes = static_cast<uint16_t>(data.size());
+		const auto result = file.Write(reinterpret_cast<uint8_t*>(data.data()),
+		                               &num_bytes);
+		EXPECT_EQ(num_bytes, result ? data.size() : 0);
+		return result;
+	};
+
+	// The write is held back and reported as done, so the failure is
+	// reported by the commit, once
+	EXPECT_TRUE(write());
+	EXPECT_FALSE(file.Flush());
+	EXPECT_TRUE(file.Flush());
+
+	// Or by the next write, if the data was written out in the meantime
+	EXPECT_TRUE(write());
+	file.FlushHeldBackWrites();
+	EXPECT_FALSE(write());
+	EXPECT_EQ(dos.errorcode, DOSERR_ACCESS_DENIED);
+
+	file.Close();
+	std_fs::remove_all(dir);
+}
+
+// Returns the sorted names in a directory, without . and .., as DIR sees them
+std::vector<std::string> list_dos_dir(const std::string& dir)
+{
+	std::vector<std::string> names = {};
+
+	const auto pattern = dir + "\\*.*";
+	FatAttributeFlags attr = FatAttributeFlags::Directory;
+	if (!DOS_FindFirst(pattern.c_str(), attr)) {
+		return names;
+	}
+	do {
+		DOS_DTA::Result result = {};
+		DOS_DTA(dos.dta()).GetResult(result);
+		if (!result.IsDummyDirectory()) {
+			names.emplace_back(result.name);
+		}
+	} while (DOS_FindNext());
+
+	std::sort(names.begin(), names.end());
+	return names;
+}
+
+void create_dos_file(const char* name)
+{
+	uint16_t entry = 0;
+	ASSERT_TRUE(DOS_CreateFile(name, {}, &entry));
+	DOS_CloseFile(entry);
+}
+
+TEST_F(DOS_FilesTest, Overlay_RenameAndUnlinkKeepListingsCurrent)
+{
+	using Names = std::vector<std::string>;
+
+	const auto dir = std_fs::temp_directory_path() / "dosbox_overlay_test";
+	std_fs::remove_all(dir);
+	std_fs::create_directories(dir / "base" / "sub");
+	std_fs::create_directories(dir / "overlay");
+	std::ofstream(dir / "base" / "base.txt") << "base";
+	std::ofstream(dir / "base" / "keep.txt") << "keep";
+	std::ofstream(dir / "base" / "sub" / "subfile.txt") << "sub";
+
+	constexpr auto DriveIndex = 3;
+
+	const auto base_dir    = (dir / "base").string() + CROSS_FILESPLIT;
+	const auto overlay_dir = (dir / "overlay").string() + CROSS_FILESPLIT;
+
+	uint8_t error = 0;
+	Drives.at(DriveIndex) = std::make_shared<Overlay_Drive>(
+	        base_dir.c_str(), overlay_dir.c_str(), 512, 32, 32765, 16000, 0xf8, error);
+	ASSERT_EQ(error, 0);
+
+	// A base file, renamed in its directory, leaves its old name hidden
+	EXPECT_TRUE(DOS_Rename("D:\\BASE.TXT", "D:\\RENAMED.TXT"));
+	EXPECT_EQ(list_dos_dir("D:"), (Names{"KEEP.TXT", "RENAMED.TXT", "SUB"}));
+
+	// An overlay-only file, renamed in the same directory
+	create_dos_file("D:\\NEW.TXT");
+	EXPECT_TRUE(DOS_Rename("D:\\NEW.TXT", "D:\\NEWER.TXT"));
+	EXPECT_EQ(list_dos_dir("D:"),
+	          (Names{"KEEP.TXT", "NEWER.TXT", "RENAMED.TXT", "SUB"}));
+
+	// And across directories
+	EXPECT_TRUE(DOS_Rename("D:\\NEWER.TXT", "D:\\SUB\\MOVED.TXT"));
+	EXPECT_EQ(list_dos_dir("D:"), (Names{"KEEP.TXT", "RENAMED.TXT", "SUB"}));
+	EXPECT_EQ(list_dos_dir("D:\\SUB"), (Names{"MOVED.TXT", "SUBFILE.TXT"}));
+
+	// Unlinking a file in an overlay-only directory keeps the directory
+	// and the rest of the view
+	ASSERT_TRUE(DOS_MakeDir("D:\\ODIR"));
+	create_dos_file("D:\\ODIR\\A.TXT");
+	create_dos_file("D:\\ODIR\\B.TXT");
+	EXPECT_TRUE(DOS_UnlinkFile("D:\\ODIR\\A.TXT"));
+
+	EXPECT_EQ(list_dos_dir("D:\\ODIR"), (Names{"B.TXT"}));
+	EXPECT_EQ(list_dos_dir("D:"),
+	          (Names{"KEEP.TXT", "ODIR", "RENAMED.TXT", "SUB"}));
+	EXPECT_EQ(list_dos_dir("D:\\SUB"), (Names{"MOVED.TXT", "SUBFILE.TXT"}));
+
+	// The base directory itself is unchanged
+	EXPECT_TRUE(std_fs::exists(dir / "base" / "base.txt"));
+	EXPECT_FALSE(std_fs::exists(dir / "base" / "renamed.txt"));
+
+	Drives.at(DriveIndex).reset();
+	std_fs::remove_all(dir);
+}
+
 } // namespace
@@ -22,7 +22,15 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
 #include <string>
+#include <vector>
+
+#include "std_filesystem.h"
+#include "string_utils.h"
 
 std::string run_Set_Label(char const * const input, bool cdrom) {
     char output[32] = { 0 };
@@ -209,4 +217,241 @@ TEST(Set_Label, InvalidCharsEndingDotCD)
     EXPECT_EQ("?*':&@(..", output);
 }
 
+// Returns the short names of a directory's entries, as DIR would see them
+std::vector<std::string> list_cached_dir(DOS_Drive_Cache& cache, const std::string& dir)
+{
+	std::vector<std::string> names = {};
+
+	char path[CROSS_LEN];
+	safe_strcpy(path, dir.c_str());
+
+	uint16_t id = 0;
+	if (!cache.FindFirst(path, id)) {
+		return names;
+	}
+	char* result = nullptr;
+	while (cache.FindNext(id, result)) {
+		names.emplace_back(result);
+	}
+	return names;
+}
+
+bool contains(const std::vector<std::string>& names, const std::string& name)
+{
+	return std::find(names.begin(), names.end(), name) != names.end();
+}
+
+#if defined(HAVE_SYS_INOTIFY_H)
+
+TEST(DOS_Drive_Cache, PicksUpHostChanges)
+{
+	const auto base = std_fs::temp_directory_path() / "dosbox_drive_cache_test";
+	std_fs::remove_all(base);
+	std_fs::create_directories(base / "sub");
+	std::ofstream(base / "a.txt") << "a";
+
+	const auto base_dir = base.string() + CROSS_FILESPLIT;
+	const auto sub_dir  = base_dir + "SUB" + CROSS_FILESPLIT;
+
+	DOS_Drive_Cache cache(base_dir.c_str());
+	ASSERT_TRUE(cache.EnableHostWatching());
+
+	auto names = list_cached_dir(cache, base_dir);
+	EXPECT_TRUE(contains(names, "A.TXT"));
+	EXPECT_FALSE(contains(names, "B.TXT"));
+	EXPECT_TRUE(list_cached_dir(cache, sub_dir).size() == 2); // . and ..
+
+	// Added and removed on the host, without a rescan
+	std::ofstream(base / "b.txt") << "b";
+	std::ofstream(base / "sub" / "c.txt") << "c";
+	std_fs::remove(base / "a.txt");
+
+	names = list_cached_dir(cache, base_dir);
+	EXPECT_FALSE(contains(names, "A.TXT"));
+	EXPECT_TRUE(contains(names, "B.TXT"));
+	EXPECT_TRUE(contains(list_cached_dir(cache, sub_dir), "C.TXT"));
+
+	// Cached details are dropped when the file changes
+	const auto b_path = base_dir + "B.TXT";
+
+	DOS_Drive_Cache::FileDetails details = {};
+	details.size = 1;
+	cache.SetFileDetails(b_path.c_str(), details);
+	EXPECT_TRUE(cache.GetFileDetails(b_path.c_str(), details));
+
+	std::ofstream(base / "b.txt", std::ios::app) << "more";
+	list_cached_dir(cache, base_dir);
+	EXPECT_FALSE(cache.GetFileDetails(b_path.c_str(), details));
+
+	std_fs::remove_all(base);
+}
+
+#endif
+
+// A directory like the ones some games install from CD-ROM, with thousands
+// of files that all need generated short names
+std_fs::path make_large_dir(const int num_files)
+{
+	const auto base = std_fs::temp_directory_path() / "dosbox_drive_cache_large";
+	std_fs::remove_all(base);
+	std_fs::create_directories(base / "data");
+
+	for (auto i = 0; i < num_files; ++i) {
+		std::ofstream(base / "data" / format_str("longfilename_%05d.dat", i));
+	}
+	std::ofstream(base / "data" / "readme.txt");
+	return base;
+}
+
+TEST(DOS_Drive_Cache, ResolvesNamesInLargeDir)
+{
+	constexpr auto NumFiles = 1000;
+
+	const auto base     = make_large_dir(NumFiles);
+	const auto base_dir = base.string() + CROSS_FILESPLIT;
+	const auto data_dir = base_dir + "DATA" + CROSS_FILESPLIT;
+
+	DOS_Drive_Cache cache(base_dir.c_str());
+
+	const auto names = list_cached_dir(cache, data_dir);
+	ASSERT_EQ(names.size(), NumFiles + 3u); // plus ., .., and readme.txt
+	EXPECT_TRUE(std::is_sorted(names.begin() + 2, names.end()));
+	EXPECT_TRUE(contains(names, "README.TXT"));
+
+	for (auto i = 0; i < NumFiles; ++i) {
+		const auto long_name = format_str("longfilename_%05d.dat", i);
+		const auto host_path = (base / "data" / long_name).string();
+
+		char short_name[DOS_NAMELENGTH_ASCII] = {};
+		ASSERT_TRUE(cache.GetShortName((data_dir + long_name).c_str(), short_name));
+		EXPECT_TRUE(contains(names, short_name));
+
+		const auto dos_path = data_dir + short_name;
+		EXPECT_EQ(cache.GetExpandNameAndNormaliseCase(dos_path.c_str()), host_path);
+	}
+
+	std_fs::remove_all(base);
+}
+
+// Checks the hashed lookups against a linear search of the listing, in a
+// directory of names whose generated short names collide
+TEST(DOS_Drive_Cache, HashedLookupsMatchLinearSearch)
+{
+	const auto base = std_fs::temp_directory_path() / "dosbox_drive_cache_hashed";
+	std_fs::remove_all(base);
+	std_fs::create_directories(base);
+
+	std::vector<std::string> long_names = {};
+	for (auto i = 0; i < 50; ++i) {
+		long_names.push_back(format_str("Saved Game %02d.dat", i));
+		long_names.push_back(format_str("savedgame%02d_backup.dat", i));
+		long_names.push_back(format_str("save.%02d.old", i));
+	}
+	for (const auto& name : long_names) {
+		std::ofstream(base / name);
+	}
+
+	const auto base_dir = base.string() + CROSS_FILESPLIT;
+
+	DOS_Drive_Cache cache(base_dir.c_str());
+	const auto names = list_cached_dir(cache, base_dir);
+	ASSERT_EQ(names.size(), long_names.size() + 2); // plus . and ..
+
+	std::vector<std::string> short_names = {};
+	for (const auto& long_name : long_names) {
+		char short_name[DOS_NAMELENGTH_ASCII] = {};
+		ASSERT_TRUE(cache.GetShortName((base_dir + long_name).c_str(), short_name));
+
+		// Each short name is listed exactly once
+		EXPECT_EQ(std::count(names.begin(), names.end(), short_name), 1)
+		        << long_name << " -> " << short_name;
+		short_names.emplace_back(short_name);
+
+		const auto dos_path = base_dir + short_name;
+		EXPECT_EQ(cache.GetExpandNameAndNormaliseCase(dos_path.c_str()),
+		          (base / long_name).string());
+	}
+
+	// The short names are a one-to-one mapping of the long ones
+	std::sort(short_names.begin(), short_names.end());
+	EXPECT_EQ(std::adjacent_find(short_names.begin(), short_names.end()),
+	          short_names.end());
+
+	std_fs::remove_all(base);
+}
+
+// Timing only, run with --gtest_also_run_disabled_tests
+TEST(DOS_Drive_Cache, DISABLED_Benchmark)
+{
+	constexpr auto NumFiles   = 10000;
+	constexpr auto NumLookups = 100000;
+
+	const auto base     = make_large_dir(NumFiles);
+	const auto base_dir = base.string() + CROSS_FILESPLIT;
+	const auto data_dir = base_dir + "DATA" + CROSS_FILESPLIT;
+
+	std_fs::create_directories(base / "save");
+	std::ofstream(base / "save" / "game.sav");
+	const auto save_path = base_dir + "SAVE" + CROSS_FILESPLIT + "GAME.SAV";
+
+	const auto elapsed_ms = [](const auto start) {
+		const std::chrono::duration<double, std::milli> elapsed =
+		        std::chrono::steady_clock::now() - start;
+		return elapsed.count();
+	};
+
+	auto start = std::chrono::steady_clock::now();
+
+	DOS_Drive_Cache cache(base_dir.c_str());
+	const auto names = list_cached_dir(cache, data_dir);
+	ASSERT_EQ(names.size(), NumFiles + 3u);
+
+	const auto cache_in_ms = elapsed_ms(start);
+
+	// Open files the way a game would, by their short names, while also
+	// accessing another directory now and then
+	std::vector<std::string> paths = {};
+	for (auto i = 0; i < NumLookups; ++i) {
+		paths.push_back(data_dir + names[(i * 7919) % names.size()]);
+	}
+
+	start = std::chrono::steady_clock::now();
+	for (auto i = 0; i < NumLookups; ++i) {
+		cache.GetExpandNameAndNormaliseCase(paths[i].c_str());
+		if (i % 4 == 0) {
+			cache.GetExpandNameAndNormaliseCase(save_path.c_str());
+		}
+	}
+	const auto lookup_ms = elapsed_ms(start);
+
+	// Find the short names of newly created files, as the local drive does
+	start = std::chrono::steady_clock::now();
+	for (auto i = 0; i < NumFiles; ++i) {
+		const auto path = data_dir + format_str("longfilename_%05d.dat", i);
+
+		char short_name[DOS_NAMELENGTH_ASCII] = {};
+		cache.GetShortName(path.c_str(), short_name);
+	}
+	const auto short_name_ms = elapsed_ms(start);
+
+	// List the directory a few times, as DIR would
+	start = std::chrono::steady_clock::now();
+	for (auto i = 0; i < 10; ++i) {
+		list_cached_dir(cache, data_dir);
+	}
+	const auto listing_ms = elapsed_ms(start);
+
+	printf("[ BENCH    ] %d files: cache-in %.1f ms, %d lookups %.1f ms, "
+	       "%d short names %.1f ms, 10 listings %.1f ms\n",
+	       NumFiles,
+	       cache_in_ms,
+	       NumLookups,
+	       lookup_ms,
+	       NumFiles,
+	       short_name_ms,
+	       listing_ms);
+
+	std_fs::remove_all(base);
+}
+
 } // namespace
@@ -6,7 +6,12 @@
 #include <gtest/gtest.h>
 
 #include <cerrno>
+#include <chrono>
+#include <cstdio>
 #include <string>
+#include <vector>
+
+#include "dos_system.h"
 
 namespace {
 
@@ -123,4 +128,107 @@ TEST_F(CreateDirTest, FailDueToFileExisting2)
 	EXPECT_EQ(errno, EEXIST);
 }
 
+// Creates a file with the given contents, and opens it for reading
+NativeFileHandle make_source_file(const std_fs::path& path, const std::vector<uint8_t>& data)
+{
+	const auto handle = create_native_file(path, {});
+	write_native_file(handle, data.data(), static_cast<int64_t>(data.size()));
+	close_native_file(handle);
+
+	return open_native_file(path, false);
+}
+
+std::vector<uint8_t> make_file_data(const size_t num_bytes)
+{
+	std::vector<uint8_t> data(num_bytes);
+	for (size_t i = 0; i < num_bytes; ++i) {
+		data[i] = static_cast<uint8_t>(i * 7 + (i >> 12));
+	}
+	return data;
+}
+
+std::vector<uint8_t> read_file_data(const NativeFileHandle handle, const size_t num_bytes)
+{
+	std::vector<uint8_t> data(num_bytes + 1);
+	seek_native_file(handle, 0, NativeSeek::Set);
+
+	const auto ret = read_native_file(handle,
+	                                  data.data(),
+	                                  static_cast<int64_t>(data.size()));
+	data.resize(static_cast<size_t>(ret.num_bytes));
+	return data;
+}
+
+TEST(CopyNativeFile, CopiesWholeFile)
+{
+	const auto dir = std_fs::temp_directory_path() / "dosbox_copy_native_file";
+	std_fs::create_directories(dir);
+
+	for (const size_t num_bytes : {0, 1, 4095, 1024 * 1024 + 17, 3 * 1024 * 1024}) {
+		const auto data = make_file_data(num_bytes);
+
+		const auto src = make_source_file(dir / "src.bin", data);
+		const auto dst = create_native_file(dir / "dst.bin", {});
+		ASSERT_NE(src, InvalidNativeFileHandle);
+		ASSERT_NE(dst, InvalidNativeFileHandle);
+
+		// The copy shouldn't depend on where the source was left
+		seek_native_file(src, 3, NativeSeek::Set);
+
+		EXPECT_TRUE(copy_native_file(src, dst));
+		EXPECT_EQ(get_native_file_position(dst), static_cast<int64_t>(num_bytes));
+		EXPECT_TRUE(read_file_data(dst, num_bytes) == data) << num_bytes << " bytes";
+
+		close_native_file(src);
+		close_native_file(dst);
+	}
+	std_fs::remove_all(dir);
+}
+
+// Measures how long the first write to a large file on an overlay drive
+// stalls for, as the whole file gets copied to the overlay directory
+TEST(CopyNativeFile, DISABLED_Benchmark)
+{
+	constexpr size_t NumBytes = 64 * 1024 * 1024;
+
+	const auto dir = std_fs::temp_directory_path() / "dosbox_copy_native_file";
+	std_fs::create_directories(dir);
+
+	const auto src = make_source_file(dir / "src.bin", make_file_data(NumBytes));
+
+	const auto time_copy = [&](const auto copy) {
+		const auto dst = create_native_file(dir / "dst.bin", {});
+		seek_native_file(src, 0, NativeSeek::Set);
+
+		const auto start = std::chrono::steady_clock::now();
+		copy(src, dst);
+		const std::chrono::duration<double, std::milli> elapsed =
+		        std::chrono::steady_clock::now() - start;
+
+		close_native_file(dst);
+		return elapsed.count();
+	};
+
+	// The copy loop the overlay drive used before
+	const auto buffered_ms = time_copy([](const auto from, const auto to) {
+		uint8_t buffer[BUFSIZ] = {};
+		while (true) {
+			const auto ret = read_native_file(from, buffer, BUFSIZ);
+			if (ret.num_bytes <= 0) {
+				break;
+			}
+			write_native_file(to, buffer, ret.num_bytes);
+		}
+	});
+	const auto native_ms = time_copy(copy_native_file);
+
+	printf("[ BENCH    ] %zu MB: buffered copy %.1f ms, native copy %.1f ms\n",
+	       NumBytes / (1024 * 1024),
+	       buffered_ms,
+	       native_ms);
+
+	close_native_file(src);
+	std_fs::remove_all(dir);
+}
+
 } // namespace
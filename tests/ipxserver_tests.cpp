@@ -0,0 +1,100 @@
+// SPDX-FileCopyrightText:  2025-2025 The DOSBox Staging Team
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "dosbox.h"
+
+#if C_IPX
+
+#include "ipxserver.h"
+
+#include <gtest/gtest.h>
+
+#include "ipx.h"
+
+namespace {
+
+// A registration packet as the client sends it: to the echo socket of a
+// null address, from the address the client believes it has
+struct Registration {
+	IPXHeader header = {};
+	UDPpacket packet = {};
+
+	Registration(const IPaddress& from, const IPaddress& reported_source)
+	{
+		SDLNet_Write16(0x2, header.dest.socket);
+		PackIP(reported_source, &header.src.addr.byIP);
+
+		packet.data    = reinterpret_cast<Uint8*>(&header);
+		packet.len     = sizeof(header);
+		packet.maxlen  = sizeof(header);
+		packet.address = from;
+	}
+};
+
+int count_connected()
+{
+	auto num_connected = 0;
+	for (Bits i = 0; i < SOCKETTABLESIZE; ++i) {
+		IPaddress* address = nullptr;
+		if (IPX_isConnectedToServer(i, &address)) {
+			++num_connected;
+		}
+	}
+	return num_connected;
+}
+
+TEST(IpxServer, ReregistrationKeepsSlot)
+{
+	const IPaddress client = {0x0100000a, 0x5000};
+
+	registerClient(Registration(client, {}).packet);
+
+	const auto slot = findConnection(client.host, client.port);
+	ASSERT_GE(slot, 0);
+	const auto num_connected = count_connected();
+
+	registerClient(Registration(client, {}).packet);
+	EXPECT_EQ(findConnection(client.host, client.port), slot);
+	EXPECT_EQ(count_connected(), num_connected);
+}
+
+TEST(IpxServer, PortChangeMovesIndexEntry)
+{
+	const IPaddress before = {0x0200000a, 0x6000};
+	const IPaddress after  = {0x0200000a, 0x6001};
+
+	registerClient(Registration(before, {}).packet);
+	const auto slot = findConnection(before.host, before.port);
+	ASSERT_GE(slot, 0);
+	const auto num_connected = count_connected();
+
+	// The client comes back through a new port, reporting its old address
+	registerClient(Registration(after, before).packet);
+
+	EXPECT_EQ(findConnection(before.host, before.port), -1);
+	EXPECT_EQ(findConnection(after.host, after.port), slot);
+	EXPECT_EQ(count_connected(), num_connected);
+
+	IPaddress* address = nullptr;
+	ASSERT_TRUE(IPX_isConnectedToServer(slot, &address));
+	EXPECT_EQ(address->port, after.port);
+}
+
+TEST(IpxServer, NewClientsGetTheirOwnSlots)
+{
+	const IPaddress first  = {0x0300000a, 0x7000};
+	const IPaddress second = {0x0400000a, 0x7000};
+
+	registerClient(Registration(first, {}).packet);
+	registerClient(Registration(second, {}).packet);
+
+	const auto first_slot  = findConnection(first.host, first.port);
+	const auto second_slot = findConnection(second.host, second.port);
+	ASSERT_GE(first_slot, 0);
+	ASSERT_GE(second_slot, 0);
+	EXPECT_NE(first_slot, second_slot);
+}
+
+} // namespace
+
+#endif
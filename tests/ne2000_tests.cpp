@@ -0,0 +1,164 @@
+// SPDX-FileCopyrightText:  2025-2025 The DOSBox Staging Team
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "ne2000.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr uint8_t MacAddress[6] = {0xac, 0xde, 0x48, 0x8e, 0x89, 0x19};
+
+constexpr uint8_t MemStartPage = BX_NE2K_MEMSTART / 256;
+constexpr uint8_t MemEndPage   = BX_NE2K_MEMEND / 256;
+
+// A started NIC with a 16-page receive ring at the start of its memory,
+// accepting frames sent to its own address
+class NE2000_RxFrame : public ::testing::Test {
+protected:
+	static constexpr uint8_t PageStart = MemStartPage + 6;
+	static constexpr uint8_t PageStop  = PageStart + 16;
+
+	void SetUp() override
+	{
+		nic.s.CR.stop    = 0;
+		nic.s.CR.start   = 1;
+		nic.s.page_start = PageStart;
+		nic.s.page_stop  = PageStop;
+		nic.s.curr_page  = PageStart;
+		nic.s.bound_ptr  = PageStart;
+		memcpy(nic.s.physaddr, MacAddress, sizeof(MacAddress));
+	}
+
+	// A frame to the NIC with a recognisable payload, in a buffer of
+	// exactly its length
+	static std::vector<uint8_t> make_frame(const size_t num_bytes)
+	{
+		std::vector<uint8_t> frame(num_bytes);
+		for (size_t i = 0; i < num_bytes; ++i) {
+			frame[i] = static_cast<uint8_t>(i * 7 + 1);
+		}
+		memcpy(frame.data(), MacAddress, sizeof(MacAddress));
+		return frame;
+	}
+
+	uint8_t& ring_byte(const unsigned page, const unsigned offset)
+	{
+		return nic.s.mem[page * 256 + offset - BX_NE2K_MEMSTART];
+	}
+
+	Ne2kRxResult receive(const std::vector<uint8_t>& frame)
+	{
+		return nic.rx_frame(frame.data(), static_cast<unsigned>(frame.size()));
+	}
+
+	bx_ne2k_c nic = {};
+};
+
+TEST_F(NE2000_RxFrame, WrapsAtPageStop)
+{
+	nic.s.curr_page = PageStop - 1;
+	nic.s.bound_ptr = PageStart + 8;
+
+	// Two pages: the header and the first 252 bytes fill the last page of
+	// the ring, and the rest goes to its first page
+	const auto frame = make_frame(300);
+	ASSERT_EQ(receive(frame), Ne2kRxResult::Received);
+
+	constexpr uint8_t NextPage = PageStart + 1;
+	EXPECT_EQ(ring_byte(PageStop - 1, 1), NextPage);
+	EXPECT_EQ(ring_byte(PageStop - 1, 2), (300 + 4) & 0xff);
+	EXPECT_EQ(ring_byte(PageStop - 1, 3), (300 + 4) >> 8);
+	EXPECT_EQ(nic.s.curr_page, NextPage);
+
+	for (unsigned i = 0; i < 252; ++i) {
+		ASSERT_EQ(ring_byte(PageStop - 1, 4 + i), frame[i]) << i;
+	}
+	for (unsigned i = 252; i < 300; ++i) {
+		ASSERT_EQ(ring_byte(PageStart, i - 252), frame[i]) << i;
+	}
+
+	// Nothing is written past the end of the ring
+	for (unsigned i = 0; i < 256; ++i) {
+		ASSERT_EQ(ring_byte(PageStop, i), 0) << i;
+	}
+}
+
+TEST_F(NE2000_RxFrame, PadsRuntFrames)
+{
+	constexpr auto FrameLength = 42;
+	constexpr auto MinLength   = 60;
+
+	for (unsigned i = 0; i < 256; ++i) {
+		ring_byte(PageStart, i) = 0xff;
+	}
+
+	const auto frame = make_frame(FrameLength);
+	ASSERT_EQ(receive(frame), Ne2kRxResult::Received);
+
+	EXPECT_EQ(ring_byte(PageStart, 2), MinLength + 4);
+	for (unsigned i = 0; i < FrameLength; ++i) {
+		ASSERT_EQ(ring_byte(PageStart, 4 + i), frame[i]) << i;
+	}
+	for (unsigned i = FrameLength; i < MinLength; ++i) {
+		ASSERT_EQ(ring_byte(PageStart, 4 + i), 0) << i;
+	}
+}
+
+TEST_F(NE2000_RxFrame, DropsWhenRingIsOutsideMemory)
+{
+	const auto frame = make_frame(100);
+
+	nic.s.page_start = MemStartPage - 1;
+	nic.s.curr_page  = MemStartPage - 1;
+	nic.s.bound_ptr  = MemStartPage - 1;
+	EXPECT_EQ(receive(frame), Ne2kRxResult::Dropped);
+
+	SetUp();
+	nic.s.page_stop = MemEndPage + 1;
+	EXPECT_EQ(receive(frame), Ne2kRxResult::Dropped);
+
+	SetUp();
+	nic.s.curr_page = PageStop;
+	EXPECT_EQ(receive(frame), Ne2kRxResult::Dropped);
+
+	SetUp();
+	nic.s.bound_ptr = PageStart - 1;
+	EXPECT_EQ(receive(frame), Ne2kRxResult::Dropped);
+
+	// Nothing was written
+	for (const auto byte : nic.s.mem) {
+		ASSERT_EQ(byte, 0);
+	}
+}
+
+TEST_F(NE2000_RxFrame, DropsFramesLargerThanRing)
+{
+	// Four pages can never hold a six-page frame, nor one that would
+	// fill the whole ring
+	nic.s.page_stop = PageStart + 4;
+
+	EXPECT_EQ(receive(make_frame(1514)), Ne2kRxResult::Dropped);
+	EXPECT_EQ(receive(make_frame(4 * 256 - 8)), Ne2kRxResult::Dropped);
+
+	EXPECT_EQ(receive(make_frame(3 * 256 - 8)), Ne2kRxResult::Received);
+}
+
+TEST_F(NE2000_RxFrame, RetriesWhenRingIsFull)
+{
+	// Only one page left before the guest's boundary pointer
+	nic.s.curr_page = PageStart + 3;
+	nic.s.bound_ptr = PageStart + 4;
+
+	const auto frame = make_frame(300);
+	EXPECT_EQ(receive(frame), Ne2kRxResult::NoSpace);
+
+	// Once the guest has taken frames out of the ring, it fits
+	nic.s.bound_ptr = PageStart + 8;
+	EXPECT_EQ(receive(frame), Ne2kRxResult::Received);
+}
+
+} // namespace
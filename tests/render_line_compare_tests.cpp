@@ -0,0 +1,140 @@
+// SPDX-FileCopyrightText:  2025-2025 The DOSBox Staging Team
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "../src/gui/render_line_compare.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+std::vector<uint8_t> make_line(const size_t num_bytes)
+{
+	std::vector<uint8_t> line(num_bytes);
+	for (size_t i = 0; i < num_bytes; ++i) {
+		line[i] = static_cast<uint8_t>(i * 7 + 3);
+	}
+	return line;
+}
+
+TEST(RenderLineCompare, IdenticalLines)
+{
+	for (const size_t num_bytes : {0, 1, 15, 16, 17, 31, 32, 33, 320, 4096}) {
+		const auto line = make_line(num_bytes);
+		const auto cache = line;
+
+		EXPECT_EQ(find_first_line_change(line.data(), cache.data(), num_bytes),
+		          num_bytes);
+	}
+}
+
+TEST(RenderLineCompare, FindsFirstChange)
+{
+	constexpr size_t NumBytes = 100;
+
+	const auto line = make_line(NumBytes);
+
+	for (size_t changed = 0; changed < NumBytes; ++changed) {
+		auto cache = line;
+		cache[changed] ^= 0x80;
+
+		// A later change must not hide the first one
+		if (changed + 20 < NumBytes) {
+			cache[changed + 20] ^= 0x01;
+		}
+		EXPECT_EQ(find_first_line_change(line.data(), cache.data(), NumBytes),
+		          changed);
+	}
+}
+
+TEST(RenderLineCompare, InvertedLineDiffersEverywhere)
+{
+	for (const size_t num_bytes : {1, 16, 33, 640}) {
+		const auto line = make_line(num_bytes);
+		std::vector<uint8_t> cache(num_bytes);
+
+		invert_line(line.data(), cache.data(), num_bytes);
+
+		for (size_t i = 0; i < num_bytes; ++i) {
+			ASSERT_EQ(cache[i], static_cast<uint8_t>(~line[i]));
+		}
+		EXPECT_EQ(find_first_line_change(line.data(), cache.data(), num_bytes), 0);
+	}
+}
+
+// The word-at-a-time comparison the renderer used before
+size_t find_first_line_change_scalar(const uint8_t* src, const uint8_t* cache,
+                                     const size_t num_bytes)
+{
+	size_t offset = 0;
+	for (; offset + sizeof(uintptr_t) <= num_bytes; offset += sizeof(uintptr_t)) {
+		uintptr_t src_val   = 0;
+		uintptr_t cache_val = 0;
+		std::memcpy(&src_val, src + offset, sizeof(src_val));
+		std::memcpy(&cache_val, cache + offset, sizeof(cache_val));
+		if (src_val != cache_val) {
+			break;
+		}
+	}
+	for (; offset < num_bytes; ++offset) {
+		if (src[offset] != cache[offset]) {
+			break;
+		}
+	}
+	return offset;
+}
+
+TEST(RenderLineCompare, DISABLED_Benchmark)
+{
+	// An unchanged 480-line frame, which has to be compared in full
+	constexpr auto NumLines  = 480;
+	constexpr auto NumFrames = 200;
+
+	using FindFunc = size_t (*)(const uint8_t*, const uint8_t*, size_t);
+
+	for (const auto width : {320, 640, 1024}) {
+		for (const auto bytes_per_pixel : {1, 2, 4}) {
+			const auto line_bytes = static_cast<size_t>(width * bytes_per_pixel);
+
+			const auto frame = make_line(line_bytes * NumLines);
+			const auto cache = frame;
+
+			const auto run = [&](const FindFunc find) {
+				size_t total = 0;
+
+				const auto start = std::chrono::steady_clock::now();
+				for (auto i = 0; i < NumFrames; ++i) {
+					for (auto y = 0; y < NumLines; ++y) {
+						const auto offset = line_bytes * y;
+						total += find(&frame[offset],
+						              &cache[offset],
+						              line_bytes);
+					}
+				}
+				const std::chrono::duration<double> elapsed =
+				        std::chrono::steady_clock::now() - start;
+
+				EXPECT_EQ(total, line_bytes * NumLines * NumFrames);
+
+				// In gigabytes per second
+				return static_cast<double>(total) / elapsed.count() / 1e9;
+			};
+
+			const auto scalar_rate = run(find_first_line_change_scalar);
+			const auto simd_rate   = run(find_first_line_change);
+
+			printf("[ BENCH    ] %4d pixels, %2d bpp: "
+			       "scalar %.1f GB/s, SIMD %.1f GB/s\n",
+			       width,
+			       bytes_per_pixel * 8,
+			       scalar_rate,
+			       simd_rate);
+		}
+	}
+}
+
+} // namespace
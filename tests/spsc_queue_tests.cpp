@@ -0,0 +1,144 @@
+// SPDX-FileCopyrightText:  2025-2025 The DOSBox Staging Team
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "spsc_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+namespace {
+
+TEST(SpscQueue, PushPopSerial)
+{
+	SpscQueue<int, 8> q;
+	EXPECT_TRUE(q.IsEmpty());
+	EXPECT_EQ(q.Front(), nullptr);
+	EXPECT_FALSE(q.TryPop());
+
+	// Wrap around the ring several times
+	for (int round = 0; round < 4; ++round) {
+		for (int i = 0; i < 8; ++i) {
+			EXPECT_TRUE(q.Push(round * 8 + i));
+		}
+		EXPECT_EQ(q.Size(), 8);
+
+		// Full
+		EXPECT_FALSE(q.Push(-1));
+
+		for (int i = 0; i < 8; ++i) {
+			ASSERT_NE(q.Front(), nullptr);
+			EXPECT_EQ(*q.Front(), round * 8 + i);
+			q.Pop();
+		}
+		EXPECT_TRUE(q.IsEmpty());
+	}
+}
+
+TEST(SpscQueue, PeekAndPopBatch)
+{
+	SpscQueue<int, 8> q;
+	EXPECT_EQ(q.Peek(0), nullptr);
+
+	// Start part-way round the ring so the batch wraps
+	for (int i = 0; i < 5; ++i) {
+		EXPECT_TRUE(q.Push(-1));
+		q.Pop();
+	}
+	for (int i = 0; i < 6; ++i) {
+		EXPECT_TRUE(q.Push(i));
+	}
+
+	for (size_t i = 0; i < 6; ++i) {
+		ASSERT_NE(q.Peek(i), nullptr);
+		EXPECT_EQ(*q.Peek(i), static_cast<int>(i));
+	}
+	EXPECT_EQ(q.Peek(6), nullptr);
+
+	q.Pop(4);
+	EXPECT_EQ(q.Size(), 2);
+	ASSERT_NE(q.Front(), nullptr);
+	EXPECT_EQ(*q.Front(), 4);
+	EXPECT_EQ(*q.Peek(1), 5);
+	EXPECT_EQ(q.Peek(2), nullptr);
+
+	q.Pop(2);
+	EXPECT_TRUE(q.IsEmpty());
+}
+
+TEST(SpscQueue, ProducerConsumerThreads)
+{
+	constexpr int NumItems = 100000;
+
+	SpscQueue<int, 64> q;
+
+	std::thread producer([&q] {
+		for (int i = 0; i < NumItems; ++i) {
+			while (!q.Push(i)) {
+				std::this_thread::yield();
+			}
+		}
+	});
+
+	int expected = 0;
+	while (expected < NumItems) {
+		if (const auto item = q.TryPop()) {
+			ASSERT_EQ(*item, expected);
+			++expected;
+		} else {
+			std::this_thread::yield();
+		}
+	}
+	producer.join();
+
+	EXPECT_TRUE(q.IsEmpty());
+}
+
+struct TestWrite {
+	double timestamp_ms = 0.0;
+	int value           = 0;
+};
+
+TEST(TimedWriteQueue, ApplyUpTo)
+{
+	TimedWriteQueue<TestWrite, 16> q;
+
+	EXPECT_TRUE(q.Push({1.0, 10}));
+	EXPECT_TRUE(q.Push({2.0, 20}));
+	EXPECT_TRUE(q.Push({2.0, 21}));
+	EXPECT_TRUE(q.Push({3.5, 30}));
+
+	std::vector<int> applied = {};
+	const auto apply = [&applied](const TestWrite& w) {
+		applied.push_back(w.value);
+	};
+
+	q.ApplyUpTo(0.5, apply);
+	EXPECT_TRUE(applied.empty());
+
+	q.ApplyUpTo(2.0, apply);
+	EXPECT_EQ(applied, (std::vector<int>{10, 20, 21}));
+
+	q.ApplyUpTo(3.0, apply);
+	EXPECT_EQ(applied.size(), 3);
+
+	q.ApplyAll(apply);
+	EXPECT_EQ(applied, (std::vector<int>{10, 20, 21, 30}));
+	EXPECT_EQ(q.Size(), 0);
+}
+
+TEST(TimedWriteQueue, CountsDroppedWrites)
+{
+	TimedWriteQueue<TestWrite, 2> q;
+
+	EXPECT_TRUE(q.Push({0.0, 1}));
+	EXPECT_TRUE(q.Push({0.0, 2}));
+	EXPECT_FALSE(q.Push({0.0, 3}));
+	EXPECT_FALSE(q.Push({0.0, 4}));
+
+	EXPECT_EQ(q.GetNumDropped(), 2);
+	EXPECT_EQ(q.Size(), 2);
+}
+
+} // namespace
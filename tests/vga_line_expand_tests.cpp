@@ -0,0 +1,127 @@
+// SPDX-FileCopyrightText:  2025-2025 The DOSBox Staging Team
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "../src/hardware/vga_line_expand.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+namespace {
+
+std::vector<Bgrx8888> make_palette()
+{
+	std::vector<Bgrx8888> palette(256);
+	for (auto i = 0; i < 256; ++i) {
+		palette[i].Set(static_cast<uint8_t>(i),
+		               static_cast<uint8_t>(255 - i),
+		               static_cast<uint8_t>(i * 37));
+	}
+	return palette;
+}
+
+std::vector<uint8_t> make_indices(const size_t num_pixels)
+{
+	std::vector<uint8_t> indices(num_pixels);
+	for (size_t i = 0; i < num_pixels; ++i) {
+		indices[i] = static_cast<uint8_t>(i * 13 + (i >> 3));
+	}
+	return indices;
+}
+
+// The per-pixel lookup the VGA line drawers used before
+void expand_palette_indices_scalar(const uint8_t* indices, const Bgrx8888* palette,
+                                   uint8_t* out, const size_t num_pixels)
+{
+	for (size_t x = 0; x < num_pixels; ++x) {
+		std::memcpy(out + x * sizeof(uint32_t), palette + indices[x], sizeof(uint32_t));
+	}
+}
+
+TEST(VgaLineExpand, PaletteIndicesMatchScalar)
+{
+	const auto palette = make_palette();
+
+	for (const size_t num_pixels : {0, 1, 7, 15, 16, 17, 33, 320, 640, 1023}) {
+		const auto indices = make_indices(num_pixels);
+
+		// One extra pixel to catch writes past the end
+		std::vector<uint8_t> expected((num_pixels + 1) * sizeof(uint32_t), 0xaa);
+		auto actual = expected;
+
+		expand_palette_indices_scalar(indices.data(),
+		                              palette.data(),
+		                              expected.data(),
+		                              num_pixels);
+		expand_palette_indices(indices.data(), palette.data(), actual.data(), num_pixels);
+
+		EXPECT_EQ(actual, expected) << num_pixels << " pixels";
+	}
+}
+
+TEST(VgaLineExpand, GlyphRowMatchesScalar)
+{
+	constexpr uint32_t Fg = 0x00a0b0c0;
+	constexpr uint32_t Bg = 0x00102030;
+
+	for (auto font = 0; font < 256; ++font) {
+		uint32_t expected[8] = {};
+		for (auto n = 0; n < 8; ++n) {
+			expected[n] = (font & (0x80 >> n)) ? Fg : Bg;
+		}
+
+		uint32_t actual[8] = {};
+		expand_glyph_row(static_cast<uint8_t>(font),
+		                 Fg,
+		                 Bg,
+		                 reinterpret_cast<uint8_t*>(actual));
+
+		ASSERT_EQ(std::memcmp(actual, expected, sizeof(actual)), 0)
+		        << "font bits " << font;
+	}
+}
+
+TEST(VgaLineExpand, PackedPixelsMatchScalar)
+{
+	uint8_t palette[16] = {};
+	for (auto i = 0; i < 16; ++i) {
+		palette[i] = static_cast<uint8_t>(15 - i);
+	}
+
+	std::vector<uint8_t> src(256);
+	for (auto i = 0; i < 256; ++i) {
+		src[i] = static_cast<uint8_t>(i);
+	}
+
+	PackedPixelTable table = {};
+
+	// Run twice, the second time with a changed palette, to make sure the
+	// table picks up the change
+	for (auto pass = 0; pass < 2; ++pass) {
+		table.Update(palette);
+
+		std::vector<uint8_t> expected    = {};
+		std::vector<uint8_t> expected_x2 = {};
+		for (const auto byte : src) {
+			const auto left  = palette[byte >> 4];
+			const auto right = palette[byte & 0x0f];
+
+			expected.insert(expected.end(), {left, right});
+			expected_x2.insert(expected_x2.end(), {left, left, right, right});
+		}
+
+		std::vector<uint8_t> actual(src.size() * 2);
+		std::vector<uint8_t> actual_x2(src.size() * 4);
+
+		table.Expand(src.data(), actual.data(), src.size());
+		table.ExpandDoubled(src.data(), actual_x2.data(), src.size());
+
+		EXPECT_EQ(actual, expected);
+		EXPECT_EQ(actual_x2, expected_x2);
+
+		palette[3] = 0x42;
+	}
+}
+
+} // namespace
@@ -0,0 +1,159 @@
+// SPDX-FileCopyrightText:  2025-2025 The DOSBox Staging Team
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "../include/vga.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+constexpr uint8_t GfxModeIndex = 5;
+constexpr uint8_t GfxMiscIndex = 6;
+constexpr uint8_t SeqMapMaskIndex    = 2;
+constexpr uint8_t SeqMemoryModeIndex = 4;
+
+constexpr uint8_t CrtcStartAddressHighIndex = 0x0c;
+constexpr uint8_t CrtcStartAddressLowIndex  = 0x0d;
+constexpr uint8_t CrtcOffsetIndex           = 0x13;
+
+TEST(VgaRegisters, GfxModeReadAndWriteModesDontChangePicture)
+{
+	vga.gfx.index = GfxModeIndex;
+	vga.gfx.mode  = 0x40; // 256 colour mode, write mode 0, read mode 0
+
+	EXPECT_FALSE(gfx_write_changes_picture(0x40));
+	EXPECT_FALSE(gfx_write_changes_picture(0x41));
+	EXPECT_FALSE(gfx_write_changes_picture(0x42));
+	EXPECT_FALSE(gfx_write_changes_picture(0x43));
+	EXPECT_FALSE(gfx_write_changes_picture(0x48));
+
+	EXPECT_TRUE(gfx_write_changes_picture(0x00));
+	EXPECT_TRUE(gfx_write_changes_picture(0x50));
+	EXPECT_TRUE(gfx_write_changes_picture(0x60));
+}
+
+TEST(VgaRegisters, GfxMiscChangesPicture)
+{
+	vga.gfx.index         = GfxMiscIndex;
+	vga.gfx.miscellaneous = 0x05; // graphics mode, A000h-AFFFh
+
+	EXPECT_FALSE(gfx_write_changes_picture(0x05));
+	EXPECT_FALSE(gfx_write_changes_picture(0xf5));
+
+	EXPECT_TRUE(gfx_write_changes_picture(0x04));
+	EXPECT_TRUE(gfx_write_changes_picture(0x07));
+	EXPECT_TRUE(gfx_write_changes_picture(0x0d));
+}
+
+TEST(VgaRegisters, OtherGfxRegistersDontChangePicture)
+{
+	for (uint8_t index = 0; index <= 8; ++index) {
+		if (index == GfxModeIndex || index == GfxMiscIndex) {
+			continue;
+		}
+		vga.gfx.index = index;
+		EXPECT_FALSE(gfx_write_changes_picture(0xff)) << "index " << int(index);
+	}
+}
+
+TEST(VgaRegisters, SeqOnlyChangedValuesChangePicture)
+{
+	vga.seq.index       = SeqMemoryModeIndex;
+	vga.seq.memory_mode = 0x06;
+
+	EXPECT_FALSE(seq_write_changes_picture(0x06));
+	EXPECT_TRUE(seq_write_changes_picture(0x0e));
+
+	vga.seq.index    = SeqMapMaskIndex;
+	vga.seq.map_mask = 0x01;
+	EXPECT_FALSE(seq_write_changes_picture(0x0f));
+}
+
+TEST(VgaRegisters, WriteModeChangeKeepsWholeFrameRendering)
+{
+	vga.draw.is_frame_deferred = true;
+
+	vga.gfx.index = GfxModeIndex;
+	vga.gfx.mode  = 0x40;
+
+	// What Mode X code does between blits
+	for (const uint8_t mode : {0x41, 0x40, 0x42, 0x48, 0x40}) {
+		write_p3cf(0x3cf, mode, io_width_t::byte);
+		EXPECT_TRUE(vga.draw.is_frame_deferred);
+		EXPECT_EQ(vga.gfx.mode, mode);
+		EXPECT_EQ(vga.config.write_mode, mode & 3);
+	}
+
+	vga.draw.is_frame_deferred = false;
+}
+
+TEST(VgaRegisters, MapMaskWriteKeepsWholeFrameRendering)
+{
+	vga.draw.is_frame_deferred = true;
+
+	vga.seq.index = SeqMapMaskIndex;
+	for (uint8_t mask = 1; mask <= 8; mask <<= 1) {
+		write_p3c5(0x3c5, mask, io_width_t::byte);
+		EXPECT_TRUE(vga.draw.is_frame_deferred);
+		EXPECT_EQ(vga.seq.map_mask, mask);
+	}
+
+	vga.draw.is_frame_deferred = false;
+}
+
+TEST(VgaRegisters, AttrOnlyPaletteSourceAndChangedValuesChangePicture)
+{
+	constexpr uint8_t PaletteAddressSource = 0x20;
+	constexpr uint8_t OverscanColorIndex   = 0x11;
+
+	// Index writes, with the screen enabled
+	vga.attr.is_address_mode = true;
+	vga.attr.disabled        = 0;
+	EXPECT_FALSE(attr_write_changes_picture(PaletteAddressSource | 0x13));
+	EXPECT_TRUE(attr_write_changes_picture(0x00));
+
+	// Data writes
+	vga.attr.is_address_mode = false;
+	vga.attr.index           = OverscanColorIndex;
+	vga.attr.overscan_color  = 0x01;
+	EXPECT_FALSE(attr_write_changes_picture(0x01));
+	EXPECT_TRUE(attr_write_changes_picture(0x02));
+
+	vga.attr.is_address_mode = true;
+}
+
+TEST(VgaRegisters, CrtcOnlyChangedValuesChangePicture)
+{
+	vga.crtc.index  = CrtcOffsetIndex;
+	vga.crtc.offset = 0x28;
+
+	EXPECT_FALSE(crtc_write_changes_picture(0x28));
+	EXPECT_TRUE(crtc_write_changes_picture(0x50));
+
+	// Only latched at vertical retrace
+	vga.crtc.index = CrtcStartAddressHighIndex;
+	EXPECT_FALSE(crtc_write_changes_picture(0x40));
+	vga.crtc.index = CrtcStartAddressLowIndex;
+	EXPECT_FALSE(crtc_write_changes_picture(0x80));
+}
+
+TEST(VgaRegisters, StartAddressWriteKeepsWholeFrameRendering)
+{
+	vga.draw.is_frame_deferred = true;
+
+	// Flip between two pages, as double-buffering Mode X games do
+	for (const uint8_t page : {0x40, 0x00, 0x40}) {
+		vga.crtc.index = CrtcStartAddressHighIndex;
+		vga_write_p3d5(0x3d5, page, io_width_t::byte);
+		vga.crtc.index = CrtcStartAddressLowIndex;
+		vga_write_p3d5(0x3d5, 0x00, io_width_t::byte);
+
+		EXPECT_TRUE(vga.draw.is_frame_deferred);
+		EXPECT_EQ(vga.crtc.start_address_high, page);
+		EXPECT_EQ(vga.config.display_start & 0xff00, static_cast<uint32_t>(page << 8));
+	}
+
+	vga.draw.is_frame_deferred = false;
+}
+
+} // namespace
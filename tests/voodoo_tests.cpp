@@ -0,0 +1,246 @@
+// SPDX-FileCopyrightText:  2025-2025 The DOSBox Staging Team
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "../src/hardware/voodoo.h"
+#include "../src/hardware/voodoo_register_stream.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "std_filesystem.h"
+
+namespace {
+
+constexpr VoodooBenchmarkScene AllScenes[] = {
+        VoodooBenchmarkScene::Textured,
+        VoodooBenchmarkScene::TexturedWBuffered,
+        VoodooBenchmarkScene::Gouraud,
+        VoodooBenchmarkScene::AlphaBlended,
+};
+
+const char* to_string(const VoodooBenchmarkScene scene)
+{
+	switch (scene) {
+	case VoodooBenchmarkScene::Textured: return "textured";
+	case VoodooBenchmarkScene::TexturedWBuffered: return "textured, W-buffered";
+	case VoodooBenchmarkScene::Gouraud: return "Gouraud";
+	case VoodooBenchmarkScene::AlphaBlended: return "alpha blended";
+	}
+	return "";
+}
+
+void expect_same_output(const VoodooBenchmarkResult& expected,
+                        const VoodooBenchmarkResult& actual)
+{
+	EXPECT_EQ(expected.pixels_out, actual.pixels_out);
+	EXPECT_EQ(expected.zfunc_fail, actual.zfunc_fail);
+	EXPECT_EQ(expected.afunc_fail, actual.afunc_fail);
+	EXPECT_EQ(expected.buffer_hash, actual.buffer_hash);
+}
+
+TEST(Voodoo, SpecialisedRasterizersMatchGeneric)
+{
+	VoodooBenchmarkOptions options = {};
+	options.num_frames = 4;
+	options.use_simd_rasterizers = false;
+
+	for (const auto num_threads : {1, 4}) {
+		options.num_threads = num_threads;
+
+		options.use_specialised_rasterizers = false;
+		const auto generic = VOODOO_RunRasterizerBenchmark(options);
+
+		options.use_specialised_rasterizers = true;
+		const auto specialised = VOODOO_RunRasterizerBenchmark(options);
+
+		EXPECT_GT(generic.pixels_out, 0);
+		expect_same_output(generic, specialised);
+
+		// The benchmark scene only uses a state with a specialised
+		// rasterizer
+		EXPECT_GT(generic.num_generic, 0);
+		EXPECT_EQ(specialised.num_generic, 0);
+	}
+}
+
+TEST(Voodoo, SimdPixelPipelineMatchesScalar)
+{
+	VoodooBenchmarkOptions options = {};
+	options.num_frames = 3;
+
+	for (const auto scene : AllScenes) {
+		SCOPED_TRACE(to_string(scene));
+		options.scene = scene;
+
+		options.use_specialised_rasterizers = false;
+		options.use_simd_rasterizers        = false;
+		const auto scalar = VOODOO_RunRasterizerBenchmark(options);
+
+		EXPECT_GT(scalar.pixels_out, 0);
+
+		// Both the generic and the specialised rasterizers
+		for (const auto use_specialised : {false, true}) {
+			options.use_specialised_rasterizers = use_specialised;
+			options.use_simd_rasterizers        = true;
+			expect_same_output(scalar, VOODOO_RunRasterizerBenchmark(options));
+		}
+	}
+
+	// The depth and alpha tests must have masked out some pixels
+	options.scene = VoodooBenchmarkScene::Textured;
+	EXPECT_GT(VOODOO_RunRasterizerBenchmark(options).zfunc_fail, 0);
+
+	options.scene = VoodooBenchmarkScene::AlphaBlended;
+	EXPECT_GT(VOODOO_RunRasterizerBenchmark(options).afunc_fail, 0);
+}
+
+TEST(Voodoo, TextureCacheMatchesUncached)
+{
+	VoodooBenchmarkOptions options = {};
+	options.num_frames = 3;
+
+	for (const auto scene : AllScenes) {
+		SCOPED_TRACE(to_string(scene));
+		options.scene = scene;
+
+		options.use_texture_cache = false;
+		const auto uncached = VOODOO_RunRasterizerBenchmark(options);
+
+		EXPECT_EQ(uncached.tex_cache_hits + uncached.tex_cache_misses, 0);
+
+		options.use_texture_cache = true;
+		expect_same_output(uncached, VOODOO_RunRasterizerBenchmark(options));
+	}
+
+	// The texture is decoded when it's first used, then reused by the
+	// following triangles
+	options.scene = VoodooBenchmarkScene::Textured;
+
+	const auto cached = VOODOO_RunRasterizerBenchmark(options);
+	EXPECT_GE(cached.tex_cache_misses, 1);
+	EXPECT_GT(cached.tex_cache_hits, cached.tex_cache_misses);
+}
+
+TEST(Voodoo, DISABLED_RasterizerBenchmark)
+{
+	VoodooBenchmarkOptions options = {};
+	options.num_frames = 30;
+
+	const auto run = [&](const char* name) {
+		const auto result = VOODOO_RunRasterizerBenchmark(options);
+
+		printf("[ BENCH    ] %s, %s rasterizer: %d triangles, %.1f Mpixels/s\n",
+		       to_string(options.scene),
+		       name,
+		       result.num_triangles,
+		       static_cast<double>(result.pixels_out) /
+		               (result.elapsed_ms * 1000.0));
+	};
+
+	options.use_simd_rasterizers = false;
+	for (const auto use_specialised : {false, true}) {
+		options.use_specialised_rasterizers = use_specialised;
+		run(use_specialised ? "specialised" : "generic");
+	}
+
+	for (const auto scene : AllScenes) {
+		options.scene = scene;
+
+		options.use_simd_rasterizers = false;
+		run("scalar");
+
+		options.use_simd_rasterizers = true;
+		run("SIMD");
+	}
+
+	options.scene             = VoodooBenchmarkScene::Textured;
+	options.use_texture_cache = false;
+	run("SIMD, uncached textures");
+}
+
+// A uniquely named file in the temporary directory, so concurrent test runs
+// don't share it, that's removed when the test ends even if it fails
+struct TempFile {
+	TempFile(const std::string& prefix, const std::string& extension)
+	        : path(std_fs::temp_directory_path() /
+	               (prefix + std::to_string(std::random_device{}()) + extension))
+	{}
+
+	~TempFile()
+	{
+		std::error_code ec = {};
+		std_fs::remove(path, ec);
+	}
+
+	TempFile(const TempFile&)            = delete;
+	TempFile& operator=(const TempFile&) = delete;
+
+	const std_fs::path path;
+};
+
+TEST(Voodoo, RegisterStreamReplay)
+{
+	constexpr auto NumFrames = 5;
+
+	const TempFile temp_file("voodoo_tests_", ".vrs");
+	const auto& path = temp_file.path;
+
+	VoodooBenchmarkOptions options = {};
+	options.num_frames  = NumFrames;
+	options.record_path = path.string();
+
+	const auto recorded = VOODOO_RunRasterizerBenchmark(options);
+
+	const auto stream = VOODOO_LoadRegisterStream(path);
+	ASSERT_TRUE(stream);
+	EXPECT_FALSE(stream->entries.empty());
+
+	// The stream is timed by the benchmark's 60 Hz frame clock, and the
+	// last entry is the final swap
+	EXPECT_NEAR(stream->entries.back().time_us,
+	            (NumFrames - 1) * 1000000.0 / 60,
+	            1.0);
+
+	const auto replayed = VOODOO_ReplayRegisterStream(*stream, 1);
+
+	// Replaying must reproduce the recorded output exactly
+	EXPECT_EQ(replayed.buffer_hash, recorded.buffer_hash);
+
+	ASSERT_EQ(replayed.frame_hashes.size(), NumFrames);
+	EXPECT_NE(replayed.frame_hashes[0], replayed.frame_hashes[1]);
+
+	EXPECT_EQ(replayed.swaps.num_writes, NumFrames);
+	EXPECT_EQ(replayed.textures.num_writes, 64 * 64 / 2);
+	EXPECT_EQ(replayed.lfb.num_writes, 0);
+	EXPECT_EQ(replayed.num_entries,
+	          replayed.registers.num_writes + replayed.textures.num_writes +
+	                  replayed.swaps.num_writes);
+
+	// Also with the rasterizer threads
+	const auto threaded = VOODOO_ReplayRegisterStream(*stream, 4);
+	EXPECT_EQ(threaded.frame_hashes, replayed.frame_hashes);
+	EXPECT_EQ(threaded.buffer_hash, replayed.buffer_hash);
+
+	// A truncated stream loads up to its last complete entry
+	std::vector<char> data = {};
+	{
+		std::ifstream file(path, std::ios::binary);
+		data.assign(std::istreambuf_iterator<char>(file), {});
+	}
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file.write(data.data(), static_cast<std::streamsize>(data.size() - 3));
+	}
+	const auto truncated = VOODOO_LoadRegisterStream(path);
+	ASSERT_TRUE(truncated);
+	EXPECT_EQ(truncated->entries.size(), stream->entries.size() - 1);
+}
+
+} // namespace
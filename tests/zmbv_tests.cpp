@@ -0,0 +1,270 @@
+// SPDX-FileCopyrightText:  2025-2025 The DOSBox Staging Team
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "zmbv/zmbv.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+// A tiled background with a few moving sprites and a scrolling band, which
+// is roughly what a DOS game screen looks like to the encoder.
+class SyntheticSequence {
+public:
+	SyntheticSequence(const int _width, const int _height, const int _bytes_per_pixel)
+	        : width(_width),
+	          height(_height),
+	          bytes_per_pixel(_bytes_per_pixel),
+	          frame(static_cast<size_t>(_width * _height * _bytes_per_pixel))
+	{}
+
+	const std::vector<uint8_t>& Render(const int frame_num)
+	{
+		for (auto y = 0; y < height; ++y) {
+			for (auto x = 0; x < width; ++x) {
+				// Background tiles
+				auto colour = ((x / 8) + (y / 8)) % 7 * 16 + (x ^ y) % 3;
+
+				// Scrolling band in the middle
+				if (y > height / 3 && y < height / 2) {
+					colour = ((x + frame_num * 2) / 4) % 32 + 100;
+				}
+
+				// Sprites moving diagonally
+				for (auto s = 0; s < 4; ++s) {
+					const auto sx = (s * 70 + frame_num * 3) % width;
+					const auto sy = (s * 40 + frame_num * 2) % height;
+					if (x >= sx && x < sx + 24 && y >= sy && y < sy + 24) {
+						colour = 200 + s * 8 + (x - sx) % 8;
+					}
+				}
+				SetPixel(x, y, colour);
+			}
+		}
+		return frame;
+	}
+
+	void SetPixel(const int x, const int y, const int colour)
+	{
+		auto pixel = &frame[static_cast<size_t>((y * width + x) * bytes_per_pixel)];
+		for (auto i = 0; i < bytes_per_pixel; ++i) {
+			pixel[i] = static_cast<uint8_t>(colour * (i + 1));
+		}
+	}
+
+	const int width;
+	const int height;
+	const int bytes_per_pixel;
+
+private:
+	std::vector<uint8_t> frame;
+};
+
+class Encoder {
+public:
+	Encoder(const int _width, const int _height, const ZMBV_FORMAT _format,
+	        const ZMBV_COMPRESSION compression = ZMBV_COMPRESSION::BALANCED)
+	        : width(_width),
+	          height(_height),
+	          format(_format)
+	{
+		codec.SetupCompress(width, height, compression);
+		out.resize(static_cast<size_t>(codec.NeededSize(width, height, format)));
+	}
+
+	~Encoder()
+	{
+		codec.FinishVideo();
+	}
+
+	std::vector<uint8_t> Encode(const std::vector<uint8_t>& frame,
+	                            const bool is_keyframe = false)
+	{
+		EXPECT_TRUE(codec.PrepareCompressFrame(is_keyframe ? 1 : 0,
+		                                       format,
+		                                       nullptr,
+		                                       out.data(),
+		                                       static_cast<uint32_t>(
+		                                               out.size())));
+
+		const auto row_bytes = frame.size() / static_cast<size_t>(height);
+		for (auto y = 0; y < height; ++y) {
+			const uint8_t* row = &frame[static_cast<size_t>(y) * row_bytes];
+			codec.CompressLines(1, &row);
+		}
+
+		const auto written = codec.FinishCompressFrame();
+		EXPECT_GT(written, 0);
+		return {out.begin(), out.begin() + written};
+	}
+
+private:
+	VideoCodec codec = {};
+	std::vector<uint8_t> out = {};
+
+	const int width;
+	const int height;
+	const ZMBV_FORMAT format;
+};
+
+const char* to_string(const ZMBV_COMPRESSION compression)
+{
+	switch (compression) {
+	case ZMBV_COMPRESSION::FAST: return "fast";
+	case ZMBV_COMPRESSION::BALANCED: return "balanced";
+	case ZMBV_COMPRESSION::BEST: return "best";
+	}
+	return "";
+}
+
+std::vector<uint8_t> encode_sequence(
+        SyntheticSequence& seq, const ZMBV_FORMAT format, const int num_frames,
+        const ZMBV_COMPRESSION compression = ZMBV_COMPRESSION::BALANCED)
+{
+	Encoder encoder(seq.width, seq.height, format, compression);
+
+	std::vector<uint8_t> stream = {};
+	for (auto i = 0; i < num_frames; ++i) {
+		const auto encoded = encoder.Encode(seq.Render(i), i == 0);
+		stream.insert(stream.end(), encoded.begin(), encoded.end());
+	}
+	return stream;
+}
+
+TEST(ZMBV, Encode320x200Sequence)
+{
+	constexpr auto NumFrames = 120;
+
+	SyntheticSequence seq(320, 200, 1);
+	const auto stream = encode_sequence(seq, ZMBV_FORMAT::BPP_8, NumFrames);
+
+	// The encoding must be deterministic
+	EXPECT_EQ(stream, encode_sequence(seq, ZMBV_FORMAT::BPP_8, NumFrames));
+
+	EXPECT_LT(stream.size(), static_cast<size_t>(320 * 200 * NumFrames / 10));
+}
+
+TEST(ZMBV, Encode640x480Sequence)
+{
+	constexpr auto NumFrames = 60;
+
+	SyntheticSequence seq(640, 480, 4);
+	const auto stream = encode_sequence(seq, ZMBV_FORMAT::BPP_32, NumFrames);
+
+	EXPECT_EQ(stream, encode_sequence(seq, ZMBV_FORMAT::BPP_32, NumFrames));
+
+	EXPECT_LT(stream.size(), static_cast<size_t>(640 * 480 * 4 * NumFrames / 10));
+}
+
+TEST(ZMBV, CompressionPresets)
+{
+	constexpr auto NumFrames = 60;
+
+	SyntheticSequence seq(640, 480, 4);
+
+	const auto fast = encode_sequence(seq,
+	                                  ZMBV_FORMAT::BPP_32,
+	                                  NumFrames,
+	                                  ZMBV_COMPRESSION::FAST);
+	const auto balanced = encode_sequence(seq,
+	                                      ZMBV_FORMAT::BPP_32,
+	                                      NumFrames,
+	                                      ZMBV_COMPRESSION::BALANCED);
+	const auto best = encode_sequence(seq,
+	                                  ZMBV_FORMAT::BPP_32,
+	                                  NumFrames,
+	                                  ZMBV_COMPRESSION::BEST);
+
+	EXPECT_LE(balanced.size(), fast.size());
+	EXPECT_LE(best.size(), balanced.size());
+}
+
+TEST(ZMBV, DISABLED_Benchmark)
+{
+	constexpr auto NumFrames = 120;
+
+	struct Sequence {
+		int width;
+		int height;
+		int bytes_per_pixel;
+		ZMBV_FORMAT format;
+	};
+	constexpr Sequence Sequences[] = {
+	        {320, 200, 1, ZMBV_FORMAT::BPP_8},
+	        {640, 480, 2, ZMBV_FORMAT::BPP_16},
+	        {640, 480, 4, ZMBV_FORMAT::BPP_32},
+	};
+	constexpr ZMBV_COMPRESSION Presets[] = {ZMBV_COMPRESSION::FAST,
+	                                        ZMBV_COMPRESSION::BALANCED,
+	                                        ZMBV_COMPRESSION::BEST};
+
+	for (const auto& s : Sequences) {
+		SyntheticSequence seq(s.width, s.height, s.bytes_per_pixel);
+		for (const auto compression : Presets) {
+			Encoder encoder(s.width, s.height, s.format, compression);
+
+			// Only time the encoding, not the rendering of the frames
+			std::chrono::duration<double> elapsed = {};
+			size_t num_bytes = 0;
+
+			for (auto i = 0; i < NumFrames; ++i) {
+				const auto& frame = seq.Render(i);
+
+				const auto start = std::chrono::steady_clock::now();
+				num_bytes += encoder.Encode(frame, i == 0).size();
+				elapsed += std::chrono::steady_clock::now() - start;
+			}
+
+			printf("[ BENCH    ] %dx%d, %d bytes per pixel, %s: %.0f fps, %zu KB\n",
+			       s.width,
+			       s.height,
+			       s.bytes_per_pixel,
+			       to_string(compression),
+			       NumFrames / elapsed.count(),
+			       num_bytes / 1024);
+		}
+	}
+}
+
+TEST(ZMBV, SinglePixelChangeIsEncoded)
+{
+	SyntheticSequence seq(320, 200, 2);
+	const auto frame = seq.Render(0);
+
+	// Encode the same frame twice, and once more with a single pixel
+	// changed in the second frame; the vectorised block comparison must
+	// not miss it.
+	Encoder unchanged(320, 200, ZMBV_FORMAT::BPP_16);
+	Encoder changed(320, 200, ZMBV_FORMAT::BPP_16);
+
+	EXPECT_EQ(unchanged.Encode(frame, true), changed.Encode(frame, true));
+
+	auto modified = frame;
+	modified[(45 * 320 + 123) * 2] ^= 0x01;
+
+	EXPECT_NE(unchanged.Encode(frame), changed.Encode(modified));
+}
+
+TEST(ZMBV, IgnoresUnusedByteOf32BitPixels)
+{
+	SyntheticSequence seq(64, 32, 4);
+	auto frame = seq.Render(0);
+
+	Encoder reference(64, 32, ZMBV_FORMAT::BPP_32);
+	Encoder padded(64, 32, ZMBV_FORMAT::BPP_32);
+
+	EXPECT_EQ(reference.Encode(frame, true), padded.Encode(frame, true));
+
+	// Scribble over the unused top byte of every pixel
+	auto scribbled = frame;
+	for (size_t i = 3; i < scribbled.size(); i += 4) {
+		scribbled[i] = static_cast<uint8_t>(i);
+	}
+	EXPECT_EQ(reference.Encode(frame), padded.Encode(scribbled));
+}
+
+} // namespace